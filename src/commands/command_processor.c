@@ -26,14 +26,25 @@ void execute(FILE* data_in) {
         return;
     }
 
+    // Batches interrupted by a crash are finished before the files are touched again
+    if (!recover_interrupted_batch(args)) {
+        puts(EX_FILE_ERROR);
+        destroy_command_args(args);
+        return;
+    }
+
     switch (args->command) {
         case PARSE_AND_SERIALIZE:
+        case PARSE_AND_SERIALIZE_WITH_LINEAR_INDEX:
+        case PARSE_AND_SERIALIZE_WITH_BTREE_INDEX:
             c_parse_and_serialize(args);
             break;
         case DESERIALIZE_AND_PRINT:
             c_deserialize_and_print(args);
             break;
         case DESERIALIZE_FILTER_AND_PRINT:
+        case FILTER_AND_PRINT_WITH_LINEAR_INDEX:
+        case FILTER_AND_PRINT_WITH_BTREE_INDEX:
             c_deserialize_filter_and_print(args);
             break;
         case DESERIALIZE_SEARCH_RRN_AND_PRINT:
@@ -46,18 +57,34 @@ void execute(FILE* data_in) {
         case REMOVE_REGISTRY_WITH_BTREE_INDEX:
         case REMOVE_REGISTRY_WITH_LINEAR_INDEX:
             c_remove_registry(args);
+            c_auto_compact_registry(args);
             break;
         case INSERT_REGISTRY_WITH_BTREE_INDEX:
         case INSERT_REGISTRY_WITH_LINEAR_INDEX:
             c_insert_registry(args);
+            c_auto_compact_registry(args);
             break;
         case UPDATE_REGISTRY_WITH_BTREE_INDEX:
         case UPDATE_REGISTRY_WITH_LINEAR_INDEX:
             c_update_registry(args);
+            c_auto_compact_registry(args);
             break;
         case QUERY_REGISTRY_WITH_BTREE_INDEX:
             c_query_index_registry(args);
             break;
+        case COMPACT_REGISTRY_WITH_BTREE_INDEX:
+        case COMPACT_REGISTRY_WITH_LINEAR_INDEX:
+            c_compact_registry(args);
+            break;
+        case REGISTRY_STATS:
+            c_registry_stats(args);
+            break;
+        case CONVERT_TO_COLUMNAR:
+            c_convert_to_columnar(args);
+            break;
+        case COLUMNAR_FILTER_AND_PRINT:
+            c_columnar_filter_and_print(args);
+            break;
     }
 
     destroy_command_args(args);
@@ -166,7 +193,7 @@ CommandArgs* read_command(FILE* source) {
     fscanf(source, "%u", &command);
 
     // Validate command //
-    ex_assert(command >= MIN_COMMAND && command <= MAX_COMMAND, EX_COMMAND_PARSE_ERROR);
+    ex_assert((command >= MIN_COMMAND && command <= MAX_COMMAND) || (command >= MIN_EXTENDED_COMMAND && command <= MAX_EXTENDED_COMMAND), EX_COMMAND_PARSE_ERROR);
 
     // Create base args //
     CommandArgs* args = new_command_args(command);
@@ -181,6 +208,8 @@ CommandArgs* read_command(FILE* source) {
         args->registry_type = RT_FIX_LEN;
     } else if (strncasecmp("tipo2", buffer, 6) == 0) {
         args->registry_type = RT_VAR_LEN;
+    } else if (strncasecmp("tipo3", buffer, 6) == 0) {
+        args->registry_type = RT_SLOTTED;
     }
 
     // Invalid registry type
@@ -203,40 +232,39 @@ CommandArgs* read_command(FILE* source) {
             args->index_type = IT_B_TREE;
         case BUILD_LINEAR_INDEX_FROM_REGISTRY:
         case PARSE_AND_SERIALIZE:
+        case CONVERT_TO_COLUMNAR:
+            read_secondary_file_path(source, args);
+            break;
+
+        case COMPACT_REGISTRY_WITH_BTREE_INDEX:
+            args->index_type = IT_B_TREE;
+        case COMPACT_REGISTRY_WITH_LINEAR_INDEX:
+            // Load index file path
             read_secondary_file_path(source, args);
             break;
 
         case DESERIALIZE_AND_PRINT:
+        case REGISTRY_STATS:
             break;
 
-        case DESERIALIZE_FILTER_AND_PRINT:;// This is not a typo
-            // Read number of filters to read
-            uint32_t n_filters;
-            fscanf(source, "%u", &n_filters);
-
-            // Build filter list
-            FilterArgs* filter_tail = NULL;
-
-            for (uint32_t i = 0; i < n_filters; i++) {
-                FilterArgs* new_filter = malloc(sizeof(struct FilterArgs));
-                new_filter->next = NULL;
-                new_filter->parsed_value = NULL;
-
-                // Field name
-                new_filter->key = read_string_raw(source);
-                // Field value
-                new_filter->value = read_string_field(source);
-
-                // Update list filter_tail ref
-                if (filter_tail == NULL) {
-                    args->specific_data = new_filter;
-                } else {
-                    filter_tail->next = new_filter;
-                }
+        case PARSE_AND_SERIALIZE_WITH_BTREE_INDEX:
+            args->index_type = IT_B_TREE;
+        case PARSE_AND_SERIALIZE_WITH_LINEAR_INDEX:;// This is not a typo
+            // Load destination file path, followed by the index file path
+            read_secondary_file_path(source, args);
+            IngestArgs* ingest_args = malloc(sizeof(struct IngestArgs));
+            ingest_args->index_file = read_string_raw(source);
+            args->specific_data = ingest_args;
+            break;
 
-                // Update tail ref
-                filter_tail = new_filter;
-            }
+        case FILTER_AND_PRINT_WITH_BTREE_INDEX:
+            args->index_type = IT_B_TREE;
+        case FILTER_AND_PRINT_WITH_LINEAR_INDEX:
+            // Load index file path
+            read_secondary_file_path(source, args);
+        case DESERIALIZE_FILTER_AND_PRINT:
+        case COLUMNAR_FILTER_AND_PRINT:
+            args->specific_data = read_filter_list(source);
             break;
 
         case DESERIALIZE_SEARCH_RRN_AND_PRINT:;// This is not a typo
@@ -462,3 +490,41 @@ CommandArgs* read_command(FILE* source) {
 
     return args;
 }
+
+/**
+ * Read a filter list (amount of filters, followed by each field name and value)
+ * @param source source file
+ * @return the filter list (NULL if empty)
+ */
+FilterArgs* read_filter_list(FILE* source) {
+    // Read number of filters to read
+    uint32_t n_filters;
+    fscanf(source, "%u", &n_filters);
+
+    // Build filter list
+    FilterArgs* filter_head = NULL;
+    FilterArgs* filter_tail = NULL;
+
+    for (uint32_t i = 0; i < n_filters; i++) {
+        FilterArgs* new_filter = malloc(sizeof(struct FilterArgs));
+        new_filter->next = NULL;
+        new_filter->parsed_value = NULL;
+
+        // Field name
+        new_filter->key = read_string_raw(source);
+        // Field value
+        new_filter->value = read_string_field(source);
+
+        // Update list filter_tail ref
+        if (filter_tail == NULL) {
+            filter_head = new_filter;
+        } else {
+            filter_tail->next = new_filter;
+        }
+
+        // Update tail ref
+        filter_tail = new_filter;
+    }
+
+    return filter_head;
+}
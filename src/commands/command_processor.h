@@ -21,3 +21,10 @@ void execute(FILE* data_in);
  * @return the parsed command
  */
 CommandArgs* read_command(FILE* source);
+
+/**
+ * Read a filter list (amount of filters, followed by each field name and value)
+ * @param source source file
+ * @return the filter list (NULL if empty)
+ */
+FilterArgs* read_filter_list(FILE* source);
@@ -10,23 +10,206 @@
 #include "../const/const.h"
 #include "../exception/exception.h"
 #include "../index/index.h"
+#include "../scan/checkpoints.h"
+#include "../scan/column_scanner.h"
+#include "../scan/parallel_scan.h"
+#include "../scan/registry_scanner.h"
+#include "../scan/registry_stats.h"
+#include "../struct/free_slot_bitmap.h"
+#include "../struct/free_space_map.h"
+#include "../struct/insertion_plan.h"
+#include "../struct/t3_registry.h"
 #include "../utils/csv_parser.h"
+#include "../utils/csv_pipeline.h"
+#include "../utils/file_swap.h"
+#include "../utils/output_buffer.h"
 #include "../utils/provided_functions.h"
 #include "../utils/registry_loader.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+#include "../utils/wal.h"
 #include "common.h"
+#include "filter.h"
 
 
 // Commands //
 
+/**
+ * Creates (or empties) a file, first dropping the log and swap left by batches interrupted on its previous version
+ * (they'd otherwise be replayed over the new file)
+ * @param path the file path
+ * @param mode creation mode ("wb" or "wb+")
+ * @return the created file (NULL on failure)
+ */
+static FILE* create_file(const char* path, const char* mode) {
+    char* wal_path = wal_file_path(path);
+    remove(wal_path);
+    free(wal_path);
+
+    char* swap_path = swap_sidecar_path(path, SWAP_FILE_SUFFIX);
+    remove(swap_path);
+    free(swap_path);
+    discard_replacement(path);
+
+    return fopen(path, mode);
+}
+
+/**
+ * Allocates the sorter used to bulk load a new index, linear indexes are always written from sorted elements while
+ * bottom-up B-Tree loads are opt-in (the resulting tree layout differs from one-by-one insertions)
+ * @param index_type index being built
+ * @param fill_factor where the B-Tree fill factor will be stored
+ * @return the sorter (NULL if the index should be built through regular insertions)
+ */
+static ExternalSorter* new_index_build_sorter(IndexType index_type, uint32_t* fill_factor) {
+    *fill_factor = 0;
+    if (index_type == IT_B_TREE) {
+        *fill_factor = (uint32_t) get_size_setting(SETTING_BTREE_FILL_FACTOR, 0, 0, 100);
+        if (*fill_factor == 0) {
+            return NULL;
+        }
+    }
+
+    return new_index_element_sorter();
+}
+
 /**
  * Struct to hold shared information for the csv_stream processing function
  */
 typedef struct CSVParseArgs {
     Header* header;
     Registry* registry;
-    FILE* dest_file;
+    OutputBuffer* output;
+    CheckpointIndex* checkpoints;
+    IndexHeader* index_header;
+    ExternalSorter* index_sorter;
+    bool index_failed;
+    int n_lines;
+
+    // Page being filled (slotted files only)
+    T3Page* page;
 } CSVParseArgs;
 
+/**
+ * Registries of a CSV chunk, encoded by a parsing thread
+ */
+typedef struct EncodedCSVChunk {
+    Registry* registry;
+    char* data;
+    size_t used;
+    size_t capacity;
+    int32_t* ids;
+    size_t* sizes;
+    size_t n_registries;
+    size_t registries_capacity;
+    int n_lines;
+
+    // Lines missing columns keep values from the previous line (see load_registry_from_csv_line)
+    bool short_lines;
+    int32_t last_id;
+    int32_t last_ano;
+    int32_t last_qtt;
+} EncodedCSVChunk;
+
+// Columns loaded into fixed size fields (id, anoFabricacao, cidade and quantidade)
+#define CSV_FIXED_COLUMNS 4
+
+/**
+ * Feed the index with an appended registry's reference (a repeated id invalidates the index)
+ * @param args shared csv parsing data
+ * @param id registry id
+ * @param reference registry reference
+ */
+static void index_appended_registry(CSVParseArgs* args, int32_t id, int64_t reference) {
+    if (args->index_header == NULL || args->index_failed) {
+        return;
+    }
+
+    if (args->index_sorter != NULL) {
+        external_sorter_add(args->index_sorter, &(IndexElement){id, reference});
+    } else {
+        args->index_failed = !index_add(args->index_header, id, reference);
+    }
+}
+
+/**
+ * Keep track of a registry appended to the data file (header, checkpoints and index)
+ * @param args shared csv parsing data
+ * @param id registry id
+ * @param offset registry offset
+ * @param appended_bytes registry size
+ */
+static void track_appended_registry(CSVParseArgs* args, int32_t id, size_t offset, size_t appended_bytes) {
+    header_increment_next(args->header, appended_bytes);
+
+    // Keep track of registry boundaries (variable length files only)
+    if (args->checkpoints != NULL) {
+        checkpoint_track(args->checkpoints, offset, appended_bytes);
+    }
+
+    index_appended_registry(args, id, (int64_t) get_registry_reference(args->header, offset));
+}
+
+/**
+ * Write the page being filled into the slotted file being built (no-op for empty pages)
+ * @param args shared csv parsing data
+ */
+static void flush_slotted_page(CSVParseArgs* args) {
+    T3Page* page = args->page;
+    if (page->nroSlots == 0) {
+        return;
+    }
+
+    ex_assert(output_buffer_offset(args->output) == t3_page_offset(page->number), EX_FILE_ERROR);
+
+    char* dest = output_buffer_reserve(args->output, T3_PAGE_SIZE);
+    memcpy(dest, t3_encode_page(page), T3_PAGE_SIZE);
+    output_buffer_commit(args->output, T3_PAGE_SIZE);
+
+    header_increment_next(args->header, T3_PAGE_SIZE);
+    t3_track_page(args->header, page);
+}
+
+/**
+ * Append a registry to the slotted file being built, pages are filled in order and only written once full
+ * @param args shared csv parsing data
+ * @param registry the registry to be appended
+ */
+static void append_slotted_registry(CSVParseArgs* args, Registry* registry) {
+    T3Page* page = args->page;
+
+    reset_registry_metadata(registry);
+    if (!t3_page_insert(page, registry)) {
+        // Registries bigger than a whole page can't be stored
+        ex_assert(page->nroSlots > 0, EX_CORRUPTED_REGISTRY);
+
+        flush_slotted_page(args);
+        t3_setup_page(page, page->number + 1);
+
+        bool inserted = t3_page_insert(page, registry);
+        ex_assert(inserted, EX_CORRUPTED_REGISTRY);
+    }
+
+    index_appended_registry(args, registry->registry_content->id, (int64_t) registry_reference(args->header, registry));
+}
+
+/**
+ * Allocates the page used to build a slotted file (NULL for other registry types)
+ * @param registry_type the file's registry type
+ * @return the allocated page
+ */
+static T3Page* new_slotted_page(RegistryType registry_type) {
+    if (registry_type != RT_SLOTTED) {
+        return NULL;
+    }
+
+    T3Page* page = malloc(sizeof(struct T3Page));
+    ex_assert(page != NULL, EX_MEMORY_ERROR);
+    t3_setup_page(page, 0);
+
+    return page;
+}
+
 /**
  * Function used for csv_stream, receives each CSV line, parse it into a registry and serialize it into the dest file
  * @param idx the line index
@@ -43,12 +226,154 @@ void parse_csv_line(int idx, CSVLine* line, void* passthrough) {
 
     setup_registry(args->registry);
     load_registry_from_csv_line(args->registry, line);
-    size_t appended_bytes = write_registry(args->registry, args->dest_file);
-    header_increment_next(args->header, appended_bytes);
+
+    if (args->page != NULL) {
+        append_slotted_registry(args, args->registry);
+        return;
+    }
+
+    // Encode straight into the output buffer
+    char* dest = output_buffer_reserve(args->output, encoded_registry_size(args->registry));
+    size_t appended_bytes = encode_registry(args->registry, dest, output_buffer_offset(args->output));
+    output_buffer_commit(args->output, appended_bytes);
+
+    track_appended_registry(args, args->registry->registry_content->id, args->registry->offset, appended_bytes);
+}
+
+/**
+ * Function used for stream_csv_buffer on parsing threads, parses each line and encodes it into the chunk result
+ * @param idx the line index (0 only for the first line of the file)
+ * @param line the CSV line info
+ * @param passthrough the EncodedCSVChunk
+ */
+void encode_csv_chunk_line(int idx, CSVLine* line, void* passthrough) {
+    EncodedCSVChunk* encoded = passthrough;
+    encoded->n_lines++;
+
+    // Ignore header
+    if (idx == 0) {
+        return;
+    }
+
+    if (line->n_fields < CSV_FIXED_COLUMNS) {
+        encoded->short_lines = true;
+    }
+
+    setup_registry(encoded->registry);
+    load_registry_from_csv_line(encoded->registry, line);
+
+    // Encode into the chunk buffer (offsets are only known once the chunk is consumed)
+    size_t size = encoded_registry_size(encoded->registry);
+    if (encoded->used + size > encoded->capacity) {
+        encoded->capacity = max(2 * encoded->capacity, encoded->used + size);
+        encoded->data = realloc(encoded->data, encoded->capacity);
+        ex_assert(encoded->data != NULL, EX_MEMORY_ERROR);
+    }
+    size = encode_registry(encoded->registry, encoded->data + encoded->used, 0);
+    encoded->used += size;
+
+    if (encoded->n_registries == encoded->registries_capacity) {
+        encoded->registries_capacity = max(1024, 2 * encoded->registries_capacity);
+        encoded->ids = realloc(encoded->ids, encoded->registries_capacity * sizeof(int32_t));
+        encoded->sizes = realloc(encoded->sizes, encoded->registries_capacity * sizeof(size_t));
+        ex_assert(encoded->ids != NULL && encoded->sizes != NULL, EX_MEMORY_ERROR);
+    }
+    encoded->ids[encoded->n_registries] = encoded->registry->registry_content->id;
+    encoded->sizes[encoded->n_registries] = size;
+    encoded->n_registries++;
+}
+
+/**
+ * Parse a CSV chunk into encoded registries (runs on the parsing threads)
+ * @param chunk target chunk
+ * @param passthrough a CSVParseArgs pointer (only the registry type is read)
+ */
+void parse_csv_chunk(CSVChunk* chunk, void* passthrough) {
+    CSVParseArgs* args = passthrough;
+
+    // Results are reused between chunks
+    EncodedCSVChunk* encoded = chunk->result;
+    if (encoded == NULL) {
+        encoded = calloc(1, sizeof(struct EncodedCSVChunk));
+        ex_assert(encoded != NULL, EX_MEMORY_ERROR);
+        encoded->registry = new_registry();
+        encoded->registry->registry_type = args->header->registry_type;
+        chunk->result = encoded;
+    }
+    encoded->used = 0;
+    encoded->n_registries = 0;
+    encoded->n_lines = 0;
+    encoded->short_lines = false;
+
+    // The header can only be on the first chunk
+    stream_csv_buffer(chunk->data, chunk->size, chunk->index == 0 ? 0 : 1, encode_csv_chunk_line, encoded);
+
+    RegistryContent* content = encoded->registry->registry_content;
+    if (content != NULL) {
+        encoded->last_id = content->id;
+        encoded->last_ano = content->ano;
+        encoded->last_qtt = content->qtt;
+    }
+}
+
+/**
+ * Append the encoded registries of a chunk into the data file, in file order (runs on the calling thread)
+ * @param chunk target chunk
+ * @param passthrough a CSVParseArgs pointer with the shared information from the original calling function
+ */
+void consume_csv_chunk(CSVChunk* chunk, void* passthrough) {
+    CSVParseArgs* args = passthrough;
+    EncodedCSVChunk* encoded = chunk->result;
+
+    // Values carried between lines depend on the previous chunks, so these chunks are parsed again here (same goes
+    // for a header that didn't land on the first chunk, only possible after a whole chunk of empty lines)
+    if (encoded->short_lines || (args->n_lines == 0 && chunk->index > 0)) {
+        stream_csv_buffer(chunk->data, chunk->size, args->n_lines, parse_csv_line, args);
+        args->n_lines += encoded->n_lines;
+        return;
+    }
+    args->n_lines += encoded->n_lines;
+
+    size_t position = 0;
+    for (size_t i = 0; i < encoded->n_registries; i++) {
+        size_t size = encoded->sizes[i];
+        char* dest = output_buffer_reserve(args->output, size);
+        size_t offset = output_buffer_offset(args->output);
+        memcpy(dest, encoded->data + position, size);
+        output_buffer_commit(args->output, size);
+        position += size;
+
+        track_appended_registry(args, encoded->ids[i], offset, size);
+    }
+
+    // Following lines carry the values of the last one
+    if (encoded->n_registries > 0) {
+        if (args->registry->registry_content == NULL) {
+            setup_registry(args->registry);
+        }
+        args->registry->registry_content->id = encoded->last_id;
+        args->registry->registry_content->ano = encoded->last_ano;
+        args->registry->registry_content->qtt = encoded->last_qtt;
+    }
+}
+
+/**
+ * Free an encoded chunk
+ * @param result the EncodedCSVChunk
+ */
+void destroy_encoded_csv_chunk(void* result) {
+    EncodedCSVChunk* encoded = result;
+    destroy_registry(encoded->registry);
+    free(encoded->data);
+    free(encoded->ids);
+    free(encoded->sizes);
+    free(encoded);
 }
 
 /**
  * Parse csv file and build registry
+ *
+ * Commands 16 and 17 also build the index on the same pass (both files are only marked good at the end)
  * @param args command args
  */
 void c_parse_and_serialize(CommandArgs* args) {
@@ -63,32 +388,84 @@ void c_parse_and_serialize(CommandArgs* args) {
     }
 
     // Open destination file
-    FILE* dest_file = fopen(args->secondary_file, "wb");
+    FILE* dest_file = create_file(args->secondary_file, "wb");
     if (dest_file == NULL) {
         puts(EX_FILE_ERROR);
         fclose(csv_file);
         return;
     }
 
+    // Open index file (combined ingest only)
+    IngestArgs* ingest_args = args->specific_data;
+    FILE* index_file = NULL;
+    if (ingest_args != NULL) {
+        index_file = create_file(ingest_args->index_file, "wb+");
+        if (index_file == NULL) {
+            puts(EX_FILE_ERROR);
+            fclose(csv_file);
+            fclose(dest_file);
+            return;
+        }
+    }
+
     // Write default header with a bad status
     Header* header = build_default_header(args->registry_type);
     set_header_status(header, STATUS_BAD);
     write_header(header, dest_file);
 
+    // Create index header (with a bad status until it's completely written)
+    IndexHeader* index_header = NULL;
+    ExternalSorter* index_sorter = NULL;
+    uint32_t fill_factor = 0;
+    if (index_file != NULL) {
+        index_header = new_index(args->registry_type, args->index_type);
+        set_index_status(index_header, STATUS_BAD);
+        write_index_status(index_header, index_file);
+        set_index_file(index_header, index_file);
+        index_sorter = new_index_build_sorter(args->index_type, &fill_factor);
+    }
+
     // Write registries
     Registry* registry = new_registry();
     registry->registry_type = args->registry_type;
 
+    // Variable length files get resynchronisation checkpoints
+    CheckpointIndex* checkpoints = NULL;
+    if (args->registry_type == RT_VAR_LEN) {
+        size_t interval = get_size_setting(SETTING_CHECKPOINT_INTERVAL, DEFAULT_CHECKPOINT_INTERVAL, 1, INT32_MAX);
+        checkpoints = new_checkpoint_index((int32_t) interval, current_offset(dest_file));
+    }
+
+    // Registries are encoded into a big buffer and written in chunks
+    OutputBuffer* output = new_output_buffer(dest_file, DEFAULT_OUTPUT_BUFFER_SIZE);
+
     // Create shared data for stream passthrough
     CSVParseArgs csv_parse_args = {
             header,
             registry,
-            dest_file};
+            output,
+            checkpoints,
+            index_header,
+            index_sorter,
+            false,
+            0,
+            new_slotted_page(args->registry_type)};
+
+    // CSV streaming: chunks parsed on worker threads, or else loop each line calling the before-defined parse_csv_line
+    // (registries encoded by the workers can't be laid out on pages, so slotted files are always parsed here)
+    bool parsed = csv_parse_args.page == NULL && parallel_stream_csv(csv_file, parse_csv_chunk, consume_csv_chunk, destroy_encoded_csv_chunk, &csv_parse_args);
+    if (!parsed) {
+        stream_csv(csv_file, parse_csv_line, &csv_parse_args);
+    }
 
-    // CSV streaming: loop each line calling the before-defined parse_csv_line function
-    stream_csv(csv_file, parse_csv_line, &csv_parse_args);
+    // Last page, not full
+    if (csv_parse_args.page != NULL) {
+        flush_slotted_page(&csv_parse_args);
+        free(csv_parse_args.page);
+    }
 
     // Cleanup
+    destroy_output_buffer(output);
     destroy_registry(registry);
     fclose(csv_file);
 
@@ -97,12 +474,59 @@ void c_parse_and_serialize(CommandArgs* args) {
     fseek(dest_file, 0, SEEK_SET);
     write_header(header, dest_file);
 
+    // Tie the checkpoints to the written file
+    if (checkpoints != NULL) {
+        checkpoints->fingerprint = checkpoint_fingerprint(header, dest_file);
+    }
+
     // Cleanup
     fclose(dest_file);
     destroy_header(header);
 
+    // Save checkpoints sidecar
+    if (checkpoints != NULL) {
+        save_checkpoint_index(checkpoints, args->secondary_file);
+        destroy_checkpoint_index(checkpoints);
+    }
+
     // Autocorrection stuff
     print_autocorrection_checksum(args->secondary_file);
+
+    if (index_header != NULL) {
+        // Build the whole index at once
+        bool bulk_loaded = index_sorter != NULL;
+        if (bulk_loaded) {
+            external_sorter_finish(index_sorter);
+            csv_parse_args.index_failed = !index_bulk_load(index_header, index_sorter, fill_factor);
+            index_file = get_index_file(index_header);
+            destroy_external_sorter(index_sorter);
+        }
+
+        if (csv_parse_args.index_failed) {
+            // Repeated ids, the index is kept with a bad status (same as building it on a separate command)
+            puts(EX_FILE_ERROR);
+            destroy_index_header(index_header);
+            fclose(index_file);
+            return;
+        }
+
+        // Write index (bulk loads already wrote it)
+        if (!bulk_loaded) {
+            write_index(index_header, index_file);
+            index_file = get_index_file(index_header);
+        }
+
+        // Update index status
+        set_index_status(index_header, STATUS_GOOD);
+        write_index_status(index_header, index_file);
+
+        // Cleanup
+        destroy_index_header(index_header);
+        fclose(index_file);
+
+        // Autocorrection stuff
+        print_autocorrection_checksum(ingest_args->index_file);
+    }
 }
 
 /**
@@ -128,25 +552,27 @@ void c_deserialize_and_print(CommandArgs* args) {
     if (read_bytes == 0 || get_header_status(header) == STATUS_BAD) {
         puts(EX_FILE_ERROR);
     } else {
-        // Allocate shared registry (freed only at the end, information is always reset on the read_registry call)
-        Registry* registry = build_registry(header);
-        size_t max_offset = get_max_offset(header);
+        // Shared view (no allocations, the strings point straight into the scanned bytes)
+        RegistryView view;
 
-        // Loop each registry until reaching the file limit (defined on header)
-        while (read_bytes < max_offset) {
-            read_bytes += read_registry(registry, file);
+        // Sequential scan over the memory-mapped file (falls back to regular reads if mapping isn't possible)
+        RegistryScanner* scanner = new_registry_scanner(header, file, read_bytes, SM_MMAP);
+        ResultWriter* writer = new_result_writer(stdout, get_output_format_setting());
 
+        // Loop each registry until reaching the file limit (defined on header)
+        while (scanner_next_view(scanner, &view)) {
             // On read failure or removal, skip
-            if (registry == NULL || is_registry_removed(registry)) {
+            if (view.removed) {
                 continue;
             }
 
-            print_registry(header, registry);
+            print_registry_view(writer, header, &view);
             printed = true;
         }
 
         // Cleanup
-        destroy_registry(registry);
+        destroy_result_writer(writer);
+        destroy_registry_scanner(scanner);
 
         // No registry found
         if (!printed) {
@@ -159,8 +585,195 @@ void c_deserialize_and_print(CommandArgs* args) {
     fclose(file);
 }
 
+/**
+ * Struct to hold shared information for the parallel filter scan callbacks
+ */
+typedef struct FilterScanArgs {
+    Header* header;
+    FilterProgram* program;
+    ResultWriter* writer;
+    bool printed;
+} FilterScanArgs;
+
+/**
+ * Parallel scan predicate, checks the registry against the filters
+ * @param view the registry view
+ * @param passthrough a FilterScanArgs pointer
+ * @return if the registry matches
+ */
+bool filter_scan_match(RegistryView* view, void* passthrough) {
+    FilterScanArgs* args = passthrough;
+    return filter_program_match(args->program, view);
+}
+
+/**
+ * Parallel scan batch predicate, evaluates the compiled filters over a whole batch
+ * @param batch the decoded batch
+ * @param selection output selection bitmap
+ * @param passthrough a FilterScanArgs pointer
+ */
+void filter_scan_select(RegistryBatch* batch, uint64_t* selection, void* passthrough) {
+    FilterScanArgs* args = passthrough;
+    filter_program_select(args->program, batch, selection);
+}
+
+/**
+ * Parallel scan callback, prints each matched registry
+ * @param view the registry view
+ * @param passthrough a FilterScanArgs pointer
+ */
+void filter_scan_print(RegistryView* view, void* passthrough) {
+    FilterScanArgs* args = passthrough;
+    print_registry_view(args->writer, args->header, view);
+    args->printed = true;
+}
+
+/**
+ * Full scan of the registries, printing every one matching the compiled filters
+ * @param args command args
+ * @param header the file's header
+ * @param file the source file
+ * @param first_registry_offset offset of the first registry
+ * @param program the compiled filters
+ * @param writer destination writer
+ * @return if any registry was printed
+ */
+static bool scan_filter_and_print(CommandArgs* args, Header* header, FILE* file, size_t first_registry_offset, FilterProgram* program, ResultWriter* writer) {
+    // Variable length files can only be split with checkpoints (not even loaded when the scan runs on a single thread)
+    CheckpointIndex* checkpoints = scan_thread_count() < 2 ? NULL : load_checkpoint_index(header, file, args->primary_file, false);
+
+    // Try a parallel scan first (big enough files), results are printed in file order
+    FilterScanArgs scan_args = {header, program, writer, false};
+    bool scanned = parallel_scan(header, file, first_registry_offset, checkpoints, filter_scan_match, filter_scan_select, filter_scan_print, &scan_args);
+    destroy_checkpoint_index(checkpoints);
+
+    if (scanned) {
+        return scan_args.printed;
+    }
+
+    bool printed = false;
+
+    // Shared view (no allocations, the strings point straight into the scanned bytes)
+    RegistryView view;
+
+    // Sequential scan over the memory-mapped file (falls back to regular reads if mapping isn't possible)
+    RegistryScanner* scanner = new_registry_scanner(header, file, first_registry_offset, SM_MMAP);
+
+    if (scanner->scan_mode == SM_MMAP) {
+        // Decode batches of numeric columns, strings are only viewed for the selected registries
+        RegistryBatch* batch = malloc(sizeof(struct RegistryBatch));
+        ex_assert(batch != NULL, EX_MEMORY_ERROR);
+        uint64_t selection[REGISTRY_BATCH_WORDS];
+
+        while (scanner_next_batch(scanner, batch)) {
+            filter_program_select(program, batch, selection);
+
+            for (size_t i = 0; i < batch->n_registries; i++) {
+                if ((selection[i / 64] >> (i % 64)) & 1) {
+                    view_batch_registry(batch, i, &view);
+                    print_registry_view(writer, header, &view);
+                    printed = true;
+                }
+            }
+        }
+
+        free(batch);
+    } else {
+        // Loop each registry until reaching the file limit (defined on header)
+        while (scanner_next_view(scanner, &view)) {
+            // On read failure, removal or no filter match, skip
+            if (!filter_program_match(program, &view)) {
+                continue;
+            }
+
+            print_registry_view(writer, header, &view);
+            printed = true;
+        }
+    }
+
+    // Cleanup
+    destroy_registry_scanner(scanner);
+
+    return printed;
+}
+
+/**
+ * Index point lookup for filters pinning the id, printing the registry if it matches every filter
+ * @param args command args (the index is on the secondary file)
+ * @param header the file's header
+ * @param file the source file
+ * @param filters the raw filters
+ * @param program the compiled filters
+ * @param writer destination writer
+ * @param printed set if the registry was printed
+ * @return if the lookup was executed (false when there's no id filter or no usable index, so a full scan is needed)
+ */
+static bool index_filter_and_print(CommandArgs* args, Header* header, FILE* file, FilterArgs* filters, FilterProgram* program, ResultWriter* writer, bool* printed) {
+    // Look for a non-null id filter (any other filter is checked on the retrieved registry)
+    FilterArgs* id_filter = NULL;
+    for (FilterArgs* cur_filter = filters; cur_filter != NULL && id_filter == NULL; cur_filter = cur_filter->next) {
+        if (strcmp(ID_FIELD_NAME, cur_filter->key) == 0 && cur_filter->value != NULL && cur_filter->value[0] != '\0') {
+            id_filter = cur_filter;
+        }
+    }
+
+    if (id_filter == NULL || args->secondary_file == NULL) {
+        return false;
+    }
+
+    // Open index_file (a missing index falls back to the full scan)
+    FILE* index_file = fopen(args->secondary_file, "rb");
+    if (index_file == NULL) {
+        return false;
+    }
+
+    // Load index
+    IndexHeader* index_header = new_index(args->registry_type, args->index_type);
+    size_t read_bytes_index = read_index(index_header, index_file);
+
+    // Check for read failure or bad status
+    if (read_bytes_index == 0 || get_index_status(index_header) == STATUS_BAD) {
+        destroy_index_header(index_header);
+        fclose(index_file);
+        return false;
+    }
+
+    // Search for id on index
+    IndexElement index_match = index_query(index_header, parse_int32_filter(id_filter));
+
+    // If found, check the remaining filters on the registry
+    if (index_match.id != -1) {
+        // Load target registry (only the filtered fields)
+        Registry* registry = build_registry(header);
+        seek_registry(header, file, index_match.reference);
+        read_registry_projected(registry, file, filter_program_fields(program));
+
+        RegistryView view;
+        view_from_registry(&view, registry);
+        if (filter_program_match(program, &view)) {
+            // Decode the remaining fields to print it
+            read_registry_remaining(registry, file);
+            view_from_registry(&view, registry);
+
+            print_registry_view(writer, header, &view);
+            *printed = true;
+        }
+
+        // Cleanup
+        destroy_registry(registry);
+    }
+
+    // Cleanup
+    destroy_index_header(index_header);
+    fclose(index_file);
+
+    return true;
+}
+
 /**
  * Deserialize a registry and print everyone matching the given filter
+ *
+ * Commands with an index (14 and 15) look up filters on the id straight on the index, falling back to a full scan
  * @param args command args
  */
 void c_deserialize_filter_and_print(CommandArgs* args) {
@@ -185,25 +798,17 @@ void c_deserialize_filter_and_print(CommandArgs* args) {
     if (read_bytes == 0 || get_header_status(header) == STATUS_BAD) {
         puts(EX_FILE_ERROR);
     } else {
-        // Allocate shared registry (freed only at the end, information is always reset on the read_registry call)
-        Registry* registry = build_registry(header);
-        size_t max_offset = get_max_offset(header);
-
-        // Loop each registry until reaching the file limit (defined on header)
-        while (read_bytes < max_offset) {
-            read_bytes += read_registry(registry, file);
-
-            // On read failure, removal or no filter match, skip
-            if (registry == NULL || is_registry_removed(registry) || !registry_filter_match(registry, filters)) {
-                continue;
-            }
+        // Compile the filters once (the program is read-only afterwards, so it can be shared between threads)
+        FilterProgram* program = compile_filter_program(filters);
+        ResultWriter* writer = new_result_writer(stdout, get_output_format_setting());
 
-            print_registry(header, registry);
-            printed = true;
+        // Plan: index point lookup when possible, full scan otherwise
+        if (!index_filter_and_print(args, header, file, filters, program, writer, &printed)) {
+            printed = scan_filter_and_print(args, header, file, read_bytes, program, writer);
         }
 
-        // Cleanup
-        destroy_registry(registry);
+        destroy_filter_program(program);
+        destroy_result_writer(writer);
 
         // No registry found
         if (!printed) {
@@ -267,7 +872,9 @@ void c_deserialize_direct_access_rrn_and_print(CommandArgs* args) {
 
     // Check if the registry exists
     if (!is_registry_removed(registry)) {
-        print_registry(header, registry);
+        ResultWriter* writer = new_result_writer(stdout, get_output_format_setting());
+        print_registry(writer, header, registry);
+        destroy_result_writer(writer);
     } else {
         puts(EX_REGISTRY_NOT_FOUND);
     }
@@ -294,7 +901,7 @@ void c_build_index_from_registry(CommandArgs* args) {
     }
 
     // Open index_file
-    FILE* index_file = fopen(args->secondary_file, "wb+");
+    FILE* index_file = create_file(args->secondary_file, "wb+");
     if (index_file == NULL) {
         puts(EX_FILE_ERROR);
         return;
@@ -310,6 +917,9 @@ void c_build_index_from_registry(CommandArgs* args) {
     write_index_status(index_header, index_file);
     set_index_file(index_header, index_file);
 
+    // Bulk loads write the whole index by themselves
+    bool bulk_loaded = false;
+
     // Check for read failure or bad status
     if (read_bytes == 0 || get_header_status(header) == STATUS_BAD) {
         puts(EX_FILE_ERROR);
@@ -319,37 +929,55 @@ void c_build_index_from_registry(CommandArgs* args) {
         destroy_index_header(index_header);
         return;
     } else {
-        // Allocate shared registry (freed only at the end, information is always reset on the read_registry call)
-        Registry* registry = build_registry(header);
-        size_t max_offset = get_max_offset(header);
+        // Elements staged for a sorted bulk load (if any)
+        uint32_t fill_factor;
+        ExternalSorter* sorter = new_index_build_sorter(args->index_type, &fill_factor);
 
-        // Loop each registry until reaching the file limit (defined on header)
-        while (read_bytes < max_offset) {
-            size_t registry_reference = get_registry_reference(header, read_bytes);
-            read_bytes += read_registry(registry, registry_file);
+        // Only the id and reference are needed, so a view is enough
+        RegistryView view;
+        RegistryScanner* scanner = new_registry_scanner(header, registry_file, read_bytes, SM_BLOCK);
 
+        // Loop each registry until reaching the file limit (defined on header)
+        bool success = true;
+        while (success && scanner_next_view(scanner, &view)) {
             // On read failure or removal, skip
-            if (registry == NULL || is_registry_removed(registry)) {
+            if (view.removed) {
                 continue;
             }
 
-            // Add registry to index
-            bool success = index_add(index_header, registry->registry_content->id, (int64_t) registry_reference);
+            int64_t reference = (int64_t) view_reference(header, &view);
 
-            // If the registry already exists
-            if (!success) {
-                puts(EX_FILE_ERROR);
-                destroy_header(header);
-                destroy_registry(registry);
-                destroy_index_header(index_header);
-                fclose(registry_file);
-                fclose(index_file);
-                return;
+            // Stage element for the bulk load
+            if (sorter != NULL) {
+                external_sorter_add(sorter, &(IndexElement){view.id, reference});
+                continue;
             }
+
+            // Add registry to index
+            success = index_add(index_header, view.id, reference);
+        }
+
+        // Build the whole index at once
+        if (sorter != NULL) {
+            external_sorter_finish(sorter);
+            success = index_bulk_load(index_header, sorter, fill_factor);
+            index_file = get_index_file(index_header);
+            bulk_loaded = true;
         }
 
         // Cleanup
-        destroy_registry(registry);
+        destroy_registry_scanner(scanner);
+        destroy_external_sorter(sorter);
+
+        // If the registry already exists
+        if (!success) {
+            puts(EX_FILE_ERROR);
+            destroy_header(header);
+            destroy_index_header(index_header);
+            fclose(registry_file);
+            fclose(index_file);
+            return;
+        }
     }
 
     // Cleanup registry
@@ -357,8 +985,10 @@ void c_build_index_from_registry(CommandArgs* args) {
     fclose(registry_file);
 
     // Write index
-    write_index(index_header, index_file);
-    index_file = get_index_file(index_header);
+    if (!bulk_loaded) {
+        write_index(index_header, index_file);
+        index_file = get_index_file(index_header);
+    }
 
     // Update index status
     set_index_status(index_header, STATUS_GOOD);
@@ -373,27 +1003,111 @@ void c_build_index_from_registry(CommandArgs* args) {
 }
 
 /**
- * Logically remove a registry and update the given index
- * @param args command args
+ * Starts the write-ahead log of a batch of changes over a data file and its index
+ * @param data_path the data file path
+ * @return the log (NULL when disabled through SETTING_WAL or when it couldn't be created)
  */
-void c_remove_registry(CommandArgs* args) {
-    ex_assert(args->primary_file != NULL, EX_COMMAND_PARSE_ERROR);
+static WriteAheadLog* begin_batch(const char* data_path) {
+    if (get_size_setting(SETTING_WAL, 1, 0, 1) == 0) {
+        return NULL;
+    }
+    return begin_wal(data_path);
+}
+
+/**
+ * Opens a file changed by a batch, journaled if the batch has a log
+ * @param wal the batch log (may be NULL)
+ * @param path the file path
+ * @return the opened file (NULL on failure)
+ */
+static FILE* open_batch_file(WriteAheadLog* wal, const char* path) {
+    if (wal == NULL) {
+        return fopen(path, "rb+");
+    }
+    return wal_fopen(wal, path);
+}
+
+/**
+ * Commits a batch log (its files must be already closed) and frees it, then saves the data file's free space map and
+ * free slot bitmap
+ * @param wal the batch log (may be NULL)
+ * @param header the data file header
+ * @param data_path the data file path
+ */
+static void finish_batch(WriteAheadLog* wal, Header* header, const char* data_path) {
+    if (wal != NULL && !commit_wal(wal)) {
+        puts(EX_FILE_ERROR);
+        destroy_wal(wal);
+        return;
+    }
+    destroy_wal(wal);
+
+    // Only kept if the batch made it into the data file
+    save_free_space_map(header, data_path);
+    save_free_slot_bitmap(header, data_path);
+}
+
+/**
+ * Finishes any batch interrupted on the command's data file (replayed if it was committed, discarded otherwise)
+ * @param args command args
+ * @return if the files are settled (false when a committed batch couldn't be replayed, its log is kept)
+ */
+bool recover_interrupted_batch(CommandArgs* args) {
+    if (args->primary_file == NULL) {
+        return true;
+    }
+
+    // Compactions which reached their renames are finished
+    recover_file_swap(args->primary_file);
+
+    WalRecovery recovery = recover_wal(args->primary_file);
+    if (recovery == WR_FAILED) {
+        return false;
+    }
+
+    // Checkpoints might have been saved past the discarded changes
+    if (recovery == WR_ROLLED_BACK) {
+        char* path = checkpoint_file_path(args->primary_file);
+        remove(path);
+        free(path);
+    }
+
+    // Replacements still around belong to swaps which crashed before writing their intent
+    discard_replacement(args->primary_file);
+    if (args->secondary_file != NULL) {
+        discard_replacement(args->secondary_file);
+    }
+
+    return true;
+}
+
+/**
+ * Logically remove a registry and update the given index
+ * @param args command args
+ */
+void c_remove_registry(CommandArgs* args) {
+    ex_assert(args->primary_file != NULL, EX_COMMAND_PARSE_ERROR);
     ex_assert(args->secondary_file != NULL, EX_COMMAND_PARSE_ERROR);
     ex_assert(args->specific_data != NULL, EX_COMMAND_PARSE_ERROR);
 
     RemovalArgs* removal_args = args->specific_data;
 
+    // Changes are journaled until the whole batch is done
+    WriteAheadLog* wal = begin_batch(args->primary_file);
+
     // Open registry_file
-    FILE* registry_file = fopen(args->primary_file, "rb+");
+    FILE* registry_file = open_batch_file(wal, args->primary_file);
     if (registry_file == NULL) {
         puts(EX_FILE_ERROR);
+        destroy_wal(wal);
         return;
     }
 
     // Open index_file
-    FILE* index_file = fopen(args->secondary_file, "rb+");
+    FILE* index_file = open_batch_file(wal, args->secondary_file);
     if (index_file == NULL) {
         puts(EX_FILE_ERROR);
+        destroy_wal(wal);
         return;
     }
 
@@ -410,11 +1124,18 @@ void c_remove_registry(CommandArgs* args) {
         puts(EX_FILE_ERROR);
         fclose(registry_file);
         fclose(index_file);
+        destroy_wal(wal);
         destroy_header(header);
         destroy_index_header(index_header);
         return;
     }
 
+    // Removed registries are found through the free space map (variable length files)
+    header->free_space_map = load_free_space_map(header, registry_file, args->primary_file);
+
+    // Checkpoints are only caught up if they were saved for the file as it is before the batch
+    CheckpointFingerprint fingerprint = checkpoint_fingerprint(header, registry_file);
+
     // Update registry header status
     set_header_status(header, STATUS_BAD);
     fseek(registry_file, 0, SEEK_SET);
@@ -424,6 +1145,10 @@ void c_remove_registry(CommandArgs* args) {
     set_index_status(index_header, STATUS_BAD);
     write_index_status(index_header, index_file);
 
+    // Free slots are handed out in file order through the free slot bitmap (fixed length files, the stack might be
+    // relinked, so only once the file is marked as being changed)
+    header->free_slot_bitmap = load_free_slot_bitmap(header, registry_file, args->primary_file);
+
     // Do each removal in the given order
     for (uint32_t i = 0; i < removal_args->n_removals; i++) {
         RemovalTarget current_removal = removal_args->removal_targets[i];
@@ -447,17 +1172,26 @@ void c_remove_registry(CommandArgs* args) {
                 continue;
             }
 
-            // Load target registry
+            // Load target registry (only the filtered fields)
+            FilterProgram* program = compile_filter_program(current_removal.unindexed_filter_args);
             Registry* registry = build_registry(header);
             seek_registry(header, registry_file, index_match.reference);
-            read_registry(registry, registry_file);
+            read_registry_projected(registry, registry_file, filter_program_fields(program));
 
             // Check if the registry exists and match the filters
-            if (is_registry_removed(registry) || !registry_filter_match(registry, current_removal.unindexed_filter_args)) {
+            RegistryView view;
+            view_from_registry(&view, registry);
+            bool matched = filter_program_match(program, &view);
+            destroy_filter_program(program);
+
+            if (!matched) {
                 destroy_registry(registry);
                 continue;
             }
 
+            // Decode the remaining fields (the removal rewrites the registry)
+            read_registry_remaining(registry, registry_file);
+
             // Remove the registry and update the index
             remove_registry(header, registry, registry_file);
             index_remove(index_header, id);
@@ -467,43 +1201,45 @@ void c_remove_registry(CommandArgs* args) {
         } else {
             // Non-indexed cases //
 
-            // Go to top of the registry for iteration
-            go_to_offset(first_registry_offset, registry_file);
-            size_t read_bytes_registry = first_registry_offset;
+            // Iterate from the top of the registry (the file is modified during the scan, so no mapping here)
+            RegistryScanner* scanner = new_registry_scanner(header, registry_file, first_registry_offset, SM_STDIO);
+            RegistryView view;
 
             // Allocate registry for reading
             Registry* registry = build_registry(header);
 
-            // Compute the max offset for iteration
-            size_t max_offset = get_max_offset(header);
-
-            // Load filterls
-            FilterArgs* filter_args = current_removal.unindexed_filter_args;
+            // Load filters (compiled once for the whole scan)
+            FilterProgram* program = compile_filter_program(current_removal.unindexed_filter_args);
 
             // Loop each registry until reaching the file limit
-            while (read_bytes_registry < max_offset) {
-                // Load the registry
-                read_bytes_registry += read_registry(registry, registry_file);
-
+            while (scanner_next_view(scanner, &view)) {
                 // Check if registry is present and filter matches
-                if (registry == NULL || is_registry_removed(registry) || !registry_filter_match(registry, filter_args)) {
+                if (!filter_program_match(program, &view)) {
                     continue;
                 }
 
+                // Materialize the matched registry
+                go_to_offset(view.offset, registry_file);
+                read_registry(registry, registry_file);
+
                 // Remove matched registry
-                size_t cur_offset = current_offset(registry_file);// Keep current offset to return to it in iteration
                 remove_registry(header, registry, registry_file);
-                go_to_offset(cur_offset, registry_file);// Return to offset to continue iteration
+                go_to_offset(scanner->offset, registry_file);// Return to offset to continue iteration
 
                 // Removed registry from index
                 index_remove(index_header, registry->registry_content->id);
             }
 
             // Cleanup
+            destroy_filter_program(program);
+            destroy_registry_scanner(scanner);
             destroy_registry(registry);
         }
     }
 
+    // Keep checkpoints tied to the changed file (removals don't move any registry boundary)
+    sync_checkpoint_index(header, registry_file, args->primary_file, fingerprint);
+
     // Update registry header
     set_header_status(header, STATUS_GOOD);
     fseek(registry_file, 0, SEEK_SET);
@@ -518,17 +1254,77 @@ void c_remove_registry(CommandArgs* args) {
     write_index_status(index_header, index_file);
 
     // Cleanup
-    destroy_header(header);
     destroy_index_header(index_header);
     fclose(registry_file);
     fclose(index_file);
 
+    // Apply the journaled batch before the files are read back
+    finish_batch(wal, header, args->primary_file);
+    destroy_header(header);
+
     // Autocorrection stuff
     print_autocorrection_checksum(args->primary_file);
     print_autocorrection_checksum(args->secondary_file);
 }
 
 
+/**
+ * Insertion id and its position on the batch
+ */
+typedef struct InsertionKey {
+    int32_t id;
+    uint32_t position;
+} InsertionKey;
+
+/**
+ * Compares insertion keys by id, then by batch position
+ * @param a InsertionKey ptr
+ * @param b InsertionKey ptr
+ * @return comparison result
+ */
+static int compare_insertion_keys(const void* a, const void* b) {
+    const InsertionKey* key_a = a;
+    const InsertionKey* key_b = b;
+
+    if (key_a->id != key_b->id) return key_a->id < key_b->id ? -1 : 1;
+    if (key_a->position != key_b->position) return key_a->position < key_b->position ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Decides which insertions of a batch go through, probing the index once per distinct id and in id order
+ *
+ * Same outcome as checking each insertion in order: an id is only inserted by its first occurrence, if not indexed yet
+ * @param index_header the file's index
+ * @param insertion_args the insertion batch
+ * @return the allocated acceptance flags (by batch position)
+ */
+static bool* accept_insertions(IndexHeader* index_header, InsertionArgs* insertion_args) {
+    uint32_t n_insertions = insertion_args->n_insertions;
+
+    bool* accepted = calloc(max(n_insertions, 1), sizeof(bool));
+    InsertionKey* keys = malloc(max(n_insertions, 1) * sizeof(struct InsertionKey));
+    ex_assert(accepted != NULL && keys != NULL, EX_MEMORY_ERROR);
+
+    for (uint32_t i = 0; i < n_insertions; i++) {
+        keys[i] = (InsertionKey){insertion_args->insertion_targets[i].id, i};
+    }
+    qsort(keys, n_insertions, sizeof(struct InsertionKey), compare_insertion_keys);
+
+    for (uint32_t i = 0; i < n_insertions; i++) {
+        // Repeated ids were indexed by their first occurrence, except for -1 (the "not found" id, always inserted)
+        if (i > 0 && keys[i].id == keys[i - 1].id) {
+            accepted[keys[i].position] = keys[i].id == -1;
+            continue;
+        }
+
+        accepted[keys[i].position] = index_query(index_header, keys[i].id).id == -1;
+    }
+
+    free(keys);
+    return accepted;
+}
+
 /**
  * Insert registries into an existing file and udpate index
  * @param args command args
@@ -540,17 +1336,22 @@ void c_insert_registry(CommandArgs* args) {
 
     InsertionArgs* insertion_args = args->specific_data;
 
+    // Changes are journaled until the whole batch is done
+    WriteAheadLog* wal = begin_batch(args->primary_file);
+
     // Open registry_file
-    FILE* registry_file = fopen(args->primary_file, "rb+");
+    FILE* registry_file = open_batch_file(wal, args->primary_file);
     if (registry_file == NULL) {
         puts(EX_FILE_ERROR);
+        destroy_wal(wal);
         return;
     }
 
     // Open index_file
-    FILE* index_file = fopen(args->secondary_file, "rb+");
+    FILE* index_file = open_batch_file(wal, args->secondary_file);
     if (index_file == NULL) {
         puts(EX_FILE_ERROR);
+        destroy_wal(wal);
         return;
     }
 
@@ -567,11 +1368,18 @@ void c_insert_registry(CommandArgs* args) {
         puts(EX_FILE_ERROR);
         fclose(registry_file);
         fclose(index_file);
+        destroy_wal(wal);
         destroy_header(header);
         destroy_index_header(index_header);
         return;
     }
 
+    // Removed registries are found through the free space map (variable length files)
+    header->free_space_map = load_free_space_map(header, registry_file, args->primary_file);
+
+    // Checkpoints are only caught up if they were saved for the file as it is before the batch
+    CheckpointFingerprint fingerprint = checkpoint_fingerprint(header, registry_file);
+
     // Update registry header status
     set_header_status(header, STATUS_BAD);
     fseek(registry_file, 0, SEEK_SET);
@@ -581,12 +1389,32 @@ void c_insert_registry(CommandArgs* args) {
     set_index_status(index_header, STATUS_BAD);
     write_index_status(index_header, index_file);
 
+    // Free slots are handed out in file order through the free slot bitmap (fixed length files, the stack might be
+    // relinked, so only once the file is marked as being changed)
+    header->free_slot_bitmap = load_free_slot_bitmap(header, registry_file, args->primary_file);
+
     Registry* registry = build_registry(header);
 
-    // Do each insertion in the given order
+    // Drop duplicated insertions up front, in a single ordered pass over the index
+    bool* accepted = accept_insertions(index_header, insertion_args);
+
+    // Slots are assigned in the given order, but only written once the whole batch is planned
+    InsertionPlan* plan = new_insertion_plan(header, registry_file);
+
+    // Free slots (fixed length files) are all taken at once, lowest first
+    size_t n_accepted = 0;
+    for (uint32_t i = 0; i < insertion_args->n_insertions; i++) {
+        n_accepted += accepted[i];
+    }
+    reserve_free_slots(plan, n_accepted);
+
     for (uint32_t i = 0; i < insertion_args->n_insertions; i++) {
         InsertionTarget current_insertion = insertion_args->insertion_targets[i];
 
+        if (!accepted[i]) {
+            continue;
+        }
+
         // Load registry with insertion data //
         setup_registry(registry);
         registry->registry_content->id = current_insertion.id;
@@ -633,17 +1461,22 @@ void c_insert_registry(CommandArgs* args) {
             registry->registry_content->modelo[len_modelo] = '\0';
         }
 
-        // Check for already existing ID
-        if (index_query(index_header, current_insertion.id).id == -1) {
-            // Write the registry
-            add_registry(header, registry, registry_file);
-            // Update the index
-            index_add(index_header, registry->registry_content->id, (int64_t) get_registry_reference(header, registry->offset));
-        }
+        // Plan the registry's slot
+        plan_insertion(plan, registry);
+        // Update the index
+        index_add(index_header, registry->registry_content->id, (int64_t) registry_reference(header, registry));
     }
 
+    // Write the planned registries
+    apply_insertion_plan(plan);
+
     // Cleanup
+    destroy_insertion_plan(plan);
     destroy_registry(registry);
+    free(accepted);
+
+    // Keep checkpoints current with appended registries
+    sync_checkpoint_index(header, registry_file, args->primary_file, fingerprint);
 
     // Update registry header
     set_header_status(header, STATUS_GOOD);
@@ -659,11 +1492,14 @@ void c_insert_registry(CommandArgs* args) {
     write_index_status(index_header, index_file);
 
     // Cleanup
-    destroy_header(header);
     destroy_index_header(index_header);
     fclose(registry_file);
     fclose(index_file);
 
+    // Apply the journaled batch before the files are read back
+    finish_batch(wal, header, args->primary_file);
+    destroy_header(header);
+
     // Autocorrection stuff
     print_autocorrection_checksum(args->primary_file);
     print_autocorrection_checksum(args->secondary_file);
@@ -789,10 +1625,10 @@ bool execute_update(Header* header, Registry* registry, UpdateTarget* current_up
     if (reindex) {
         // ID changed, so we need to remove the old one from the index and insert a new one
         index_remove(index_header, old_id);
-        index_add(index_header, registry->registry_content->id, (int64_t) get_registry_reference(header, registry->offset));
+        index_add(index_header, registry->registry_content->id, (int64_t) registry_reference(header, registry));
     } else if (rereference) {
         // ID is the same, but the offset changed, so we need to update the index reference
-        index_update(index_header, registry->registry_content->id, (int64_t) get_registry_reference(header, registry->offset));
+        index_update(index_header, registry->registry_content->id, (int64_t) registry_reference(header, registry));
     }
 
     return true;
@@ -809,17 +1645,22 @@ void c_update_registry(CommandArgs* args) {
 
     UpdateArgs* update_args = args->specific_data;
 
+    // Changes are journaled until the whole batch is done
+    WriteAheadLog* wal = begin_batch(args->primary_file);
+
     // Open registry_file
-    FILE* registry_file = fopen(args->primary_file, "rb+");
+    FILE* registry_file = open_batch_file(wal, args->primary_file);
     if (registry_file == NULL) {
         puts(EX_FILE_ERROR);
+        destroy_wal(wal);
         return;
     }
 
     // Open index_file
-    FILE* index_file = fopen(args->secondary_file, "rb+");
+    FILE* index_file = open_batch_file(wal, args->secondary_file);
     if (index_file == NULL) {
         puts(EX_FILE_ERROR);
+        destroy_wal(wal);
         return;
     }
 
@@ -836,11 +1677,18 @@ void c_update_registry(CommandArgs* args) {
         puts(EX_FILE_ERROR);
         fclose(registry_file);
         fclose(index_file);
+        destroy_wal(wal);
         destroy_header(header);
         destroy_index_header(index_header);
         return;
     }
 
+    // Removed registries are found through the free space map (variable length files)
+    header->free_space_map = load_free_space_map(header, registry_file, args->primary_file);
+
+    // Checkpoints are only caught up if they were saved for the file as it is before the batch
+    CheckpointFingerprint fingerprint = checkpoint_fingerprint(header, registry_file);
+
     // Update registry header status
     set_header_status(header, STATUS_BAD);
     fseek(registry_file, 0, SEEK_SET);
@@ -850,6 +1698,10 @@ void c_update_registry(CommandArgs* args) {
     set_index_status(index_header, STATUS_BAD);
     write_index_status(index_header, index_file);
 
+    // Free slots are handed out in file order through the free slot bitmap (fixed length files, the stack might be
+    // relinked, so only once the file is marked as being changed)
+    header->free_slot_bitmap = load_free_slot_bitmap(header, registry_file, args->primary_file);
+
     // Allocate registry
     Registry* registry = build_registry(header);
 
@@ -876,54 +1728,66 @@ void c_update_registry(CommandArgs* args) {
                 continue;
             }
 
-            // Load target registry
+            // Load target registry (only the filtered fields)
+            FilterProgram* program = compile_filter_program(current_update.unindexed_filter_args);
             seek_registry(header, registry_file, index_match.reference);
-            read_registry(registry, registry_file);
+            read_registry_projected(registry, registry_file, filter_program_fields(program));
 
             // If registry is not present or filters don't match, skip
-            if (is_registry_removed(registry) || !registry_filter_match(registry, current_update.unindexed_filter_args)) {
+            RegistryView view;
+            view_from_registry(&view, registry);
+            bool matched = filter_program_match(program, &view);
+            destroy_filter_program(program);
+
+            if (!matched) {
                 continue;
             }
 
+            // Decode the remaining fields before updating
+            read_registry_remaining(registry, registry_file);
+
             // Execute the update
             execute_update(header, registry, &current_update, registry_file, index_header);
         } else {
             // Non-indexed cases //
 
-            // Go to top of the registry for iteration
-            go_to_offset(first_registry_offset, registry_file);
-            size_t read_bytes_registry = first_registry_offset;
-            // Max iteration offset
-            size_t max_offset = get_max_offset(header);
+            // Iterate from the top of the registry (the file is modified during the scan, so no mapping here)
+            RegistryScanner* scanner = new_registry_scanner(header, registry_file, first_registry_offset, SM_STDIO);
+            RegistryView view;
 
-            // Filters
-            FilterArgs* filter_args = current_update.unindexed_filter_args;
+            // Filters (compiled once for the whole scan)
+            FilterProgram* program = compile_filter_program(current_update.unindexed_filter_args);
 
             // Loop each registry until reaching the file limit
-            while (read_bytes_registry < max_offset) {
-                // Read the current registry
-                read_bytes_registry += read_registry(registry, registry_file);
-
+            while (scanner_next_view(scanner, &view)) {
                 // On read failure, removal or no filter match, skip
-                if (registry == NULL || is_registry_removed(registry) || !registry_filter_match(registry, filter_args)) {
+                if (!filter_program_match(program, &view)) {
                     continue;
                 }
 
-                // Store current offset for later recovery
-                size_t cur_offset = current_offset(registry_file);
+                // Materialize the matched registry
+                go_to_offset(view.offset, registry_file);
+                read_registry(registry, registry_file);
 
                 // Execute the update
                 execute_update(header, registry, &current_update, registry_file, index_header);
 
                 // Recover to iteration position
-                go_to_offset(cur_offset, registry_file);
+                go_to_offset(scanner->offset, registry_file);
             }
+
+            // Cleanup
+            destroy_filter_program(program);
+            destroy_registry_scanner(scanner);
         }
     }
 
     // Cleanup
     destroy_registry(registry);
 
+    // Keep checkpoints current with appended registries
+    sync_checkpoint_index(header, registry_file, args->primary_file, fingerprint);
+
     // Update registry header
     set_header_status(header, STATUS_GOOD);
     fseek(registry_file, 0, SEEK_SET);
@@ -938,11 +1802,14 @@ void c_update_registry(CommandArgs* args) {
     write_index_status(index_header, index_file);
 
     // Cleanup
-    destroy_header(header);
     destroy_index_header(index_header);
     fclose(registry_file);
     fclose(index_file);
 
+    // Apply the journaled batch before the files are read back
+    finish_batch(wal, header, args->primary_file);
+    destroy_header(header);
+
     // Autocorrection stuff
     print_autocorrection_checksum(args->primary_file);
     print_autocorrection_checksum(args->secondary_file);
@@ -1005,7 +1872,9 @@ void c_query_index_registry(CommandArgs* args) {
 
         // If registry is not present skip
         if (!is_registry_removed(registry)) {
-            print_registry(header, registry);
+            ResultWriter* writer = new_result_writer(stdout, get_output_format_setting());
+            print_registry(writer, header, registry);
+            destroy_result_writer(writer);
         } else {// Should never hit this else, since the registry won't be on the index, but...
             puts(EX_REGISTRY_NOT_FOUND);
         }
@@ -1023,69 +1892,668 @@ void c_query_index_registry(CommandArgs* args) {
     fclose(index_file);
 }
 
+/**
+ * Rewrites a data file with its live registries only (back to back, without free space) and rebuilds its index with
+ * the new references on the same pass, the new files replace the old ones at once
+ * @param args command args (data file, index file and index type)
+ * @param reclaimed_bytes where the amount of bytes freed will be stored
+ * @return if the files were compacted
+ */
+static bool compact_registry_file(CommandArgs* args, size_t* reclaimed_bytes) {
+    *reclaimed_bytes = 0;
+
+    // Open registry_file
+    FILE* registry_file = fopen(args->primary_file, "rb");
+    if (registry_file == NULL) {
+        return false;
+    }
+
+    // Allocate and read header
+    Header* header = build_header(args->registry_type);
+    size_t read_bytes = read_header(header, registry_file);
+
+    // Check for read failure or bad status
+    if (read_bytes == 0 || get_header_status(header) == STATUS_BAD) {
+        fclose(registry_file);
+        destroy_header(header);
+        return false;
+    }
+
+    // Both files are rebuilt aside, the originals are untouched until the swap
+    FileSwap* swap = new_file_swap(args->primary_file);
+    FILE* dest_file = swap_fopen(swap, args->primary_file);
+    FILE* index_file = dest_file == NULL ? NULL : swap_fopen(swap, args->secondary_file);
+    if (index_file == NULL) {
+        if (dest_file != NULL) {
+            fclose(dest_file);
+        }
+        destroy_file_swap(swap);
+        fclose(registry_file);
+        destroy_header(header);
+        return false;
+    }
+
+    // Same header content, no registries yet
+    Header* compacted_header = build_header(args->registry_type);
+    fseek(registry_file, 0, SEEK_SET);
+    read_header(compacted_header, registry_file);
+    reset_header_registries(compacted_header);
+    set_header_status(compacted_header, STATUS_BAD);
+    write_header(compacted_header, dest_file);
+
+    // Create index header (with a bad status until it's completely written)
+    IndexHeader* index_header = new_index(args->registry_type, args->index_type);
+    set_index_status(index_header, STATUS_BAD);
+    write_index_status(index_header, index_file);
+    set_index_file(index_header, index_file);
+    uint32_t fill_factor;
+    ExternalSorter* index_sorter = new_index_build_sorter(args->index_type, &fill_factor);
+
+    // Variable length files get their checkpoints rebuilt
+    CheckpointIndex* checkpoints = NULL;
+    if (args->registry_type == RT_VAR_LEN) {
+        size_t interval = get_size_setting(SETTING_CHECKPOINT_INTERVAL, DEFAULT_CHECKPOINT_INTERVAL, 1, INT32_MAX);
+        checkpoints = new_checkpoint_index((int32_t) interval, current_offset(dest_file));
+    }
+
+    // Live registries are appended exactly like an ingest does
+    OutputBuffer* output = new_output_buffer(dest_file, DEFAULT_OUTPUT_BUFFER_SIZE);
+    CSVParseArgs compact_args = {
+            compacted_header,
+            NULL,
+            output,
+            checkpoints,
+            index_header,
+            index_sorter,
+            false,
+            0,
+            new_slotted_page(args->registry_type)};
+
+    Registry* registry = build_registry(header);
+    RegistryScanner* scanner = new_registry_scanner(header, registry_file, read_bytes, SM_BLOCK);
+    while (!compact_args.index_failed && scanner_next(scanner, registry)) {
+        if (is_registry_removed(registry)) {
+            continue;
+        }
+
+        // Slotted registries are packed into pages
+        if (compact_args.page != NULL) {
+            append_slotted_registry(&compact_args, registry);
+            continue;
+        }
+
+        // Drops the free space left by reused slots
+        reset_registry_metadata(registry);
+
+        size_t size = encoded_registry_size(registry);
+        char* dest = output_buffer_reserve(output, size);
+        size_t offset = output_buffer_offset(output);
+        encode_registry(registry, dest, offset);
+        output_buffer_commit(output, size);
+
+        track_appended_registry(&compact_args, registry->registry_content->id, offset, size);
+    }
+
+    // Last page, not full
+    if (compact_args.page != NULL) {
+        flush_slotted_page(&compact_args);
+        free(compact_args.page);
+    }
+
+    // Cleanup
+    destroy_registry_scanner(scanner);
+    destroy_registry(registry);
+    destroy_output_buffer(output);
+    fclose(registry_file);
+
+    // Build the whole index at once
+    bool bulk_loaded = index_sorter != NULL;
+    if (bulk_loaded && !compact_args.index_failed) {
+        external_sorter_finish(index_sorter);
+        compact_args.index_failed = !index_bulk_load(index_header, index_sorter, fill_factor);
+    }
+    destroy_external_sorter(index_sorter);
+    index_file = get_index_file(index_header);
+
+    // Write index (bulk loads already wrote it)
+    if (!bulk_loaded && !compact_args.index_failed) {
+        write_index(index_header, index_file);
+        index_file = get_index_file(index_header);
+    }
+
+    // Update statuses
+    bool success = !compact_args.index_failed;
+    if (success) {
+        set_index_status(index_header, STATUS_GOOD);
+        write_index_status(index_header, index_file);
+
+        set_header_status(compacted_header, STATUS_GOOD);
+        fseek(dest_file, 0, SEEK_SET);
+        write_header(compacted_header, dest_file);
+
+        // Tie the checkpoints to the compacted file
+        if (checkpoints != NULL) {
+            checkpoints->fingerprint = checkpoint_fingerprint(compacted_header, dest_file);
+        }
+    }
+
+    success = fclose(dest_file) == 0 && success;
+    success = fclose(index_file) == 0 && success;
+    destroy_index_header(index_header);
+
+    if (success) {
+        // Old checkpoints, free space map and free slot bitmap point into the replaced file
+        char* checkpoint_path = checkpoint_file_path(args->primary_file);
+        remove(checkpoint_path);
+        free(checkpoint_path);
+        char* free_space_path = free_space_map_path(args->primary_file);
+        remove(free_space_path);
+        free(free_space_path);
+        char* free_slot_path = free_slot_bitmap_path(args->primary_file);
+        remove(free_slot_path);
+        free(free_slot_path);
+
+        success = commit_file_swap(swap);
+    }
+    destroy_file_swap(swap);
+
+    if (success) {
+        *reclaimed_bytes = get_max_offset(header) - get_max_offset(compacted_header);
+        if (checkpoints != NULL) {
+            save_checkpoint_index(checkpoints, args->primary_file);
+        }
+    }
+
+    // Cleanup
+    destroy_checkpoint_index(checkpoints);
+    destroy_header(compacted_header);
+    destroy_header(header);
+
+    return success;
+}
+
+/**
+ * Compacts a data file (dropping removed registries and free space) and rebuilds its index
+ * @param args command args
+ */
+void c_compact_registry(CommandArgs* args) {
+    ex_assert(args->primary_file != NULL, EX_COMMAND_PARSE_ERROR);
+    ex_assert(args->secondary_file != NULL, EX_COMMAND_PARSE_ERROR);
+
+    size_t reclaimed_bytes;
+    if (!compact_registry_file(args, &reclaimed_bytes)) {
+        puts(EX_FILE_ERROR);
+        return;
+    }
+
+    printf("Bytes recuperados: %zu\n", reclaimed_bytes);
+
+    // Autocorrection stuff
+    print_autocorrection_checksum(args->primary_file);
+    print_autocorrection_checksum(args->secondary_file);
+}
+
+/**
+ * Prints the space usage of a data file (live and dead bytes, removed registries sizes and list length)
+ * @param args command args
+ */
+void c_registry_stats(CommandArgs* args) {
+    ex_assert(args->primary_file != NULL, EX_COMMAND_PARSE_ERROR);
+
+    // Open registry_file
+    FILE* registry_file = fopen(args->primary_file, "rb");
+    if (registry_file == NULL) {
+        puts(EX_FILE_ERROR);
+        return;
+    }
+
+    // Allocate and read header
+    Header* header = build_header(args->registry_type);
+    size_t first_registry_offset = read_header(header, registry_file);
+
+    // Check for read failure or bad status
+    if (first_registry_offset == 0 || get_header_status(header) == STATUS_BAD) {
+        puts(EX_FILE_ERROR);
+        fclose(registry_file);
+        destroy_header(header);
+        return;
+    }
+
+    RegistryStats stats;
+    collect_registry_stats(&stats, header, registry_file, first_registry_offset);
+
+    printf("Registros: %u\n", stats.n_live);
+    printf("Bytes de registros: %zu\n", stats.live_bytes);
+    printf("Bytes de preenchimento: %zu\n", stats.filler_bytes);
+    printf("Registros removidos: %u\n", stats.n_removed);
+    printf("Bytes de registros removidos: %zu\n", stats.removed_bytes);
+    printf("Bytes mortos: %zu (%.2f%%)\n", stats_dead_bytes(&stats), stats_dead_ratio(&stats));
+
+    if (stats.free_list_length == -1) {
+        puts("Lista de removidos: corrompida");
+    } else {
+        printf("Lista de removidos: %lld\n", (long long) stats.free_list_length);
+    }
+
+    // Only the non-empty buckets
+    for (uint32_t i = 0; i < STATS_HOLE_BUCKETS; i++) {
+        if (stats.hole_histogram[i] == 0) {
+            continue;
+        }
+
+        if (i == STATS_HOLE_BUCKETS - 1) {
+            printf("Removidos com %zu bytes ou mais: %u\n", (size_t) 1 << i, stats.hole_histogram[i]);
+        } else {
+            printf("Removidos com %zu a %zu bytes: %u\n", (size_t) 1 << i, ((size_t) 1 << (i + 1)) - 1, stats.hole_histogram[i]);
+        }
+    }
+
+    // Cleanup
+    destroy_header(header);
+    fclose(registry_file);
+}
+
+/**
+ * Converts a data file into a columnar file holding its live registries (segments of SETTING_COLUMN_SEGMENT_ROWS rows)
+ * @param args command args
+ */
+void c_convert_to_columnar(CommandArgs* args) {
+    ex_assert(args->primary_file != NULL, EX_COMMAND_PARSE_ERROR);
+    ex_assert(args->secondary_file != NULL, EX_COMMAND_PARSE_ERROR);
+
+    // Open registry_file
+    FILE* registry_file = fopen(args->primary_file, "rb");
+    if (registry_file == NULL) {
+        puts(EX_FILE_ERROR);
+        return;
+    }
+
+    // Allocate and read header
+    Header* header = build_header(args->registry_type);
+    size_t first_registry_offset = read_header(header, registry_file);
+
+    // Check for read failure or bad status
+    if (first_registry_offset == 0 || get_header_status(header) == STATUS_BAD) {
+        puts(EX_FILE_ERROR);
+        fclose(registry_file);
+        destroy_header(header);
+        return;
+    }
+
+    // Open column_file
+    FILE* column_file = create_file(args->secondary_file, "wb");
+    if (column_file == NULL) {
+        puts(EX_FILE_ERROR);
+        fclose(registry_file);
+        destroy_header(header);
+        return;
+    }
+
+    // Mark the columnar file as unstable until every segment is written
+    ColumnFileHeader* column_header = new_column_file_header(args->registry_type);
+    memcpy(column_header->header_content, header->header_content, sizeof(struct HeaderContent));
+    column_header->status = STATUS_BAD;
+    write_column_file_header(column_header, column_file);
+
+    size_t segment_rows = get_size_setting(SETTING_COLUMN_SEGMENT_ROWS, DEFAULT_COLUMN_SEGMENT_ROWS, 1, MAX_COLUMN_SEGMENT_ROWS);
+    ColumnWriter* writer = new_column_writer(column_header, column_file, (uint32_t) segment_rows);
+
+    RegistryScanner* scanner = new_registry_scanner(header, registry_file, first_registry_offset, SM_MMAP);
+    RegistryView view;
+
+    // Removed registries (and slotted page bookkeeping) are left out
+    while (scanner_next_view(scanner, &view)) {
+        if (!view.removed) {
+            column_writer_append(writer, &view);
+        }
+    }
+
+    column_writer_flush(writer);
+
+    // Write the final header
+    column_header->status = STATUS_GOOD;
+    fseek(column_file, 0, SEEK_SET);
+    write_column_file_header(column_header, column_file);
+
+    // Cleanup
+    destroy_registry_scanner(scanner);
+    destroy_column_writer(writer);
+    destroy_column_file_header(column_header);
+    destroy_header(header);
+    fclose(registry_file);
+    fclose(column_file);
+
+    print_autocorrection_checksum(args->secondary_file);
+}
+
+/**
+ * Filter and print the registries of a columnar file, only the filtered columns are read for every registry and the
+ * remaining ones are loaded for the matching registries' segments
+ * @param args command args
+ */
+void c_columnar_filter_and_print(CommandArgs* args) {
+    ex_assert(args->primary_file != NULL, EX_COMMAND_PARSE_ERROR);
+
+    // Extract filters from args (and type-cast it)
+    FilterArgs* filters = args->specific_data;
+
+    // Open source file
+    FILE* file = fopen(args->primary_file, "rb");
+    if (file == NULL) {
+        puts(EX_FILE_ERROR);
+        return;
+    }
+
+    // Allocate and read header
+    ColumnFileHeader* column_header = new_column_file_header(args->registry_type);
+    size_t read_bytes = read_column_file_header(column_header, file);
+
+    // Check for read failure, bad status or a file converted from another type
+    if (read_bytes == 0 || column_header->status == STATUS_BAD || column_header->tipoOrigem != (int32_t) args->registry_type) {
+        puts(EX_FILE_ERROR);
+        destroy_column_file_header(column_header);
+        fclose(file);
+        return;
+    }
+
+    // Registries print with the source file's header content
+    Header* header = build_header(args->registry_type);
+    memcpy(header->header_content, column_header->header_content, sizeof(struct HeaderContent));
+
+    FilterProgram* program = compile_filter_program(filters);
+    ResultWriter* writer = new_result_writer(stdout, get_output_format_setting());
+    bool printed = false;
+
+    ColumnScanner* scanner = new_column_scanner(column_header, file, read_bytes, filter_program_fields(program));
+    RegistryView view;
+
+    while (column_scanner_next_view(scanner, &view)) {
+        if (!filter_program_match(program, &view)) {
+            continue;
+        }
+
+        column_scanner_materialize(scanner, FM_ALL, &view);
+        print_registry_view(writer, header, &view);
+        printed = true;
+    }
+
+    destroy_column_scanner(scanner);
+    destroy_filter_program(program);
+    destroy_result_writer(writer);
+
+    // No registry found
+    if (!printed) {
+        puts(EX_REGISTRY_NOT_FOUND);
+    }
+
+    // Cleanup
+    destroy_header(header);
+    destroy_column_file_header(column_header);
+    fclose(file);
+}
+
+/**
+ * Compacts the command's data file (rebuilding its index) once its dead space crosses SETTING_AUTO_COMPACT, silently
+ * (the batch's own output is kept as is)
+ * @param args command args (of an insert, update or remove batch)
+ */
+void c_auto_compact_registry(CommandArgs* args) {
+    size_t threshold = get_size_setting(SETTING_AUTO_COMPACT, 0, 0, 100);
+    if (threshold == 0 || args->primary_file == NULL || args->secondary_file == NULL) {
+        return;
+    }
+
+    // A batch the command couldn't commit is settled before anything is measured
+    if (!recover_interrupted_batch(args)) {
+        return;
+    }
+
+    FILE* registry_file = fopen(args->primary_file, "rb");
+    if (registry_file == NULL) {
+        return;
+    }
+
+    Header* header = build_header(args->registry_type);
+    size_t first_registry_offset = read_header(header, registry_file);
+
+    bool fragmented = false;
+    if (first_registry_offset != 0 && get_header_status(header) != STATUS_BAD) {
+        RegistryStats stats;
+        collect_registry_stats(&stats, header, registry_file, first_registry_offset);
+        fragmented = stats_dead_bytes(&stats) > 0 && stats_dead_ratio(&stats) >= (double) threshold;
+    }
+
+    destroy_header(header);
+    fclose(registry_file);
+
+    if (fragmented) {
+        size_t reclaimed_bytes;
+        compact_registry_file(args, &reclaimed_bytes);
+    }
+}
+
 // Utils //
 
 /**
  * Print a fixed length string
+ * @param writer destination writer
  * @param desc target string
  * @param n string length
  */
-void print_fixed_len_str(char* desc, size_t n) {
-    for (size_t i = 0; i < n; i++) {
-        putchar(desc[i]);
-    }
+void print_fixed_len_str(ResultWriter* writer, char* desc, size_t n) {
+    writer_write(writer, desc, n);
 }
 
 /**
- * Print a given type 1 registry into stdout
- *
+ * Print a non-null string field (up to its first NULL byte)
+ * @param writer destination writer
+ * @param slice the field
+ */
+static void print_str_field(ResultWriter* writer, StrSlice slice) {
+    writer_write(writer, slice.data, str_slice_length(slice));
+}
+
+/**
+ * Print a registry view on the human-readable layout
+ * @param writer destination writer
  * @param header current file header
- * @param registry current registry
+ * @param view current registry view
  */
-void print_registry(Header* header, Registry* registry) {
+static void print_registry_view_text(ResultWriter* writer, Header* header, RegistryView* view) {
     HeaderContent* header_content = header->header_content;
-    RegistryContent* registry_content = registry->registry_content;
     // Marca
-    print_column_description(header_content->desC6);
-    if (registry_content->marca == NULL) {
-        puts(NULL_FIELD_REPR);
+    print_column_description(writer, header_content->desC6);
+    if (view->marca.data == NULL) {
+        writer_puts(writer, NULL_FIELD_REPR);
     } else {
-        printf("%s\n", registry_content->marca);
+        print_str_field(writer, view->marca);
     }
+    writer_putc(writer, '\n');
 
     // Modelo
-    print_column_description(header_content->desC7);
-    if (registry_content->modelo == NULL) {
-        puts(NULL_FIELD_REPR);
+    print_column_description(writer, header_content->desC7);
+    if (view->modelo.data == NULL) {
+        writer_puts(writer, NULL_FIELD_REPR);
     } else {
-        printf("%s\n", registry_content->modelo);
+        print_str_field(writer, view->modelo);
     }
+    writer_putc(writer, '\n');
 
     // Ano Fabricacao
-    print_column_description(header_content->desC2);
-    if (registry_content->ano == -1) {
-        puts(NULL_FIELD_REPR);
+    print_column_description(writer, header_content->desC2);
+    if (view->ano == -1) {
+        writer_puts(writer, NULL_FIELD_REPR);
     } else {
-        printf("%d\n", registry_content->ano);
+        writer_put_int32(writer, view->ano);
     }
+    writer_putc(writer, '\n');
 
     // Cidade
-    print_column_description(header_content->desC5);
-    if (registry_content->cidade == NULL) {
-        puts(NULL_FIELD_REPR);
+    print_column_description(writer, header_content->desC5);
+    if (view->cidade.data == NULL) {
+        writer_puts(writer, NULL_FIELD_REPR);
     } else {
-        printf("%s\n", registry_content->cidade);
+        print_str_field(writer, view->cidade);
     }
+    writer_putc(writer, '\n');
 
     // Qtt
-    print_column_description(header_content->desC3);
-    if (registry_content->qtt == -1) {
-        puts(NULL_FIELD_REPR);
+    print_column_description(writer, header_content->desC3);
+    if (view->qtt == -1) {
+        writer_puts(writer, NULL_FIELD_REPR);
     } else {
-        printf("%d\n", registry_content->qtt);
+        writer_put_int32(writer, view->qtt);
+    }
+    writer_putc(writer, '\n');
+
+    writer_putc(writer, '\n');
+}
+
+/**
+ * Print a TSV string field (null fields are left empty, tabs, line breaks and backslashes are escaped)
+ * @param writer destination writer
+ * @param slice the field
+ */
+static void print_tsv_str_field(ResultWriter* writer, StrSlice slice) {
+    if (slice.data == NULL) {
+        return;
+    }
+
+    size_t len = str_slice_length(slice);
+    size_t plain_begin = 0;
+    for (size_t i = 0; i < len; i++) {
+        char escaped = slice.data[i] == '\t' ? 't' : slice.data[i] == '\n' ? 'n' : slice.data[i] == '\r' ? 'r' : slice.data[i] == '\\' ? '\\' : '\0';
+        if (escaped == '\0') {
+            continue;
+        }
+
+        writer_write(writer, slice.data + plain_begin, i - plain_begin);
+        writer_putc(writer, '\\');
+        writer_putc(writer, escaped);
+        plain_begin = i + 1;
+    }
+    writer_write(writer, slice.data + plain_begin, len - plain_begin);
+}
+
+/**
+ * Print a TSV numeric field (null fields are left empty)
+ * @param writer destination writer
+ * @param value the field
+ */
+static void print_tsv_int32_field(ResultWriter* writer, int32_t value) {
+    if (value != -1) {
+        writer_put_int32(writer, value);
+    }
+}
+
+/**
+ * Print a registry view as a TSV line (the column names line is printed before the first registry)
+ * @param writer destination writer
+ * @param view current registry view
+ */
+static void print_registry_view_tsv(ResultWriter* writer, RegistryView* view) {
+    if (writer->n_rows == 0) {
+        const char* column_names[] = {ID_FIELD_NAME, ANO_FIELD_NAME, QTT_FIELD_NAME, SIGLA_FIELD_NAME, CIDADE_FIELD_NAME, MARCA_FIELD_NAME, MODELO_FIELD_NAME};
+        for (size_t i = 0; i < sizeof(column_names) / sizeof(char*); i++) {
+            if (i > 0) {
+                writer_putc(writer, '\t');
+            }
+            writer_puts(writer, column_names[i]);
+        }
+        writer_putc(writer, '\n');
+    }
+
+    print_tsv_int32_field(writer, view->id);
+    writer_putc(writer, '\t');
+    print_tsv_int32_field(writer, view->ano);
+    writer_putc(writer, '\t');
+    print_tsv_int32_field(writer, view->qtt);
+    writer_putc(writer, '\t');
+
+    // Sigla (filler bytes are omitted)
+    for (size_t i = 0; i < REGISTRY_SIGLA_SIZE && view->sigla[i] != FILLER_BYTE[0]; i++) {
+        writer_putc(writer, view->sigla[i]);
+    }
+    writer_putc(writer, '\t');
+
+    print_tsv_str_field(writer, view->cidade);
+    writer_putc(writer, '\t');
+    print_tsv_str_field(writer, view->marca);
+    writer_putc(writer, '\t');
+    print_tsv_str_field(writer, view->modelo);
+    writer_putc(writer, '\n');
+}
+
+/**
+ * Print a length-prefixed binary string field (int32 length, -1 for null fields, followed by the bytes)
+ * @param writer destination writer
+ * @param slice the field
+ */
+static void print_binary_str_field(ResultWriter* writer, StrSlice slice) {
+    int32_t len = slice.data == NULL ? -1 : (int32_t) str_slice_length(slice);
+    writer_write(writer, &len, sizeof(len));
+    if (len > 0) {
+        writer_write(writer, slice.data, (size_t) len);
     }
+}
 
-    putchar('\n');
+/**
+ * Print a registry view as a binary row: uint32 row size (excluding itself), int32 id, ano and qtt, 2 sigla bytes
+ * and the length-prefixed cidade, marca and modelo (native byte order, same as the data files)
+ * @param writer destination writer
+ * @param view current registry view
+ */
+static void print_registry_view_binary(ResultWriter* writer, RegistryView* view) {
+    size_t str_lens[] = {
+            view->cidade.data == NULL ? 0 : str_slice_length(view->cidade),
+            view->marca.data == NULL ? 0 : str_slice_length(view->marca),
+            view->modelo.data == NULL ? 0 : str_slice_length(view->modelo)};
+    uint32_t row_size = (uint32_t) (3 * sizeof(int32_t) + REGISTRY_SIGLA_SIZE + 3 * sizeof(int32_t) + str_lens[0] + str_lens[1] + str_lens[2]);
+
+    writer_write(writer, &row_size, sizeof(row_size));
+    writer_write(writer, &view->id, sizeof(view->id));
+    writer_write(writer, &view->ano, sizeof(view->ano));
+    writer_write(writer, &view->qtt, sizeof(view->qtt));
+    writer_write(writer, view->sigla, REGISTRY_SIGLA_SIZE);
+    print_binary_str_field(writer, view->cidade);
+    print_binary_str_field(writer, view->marca);
+    print_binary_str_field(writer, view->modelo);
+}
+
+/**
+ * Print a given type 1 registry into the writer
+ *
+ * @param writer destination writer
+ * @param header current file header
+ * @param registry current registry
+ */
+void print_registry(ResultWriter* writer, Header* header, Registry* registry) {
+    RegistryView view;
+    view_from_registry(&view, registry);
+    print_registry_view(writer, header, &view);
+}
+
+/**
+ * Print a given registry view into the writer (on the writer's format)
+ *
+ * @param writer destination writer
+ * @param header current file header
+ * @param view current registry view
+ */
+void print_registry_view(ResultWriter* writer, Header* header, RegistryView* view) {
+    switch (writer->format) {
+        case OF_TEXT:
+            print_registry_view_text(writer, header, view);
+            break;
+        case OF_TSV:
+            print_registry_view_tsv(writer, view);
+            break;
+        case OF_BINARY:
+            print_registry_view_binary(writer, view);
+            break;
+    }
+
+    writer->n_rows++;
 }
 
 /**
@@ -1117,7 +2585,19 @@ int32_t parse_int32_filter(FilterArgs* filter) {
  * @return if registry matches the filters or not
  */
 bool registry_filter_match(Registry* registry, FilterArgs* filters) {
-    if (is_registry_removed(registry)) {
+    RegistryView view;
+    view_from_registry(&view, registry);
+    return registry_view_filter_match(&view, filters);
+}
+
+/**
+ * Checks if a registry view matches the given filter list
+ * @param view target registry view
+ * @param filters target filters
+ * @return if registry matches the filters or not
+ */
+bool registry_view_filter_match(RegistryView* view, FilterArgs* filters) {
+    if (view->removed) {
         return false;
     }
 
@@ -1125,30 +2605,29 @@ bool registry_filter_match(Registry* registry, FilterArgs* filters) {
         return true;
     }
 
-    RegistryContent* registry_content = registry->registry_content;
     FilterArgs* cur_filter = filters;
 
     while (cur_filter != NULL) {
         bool is_null = cur_filter->value == NULL || cur_filter->value[0] == '\0';
         if (strcmp(ID_FIELD_NAME, cur_filter->key) == 0) {// id
             int32_t id_filter = parse_int32_filter(cur_filter);
-            if (id_filter != registry_content->id) {
+            if (id_filter != view->id) {
                 return false;
             }
         } else if (strcmp(ANO_FIELD_NAME, cur_filter->key) == 0) {// ano
             int32_t ano_filter = parse_int32_filter(cur_filter);
-            if (ano_filter != registry_content->ano) {
+            if (ano_filter != view->ano) {
                 return false;
             }
         } else if (strcmp(QTT_FIELD_NAME, cur_filter->key) == 0) {// qtt
             int32_t qtt_filter = parse_int32_filter(cur_filter);
-            if (qtt_filter != registry_content->qtt) {
+            if (qtt_filter != view->qtt) {
                 return false;
             }
         } else if (strcmp(SIGLA_FIELD_NAME, cur_filter->key) == 0) {// sigla
             // In case filter is NULL, check sigla for null value
             if (cur_filter->value == NULL) {
-                if (registry_content->sigla[0] != '$') {
+                if (view->sigla[0] != '$') {
                     return false;
                 }
             } else {
@@ -1160,41 +2639,41 @@ bool registry_filter_match(Registry* registry, FilterArgs* filters) {
 
                 // compare char-by-char sigla and filter (if filter is smaller, ensure remaining bytes are NULL)
                 for (size_t i = 0; i < REGISTRY_SIGLA_SIZE; i++) {
-                    if (i >= len && registry_content->sigla[i] != FILLER_BYTE[0]) {
+                    if (i >= len && view->sigla[i] != FILLER_BYTE[0]) {
                         return false;
-                    } else if (cur_filter->value[i] != registry_content->sigla[i]) {
+                    } else if (cur_filter->value[i] != view->sigla[i]) {
                         return false;
                     }
                 }
             }
         } else if (strcmp(CIDADE_FIELD_NAME, cur_filter->key) == 0) {// cidade
             // Check for null fields
-            if (is_null || registry_content->cidade == NULL) {
+            if (is_null || view->cidade.data == NULL) {
                 // Check for non-matching null fields
-                if ((is_null && registry_content->cidade != NULL) || (registry_content->cidade == NULL && !is_null)) {
+                if ((is_null && view->cidade.data != NULL) || (view->cidade.data == NULL && !is_null)) {
                     return false;
                 }
-            } else if (strcmp(cur_filter->value, registry_content->cidade) != 0) {// Compare non-null values directly
+            } else if (!str_slice_equals(view->cidade, cur_filter->value)) {// Compare non-null values directly
                 return false;
             }
         } else if (strcmp(MARCA_FIELD_NAME, cur_filter->key) == 0) {// marca
             // Check for null fields
-            if (is_null || registry_content->marca == NULL) {
+            if (is_null || view->marca.data == NULL) {
                 // Check for non-matching null fields
-                if ((is_null && registry_content->marca != NULL) || (registry_content->marca == NULL && !is_null)) {
+                if ((is_null && view->marca.data != NULL) || (view->marca.data == NULL && !is_null)) {
                     return false;
                 }
-            } else if (strcmp(cur_filter->value, registry_content->marca) != 0) {// Compare non-null values directly
+            } else if (!str_slice_equals(view->marca, cur_filter->value)) {// Compare non-null values directly
                 return false;
             }
         } else if (strcmp(MODELO_FIELD_NAME, cur_filter->key) == 0) {// modelo
             // Check for null fields
-            if (is_null || registry_content->modelo == NULL) {
+            if (is_null || view->modelo.data == NULL) {
                 // Check for non-matching null fields
-                if ((is_null && registry_content->modelo != NULL) || (registry_content->modelo == NULL && !is_null)) {
+                if ((is_null && view->modelo.data != NULL) || (view->modelo.data == NULL && !is_null)) {
                     return false;
                 }
-            } else if (strcmp(cur_filter->value, registry_content->modelo) != 0) {// Compare non-null values directly
+            } else if (!str_slice_equals(view->modelo, cur_filter->value)) {// Compare non-null values directly
                 return false;
             }
         }
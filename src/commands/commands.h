@@ -8,13 +8,17 @@
 
 #include "../struct/registry.h"
 #include "../struct/registry_content.h"
+#include "../struct/registry_view.h"
 #include "../struct/t1_registry.h"
 #include "../struct/t2_registry.h"
+#include "../utils/result_writer.h"
 #include "common.h"
 
 // Commands //
 /**
  * Parse csv file and build registry
+ *
+ * Commands 16 and 17 also build the index on the same pass (both files are only marked good at the end)
  * @param args command args
  */
 void c_parse_and_serialize(CommandArgs* args);
@@ -27,6 +31,8 @@ void c_deserialize_and_print(CommandArgs* args);
 
 /**
  * Deserialize a registry and print everyone matching the given filter
+ *
+ * Commands with an index (14 and 15) look up filters on the id straight on the index, falling back to a full scan
  * @param args command args
  */
 void c_deserialize_filter_and_print(CommandArgs* args);
@@ -67,21 +73,71 @@ void c_update_registry(CommandArgs* args);
  */
 void c_query_index_registry(CommandArgs* args);
 
+/**
+ * Compacts a data file (dropping removed registries and free space) and rebuilds its index
+ * @param args command args
+ */
+void c_compact_registry(CommandArgs* args);
+
+/**
+ * Prints the space usage of a data file (live and dead bytes, removed registries sizes and list length)
+ * @param args command args
+ */
+void c_registry_stats(CommandArgs* args);
+
+/**
+ * Converts a data file into a columnar file holding its live registries (segments of SETTING_COLUMN_SEGMENT_ROWS rows)
+ * @param args command args
+ */
+void c_convert_to_columnar(CommandArgs* args);
+
+/**
+ * Filter and print the registries of a columnar file, only the filtered columns are read for every registry and the
+ * remaining ones are loaded for the matching registries' segments
+ * @param args command args
+ */
+void c_columnar_filter_and_print(CommandArgs* args);
+
+/**
+ * Compacts the command's data file (rebuilding its index) once its dead space crosses SETTING_AUTO_COMPACT, silently
+ * (the batch's own output is kept as is)
+ * @param args command args (of an insert, update or remove batch)
+ */
+void c_auto_compact_registry(CommandArgs* args);
+
+/**
+ * Finishes any batch interrupted on the command's data file (replayed if it was committed, discarded otherwise)
+ * @param args command args
+ * @return if the files are settled (false when a committed batch couldn't be replayed, its log is kept)
+ */
+bool recover_interrupted_batch(CommandArgs* args);
+
 // Utilities //
 /**
  * Print a fixed length string
+ * @param writer destination writer
  * @param desc target string
  * @param n string length
  */
-void print_fixed_len_str(char* desc, size_t n);
+void print_fixed_len_str(ResultWriter* writer, char* desc, size_t n);
 
 /**
- * Print a given type 1 registry into stdout
+ * Print a given type 1 registry into the writer
  *
+ * @param writer destination writer
  * @param header current file header
  * @param registry current registry
  */
-void print_registry(Header* header, Registry* registry);
+void print_registry(ResultWriter* writer, Header* header, Registry* registry);
+
+/**
+ * Print a given registry view into the writer (on the writer's format)
+ *
+ * @param writer destination writer
+ * @param header current file header
+ * @param view current registry view
+ */
+void print_registry_view(ResultWriter* writer, Header* header, RegistryView* view);
 
 /**
  * Parse filter to int32
@@ -98,6 +154,14 @@ int32_t parse_int32_filter(FilterArgs* filter);
  */
 bool registry_filter_match(Registry* registry, FilterArgs* filters);
 
+/**
+ * Checks if a registry view matches the given filter list
+ * @param view target registry view
+ * @param filters target filters
+ * @return if registry matches the filters or not
+ */
+bool registry_view_filter_match(RegistryView* view, FilterArgs* filters);
+
 // Macros //
 // Macro for printing a column description
-#define print_column_description(desc) print_fixed_len_str(desc, sizeof(desc) / sizeof(char))
+#define print_column_description(writer, desc) print_fixed_len_str(writer, desc, sizeof(desc) / sizeof(char))
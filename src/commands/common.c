@@ -48,6 +48,9 @@ void destroy_command_args(CommandArgs* args) {
     if (args->specific_data != NULL) {
         switch (args->command) {
             case DESERIALIZE_FILTER_AND_PRINT:
+            case FILTER_AND_PRINT_WITH_LINEAR_INDEX:
+            case FILTER_AND_PRINT_WITH_BTREE_INDEX:
+            case COLUMNAR_FILTER_AND_PRINT:
                 destroy_filter_args((FilterArgs*) args->specific_data);
                 break;
 
@@ -56,6 +59,13 @@ void destroy_command_args(CommandArgs* args) {
                 free(args->specific_data);
                 break;
 
+            case PARSE_AND_SERIALIZE_WITH_LINEAR_INDEX:
+            case PARSE_AND_SERIALIZE_WITH_BTREE_INDEX:;
+                IngestArgs* ingest_args = args->specific_data;
+                free(ingest_args->index_file);
+                free(ingest_args);
+                break;
+
             case REMOVE_REGISTRY_WITH_LINEAR_INDEX:
             case REMOVE_REGISTRY_WITH_BTREE_INDEX:;
                 RemovalArgs* removal_args = args->specific_data;
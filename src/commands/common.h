@@ -14,6 +14,10 @@
 #define MIN_COMMAND 1
 #define MAX_COMMAND 10
 
+// Extension commands (kept apart from the original numbering)
+#define MIN_EXTENDED_COMMAND 14
+#define MAX_EXTENDED_COMMAND 22
+
 enum Command {
     PARSE_AND_SERIALIZE = 1,
     DESERIALIZE_AND_PRINT = 2,
@@ -29,7 +33,18 @@ enum Command {
     // Implementation not requested
     INSERT_REGISTRY_WITH_BTREE_INDEX = 11,
     REMOVE_REGISTRY_WITH_BTREE_INDEX = 12,
-    UPDATE_REGISTRY_WITH_BTREE_INDEX = 13
+    UPDATE_REGISTRY_WITH_BTREE_INDEX = 13,
+
+    // Extensions
+    FILTER_AND_PRINT_WITH_LINEAR_INDEX = 14,
+    FILTER_AND_PRINT_WITH_BTREE_INDEX = 15,
+    PARSE_AND_SERIALIZE_WITH_LINEAR_INDEX = 16,
+    PARSE_AND_SERIALIZE_WITH_BTREE_INDEX = 17,
+    COMPACT_REGISTRY_WITH_LINEAR_INDEX = 18,
+    COMPACT_REGISTRY_WITH_BTREE_INDEX = 19,
+    REGISTRY_STATS = 20,
+    CONVERT_TO_COLUMNAR = 21,
+    COLUMNAR_FILTER_AND_PRINT = 22
 };
 
 // Field names for input parsing
@@ -53,6 +68,10 @@ typedef struct CommandArgs {
     void* specific_data;
 } CommandArgs;
 
+typedef struct IngestArgs {
+    char* index_file;
+} IngestArgs;
+
 typedef struct SearchByRRNArgs {
     uint64_t rrn;
 } SearchByRRNArgs;
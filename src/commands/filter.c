@@ -0,0 +1,425 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "filter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define FILTER_X86_SIMD 1
+#endif
+
+/**
+ * Column-wise equality selection, clears the selected bits whose column value differs from the target
+ * @param column the column values (REGISTRY_BATCH_SIZE long)
+ * @param value target value
+ * @param selection the selection bitmap
+ * @param n_words amount of bitmap words to be evaluated
+ */
+typedef void (*SelectEqualsFunction)(const int32_t* column, int32_t value, uint64_t* selection, size_t n_words);
+
+/**
+ * Scalar column selection (fallback)
+ * @param column the column values (REGISTRY_BATCH_SIZE long)
+ * @param value target value
+ * @param selection the selection bitmap
+ * @param n_words amount of bitmap words to be evaluated
+ */
+static void select_equals_scalar(const int32_t* column, int32_t value, uint64_t* selection, size_t n_words) {
+    for (size_t word = 0; word < n_words; word++) {
+        if (selection[word] == 0) {
+            continue;
+        }
+
+        uint64_t mask = 0;
+        const int32_t* values = column + word * 64;
+        for (size_t i = 0; i < 64; i++) {
+            mask |= (uint64_t) (values[i] == value) << i;
+        }
+        selection[word] &= mask;
+    }
+}
+
+#ifdef FILTER_X86_SIMD
+/**
+ * SSE2 column selection (4 values per compare)
+ * @param column the column values (REGISTRY_BATCH_SIZE long)
+ * @param value target value
+ * @param selection the selection bitmap
+ * @param n_words amount of bitmap words to be evaluated
+ */
+__attribute__((target("sse2"))) static void select_equals_sse2(const int32_t* column, int32_t value, uint64_t* selection, size_t n_words) {
+    __m128i target = _mm_set1_epi32(value);
+    for (size_t word = 0; word < n_words; word++) {
+        if (selection[word] == 0) {
+            continue;
+        }
+
+        uint64_t mask = 0;
+        const int32_t* values = column + word * 64;
+        for (size_t i = 0; i < 64; i += 4) {
+            __m128i equals = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (values + i)), target);
+            mask |= (uint64_t) _mm_movemask_ps(_mm_castsi128_ps(equals)) << i;
+        }
+        selection[word] &= mask;
+    }
+}
+
+/**
+ * AVX2 column selection (8 values per compare)
+ * @param column the column values (REGISTRY_BATCH_SIZE long)
+ * @param value target value
+ * @param selection the selection bitmap
+ * @param n_words amount of bitmap words to be evaluated
+ */
+__attribute__((target("avx2"))) static void select_equals_avx2(const int32_t* column, int32_t value, uint64_t* selection, size_t n_words) {
+    __m256i target = _mm256_set1_epi32(value);
+    for (size_t word = 0; word < n_words; word++) {
+        if (selection[word] == 0) {
+            continue;
+        }
+
+        uint64_t mask = 0;
+        const int32_t* values = column + word * 64;
+        for (size_t i = 0; i < 64; i += 8) {
+            __m256i equals = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (values + i)), target);
+            mask |= (uint64_t) (uint32_t) _mm256_movemask_ps(_mm256_castsi256_ps(equals)) << i;
+        }
+        selection[word] &= mask;
+    }
+}
+#endif
+
+// Column selection implementation, resolved on the first compilation (before any scan thread exists)
+static SelectEqualsFunction select_equals = NULL;
+
+/**
+ * Picks the best column selection implementation for the running CPU (bounded by SETTING_SIMD_LEVEL)
+ * @return the selection function
+ */
+static SelectEqualsFunction resolve_select_equals() {
+    size_t simd_level = get_size_setting(SETTING_SIMD_LEVEL, 2, 0, 2);
+
+#ifdef FILTER_X86_SIMD
+    __builtin_cpu_init();
+    if (simd_level >= 2 && __builtin_cpu_supports("avx2")) {
+        return select_equals_avx2;
+    }
+    if (simd_level >= 1 && __builtin_cpu_supports("sse2")) {
+        return select_equals_sse2;
+    }
+#else
+    (void) simd_level;
+#endif
+
+    return select_equals_scalar;
+}
+
+/**
+ * Parse a numeric filter value (NULL or empty values are represented as -1, same as on the file)
+ * @param value the raw value
+ * @return the parsed value
+ */
+static int32_t parse_filter_int(const char* value) {
+    if (value == NULL || value[0] == '\0') {
+        return -1;
+    }
+    return (int32_t) strtol(value, NULL, 10);
+}
+
+/**
+ * Compiles a single filter
+ * @param filter target filter
+ * @param predicate output predicate
+ * @return if the filter was compiled (unknown fields are ignored)
+ */
+static bool compile_filter(FilterArgs* filter, FilterPredicate* predicate) {
+    bool is_null = filter->value == NULL || filter->value[0] == '\0';
+
+    predicate->operator= FO_EQUALS;
+    predicate->int_value = -1;
+    predicate->str_value = NULL;
+    predicate->str_len = 0;
+
+    if (strcmp(ID_FIELD_NAME, filter->key) == 0) {
+        predicate->field = FF_ID;
+        predicate->int_value = parse_filter_int(filter->value);
+    } else if (strcmp(ANO_FIELD_NAME, filter->key) == 0) {
+        predicate->field = FF_ANO;
+        predicate->int_value = parse_filter_int(filter->value);
+    } else if (strcmp(QTT_FIELD_NAME, filter->key) == 0) {
+        predicate->field = FF_QTT;
+        predicate->int_value = parse_filter_int(filter->value);
+    } else if (strcmp(SIGLA_FIELD_NAME, filter->key) == 0) {
+        predicate->field = FF_SIGLA;
+        if (filter->value == NULL) {
+            predicate->operator= FO_IS_NULL;
+        } else if (strlen(filter->value) != REGISTRY_SIGLA_SIZE) {
+            // Only full siglas can ever match
+            predicate->operator= FO_NEVER;
+        } else {
+            memcpy(predicate->sigla_value, filter->value, REGISTRY_SIGLA_SIZE);
+        }
+    } else if (strcmp(CIDADE_FIELD_NAME, filter->key) == 0 || strcmp(MARCA_FIELD_NAME, filter->key) == 0 || strcmp(MODELO_FIELD_NAME, filter->key) == 0) {
+        if (strcmp(CIDADE_FIELD_NAME, filter->key) == 0) {
+            predicate->field = FF_CIDADE;
+        } else if (strcmp(MARCA_FIELD_NAME, filter->key) == 0) {
+            predicate->field = FF_MARCA;
+        } else {
+            predicate->field = FF_MODELO;
+        }
+
+        if (is_null) {
+            predicate->operator= FO_IS_NULL;
+        } else {
+            predicate->str_value = filter->value;
+            predicate->str_len = strlen(filter->value);
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Compiles a filter list into a predicate program (same semantics as registry_filter_match)
+ *
+ * The program references the filter values, so the filters must outlive it
+ * @param filters target filters (may be NULL, matching every registry)
+ * @return the compiled program
+ */
+FilterProgram* compile_filter_program(FilterArgs* filters) {
+    FilterProgram* program = malloc(sizeof(struct FilterProgram));
+    ex_assert(program != NULL, EX_MEMORY_ERROR);
+
+    size_t n_filters = 0;
+    for (FilterArgs* cur_filter = filters; cur_filter != NULL; cur_filter = cur_filter->next) {
+        n_filters++;
+    }
+
+    program->predicates = calloc(max(n_filters, 1), sizeof(struct FilterPredicate));
+    ex_assert(program->predicates != NULL, EX_MEMORY_ERROR);
+    program->n_predicates = 0;
+    program->n_numeric_predicates = 0;
+
+    // Two passes: numeric predicates first (cheapest rejects), then the others, keeping the relative order
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        for (FilterArgs* cur_filter = filters; cur_filter != NULL; cur_filter = cur_filter->next) {
+            FilterPredicate predicate;
+            if (!compile_filter(cur_filter, &predicate)) {
+                continue;
+            }
+
+            bool numeric = predicate.field == FF_ID || predicate.field == FF_ANO || predicate.field == FF_QTT;
+            if (numeric == (pass == 0)) {
+                program->predicates[program->n_predicates++] = predicate;
+            }
+        }
+
+        if (pass == 0) {
+            program->n_numeric_predicates = program->n_predicates;
+        }
+    }
+
+    if (select_equals == NULL) {
+        select_equals = resolve_select_equals();
+    }
+
+    return program;
+}
+
+/**
+ * Checks a string field against a predicate (strcmp semantics over the slice)
+ * @param predicate target predicate
+ * @param slice the field slice
+ * @return if it matches
+ */
+static inline bool match_str_predicate(FilterPredicate* predicate, StrSlice slice) {
+    if (predicate->operator== FO_IS_NULL) {
+        return slice.data == NULL;
+    }
+
+    // Quick rejects on null fields and length (the slice may only be longer if it holds a NULL byte right after)
+    if (slice.data == NULL || slice.len < predicate->str_len) {
+        return false;
+    }
+
+    if (slice.len > predicate->str_len && slice.data[predicate->str_len] != '\0') {
+        return false;
+    }
+
+    return memcmp(slice.data, predicate->str_value, predicate->str_len) == 0;
+}
+
+/**
+ * Checks a registry view against a range of the program's predicates
+ * @param program the compiled program
+ * @param first first predicate to be checked
+ * @param view target registry view
+ * @return if every predicate on the range matches
+ */
+static bool match_predicates(FilterProgram* program, size_t first, RegistryView* view) {
+    for (size_t i = first; i < program->n_predicates; i++) {
+        FilterPredicate* predicate = &program->predicates[i];
+
+        if (predicate->operator== FO_NEVER) {
+            return false;
+        }
+
+        switch (predicate->field) {
+            case FF_ID:
+                if (view->id != predicate->int_value) {
+                    return false;
+                }
+                break;
+            case FF_ANO:
+                if (view->ano != predicate->int_value) {
+                    return false;
+                }
+                break;
+            case FF_QTT:
+                if (view->qtt != predicate->int_value) {
+                    return false;
+                }
+                break;
+            case FF_SIGLA:
+                if (predicate->operator== FO_IS_NULL) {
+                    if (view->sigla[0] != FILLER_BYTE[0]) {
+                        return false;
+                    }
+                } else if (memcmp(view->sigla, predicate->sigla_value, REGISTRY_SIGLA_SIZE) != 0) {
+                    return false;
+                }
+                break;
+            case FF_CIDADE:
+                if (!match_str_predicate(predicate, view->cidade)) {
+                    return false;
+                }
+                break;
+            case FF_MARCA:
+                if (!match_str_predicate(predicate, view->marca)) {
+                    return false;
+                }
+                break;
+            case FF_MODELO:
+                if (!match_str_predicate(predicate, view->modelo)) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Runs a compiled program against a registry view
+ * @param program the compiled program
+ * @param view target registry view
+ * @return if the registry matches (removed registries never match)
+ */
+bool filter_program_match(FilterProgram* program, RegistryView* view) {
+    if (view->removed) {
+        return false;
+    }
+
+    return match_predicates(program, 0, view);
+}
+
+/**
+ * Retrieves the set of fields read by a compiled program (the projection needed to evaluate it)
+ * @param program the compiled program
+ * @return the fields (FM_* flags)
+ */
+field_mask_t filter_program_fields(FilterProgram* program) {
+    static const field_mask_t field_flags[] = {
+            [FF_ID] = FM_ID,
+            [FF_ANO] = FM_ANO,
+            [FF_QTT] = FM_QTT,
+            [FF_SIGLA] = FM_SIGLA,
+            [FF_CIDADE] = FM_CIDADE,
+            [FF_MARCA] = FM_MARCA,
+            [FF_MODELO] = FM_MODELO};
+
+    field_mask_t fields = 0;
+    for (size_t i = 0; i < program->n_predicates; i++) {
+        fields |= field_flags[program->predicates[i].field];
+    }
+
+    return fields;
+}
+
+/**
+ * Evaluates a compiled program over a whole batch into a selection bitmap
+ *
+ * Numeric predicates are evaluated column-wise (vectorized when the CPU supports it), string predicates are only
+ * evaluated (decoding the registry) for the rows passing every numeric one
+ * @param program the compiled program
+ * @param batch target batch
+ * @param selection output bitmap, bit i is set if the i-th registry matches (removed registries never match)
+ */
+void filter_program_select(FilterProgram* program, RegistryBatch* batch, uint64_t selection[REGISTRY_BATCH_WORDS]) {
+    ex_assert(select_equals != NULL, EX_GENERIC_ERROR);
+
+    // Start from the present registries
+    memcpy(selection, batch->present, sizeof(batch->present));
+    size_t n_words = (batch->n_registries + 63) / 64;
+
+    // Column-wise numeric predicates
+    for (size_t i = 0; i < program->n_numeric_predicates; i++) {
+        FilterPredicate* predicate = &program->predicates[i];
+        switch (predicate->field) {
+            case FF_ID:
+                select_equals(batch->id, predicate->int_value, selection, n_words);
+                break;
+            case FF_ANO:
+                select_equals(batch->ano, predicate->int_value, selection, n_words);
+                break;
+            case FF_QTT:
+                select_equals(batch->qtt, predicate->int_value, selection, n_words);
+                break;
+            default:
+                ex_raise(EX_GENERIC_ERROR);
+        }
+    }
+
+    if (program->n_numeric_predicates == program->n_predicates) {
+        return;
+    }
+
+    // Row-wise remaining predicates, only over the survivors
+    RegistryView view;
+    for (size_t word = 0; word < n_words; word++) {
+        uint64_t bits = selection[word];
+        while (bits != 0) {
+            size_t i = word * 64 + (size_t) __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            view_batch_registry(batch, i, &view);
+            if (!match_predicates(program, program->n_numeric_predicates, &view)) {
+                selection[word] &= ~((uint64_t) 1 << (i % 64));
+            }
+        }
+    }
+}
+
+/**
+ * Destroys (frees) a compiled program
+ * @param program target program
+ */
+void destroy_filter_program(FilterProgram* program) {
+    if (program == NULL) {
+        return;
+    }
+
+    free(program->predicates);
+    free(program);
+}
@@ -0,0 +1,100 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../scan/registry_batch.h"
+#include "../struct/registry_view.h"
+#include "common.h"
+
+/**
+ * Registry fields that can be filtered
+ */
+typedef enum FilterField {
+    FF_ID,
+    FF_ANO,
+    FF_QTT,
+    FF_SIGLA,
+    FF_CIDADE,
+    FF_MARCA,
+    FF_MODELO
+} FilterField;
+
+/**
+ * Filter operators
+ *
+ * FO_EQUALS compares the field against the pre-parsed value
+ * FO_IS_NULL checks for a null field
+ * FO_NEVER never matches (e.g. sigla values with the wrong length)
+ */
+typedef enum FilterOperator {
+    FO_EQUALS,
+    FO_IS_NULL,
+    FO_NEVER
+} FilterOperator;
+
+/**
+ * Compiled filter predicate
+ */
+typedef struct FilterPredicate {
+    FilterField field;
+    FilterOperator operator;
+    int32_t int_value;
+    char sigla_value[REGISTRY_SIGLA_SIZE];
+    const char* str_value;
+    size_t str_len;
+} FilterPredicate;
+
+/**
+ * Compiled filter list: every predicate must match (numeric fields are checked first)
+ */
+typedef struct FilterProgram {
+    FilterPredicate* predicates;
+    size_t n_predicates;
+    size_t n_numeric_predicates;
+} FilterProgram;
+
+/**
+ * Compiles a filter list into a predicate program (same semantics as registry_filter_match)
+ *
+ * The program references the filter values, so the filters must outlive it
+ * @param filters target filters (may be NULL, matching every registry)
+ * @return the compiled program
+ */
+FilterProgram* compile_filter_program(FilterArgs* filters);
+
+/**
+ * Runs a compiled program against a registry view
+ * @param program the compiled program
+ * @param view target registry view
+ * @return if the registry matches (removed registries never match)
+ */
+bool filter_program_match(FilterProgram* program, RegistryView* view);
+
+/**
+ * Retrieves the set of fields read by a compiled program (the projection needed to evaluate it)
+ * @param program the compiled program
+ * @return the fields (FM_* flags)
+ */
+field_mask_t filter_program_fields(FilterProgram* program);
+
+/**
+ * Evaluates a compiled program over a whole batch into a selection bitmap
+ *
+ * Numeric predicates are evaluated column-wise (vectorized when the CPU supports it), string predicates are only
+ * evaluated (decoding the registry) for the rows passing every numeric one
+ * @param program the compiled program
+ * @param batch target batch
+ * @param selection output bitmap, bit i is set if the i-th registry matches (removed registries never match)
+ */
+void filter_program_select(FilterProgram* program, RegistryBatch* batch, uint64_t selection[REGISTRY_BATCH_WORDS]);
+
+/**
+ * Destroys (frees) a compiled program
+ * @param program target program
+ */
+void destroy_filter_program(FilterProgram* program);
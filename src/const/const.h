@@ -8,6 +8,7 @@
 #include "../struct/registry_content.h"
 #include "../struct/t1_registry.h"
 #include "../struct/t2_registry.h"
+#include "../struct/t3_registry.h"
 
 static const HeaderContent DEFAULT_HEADER_CONTENT = {
         "LISTAGEM DA FROTA DOS VEICULOS NO BRASIL",
@@ -35,5 +36,11 @@ static const T2HeaderMetadata DEFAULT_T2_HEADER_METADATA = {
         (int64_t) T2_HEADER_SIZE,
         0};
 
+static const T3HeaderMetadata DEFAULT_T3_HEADER_METADATA = {
+        STATUS_GOOD,
+        0,
+        0,
+        {0}};
+
 
 static const char NULL_FIELD_REPR[] = "NAO PREENCHIDO";
@@ -34,6 +34,7 @@ BTreeIndexHeader* new_b_tree_index_header(RegistryType registry_type) {
             header->degree = DEFAULT_BTREE_DEGREE;
             break;
         case RT_VAR_LEN:
+        case RT_SLOTTED:
             header->page_size = DEFAULT_BTREE_PAGE_SIZE_VAR_LEN;
             header->degree = DEFAULT_BTREE_DEGREE;
             break;
@@ -520,6 +521,23 @@ IndexElement b_tree_index_find(BTreeIndexHeader* index_header, int32_t current_n
     return response;
 }
 
+/**
+ * Amount of nodes used to store a tree level on bulk loads (one key between each pair of nodes is promoted)
+ * @param n_keys amount of keys on the level
+ * @param keys_per_node target amount of keys per node
+ * @return the amount of nodes
+ */
+uint64_t b_tree_bulk_level_nodes(uint64_t n_keys, uint32_t keys_per_node) {
+    uint64_t n_nodes = (n_keys + keys_per_node + 1) / (keys_per_node + 1);
+
+    // Every node must keep at least one key
+    if (n_nodes > (n_keys + 1) / 2) {
+        n_nodes = (n_keys + 1) / 2;
+    }
+
+    return n_nodes > 0 ? n_nodes : 1;
+}
+
 /////////////////////////////
 // Public index operations //
 /////////////////////////////
@@ -546,6 +564,123 @@ bool b_tree_index_add(BTreeIndexHeader* index_header, FILE* file, int32_t id, in
     return !response.conflict;
 }
 
+/**
+ * Build the whole (empty) tree bottom-up from elements sorted by id, writing its pages sequentially
+ * @param index_header target index header
+ * @param file tree's file ptr
+ * @param elements finished sorter holding the elements
+ * @param fill_factor percentage of each node's capacity to be used (1 to 100)
+ * @return if the tree was built (false indicates a repeated id)
+ */
+bool b_tree_index_bulk_load(BTreeIndexHeader* index_header, FILE* file, ExternalSorter* elements, uint32_t fill_factor) {
+    ex_assert(index_header->no_raiz == -1, EX_GENERIC_ERROR);
+
+    uint64_t n_elements = external_sorter_size(elements);
+    if (n_elements == 0) {
+        return true;
+    }
+
+    // Keys per node from the fill factor (at least one, at most a full node)
+    uint32_t keys_per_node = (index_header->maximum_occupation * fill_factor + 50) / 100;
+    if (keys_per_node < 1) {
+        keys_per_node = 1;
+    } else if (keys_per_node > index_header->maximum_occupation) {
+        keys_per_node = index_header->maximum_occupation;
+    }
+
+    // Levels are written from the leaves up, so every page goes right after the previous one
+    seek_b_tree_node(index_header, file, 0);
+    BTreeIndexNode* node = new_btree_index_node(index_header);
+
+    IndexElement* level = NULL;// Keys of the current level (the leaf level streams from the sorter)
+    uint64_t level_keys = n_elements;
+    int32_t child_rrn = -1;// First RRN of the level below (-1 on leaves)
+    IndexElement last_element = {-1, -1};
+
+    while (true) {
+        uint64_t n_nodes = b_tree_bulk_level_nodes(level_keys, keys_per_node);
+        uint64_t stored_keys = level_keys - (n_nodes - 1);
+        int32_t first_rrn = index_header->proxRRN;
+
+        // Keys between nodes are promoted to the next level
+        IndexElement* promoted = NULL;
+        if (n_nodes > 1) {
+            promoted = malloc((n_nodes - 1) * sizeof(struct IndexElement));
+            ex_assert(promoted != NULL, EX_MEMORY_ERROR);
+        }
+
+        uint64_t key = 0;
+        bool conflict = false;
+        for (uint64_t i = 0; i < n_nodes && !conflict; i++) {
+            // Spread the keys evenly (the first nodes take the remainder)
+            uint32_t n_keys = (uint32_t) (stored_keys / n_nodes + (i < stored_keys % n_nodes ? 1 : 0));
+
+            if (n_nodes == 1) {
+                node->tipoNo = ROOT_NODE;
+            } else {
+                node->tipoNo = child_rrn == -1 ? LEAF_NODE : MIDDLE_NODE;
+            }
+            node->nroChaves = n_keys;
+            node->rrn = (int32_t) (first_rrn + i);
+
+            // Node keys, followed by the one promoted to the next level
+            for (uint32_t j = 0; j <= n_keys && !conflict; j++) {
+                IndexElement element;
+                if (j == n_keys && i + 1 == n_nodes) {
+                    break;
+                }
+
+                if (level != NULL) {
+                    element = level[key++];
+                } else {
+                    // Sorted elements, repeated ids are always side by side
+                    external_sorter_next(elements, &element);
+                    conflict = last_element.id == element.id && key > 0;
+                    last_element = element;
+                    key++;
+                }
+
+                if (j < n_keys) {
+                    node->elements[j] = element;
+                } else {
+                    promoted[i] = element;
+                }
+            }
+            for (uint32_t j = 0; j <= index_header->degree; j++) {
+                node->edges[j] = (j <= n_keys && child_rrn != -1) ? child_rrn++ : -1;
+            }
+
+            write_b_tree_index_node(index_header, node, file);
+            index_header->proxRRN++;
+            index_header->nroNos++;
+        }
+
+        free(level);
+        level = promoted;
+
+        if (conflict) {
+            free(level);
+            destroy_b_tree_index_node(node);
+            return false;
+        }
+
+        // Single node level, the tree is complete
+        if (n_nodes == 1) {
+            break;
+        }
+
+        level_keys = n_nodes - 1;
+        child_rrn = first_rrn;
+    }
+
+    // Keep the root in memory, like on regular insertions
+    destroy_b_tree_index_node(index_header->root_node_ref);
+    index_header->root_node_ref = node;
+    index_header->no_raiz = node->rrn;
+
+    return true;
+}
+
 /**
  * Removes the given id from index
  * @param index_header target index header
@@ -147,6 +147,16 @@ IndexElement b_tree_index_query(BTreeIndexHeader* index_header, FILE* file, int3
  */
 bool b_tree_index_add(BTreeIndexHeader* index_header, FILE* file, int32_t id, int64_t reference);
 
+/**
+ * Build the whole (empty) tree bottom-up from elements sorted by id, writing its pages sequentially
+ * @param index_header target index header
+ * @param file tree's file ptr
+ * @param elements finished sorter holding the elements
+ * @param fill_factor percentage of each node's capacity to be used (1 to 100)
+ * @return if the tree was built (false indicates a repeated id)
+ */
+bool b_tree_index_bulk_load(BTreeIndexHeader* index_header, FILE* file, ExternalSorter* elements, uint32_t fill_factor);
+
 /**
  * Removes the given id from index
  * @param index_header target index header
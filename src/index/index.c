@@ -8,6 +8,8 @@
 
 #include "../exception/exception.h"
 #include "../struct/common.h"
+#include "../utils/settings.h"
+#include "../utils/wal.h"
 #include "btree_index.h"
 #include "linear_index.h"
 
@@ -76,6 +78,27 @@ IndexHeader* new_index(RegistryType registry_type, IndexType index_type) {
     return index_header;
 }
 
+/**
+ * Order index elements by id (qsort comparator)
+ * @param a first element
+ * @param b second element
+ * @return the comparison result
+ */
+int compare_index_elements(const void* a, const void* b) {
+    int32_t a_id = ((const IndexElement*) a)->id;
+    int32_t b_id = ((const IndexElement*) b)->id;
+    return (a_id > b_id) - (a_id < b_id);
+}
+
+/**
+ * Allocates an external sorter ordering index elements by id (memory budget taken from the settings)
+ * @return the allocated sorter
+ */
+ExternalSorter* new_index_element_sorter() {
+    size_t memory_budget = get_size_setting(SETTING_SORT_MEMORY, DEFAULT_SORT_MEMORY, 1024, SIZE_MAX);
+    return new_external_sorter(sizeof(struct IndexElement), compare_index_elements, memory_budget);
+}
+
 ///////////////////////
 // Index operations //
 //////////////////////
@@ -119,6 +142,38 @@ bool index_add(IndexHeader* index_header, int32_t id, int64_t reference) {
     return false;
 }
 
+/**
+ * Write a whole new index into its file straight from elements sorted by id (no write_index needed afterwards)
+ * @param index_header target index header (empty)
+ * @param elements finished sorter holding the elements
+ * @param fill_factor percentage of each B-Tree node's capacity to be used (ignored by linear indexes)
+ * @return if all elements were written (false indicates a repeated id, index file might change)
+ */
+bool index_bulk_load(IndexHeader* index_header, ExternalSorter* elements, uint32_t fill_factor) {
+    switch (index_header->index_type) {
+        case IT_LINEAR:
+            // Same as write_index, the file is rewritten from scratch
+            index_header->file = reopen_truncated(index_header->file, "wb+");
+            if (!write_sorted_linear_index((LinearIndexHeader*) index_header->header, elements, index_header->file)) {
+                // Drop the partially written elements, leaving only the header
+                index_header->file = reopen_truncated(index_header->file, "wb+");
+                write_linear_index_header((LinearIndexHeader*) index_header->header, index_header->file);
+                return false;
+            }
+            return true;
+        case IT_B_TREE:
+            if (!b_tree_index_bulk_load((BTreeIndexHeader*) index_header->header, index_header->file, elements, fill_factor)) {
+                return false;
+            }
+            write_b_tree_index((BTreeIndexHeader*) index_header->header, index_header->file);
+            return true;
+        default:
+            ex_raise(EX_CORRUPTED_REGISTRY);
+    }
+
+    return false;
+}
+
 /**
  * Removes the given id from index
  * @param index_header target index header
@@ -163,7 +218,7 @@ bool index_update(IndexHeader* index_header, int32_t id, int64_t reference) {
 //////////////
 
 /**
- * Write entire index into the target file (might change file ptr)
+ * Write entire index into the target file (might change file ptr), linear indexes may only append their changes
  * @param index_header target index header
  * @param dest destination file
  * @return amount of bytes written
@@ -175,7 +230,11 @@ size_t write_index(IndexHeader* index_header, FILE* dest) {
 
     switch (index_header->index_type) {
         case IT_LINEAR:
-            index_header->file = dest = freopen(NULL, "wb", dest);
+            // Small change sets go to the delta segment, the others rewrite (and merge) the whole index
+            if (can_append_linear_index_delta((LinearIndexHeader*) index_header->header)) {
+                return append_linear_index_delta((LinearIndexHeader*) index_header->header, dest);
+            }
+            index_header->file = dest = reopen_truncated(dest, "wb");
             return write_linear_index((LinearIndexHeader*) index_header->header, dest);
         case IT_B_TREE:
             return write_b_tree_index((BTreeIndexHeader*) index_header->header, dest);
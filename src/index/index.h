@@ -7,6 +7,7 @@
 #include <stdint.h>
 
 #include "../struct/registry.h"
+#include "../utils/external_sort.h"
 
 /////////////
 // Configs //
@@ -63,6 +64,12 @@ void destroy_index_header(IndexHeader* index_header);
  */
 IndexHeader* new_index(RegistryType registry_type, IndexType index_type);
 
+/**
+ * Allocates an external sorter ordering index elements by id (memory budget taken from the settings)
+ * @return the allocated sorter
+ */
+ExternalSorter* new_index_element_sorter();
+
 ///////////////////////
 // Index operations //
 //////////////////////
@@ -84,6 +91,15 @@ IndexElement index_query(IndexHeader* index_header, int32_t id);
  */
 bool index_add(IndexHeader* index_header, int32_t id, int64_t reference);
 
+/**
+ * Write a whole new index into its file straight from elements sorted by id (no write_index needed afterwards)
+ * @param index_header target index header (empty)
+ * @param elements finished sorter holding the elements
+ * @param fill_factor percentage of each B-Tree node's capacity to be used (ignored by linear indexes)
+ * @return if all elements were written (false indicates a repeated id, index file might change)
+ */
+bool index_bulk_load(IndexHeader* index_header, ExternalSorter* elements, uint32_t fill_factor);
+
 /**
  * Removes the given id from index
  * @param index_header target index header
@@ -106,7 +122,7 @@ bool index_update(IndexHeader* index_header, int32_t id, int64_t reference);
 //////////////
 
 /**
- * Write entire index into the target file
+ * Write entire index into the target file (might change file ptr), linear indexes may only append their changes
  * @param index_header target index header
  * @param dest destination file
  * @return amount of bytes written
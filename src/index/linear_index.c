@@ -5,8 +5,11 @@
 #include "linear_index.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "../exception/exception.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
 
 ///////////////////////
 // Memory management //
@@ -25,6 +28,12 @@ LinearIndexHeader* new_linear_index_header() {
     index_header->index_pool = NULL;
     index_header->pool_size = 0;
     index_header->pool_used = 0;
+    index_header->layout_known = false;
+    index_header->sorted_count = 0;
+    index_header->delta_count = 0;
+    index_header->changes = NULL;
+    index_header->changes_size = 0;
+    index_header->changes_used = 0;
 
     return index_header;
 }
@@ -40,6 +49,7 @@ void destroy_linear_index_header(LinearIndexHeader* index_header) {
 
     // Free the pool itself
     free(index_header->index_pool);
+    free(index_header->changes);
     free(index_header);
 }
 
@@ -88,6 +98,22 @@ uint32_t reserve_linear_pool_pos(LinearIndexHeader* index_header) {
     return index_header->pool_used - 1;
 }
 
+/**
+ * Records a change made to the index, to be persisted on the delta segment
+ * @param index_header target index header
+ * @param id changed id
+ * @param reference id's new reference (-1 for removals)
+ */
+static void record_linear_index_change(LinearIndexHeader* index_header, int32_t id, int64_t reference) {
+    if (index_header->changes_used == index_header->changes_size) {
+        index_header->changes_size = index_header->changes_size == 0 ? INITIAL_POOL_SIZE : index_header->changes_size * POOL_SCALING_FACTOR;
+        index_header->changes = realloc(index_header->changes, index_header->changes_size * sizeof(struct IndexElement));
+        ex_assert(index_header->changes != NULL, EX_MEMORY_ERROR);
+    }
+
+    index_header->changes[index_header->changes_used++] = (IndexElement){id, reference};
+}
+
 //////////////////////////////
 // Private index operations //
 //////////////////////////////
@@ -239,6 +265,7 @@ bool linear_index_add(LinearIndexHeader* index_header, int32_t id, int64_t refer
     uint32_t insertion_pos = reserve_linear_pool_pos(index_header);
     index_header->index_pool[insertion_pos].id = id;
     index_header->index_pool[insertion_pos].reference = reference;
+    record_linear_index_change(index_header, id, reference);
 
     // Insertion sort the new element
     if (index_header->sorted) {
@@ -293,6 +320,7 @@ bool linear_index_remove(LinearIndexHeader* index_header, int32_t id) {
     }
 
     index_header->sorted = false;
+    record_linear_index_change(index_header, id, -1);
 
     return true;
 }
@@ -315,6 +343,7 @@ bool linear_index_update(LinearIndexHeader* index_header, int32_t id, int64_t re
     }
 
     index_header->index_pool[match].reference = reference;
+    record_linear_index_change(index_header, id, reference);
 
     return true;
 }
@@ -346,9 +375,161 @@ size_t write_linear_index(LinearIndexHeader* index_header, FILE* dest) {
         written_bytes += write_linear_index_element(index_header, &index_header->index_pool[i], dest);
     }
 
+    // The file is now a single sorted segment
+    index_header->layout_known = true;
+    index_header->sorted_count = index_header->pool_used;
+    index_header->delta_count = 0;
+    index_header->changes_used = 0;
+
     return written_bytes;
 }
 
+/**
+ * Write a whole index into the target file straight from elements sorted by id (the pool is left untouched)
+ * @param index_header target index header
+ * @param elements finished sorter holding the elements
+ * @param dest destination file
+ * @return if all elements were written (false indicates a repeated id)
+ */
+bool write_sorted_linear_index(LinearIndexHeader* index_header, ExternalSorter* elements, FILE* dest) {
+    ex_assert(index_header != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    write_linear_index_header(index_header, dest);
+
+    // Sorted elements, repeated ids are always side by side
+    IndexElement element;
+    int32_t last_id = -1;
+    bool first = true;
+    while (external_sorter_next(elements, &element)) {
+        if (!first && element.id == last_id) {
+            return false;
+        }
+
+        write_linear_index_element(index_header, &element, dest);
+        last_id = element.id;
+        first = false;
+    }
+
+    return true;
+}
+
+/**
+ * A change loaded from the delta segment, along with its position on the segment
+ */
+typedef struct LinearIndexChange {
+    IndexElement element;
+    uint32_t sequence;
+} LinearIndexChange;
+
+/**
+ * Retrieves the size of an element on the index file
+ * @param index_header target index header
+ * @return the element size
+ */
+static size_t linear_index_element_size(LinearIndexHeader* index_header) {
+    return sizeof(int32_t) + (index_header->registry_type == RT_FIX_LEN ? sizeof(uint32_t) : sizeof(int64_t));
+}
+
+/**
+ * Looks for the trailer of a delta segment at the end of the file (the file position is kept)
+ * @param index_header target index header
+ * @param src source file (positioned at the first element)
+ * @param sorted_count output for the amount of elements on the sorted segment
+ * @param delta_count output for the amount of changes on the delta segment
+ * @return if the file carries a delta segment
+ */
+static bool read_linear_index_trailer(LinearIndexHeader* index_header, FILE* src, uint32_t* sorted_count, uint32_t* delta_count) {
+    long start = ftell(src);
+    fseek(src, 0, SEEK_END);
+    long size = ftell(src);
+
+    bool found = false;
+
+    if (size >= start + (long) LINEAR_INDEX_TRAILER_SIZE) {
+        fseek(src, size - (long) LINEAR_INDEX_TRAILER_SIZE, SEEK_SET);
+
+        uint32_t counts[2];
+        char magic[LINEAR_INDEX_DELTA_MAGIC_SIZE];
+        if (fread(counts, sizeof(uint32_t), 2, src) == 2 && fread(magic, 1, LINEAR_INDEX_DELTA_MAGIC_SIZE, src) == LINEAR_INDEX_DELTA_MAGIC_SIZE &&
+            memcmp(magic, LINEAR_INDEX_DELTA_MAGIC, LINEAR_INDEX_DELTA_MAGIC_SIZE) == 0) {
+            // Both segments must fill the file exactly
+            size_t expected_size = (size_t) start + ((size_t) counts[0] + counts[1]) * linear_index_element_size(index_header) + LINEAR_INDEX_TRAILER_SIZE;
+            if (expected_size == (size_t) size) {
+                found = true;
+                *sorted_count = counts[0];
+                *delta_count = counts[1];
+            }
+        }
+    }
+
+    fseek(src, start, SEEK_SET);
+    return found;
+}
+
+/**
+ * Compares delta segment changes by id, then by segment position
+ * @param a LinearIndexChange ptr
+ * @param b LinearIndexChange ptr
+ * @return comparison result
+ */
+static int compare_linear_index_changes(const void* a, const void* b) {
+    const LinearIndexChange* change_a = a;
+    const LinearIndexChange* change_b = b;
+
+    if (change_a->element.id != change_b->element.id) return change_a->element.id < change_b->element.id ? -1 : 1;
+    if (change_a->sequence != change_b->sequence) return change_a->sequence < change_b->sequence ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Merges the delta segment changes into the (sorted) pool, only the last change of each id counts
+ * @param index_header target index header
+ * @param changes loaded changes
+ * @param n_changes amount of changes
+ */
+static void apply_linear_index_delta(LinearIndexHeader* index_header, LinearIndexChange* changes, uint32_t n_changes) {
+    qsort(changes, n_changes, sizeof(struct LinearIndexChange), compare_linear_index_changes);
+
+    uint32_t capacity = max(index_header->pool_used + n_changes, INITIAL_POOL_SIZE);
+    IndexElement* merged = malloc(capacity * sizeof(struct IndexElement));
+    ex_assert(merged != NULL, EX_MEMORY_ERROR);
+
+    IndexElement* pool = index_header->index_pool;
+    uint32_t n_merged = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+
+    while (i < index_header->pool_used || j < n_changes) {
+        if (j == n_changes || (i < index_header->pool_used && pool[i].id < changes[j].element.id)) {
+            merged[n_merged++] = pool[i++];
+            continue;
+        }
+
+        // Skip to the id's last change
+        uint32_t last = j;
+        while (last + 1 < n_changes && changes[last + 1].element.id == changes[j].element.id) {
+            last++;
+        }
+
+        // The change replaces (or removes) the sorted element
+        if (i < index_header->pool_used && pool[i].id == changes[j].element.id) {
+            i++;
+        }
+
+        if (changes[last].element.reference != -1) {
+            merged[n_merged++] = changes[last].element;
+        }
+
+        j = last + 1;
+    }
+
+    free(index_header->index_pool);
+    index_header->index_pool = merged;
+    index_header->pool_size = capacity;
+    index_header->pool_used = n_merged;
+}
+
 /**
  * Read entire index from the target file
  * @param index_header target index header
@@ -368,8 +549,13 @@ size_t read_linear_index(LinearIndexHeader* index_header, FILE* src) {
         return read_bytes;
     }
 
+    // Files with a delta segment end with a trailer, plain files are a single sorted segment
+    uint32_t sorted_count = UINT32_MAX;
+    uint32_t delta_count = 0;
+    bool has_delta = read_linear_index_trailer(index_header, src, &sorted_count, &delta_count);
+
     // Load index elements
-    while (!feof(src)) {
+    for (uint32_t n_read = 0; n_read < sorted_count && !feof(src); n_read++) {
         uint32_t insertion_pos = reserve_linear_pool_pos(index_header);
         size_t last_read_bytes = read_linear_index_element(index_header, &index_header->index_pool[insertion_pos], src);
         read_bytes += last_read_bytes;
@@ -381,11 +567,92 @@ size_t read_linear_index(LinearIndexHeader* index_header, FILE* src) {
         }
     }
 
+    // Load and apply the delta segment
+    if (has_delta) {
+        LinearIndexChange* changes = malloc(max(delta_count, 1) * sizeof(struct LinearIndexChange));
+        ex_assert(changes != NULL, EX_MEMORY_ERROR);
+
+        for (uint32_t i = 0; i < delta_count; i++) {
+            read_bytes += read_linear_index_element(index_header, &changes[i].element, src);
+            changes[i].sequence = i;
+
+            // Removals are stored as reference -1 (which reads back as UINT32_MAX on 32bit references)
+            if (index_header->registry_type == RT_FIX_LEN && changes[i].element.reference == UINT32_MAX) {
+                changes[i].element.reference = -1;
+            }
+        }
+        read_bytes += LINEAR_INDEX_TRAILER_SIZE;
+
+        apply_linear_index_delta(index_header, changes, delta_count);
+        free(changes);
+    }
+
     index_header->sorted = true;
 
+    // The file layout is now known, changes from here on can be appended
+    index_header->layout_known = true;
+    index_header->sorted_count = has_delta ? sorted_count : index_header->pool_used;
+    index_header->delta_count = delta_count;
+    index_header->changes_used = 0;
+
     return read_bytes;
 }
 
+/**
+ * Checks if the pending changes can be appended to the index file's delta segment instead of rewriting the index
+ * @param index_header target index header
+ * @return if the delta segment can take the changes
+ */
+bool can_append_linear_index_delta(LinearIndexHeader* index_header) {
+    ex_assert(index_header != NULL, EX_GENERIC_ERROR);
+
+    size_t max_delta_percentage = get_size_setting(SETTING_INDEX_DELTA, 0, 0, 10000);
+    if (max_delta_percentage == 0 || !index_header->layout_known) {
+        return false;
+    }
+
+    // Past its share of the sorted segment, the delta segment is merged back by a full rewrite
+    uint64_t delta_count = (uint64_t) index_header->delta_count + index_header->changes_used;
+    return delta_count * 100 <= (uint64_t) index_header->sorted_count * max_delta_percentage;
+}
+
+/**
+ * Appends the pending changes to the index file's delta segment (the file must be the one the index was read from)
+ * @param index_header target index header
+ * @param dest destination file
+ * @return amount of bytes written
+ */
+size_t append_linear_index_delta(LinearIndexHeader* index_header, FILE* dest) {
+    ex_assert(index_header != NULL, EX_GENERIC_ERROR);
+    ex_assert(index_header->layout_known, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    // Nothing changed, the file is already up to date
+    if (index_header->changes_used == 0) {
+        return 0;
+    }
+
+    size_t written_bytes = 0;
+
+    // New changes go over the previous trailer (if any)
+    size_t delta_end = sizeof(index_header->status) + ((size_t) index_header->sorted_count + index_header->delta_count) * linear_index_element_size(index_header);
+    fseek(dest, (long) delta_end, SEEK_SET);
+
+    for (uint32_t i = 0; i < index_header->changes_used; i++) {
+        written_bytes += write_linear_index_element(index_header, &index_header->changes[i], dest);
+    }
+
+    index_header->delta_count += index_header->changes_used;
+    index_header->changes_used = 0;
+
+    // Trailer
+    uint32_t counts[2] = {index_header->sorted_count, index_header->delta_count};
+    written_bytes += fwrite(counts, sizeof(uint32_t), 2, dest);
+    written_bytes += fwrite(LINEAR_INDEX_DELTA_MAGIC, 1, LINEAR_INDEX_DELTA_MAGIC_SIZE, dest);
+
+    return written_bytes;
+}
+
 /**
  * Write index header into the target file
  * @param index_header target index header
@@ -17,6 +17,11 @@
 // Pool growth factor (the pool grows exponentially)
 #define POOL_SCALING_FACTOR 2
 
+// Trailer closing index files that carry a delta segment: sorted count, delta count and this magic
+#define LINEAR_INDEX_DELTA_MAGIC "ARQDELTA"
+#define LINEAR_INDEX_DELTA_MAGIC_SIZE 8
+#define LINEAR_INDEX_TRAILER_SIZE (2 * sizeof(uint32_t) + LINEAR_INDEX_DELTA_MAGIC_SIZE)
+
 /////////////////////////////
 // Data structures & types //
 /////////////////////////////
@@ -30,6 +35,14 @@ typedef struct LinearIndexHeader {
     IndexElement* index_pool;
     uint32_t pool_size;
     uint32_t pool_used;
+    // File layout (sorted segment followed by the append-only delta segment), known once read or fully written
+    bool layout_known;
+    uint32_t sorted_count;
+    uint32_t delta_count;
+    // Changes since then, in order (removals have reference -1)
+    IndexElement* changes;
+    uint32_t changes_size;
+    uint32_t changes_used;
 } LinearIndexHeader;
 
 ///////////////////////
@@ -113,6 +126,30 @@ bool linear_index_update(LinearIndexHeader* index_header, int32_t id, int64_t re
  */
 size_t write_linear_index(LinearIndexHeader* index_header, FILE* dest);
 
+/**
+ * Checks if the pending changes can be appended to the index file's delta segment instead of rewriting the index
+ * @param index_header target index header
+ * @return if the delta segment can take the changes
+ */
+bool can_append_linear_index_delta(LinearIndexHeader* index_header);
+
+/**
+ * Appends the pending changes to the index file's delta segment (the file must be the one the index was read from)
+ * @param index_header target index header
+ * @param dest destination file
+ * @return amount of bytes written
+ */
+size_t append_linear_index_delta(LinearIndexHeader* index_header, FILE* dest);
+
+/**
+ * Write a whole index into the target file straight from elements sorted by id (the pool is left untouched)
+ * @param index_header target index header
+ * @param elements finished sorter holding the elements
+ * @param dest destination file
+ * @return if all elements were written (false indicates a repeated id)
+ */
+bool write_sorted_linear_index(LinearIndexHeader* index_header, ExternalSorter* elements, FILE* dest);
+
 /**
  * Read entire index from the target file
  * @param index_header target index header
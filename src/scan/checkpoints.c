@@ -0,0 +1,379 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "checkpoints.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../struct/t2_registry.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+#include "registry_scanner.h"
+
+/**
+ * Allocates a new empty checkpoint index
+ * @param interval amount of registries between checkpoints
+ * @param start_offset offset of the data file's first registry
+ * @return the allocated index
+ */
+CheckpointIndex* new_checkpoint_index(int32_t interval, size_t start_offset) {
+    ex_assert(interval > 0, EX_GENERIC_ERROR);
+
+    CheckpointIndex* checkpoint_index = malloc(sizeof(struct CheckpointIndex));
+    ex_assert(checkpoint_index != NULL, EX_MEMORY_ERROR);
+
+    checkpoint_index->status = STATUS_GOOD;
+    checkpoint_index->interval = interval;
+    checkpoint_index->end_offset = (int64_t) start_offset;
+    checkpoint_index->n_registries = 0;
+    checkpoint_index->fingerprint = (CheckpointFingerprint){-1, -1, -1};
+    checkpoint_index->checkpoints = NULL;
+    checkpoint_index->n_checkpoints = 0;
+    checkpoint_index->pool_size = 0;
+
+    return checkpoint_index;
+}
+
+/**
+ * Destroys (frees) the given checkpoint index
+ * @param checkpoint_index target index
+ */
+void destroy_checkpoint_index(CheckpointIndex* checkpoint_index) {
+    if (checkpoint_index == NULL) {
+        return;
+    }
+
+    free(checkpoint_index->checkpoints);
+    free(checkpoint_index);
+}
+
+/**
+ * Builds the sidecar path for a data file
+ * @param data_path the data file path
+ * @return the allocated sidecar path
+ */
+char* checkpoint_file_path(const char* data_path) {
+    size_t len = strlen(data_path);
+    char* path = malloc(len + sizeof(CHECKPOINT_FILE_SUFFIX));
+    ex_assert(path != NULL, EX_MEMORY_ERROR);
+
+    memcpy(path, data_path, len);
+    memcpy(path + len, CHECKPOINT_FILE_SUFFIX, sizeof(CHECKPOINT_FILE_SUFFIX));
+    return path;
+}
+
+/**
+ * Append a checkpoint to the pool
+ * @param checkpoint_index target index
+ * @param offset checkpoint offset
+ */
+static void push_checkpoint(CheckpointIndex* checkpoint_index, int64_t offset) {
+    if (checkpoint_index->n_checkpoints == checkpoint_index->pool_size) {
+        checkpoint_index->pool_size = checkpoint_index->pool_size == 0 ? 64 : 2 * checkpoint_index->pool_size;
+        checkpoint_index->checkpoints = realloc(checkpoint_index->checkpoints, checkpoint_index->pool_size * sizeof(int64_t));
+        ex_assert(checkpoint_index->checkpoints != NULL, EX_MEMORY_ERROR);
+    }
+    checkpoint_index->checkpoints[checkpoint_index->n_checkpoints++] = offset;
+}
+
+/**
+ * Computes the current fingerprint of a data file (its header must be up to date, the file position is kept)
+ * @param header the data file header
+ * @param file the data file
+ * @return the fingerprint
+ */
+CheckpointFingerprint checkpoint_fingerprint(Header* header, FILE* file) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    CheckpointFingerprint fingerprint = {-1, -1, -1};
+
+    // Journaled streams have no descriptor, so the size is taken through the stream
+    long position = ftell(file);
+    if (fseek(file, 0, SEEK_END) == 0) {
+        fingerprint.file_size = ftell(file);
+    }
+    fseek(file, position, SEEK_SET);
+
+    if (header->registry_type == RT_VAR_LEN) {
+        T2HeaderMetadata* header_metadata = header->header_metadata;
+        fingerprint.prox_byte_offset = header_metadata->proxByteOffset;
+        fingerprint.n_removed = header_metadata->nroRegRem;
+    }
+
+    return fingerprint;
+}
+
+/**
+ * Compares two fingerprints
+ * @param a first fingerprint
+ * @param b second fingerprint
+ * @return if both describe the same data file state
+ */
+static bool same_fingerprint(CheckpointFingerprint a, CheckpointFingerprint b) {
+    return a.file_size == b.file_size && a.prox_byte_offset == b.prox_byte_offset && a.n_removed == b.n_removed;
+}
+
+/**
+ * Checks if a registry starts at the given offset (its metadata must be readable and fit inside the registries area)
+ * @param header the data file header
+ * @param file the data file
+ * @param offset the checked offset
+ * @return if the offset looks like a registry boundary
+ */
+static bool is_registry_boundary(Header* header, FILE* file, int64_t offset) {
+    int64_t max_offset = (int64_t) get_max_offset(header);
+    if (offset == max_offset) {
+        return true;
+    }
+    if (offset < (int64_t) T2_HEADER_SIZE || offset > max_offset) {
+        return false;
+    }
+
+    T2RegistryMetadata metadata;
+    if (fseek(file, (long) offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    bool valid = fread_member_field(&metadata, removido, file) == sizeof(metadata.removido);
+    valid = valid && fread_member_field(&metadata, tamanhoRegistro, file) == sizeof(metadata.tamanhoRegistro);
+    valid = valid && (metadata.removido == REMOVED || metadata.removido == NOT_REMOVED);
+    valid = valid && metadata.tamanhoRegistro >= 0 && offset + (int64_t) T2_IGNORED_SIZE + metadata.tamanhoRegistro <= max_offset;
+
+    return valid;
+}
+
+/**
+ * Checks if the checkpoints still fit the data file (every checkpoint and the covered area's end on registry
+ * boundaries, so a catch up never starts mid-registry)
+ * @param checkpoint_index target index
+ * @param header the data file header
+ * @param file the data file
+ * @return if the checkpoints are usable
+ */
+static bool checkpoints_fit(CheckpointIndex* checkpoint_index, Header* header, FILE* file) {
+    // The covered area can't go past the data file end, and must start at its first registry
+    if ((size_t) checkpoint_index->end_offset > get_max_offset(header)) {
+        return false;
+    }
+    if (checkpoint_index->n_checkpoints > 0 && checkpoint_index->checkpoints[0] != (int64_t) T2_HEADER_SIZE) {
+        return false;
+    }
+
+    long position = ftell(file);
+
+    bool valid = is_registry_boundary(header, file, checkpoint_index->end_offset);
+    for (size_t i = 0; i < checkpoint_index->n_checkpoints && valid; i++) {
+        int64_t offset = checkpoint_index->checkpoints[i];
+        valid = (i == 0 || offset > checkpoint_index->checkpoints[i - 1]) && offset < checkpoint_index->end_offset;
+        valid = valid && is_registry_boundary(header, file, offset);
+    }
+
+    fseek(file, position, SEEK_SET);
+    return valid;
+}
+
+/**
+ * Registers a registry appended at the end of the covered area
+ * @param checkpoint_index target index
+ * @param offset the registry offset (must be the current end offset)
+ * @param size the registry size on the file
+ */
+void checkpoint_track(CheckpointIndex* checkpoint_index, size_t offset, size_t size) {
+    ex_assert(checkpoint_index != NULL, EX_GENERIC_ERROR);
+    ex_assert((int64_t) offset == checkpoint_index->end_offset, EX_CORRUPTED_REGISTRY);
+
+    if (checkpoint_index->n_registries % checkpoint_index->interval == 0) {
+        push_checkpoint(checkpoint_index, (int64_t) offset);
+    }
+
+    checkpoint_index->n_registries++;
+    checkpoint_index->end_offset = (int64_t) (offset + size);
+}
+
+/**
+ * Walks the data file registries after the covered area (up to the header's end), tracking them
+ * @param checkpoint_index target index
+ * @param header the data file header
+ * @param file the data file
+ */
+void checkpoint_catch_up(CheckpointIndex* checkpoint_index, Header* header, FILE* file) {
+    ex_assert(checkpoint_index != NULL, EX_GENERIC_ERROR);
+
+    if ((size_t) checkpoint_index->end_offset >= get_max_offset(header)) {
+        return;
+    }
+
+    RegistryView view;
+    RegistryScanner* scanner = new_registry_scanner(header, file, (size_t) checkpoint_index->end_offset, SM_BLOCK);
+    while (scanner_next_view(scanner, &view)) {
+        checkpoint_track(checkpoint_index, view.offset, view.size);
+    }
+    destroy_registry_scanner(scanner);
+}
+
+/**
+ * Writes the checkpoint index into the given file
+ * @param checkpoint_index target index
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_checkpoint_index(CheckpointIndex* checkpoint_index, FILE* dest) {
+    ex_assert(checkpoint_index != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    size_t written_bytes = 0;
+
+    written_bytes += fwrite_member_field(checkpoint_index, status, dest);
+    written_bytes += fwrite_member_field(checkpoint_index, interval, dest);
+    written_bytes += fwrite_member_field(checkpoint_index, end_offset, dest);
+    written_bytes += fwrite_member_field(checkpoint_index, n_registries, dest);
+    written_bytes += fwrite_member_field(checkpoint_index, fingerprint.file_size, dest);
+    written_bytes += fwrite_member_field(checkpoint_index, fingerprint.prox_byte_offset, dest);
+    written_bytes += fwrite_member_field(checkpoint_index, fingerprint.n_removed, dest);
+    if (checkpoint_index->n_checkpoints > 0) {
+        written_bytes += fwrite(checkpoint_index->checkpoints, sizeof(int64_t), checkpoint_index->n_checkpoints, dest) * sizeof(int64_t);
+    }
+
+    return written_bytes;
+}
+
+/**
+ * Reads the checkpoint index from the given file
+ * @param checkpoint_index target index
+ * @param src source file
+ * @return the amount of bytes read (0 on invalid files)
+ */
+size_t read_checkpoint_index(CheckpointIndex* checkpoint_index, FILE* src) {
+    ex_assert(checkpoint_index != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    size_t read_bytes = 0;
+
+    read_bytes += fread_member_field(checkpoint_index, status, src);
+    read_bytes += fread_member_field(checkpoint_index, interval, src);
+    read_bytes += fread_member_field(checkpoint_index, end_offset, src);
+    read_bytes += fread_member_field(checkpoint_index, n_registries, src);
+    read_bytes += fread_member_field(checkpoint_index, fingerprint.file_size, src);
+    read_bytes += fread_member_field(checkpoint_index, fingerprint.prox_byte_offset, src);
+    read_bytes += fread_member_field(checkpoint_index, fingerprint.n_removed, src);
+
+    if (read_bytes == 0 || checkpoint_index->status != STATUS_GOOD || checkpoint_index->interval <= 0 || checkpoint_index->n_registries < 0) {
+        return 0;
+    }
+
+    size_t n_checkpoints = (checkpoint_index->n_registries + checkpoint_index->interval - 1) / checkpoint_index->interval;
+    checkpoint_index->checkpoints = realloc(checkpoint_index->checkpoints, max(n_checkpoints, 1) * sizeof(int64_t));
+    ex_assert(checkpoint_index->checkpoints != NULL, EX_MEMORY_ERROR);
+    checkpoint_index->pool_size = max(n_checkpoints, 1);
+    checkpoint_index->n_checkpoints = fread(checkpoint_index->checkpoints, sizeof(int64_t), n_checkpoints, src);
+
+    if (checkpoint_index->n_checkpoints != n_checkpoints) {
+        return 0;
+    }
+
+    return read_bytes + n_checkpoints * sizeof(int64_t);
+}
+
+/**
+ * Writes the checkpoint index to the data file's sidecar
+ * @param checkpoint_index target index
+ * @param data_path the data file path
+ */
+void save_checkpoint_index(CheckpointIndex* checkpoint_index, const char* data_path) {
+    char* path = checkpoint_file_path(data_path);
+    FILE* file = fopen(path, "wb");
+    free(path);
+
+    // The sidecar is just an accelerator, failing to write it isn't an error
+    if (file == NULL) {
+        return;
+    }
+
+    write_checkpoint_index(checkpoint_index, file);
+    fclose(file);
+}
+
+/**
+ * Loads the data file's checkpoints saved for the expected data file state, catching up with registries appended since
+ * then (the sidecar is updated if anything changed)
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @param build_missing if a missing sidecar should be built from a full walk
+ * @param expected fingerprint the sidecar must have been saved with
+ * @return the loaded index (NULL if not available)
+ */
+static CheckpointIndex* load_matching_checkpoint_index(Header* header, FILE* file, const char* data_path, bool build_missing, CheckpointFingerprint expected) {
+    // Only variable length files need checkpoints
+    if (header->registry_type != RT_VAR_LEN) {
+        return NULL;
+    }
+
+    size_t interval = get_size_setting(SETTING_CHECKPOINT_INTERVAL, DEFAULT_CHECKPOINT_INTERVAL, 1, INT32_MAX);
+    CheckpointIndex* checkpoint_index = new_checkpoint_index((int32_t) interval, T2_HEADER_SIZE);
+
+    char* path = checkpoint_file_path(data_path);
+    FILE* checkpoint_file = fopen(path, "rb");
+    free(path);
+
+    if (checkpoint_file == NULL && !build_missing) {
+        destroy_checkpoint_index(checkpoint_index);
+        return NULL;
+    }
+
+    bool valid = false;
+    if (checkpoint_file != NULL) {
+        valid = read_checkpoint_index(checkpoint_index, checkpoint_file) != 0;
+        fclose(checkpoint_file);
+    }
+
+    // Sidecars saved for another file (e.g. one copied over the data file) are never trusted
+    valid = valid && same_fingerprint(checkpoint_index->fingerprint, expected);
+    valid = valid && checkpoints_fit(checkpoint_index, header, file);
+
+    // Rebuild from scratch
+    if (!valid) {
+        destroy_checkpoint_index(checkpoint_index);
+        checkpoint_index = new_checkpoint_index((int32_t) interval, T2_HEADER_SIZE);
+    }
+
+    // Track appended registries
+    int64_t covered_registries = valid ? checkpoint_index->n_registries : -1;
+    checkpoint_catch_up(checkpoint_index, header, file);
+
+    CheckpointFingerprint current = checkpoint_fingerprint(header, file);
+    if (checkpoint_index->n_registries != covered_registries || !same_fingerprint(checkpoint_index->fingerprint, current)) {
+        checkpoint_index->fingerprint = current;
+        save_checkpoint_index(checkpoint_index, data_path);
+    }
+
+    return checkpoint_index;
+}
+
+/**
+ * Loads the data file's checkpoints, validating them and catching up with registries appended since the last save
+ * (sidecars which don't match the data file are rebuilt, the sidecar is updated if anything changed)
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @param build_missing if a missing sidecar should be built from a full walk
+ * @return the loaded index (NULL if not available)
+ */
+CheckpointIndex* load_checkpoint_index(Header* header, FILE* file, const char* data_path, bool build_missing) {
+    return load_matching_checkpoint_index(header, file, data_path, build_missing, checkpoint_fingerprint(header, file));
+}
+
+/**
+ * Brings an existing sidecar up to date with a data file changed by a batch (no-op for files without checkpoints)
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @param previous fingerprint of the data file before the batch
+ */
+void sync_checkpoint_index(Header* header, FILE* file, const char* data_path, CheckpointFingerprint previous) {
+    destroy_checkpoint_index(load_matching_checkpoint_index(header, file, data_path, false, previous));
+}
@@ -0,0 +1,139 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../struct/registry.h"
+
+// Sidecar file holding the checkpoints of a data file (<data file path><suffix>)
+#define CHECKPOINT_FILE_SUFFIX ".ckp"
+
+// Default amount of registries between checkpoints
+#define DEFAULT_CHECKPOINT_INTERVAL 1024
+
+/**
+ * State of a data file when its checkpoints were last saved (sidecars left beside another file don't match it)
+ */
+typedef struct CheckpointFingerprint {
+    int64_t file_size;
+    int64_t prox_byte_offset;
+    int32_t n_removed;
+} CheckpointFingerprint;
+
+/**
+ * Resynchronisation checkpoints for variable length files: the byte offset of every K-th registry (removed ones
+ * included), so walks can start at any checkpoint instead of the file's first registry
+ *
+ * Registries never change their boundaries in place (removed ones are reused whole), so the checkpoints only grow
+ * by appends at the end of the file. end_offset marks up to where the data file is covered, and the fingerprint ties
+ * the sidecar to the data file it was saved for.
+ */
+typedef struct CheckpointIndex {
+    char status;
+    int32_t interval;
+    int64_t end_offset;
+    int64_t n_registries;
+    CheckpointFingerprint fingerprint;
+    int64_t* checkpoints;
+    size_t n_checkpoints;
+    size_t pool_size;
+} CheckpointIndex;
+
+// Memory management //
+
+/**
+ * Allocates a new empty checkpoint index
+ * @param interval amount of registries between checkpoints
+ * @param start_offset offset of the data file's first registry
+ * @return the allocated index
+ */
+CheckpointIndex* new_checkpoint_index(int32_t interval, size_t start_offset);
+
+/**
+ * Destroys (frees) the given checkpoint index
+ * @param checkpoint_index target index
+ */
+void destroy_checkpoint_index(CheckpointIndex* checkpoint_index);
+
+/**
+ * Builds the sidecar path for a data file
+ * @param data_path the data file path
+ * @return the allocated sidecar path
+ */
+char* checkpoint_file_path(const char* data_path);
+
+// Operations //
+
+/**
+ * Computes the current fingerprint of a data file (its header must be up to date, the file position is kept)
+ * @param header the data file header
+ * @param file the data file
+ * @return the fingerprint
+ */
+CheckpointFingerprint checkpoint_fingerprint(Header* header, FILE* file);
+
+/**
+ * Registers a registry appended at the end of the covered area
+ * @param checkpoint_index target index
+ * @param offset the registry offset (must be the current end offset)
+ * @param size the registry size on the file
+ */
+void checkpoint_track(CheckpointIndex* checkpoint_index, size_t offset, size_t size);
+
+/**
+ * Walks the data file registries after the covered area (up to the header's end), tracking them
+ * @param checkpoint_index target index
+ * @param header the data file header
+ * @param file the data file
+ */
+void checkpoint_catch_up(CheckpointIndex* checkpoint_index, Header* header, FILE* file);
+
+// File I/O //
+
+/**
+ * Writes the checkpoint index into the given file
+ * @param checkpoint_index target index
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_checkpoint_index(CheckpointIndex* checkpoint_index, FILE* dest);
+
+/**
+ * Reads the checkpoint index from the given file
+ * @param checkpoint_index target index
+ * @param src source file
+ * @return the amount of bytes read (0 on invalid files)
+ */
+size_t read_checkpoint_index(CheckpointIndex* checkpoint_index, FILE* src);
+
+/**
+ * Writes the checkpoint index to the data file's sidecar
+ * @param checkpoint_index target index
+ * @param data_path the data file path
+ */
+void save_checkpoint_index(CheckpointIndex* checkpoint_index, const char* data_path);
+
+/**
+ * Loads the data file's checkpoints, validating them and catching up with registries appended since the last save
+ * (sidecars which don't match the data file are rebuilt, the sidecar is updated if anything changed)
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @param build_missing if a missing sidecar should be built from a full walk
+ * @return the loaded index (NULL if not available)
+ */
+CheckpointIndex* load_checkpoint_index(Header* header, FILE* file, const char* data_path, bool build_missing);
+
+/**
+ * Brings an existing sidecar up to date with a data file changed by a batch (no-op for files without checkpoints)
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @param previous fingerprint of the data file before the batch
+ */
+void sync_checkpoint_index(Header* header, FILE* file, const char* data_path, CheckpointFingerprint previous);
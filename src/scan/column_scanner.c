@@ -0,0 +1,101 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "column_scanner.h"
+
+#include <stdlib.h>
+
+#include "../exception/exception.h"
+
+/**
+ * Allocates a new scanner over the rows of a columnar file (the header must be already read)
+ * @param header the file's header
+ * @param file the source file
+ * @param first_segment_offset offset of the first segment
+ * @param fields projected columns (FM_* flags)
+ * @return the allocated scanner
+ */
+ColumnScanner* new_column_scanner(ColumnFileHeader* header, FILE* file, size_t first_segment_offset, field_mask_t fields) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    ColumnScanner* scanner = malloc(sizeof(struct ColumnScanner));
+    ex_assert(scanner != NULL, EX_MEMORY_ERROR);
+
+    scanner->header = header;
+    scanner->file = file;
+    scanner->fields = fields;
+    scanner->segment = new_column_segment();
+    scanner->next_segment_offset = first_segment_offset;
+    scanner->n_read_segments = 0;
+    scanner->row = 0;
+
+    return scanner;
+}
+
+/**
+ * Views the next row on the scan (only the projected columns are filled)
+ *
+ * The view is only valid until the next call on the scanner
+ * @param scanner the target scanner
+ * @param view the view to be filled
+ * @return if a row was read (false when the end of the file was reached)
+ */
+bool column_scanner_next_view(ColumnScanner* scanner, RegistryView* view) {
+    ex_assert(scanner != NULL, EX_GENERIC_ERROR);
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+
+    ColumnSegment* segment = scanner->segment;
+
+    while (scanner->row >= segment->n_rows) {
+        if (scanner->n_read_segments >= scanner->header->nroSegmentos) {
+            return false;
+        }
+
+        // The header counts every segment, so a short file is corrupted
+        ex_assert(fseek(scanner->file, (long) scanner->next_segment_offset, SEEK_SET) == 0, EX_FILE_ERROR);
+        size_t segment_size = read_column_segment(segment, scanner->file);
+        ex_assert(segment_size != 0, EX_CORRUPTED_REGISTRY);
+        ex_assert(load_column_segment(segment, scanner->file, scanner->fields), EX_CORRUPTED_REGISTRY);
+
+        scanner->next_segment_offset += segment_size;
+        scanner->n_read_segments++;
+        scanner->row = 0;
+    }
+
+    view_column_segment_row(segment, (RegistryType) scanner->header->tipoOrigem, scanner->row, view);
+    scanner->row++;
+
+    return true;
+}
+
+/**
+ * Loads more columns of the current segment and views the last returned row again with them
+ * @param scanner the target scanner
+ * @param fields columns to be loaded (FM_* flags)
+ * @param view the view to be filled
+ */
+void column_scanner_materialize(ColumnScanner* scanner, field_mask_t fields, RegistryView* view) {
+    ex_assert(scanner != NULL, EX_GENERIC_ERROR);
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+    ex_assert(scanner->row > 0, EX_GENERIC_ERROR);
+
+    ColumnSegment* segment = scanner->segment;
+    ex_assert(load_column_segment(segment, scanner->file, fields), EX_CORRUPTED_REGISTRY);
+
+    view_column_segment_row(segment, (RegistryType) scanner->header->tipoOrigem, scanner->row - 1, view);
+}
+
+/**
+ * Destroys (frees) the given scanner, the file and header are kept untouched
+ * @param scanner the target scanner
+ */
+void destroy_column_scanner(ColumnScanner* scanner) {
+    if (scanner == NULL) {
+        return;
+    }
+
+    destroy_column_segment(scanner->segment);
+    free(scanner);
+}
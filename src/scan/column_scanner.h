@@ -0,0 +1,63 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../struct/column_file.h"
+#include "../struct/registry_view.h"
+
+/**
+ * Sequential scanner over the rows of a columnar file
+ *
+ * Only the projected columns of each segment are read, the other chunks are skipped on the file
+ */
+typedef struct ColumnScanner {
+    ColumnFileHeader* header;
+    FILE* file;
+    field_mask_t fields;
+    ColumnSegment* segment;
+    size_t next_segment_offset;
+    int32_t n_read_segments;
+
+    // Next row on the current segment
+    uint32_t row;
+} ColumnScanner;
+
+/**
+ * Allocates a new scanner over the rows of a columnar file (the header must be already read)
+ * @param header the file's header
+ * @param file the source file
+ * @param first_segment_offset offset of the first segment
+ * @param fields projected columns (FM_* flags)
+ * @return the allocated scanner
+ */
+ColumnScanner* new_column_scanner(ColumnFileHeader* header, FILE* file, size_t first_segment_offset, field_mask_t fields);
+
+/**
+ * Views the next row on the scan (only the projected columns are filled)
+ *
+ * The view is only valid until the next call on the scanner
+ * @param scanner the target scanner
+ * @param view the view to be filled
+ * @return if a row was read (false when the end of the file was reached)
+ */
+bool column_scanner_next_view(ColumnScanner* scanner, RegistryView* view);
+
+/**
+ * Loads more columns of the current segment and views the last returned row again with them
+ * @param scanner the target scanner
+ * @param fields columns to be loaded (FM_* flags)
+ * @param view the view to be filled
+ */
+void column_scanner_materialize(ColumnScanner* scanner, field_mask_t fields, RegistryView* view);
+
+/**
+ * Destroys (frees) the given scanner, the file and header are kept untouched
+ * @param scanner the target scanner
+ */
+void destroy_column_scanner(ColumnScanner* scanner);
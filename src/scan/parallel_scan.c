@@ -0,0 +1,296 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "parallel_scan.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../exception/exception.h"
+#include "../struct/t1_registry.h"
+#include "../struct/t3_registry.h"
+#include "../utils/mapped_file.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+
+/**
+ * Work unit of a scan thread: a registry-aligned byte range and its matches
+ */
+typedef struct ScanPartition {
+    size_t begin;
+    size_t end;
+    size_t* matches;
+    size_t n_matches;
+    size_t matches_capacity;
+} ScanPartition;
+
+/**
+ * Data shared by every scan thread
+ */
+typedef struct ParallelScanArgs {
+    RegistryType registry_type;
+    MappedFile* mapped_file;
+    ViewPredicate match;
+    BatchPredicate match_batch;
+    void* passthrough;
+} ParallelScanArgs;
+
+/**
+ * Scan thread parameters
+ */
+typedef struct ScanWorker {
+    pthread_t thread;
+    ParallelScanArgs* args;
+    ScanPartition* partition;
+} ScanWorker;
+
+/**
+ * Append a matched offset to the partition results
+ * @param partition target partition
+ * @param offset matched registry offset
+ */
+static void push_partition_match(ScanPartition* partition, size_t offset) {
+    if (partition->n_matches == partition->matches_capacity) {
+        partition->matches_capacity = max(64, 2 * partition->matches_capacity);
+        partition->matches = realloc(partition->matches, partition->matches_capacity * sizeof(size_t));
+        ex_assert(partition->matches != NULL, EX_MEMORY_ERROR);
+    }
+    partition->matches[partition->n_matches++] = offset;
+}
+
+/**
+ * Batched partition scan: decode batches of registries and keep the offsets selected by the batch predicate
+ * @param args shared scan data
+ * @param partition target partition
+ */
+static void scan_partition_batches(ParallelScanArgs* args, ScanPartition* partition) {
+    const char* data = args->mapped_file->data;
+
+    RegistryBatch* batch = malloc(sizeof(struct RegistryBatch));
+    ex_assert(batch != NULL, EX_MEMORY_ERROR);
+    uint64_t selection[REGISTRY_BATCH_WORDS];
+
+    size_t offset = partition->begin;
+    while (offset < partition->end) {
+        size_t read_bytes = decode_registry_batch(batch, args->registry_type, data + offset, partition->end - offset, offset);
+
+        // Truncated registry
+        if (read_bytes == 0) {
+            break;
+        }
+
+        args->match_batch(batch, selection, args->passthrough);
+        for (size_t word = 0; word < REGISTRY_BATCH_WORDS; word++) {
+            uint64_t bits = selection[word];
+            while (bits != 0) {
+                push_partition_match(partition, batch->offsets[word * 64 + (size_t) __builtin_ctzll(bits)]);
+                bits &= bits - 1;
+            }
+        }
+
+        offset += read_bytes;
+    }
+
+    free(batch);
+}
+
+/**
+ * Scan thread body: view each registry on the partition and keep the matching offsets
+ * @param worker_ptr the ScanWorker
+ * @return NULL
+ */
+static void* scan_partition(void* worker_ptr) {
+    ScanWorker* worker = worker_ptr;
+    ParallelScanArgs* args = worker->args;
+    ScanPartition* partition = worker->partition;
+    const char* data = args->mapped_file->data;
+
+    if (args->match_batch != NULL) {
+        scan_partition_batches(args, partition);
+        return NULL;
+    }
+
+    RegistryView view;
+    size_t offset = partition->begin;
+    while (offset < partition->end) {
+        size_t read_bytes = view_registry(&view, args->registry_type, data + offset, partition->end - offset, offset);
+
+        // Truncated registry
+        if (read_bytes == 0) {
+            break;
+        }
+
+        if (!view.removed && args->match(&view, args->passthrough)) {
+            push_partition_match(partition, offset);
+        }
+
+        offset += read_bytes;
+    }
+
+    return NULL;
+}
+
+/**
+ * Retrieves the amount of threads to be used on scans
+ * @return the thread count (1 when parallel scans are disabled)
+ */
+size_t scan_thread_count() {
+    long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t default_threads = online_cpus > 0 ? (size_t) online_cpus : 1;
+    return get_size_setting(SETTING_SCAN_THREADS, min(default_threads, MAX_PARALLEL_SCAN_THREADS), 1, MAX_PARALLEL_SCAN_THREADS);
+}
+
+/**
+ * Splits the registry area into registry-aligned partitions
+ * @param header the file's header
+ * @param start_offset offset of the first registry
+ * @param end_offset offset after the last registry
+ * @param checkpoints the file's checkpoints (variable length files only)
+ * @param max_partitions maximum amount of partitions
+ * @param partitions output array (at least max_partitions long)
+ * @return the amount of partitions (0 if the file can't be split)
+ */
+static size_t plan_partitions(Header* header, size_t start_offset, size_t end_offset, CheckpointIndex* checkpoints, size_t max_partitions, ScanPartition* partitions) {
+    if (end_offset <= start_offset) {
+        return 0;
+    }
+
+    // Fixed length registries are split by RRN
+    if (header->registry_type == RT_FIX_LEN) {
+        size_t n_registries = (end_offset - start_offset) / T1_REGISTRY_SIZE;
+        size_t n_partitions = min(max_partitions, n_registries / MIN_PARALLEL_SCAN_PARTITION);
+        if (n_partitions < 2) {
+            return 0;
+        }
+
+        size_t registries_per_partition = n_registries / n_partitions;
+        for (size_t i = 0; i < n_partitions; i++) {
+            partitions[i].begin = start_offset + i * registries_per_partition * T1_REGISTRY_SIZE;
+            partitions[i].end = start_offset + (i + 1) * registries_per_partition * T1_REGISTRY_SIZE;
+        }
+        partitions[n_partitions - 1].end = start_offset + n_registries * T1_REGISTRY_SIZE;
+
+        return n_partitions;
+    }
+
+    // Slotted registries are split on page boundaries
+    if (header->registry_type == RT_SLOTTED) {
+        size_t n_pages = (end_offset - start_offset) / T3_PAGE_SIZE;
+        size_t n_partitions = min(max_partitions, n_pages / MIN_PARALLEL_SCAN_PAGES);
+        if (n_partitions < 2) {
+            return 0;
+        }
+
+        size_t pages_per_partition = n_pages / n_partitions;
+        for (size_t i = 0; i < n_partitions; i++) {
+            partitions[i].begin = start_offset + i * pages_per_partition * T3_PAGE_SIZE;
+            partitions[i].end = start_offset + (i + 1) * pages_per_partition * T3_PAGE_SIZE;
+        }
+        partitions[n_partitions - 1].end = start_offset + n_pages * T3_PAGE_SIZE;
+
+        return n_partitions;
+    }
+
+    // Variable length registries are split on checkpoints (which must cover the whole scanned area)
+    if (header->registry_type == RT_VAR_LEN && checkpoints != NULL && checkpoints->n_checkpoints > 0) {
+        if (checkpoints->checkpoints[0] != (int64_t) start_offset || checkpoints->end_offset != (int64_t) end_offset) {
+            return 0;
+        }
+
+        size_t n_partitions = min(max_partitions, (size_t) checkpoints->n_registries / MIN_PARALLEL_SCAN_PARTITION);
+        n_partitions = min(n_partitions, checkpoints->n_checkpoints);
+        if (n_partitions < 2) {
+            return 0;
+        }
+
+        for (size_t i = 0; i < n_partitions; i++) {
+            partitions[i].begin = (size_t) checkpoints->checkpoints[i * checkpoints->n_checkpoints / n_partitions];
+            if (i > 0) {
+                partitions[i - 1].end = partitions[i].begin;
+            }
+        }
+        partitions[n_partitions - 1].end = end_offset;
+
+        return n_partitions;
+    }
+
+    return 0;
+}
+
+/**
+ * Scans the file's registries in parallel partitions, evaluating the predicate on worker threads and emitting
+ * every non-removed match in file order (same results as a sequential scan)
+ * @param header the file's header
+ * @param file the source file
+ * @param start_offset offset of the first registry
+ * @param checkpoints the file's checkpoints (required to split variable length files, NULL otherwise)
+ * @param match predicate evaluated for each non-removed registry
+ * @param match_batch batch predicate used instead of match when given (may be NULL)
+ * @param emit callback for each matched registry
+ * @param passthrough shared data given to both functions
+ * @return if the scan was executed (false when not worth it or not possible, so the caller must scan sequentially)
+ */
+bool parallel_scan(Header* header, FILE* file, size_t start_offset, CheckpointIndex* checkpoints, ViewPredicate match, BatchPredicate match_batch, ViewCallback emit, void* passthrough) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    size_t n_threads = scan_thread_count();
+    if (n_threads < 2) {
+        return false;
+    }
+
+    MappedFile* mapped_file = map_file(file);
+    if (mapped_file == NULL) {
+        return false;
+    }
+
+    // Split the file (bounded by both the header and the actual file size)
+    ScanPartition partitions[MAX_PARALLEL_SCAN_THREADS];
+    size_t end_offset = min(get_max_offset(header), mapped_file->size);
+    size_t n_partitions = plan_partitions(header, start_offset, end_offset, checkpoints, n_threads, partitions);
+    if (n_partitions == 0) {
+        unmap_file(mapped_file);
+        return false;
+    }
+
+    ParallelScanArgs args = {header->registry_type, mapped_file, match, match_batch, passthrough};
+    ScanWorker workers[MAX_PARALLEL_SCAN_THREADS];
+
+    // Scan partitions
+    for (size_t i = 0; i < n_partitions; i++) {
+        partitions[i].matches = NULL;
+        partitions[i].n_matches = 0;
+        partitions[i].matches_capacity = 0;
+
+        workers[i].args = &args;
+        workers[i].partition = &partitions[i];
+        int status = pthread_create(&workers[i].thread, NULL, scan_partition, &workers[i]);
+
+        // Couldn't spawn the thread, scan the partition here instead
+        if (status != 0) {
+            scan_partition(&workers[i]);
+            workers[i].partition = NULL;
+        }
+    }
+
+    // Merge results in file order
+    RegistryView view;
+    for (size_t i = 0; i < n_partitions; i++) {
+        if (workers[i].partition != NULL) {
+            pthread_join(workers[i].thread, NULL);
+        }
+
+        for (size_t j = 0; j < partitions[i].n_matches; j++) {
+            size_t offset = partitions[i].matches[j];
+            view_registry(&view, header->registry_type, mapped_file->data + offset, end_offset - offset, offset);
+            emit(&view, passthrough);
+        }
+
+        free(partitions[i].matches);
+    }
+
+    unmap_file(mapped_file);
+    return true;
+}
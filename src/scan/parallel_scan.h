@@ -0,0 +1,58 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../struct/registry.h"
+#include "../struct/registry_view.h"
+#include "checkpoints.h"
+#include "registry_batch.h"
+
+// Minimum amount of registries for a partition to be worth its own thread
+#define MIN_PARALLEL_SCAN_PARTITION 8192
+
+// Minimum amount of pages for a slotted file partition to be worth its own thread
+#define MIN_PARALLEL_SCAN_PAGES 128
+
+// Upper bound on scan threads
+#define MAX_PARALLEL_SCAN_THREADS 64
+
+/**
+ * Predicate evaluated by the scan workers (must be thread-safe, e.g. filters must be pre-parsed)
+ */
+typedef bool (*ViewPredicate)(RegistryView* view, void* passthrough);
+
+/**
+ * Batch predicate evaluated by the scan workers, fills the selection bitmap of the batch (must be thread-safe)
+ */
+typedef void (*BatchPredicate)(RegistryBatch* batch, uint64_t* selection, void* passthrough);
+
+/**
+ * Callback receiving each matched registry, always called from the calling thread and in file order
+ */
+typedef void (*ViewCallback)(RegistryView* view, void* passthrough);
+
+/**
+ * Retrieves the amount of threads to be used on scans
+ * @return the thread count (1 when parallel scans are disabled)
+ */
+size_t scan_thread_count();
+
+/**
+ * Scans the file's registries in parallel partitions, evaluating the predicate on worker threads and emitting
+ * every non-removed match in file order (same results as a sequential scan)
+ * @param header the file's header
+ * @param file the source file
+ * @param start_offset offset of the first registry
+ * @param checkpoints the file's checkpoints (required to split variable length files, NULL otherwise)
+ * @param match predicate evaluated for each non-removed registry
+ * @param match_batch batch predicate used instead of match when given (may be NULL)
+ * @param emit callback for each matched registry
+ * @param passthrough shared data given to both functions
+ * @return if the scan was executed (false when not worth it or not possible, so the caller must scan sequentially)
+ */
+bool parallel_scan(Header* header, FILE* file, size_t start_offset, CheckpointIndex* checkpoints, ViewPredicate match, BatchPredicate match_batch, ViewCallback emit, void* passthrough);
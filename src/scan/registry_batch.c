@@ -0,0 +1,92 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "registry_batch.h"
+
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/utils.h"
+
+/**
+ * Decodes up to REGISTRY_BATCH_SIZE consecutive registries from memory into the batch columns
+ * @param batch the batch to be filled (previous content is discarded)
+ * @param registry_type the registries' type
+ * @param src the bytes of the first registry
+ * @param available amount of bytes available from src
+ * @param offset file offset of the first registry
+ * @return amount of bytes consumed (0 if no registry could be decoded)
+ */
+size_t decode_registry_batch(RegistryBatch* batch, RegistryType registry_type, const char* src, size_t available, size_t offset) {
+    ex_assert(batch != NULL, EX_GENERIC_ERROR);
+
+    batch->registry_type = registry_type;
+    batch->n_registries = 0;
+    memset(batch->present, 0, sizeof(batch->present));
+
+    // The numeric fields follow the metadata on both registry types
+    size_t fields_offset = registry_metadata_size(registry_type);
+    size_t fields_size = sizeof(int32_t) * 3;
+
+    size_t read_bytes = 0;
+    while (batch->n_registries < REGISTRY_BATCH_SIZE && read_bytes < available) {
+        const char* registry_src = src + read_bytes;
+        size_t registry_available = available - read_bytes;
+
+        bool removed = false;
+        size_t registry_size = peek_registry_size(registry_type, registry_src, registry_available, &removed);
+
+        // Truncated (or corrupted) registry, the batch ends before it
+        if (registry_size == 0 || (!removed && (registry_size > registry_available || registry_size < fields_offset + fields_size))) {
+            break;
+        }
+
+        size_t i = batch->n_registries++;
+        batch->data[i] = registry_src;
+        batch->offsets[i] = offset + read_bytes;
+        batch->sizes[i] = min(registry_size, registry_available);
+
+        if (removed) {
+            batch->id[i] = batch->ano[i] = batch->qtt[i] = 0;
+        } else {
+            batch->present[i / 64] |= (uint64_t) 1 << (i % 64);
+            memcpy(&batch->id[i], registry_src + fields_offset, sizeof(int32_t));
+            memcpy(&batch->ano[i], registry_src + fields_offset + sizeof(int32_t), sizeof(int32_t));
+            memcpy(&batch->qtt[i], registry_src + fields_offset + 2 * sizeof(int32_t), sizeof(int32_t));
+        }
+
+        read_bytes += registry_size;
+    }
+
+    // Zero the column tail, so vectorized code may run over whole words
+    size_t tail = REGISTRY_BATCH_SIZE - batch->n_registries;
+    memset(&batch->id[batch->n_registries], 0, tail * sizeof(int32_t));
+    memset(&batch->ano[batch->n_registries], 0, tail * sizeof(int32_t));
+    memset(&batch->qtt[batch->n_registries], 0, tail * sizeof(int32_t));
+
+    return min(read_bytes, available);
+}
+
+/**
+ * Checks if the i-th registry of the batch is present (not removed)
+ * @param batch target batch
+ * @param i registry position on the batch
+ * @return if it is present
+ */
+bool is_batch_registry_present(RegistryBatch* batch, size_t i) {
+    return (batch->present[i / 64] >> (i % 64)) & 1;
+}
+
+/**
+ * Fully views the i-th registry of the batch (including the strings)
+ * @param batch target batch
+ * @param i registry position on the batch
+ * @param view the view to be filled
+ */
+void view_batch_registry(RegistryBatch* batch, size_t i, RegistryView* view) {
+    ex_assert(i < batch->n_registries, EX_GENERIC_ERROR);
+
+    size_t read_bytes = view_registry(view, batch->registry_type, batch->data[i], batch->sizes[i], batch->offsets[i]);
+    ex_assert(read_bytes != 0, EX_CORRUPTED_REGISTRY);
+}
@@ -0,0 +1,65 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../struct/registry.h"
+#include "../struct/registry_view.h"
+
+// Registries decoded per batch (multiple of 64, so the selection bitmaps have no partial words)
+#define REGISTRY_BATCH_SIZE 1024
+#define REGISTRY_BATCH_WORDS (REGISTRY_BATCH_SIZE / 64)
+
+/**
+ * Batch of registries decoded into int32 columns (only the fixed numeric fields)
+ *
+ * The strings aren't decoded, each registry keeps a pointer to its bytes so it can be viewed later
+ * (while the source memory is still valid). Column entries past n_registries are zeroed.
+ */
+typedef struct RegistryBatch {
+    RegistryType registry_type;
+    size_t n_registries;
+
+    // Bit i is set if registry i is present (not removed)
+    uint64_t present[REGISTRY_BATCH_WORDS];
+
+    const char* data[REGISTRY_BATCH_SIZE];
+    size_t offsets[REGISTRY_BATCH_SIZE];
+    size_t sizes[REGISTRY_BATCH_SIZE];
+
+    int32_t id[REGISTRY_BATCH_SIZE];
+    int32_t ano[REGISTRY_BATCH_SIZE];
+    int32_t qtt[REGISTRY_BATCH_SIZE];
+} RegistryBatch;
+
+/**
+ * Decodes up to REGISTRY_BATCH_SIZE consecutive registries from memory into the batch columns
+ * @param batch the batch to be filled (previous content is discarded)
+ * @param registry_type the registries' type
+ * @param src the bytes of the first registry
+ * @param available amount of bytes available from src
+ * @param offset file offset of the first registry
+ * @return amount of bytes consumed (0 if no registry could be decoded)
+ */
+size_t decode_registry_batch(RegistryBatch* batch, RegistryType registry_type, const char* src, size_t available, size_t offset);
+
+/**
+ * Checks if the i-th registry of the batch is present (not removed)
+ * @param batch target batch
+ * @param i registry position on the batch
+ * @return if it is present
+ */
+bool is_batch_registry_present(RegistryBatch* batch, size_t i);
+
+/**
+ * Fully views the i-th registry of the batch (including the strings)
+ * @param batch target batch
+ * @param i registry position on the batch
+ * @param view the view to be filled
+ */
+void view_batch_registry(RegistryBatch* batch, size_t i, RegistryView* view);
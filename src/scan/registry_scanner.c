@@ -0,0 +1,262 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "registry_scanner.h"
+
+#include <stdlib.h>
+
+#include "../exception/exception.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+
+/**
+ * Allocates a new scanner over the registries of a file (the header must be already read)
+ *
+ * If the file can't be mapped, SM_MMAP falls back to SM_BLOCK
+ * @param header the file's header
+ * @param file the source file
+ * @param start_offset offset of the first registry to be read
+ * @param scan_mode the requested scan mode
+ * @return the allocated scanner
+ */
+RegistryScanner* new_registry_scanner(Header* header, FILE* file, size_t start_offset, ScanMode scan_mode) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    RegistryScanner* scanner = malloc(sizeof(struct RegistryScanner));
+    ex_assert(scanner != NULL, EX_MEMORY_ERROR);
+
+    scanner->scan_mode = scan_mode;
+    scanner->header = header;
+    scanner->file = file;
+    scanner->offset = start_offset;
+    scanner->max_offset = get_max_offset(header);
+    scanner->mapped_file = NULL;
+    scanner->block_reader = NULL;
+    scanner->buffer = NULL;
+    scanner->buffer_size = 0;
+
+    if (scanner->scan_mode == SM_MMAP) {
+        scanner->mapped_file = map_file(file);
+
+        // Fallback to block reads
+        if (scanner->mapped_file == NULL) {
+            scanner->scan_mode = SM_BLOCK;
+        }
+    }
+
+    if (scanner->scan_mode == SM_BLOCK) {
+        size_t block_size = get_size_setting(SETTING_BLOCK_SIZE, DEFAULT_READ_BLOCK_SIZE, MIN_READ_BLOCK_SIZE, MAX_READ_BLOCK_SIZE);
+        scanner->block_reader = new_block_reader(file, start_offset, block_size);
+    }
+
+    if (scanner->scan_mode == SM_STDIO) {
+        go_to_offset(start_offset, file);
+    }
+
+    return scanner;
+}
+
+/**
+ * Ensures the scanner's raw registry buffer can hold at least the given amount of bytes
+ * @param scanner the target scanner
+ * @param size required size
+ */
+static void reserve_scanner_buffer(RegistryScanner* scanner, size_t size) {
+    if (scanner->buffer_size >= size) {
+        return;
+    }
+
+    scanner->buffer_size = max(size, 2 * scanner->buffer_size);
+    scanner->buffer = realloc(scanner->buffer, scanner->buffer_size);
+    ex_assert(scanner->buffer != NULL, EX_MEMORY_ERROR);
+}
+
+/**
+ * Reads the raw bytes of the registry at the file's current position into the scanner buffer.
+ * Removed registries only have their metadata read, the remaining bytes are skipped
+ * @param scanner the target scanner
+ * @return the amount of bytes available on the buffer
+ */
+static size_t read_raw_registry(RegistryScanner* scanner) {
+    RegistryType registry_type = scanner->header->registry_type;
+    size_t metadata_size = registry_metadata_size(registry_type);
+
+    reserve_scanner_buffer(scanner, metadata_size);
+    size_t read_bytes = fread(scanner->buffer, 1, metadata_size, scanner->file);
+
+    bool removed = false;
+    size_t registry_size = peek_registry_size(registry_type, scanner->buffer, read_bytes, &removed);
+
+    // Truncated or corrupted registry
+    if (registry_size < metadata_size) {
+        return 0;
+    }
+
+    if (removed) {
+        fseek(scanner->file, (long) (registry_size - metadata_size), SEEK_CUR);
+        return read_bytes;
+    }
+
+    reserve_scanner_buffer(scanner, registry_size);
+    read_bytes += fread(scanner->buffer + metadata_size, 1, registry_size - metadata_size, scanner->file);
+    return read_bytes;
+}
+
+/**
+ * Loads the bytes of the scanner's next registry (removed registries may only have their metadata loaded)
+ * @param scanner the target scanner
+ * @param available output for the amount of bytes available
+ * @return pointer to the registry bytes (NULL at the end of file)
+ */
+static const char* scanner_peek(RegistryScanner* scanner, size_t* available) {
+    if (scanner->offset >= scanner->max_offset) {
+        return NULL;
+    }
+
+    if (scanner->scan_mode == SM_MMAP) {
+        MappedFile* mapped_file = scanner->mapped_file;
+
+        // File shorter than what the header states
+        if (scanner->offset >= mapped_file->size) {
+            return NULL;
+        }
+
+        *available = min(mapped_file->size, scanner->max_offset) - scanner->offset;
+        return mapped_file->data + scanner->offset;
+    }
+
+    if (scanner->scan_mode == SM_BLOCK) {
+        RegistryType registry_type = scanner->header->registry_type;
+
+        // Load the metadata first, so removed registries can be skipped without loading their bytes
+        const char* src = block_reader_peek(scanner->block_reader, registry_metadata_size(registry_type), available);
+
+        bool removed = false;
+        size_t registry_size = peek_registry_size(registry_type, src, *available, &removed);
+
+        if (registry_size != 0 && !removed) {
+            src = block_reader_peek(scanner->block_reader, registry_size, available);
+        }
+
+        return src;
+    }
+
+    *available = read_raw_registry(scanner);
+    return scanner->buffer;
+}
+
+/**
+ * Moves the scanner past the registry that was just read
+ * @param scanner the target scanner
+ * @param read_bytes the registry size
+ */
+static void scanner_advance(RegistryScanner* scanner, size_t read_bytes) {
+    scanner->offset += read_bytes;
+
+    if (scanner->scan_mode == SM_BLOCK) {
+        block_reader_skip(scanner->block_reader, read_bytes);
+    }
+}
+
+/**
+ * Reads the next registry on the scan (removed registries are also returned)
+ * @param scanner the target scanner
+ * @param registry the registry ptr on which the data will be read into
+ * @return if a registry was read (false when the end of the file was reached)
+ */
+bool scanner_next(RegistryScanner* scanner, Registry* registry) {
+    ex_assert(scanner != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+
+    size_t available = 0;
+    const char* src = scanner_peek(scanner, &available);
+    if (src == NULL || available == 0) {
+        return false;
+    }
+
+    size_t read_bytes = read_registry_from_buffer(registry, src, available, scanner->offset);
+
+    // Truncated registry
+    if (read_bytes == 0) {
+        return false;
+    }
+
+    scanner_advance(scanner, read_bytes);
+    return true;
+}
+
+/**
+ * Views the next registry on the scan (removed registries are also returned)
+ *
+ * The view is only valid until the next call on the scanner
+ * @param scanner the target scanner
+ * @param view the view to be filled
+ * @return if a registry was read (false when the end of the file was reached)
+ */
+bool scanner_next_view(RegistryScanner* scanner, RegistryView* view) {
+    ex_assert(scanner != NULL, EX_GENERIC_ERROR);
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+
+    size_t available = 0;
+    const char* src = scanner_peek(scanner, &available);
+    if (src == NULL || available == 0) {
+        return false;
+    }
+
+    size_t read_bytes = view_registry(view, scanner->header->registry_type, src, available, scanner->offset);
+
+    // Truncated registry
+    if (read_bytes == 0) {
+        return false;
+    }
+
+    scanner_advance(scanner, read_bytes);
+    return true;
+}
+
+/**
+ * Decodes the next batch of registries on the scan (removed registries are also returned)
+ *
+ * Only available on SM_MMAP scanners, the batch is valid while the scanner exists
+ * @param scanner the target scanner
+ * @param batch the batch to be filled
+ * @return if any registry was decoded (false when the end of the file was reached)
+ */
+bool scanner_next_batch(RegistryScanner* scanner, RegistryBatch* batch) {
+    ex_assert(scanner != NULL, EX_GENERIC_ERROR);
+    ex_assert(batch != NULL, EX_GENERIC_ERROR);
+    ex_assert(scanner->scan_mode == SM_MMAP, EX_GENERIC_ERROR);
+
+    size_t available = 0;
+    const char* src = scanner_peek(scanner, &available);
+    if (src == NULL || available == 0) {
+        return false;
+    }
+
+    size_t read_bytes = decode_registry_batch(batch, scanner->header->registry_type, src, available, scanner->offset);
+
+    // Truncated registry
+    if (read_bytes == 0) {
+        return false;
+    }
+
+    scanner_advance(scanner, read_bytes);
+    return true;
+}
+
+/**
+ * Destroys (frees) the given scanner, the file and header are kept untouched
+ * @param scanner the target scanner
+ */
+void destroy_registry_scanner(RegistryScanner* scanner) {
+    if (scanner == NULL) {
+        return;
+    }
+
+    unmap_file(scanner->mapped_file);
+    destroy_block_reader(scanner->block_reader);
+    free(scanner->buffer);
+    free(scanner);
+}
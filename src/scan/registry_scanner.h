@@ -0,0 +1,88 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "../struct/registry.h"
+#include "../struct/registry_view.h"
+#include "../utils/block_reader.h"
+#include "../utils/mapped_file.h"
+#include "registry_batch.h"
+
+/**
+ * Available sequential scan strategies
+ *
+ * SM_STDIO reads each registry through the stdio file functions (safe while the file is being modified)
+ * SM_BLOCK reads the file in large blocks and decodes the registries from them
+ * SM_MMAP maps the whole file and decodes the registries straight from memory
+ */
+typedef enum ScanMode {
+    SM_STDIO = 0,
+    SM_BLOCK = 1,
+    SM_MMAP = 2
+} ScanMode;
+
+/**
+ * Sequential registry scanner state
+ */
+typedef struct RegistryScanner {
+    ScanMode scan_mode;
+    Header* header;
+    FILE* file;
+    size_t offset;
+    size_t max_offset;
+    MappedFile* mapped_file;
+    BlockReader* block_reader;
+    char* buffer;
+    size_t buffer_size;
+} RegistryScanner;
+
+/**
+ * Allocates a new scanner over the registries of a file (the header must be already read)
+ *
+ * If the file can't be mapped, SM_MMAP falls back to SM_BLOCK
+ * @param header the file's header
+ * @param file the source file
+ * @param start_offset offset of the first registry to be read
+ * @param scan_mode the requested scan mode
+ * @return the allocated scanner
+ */
+RegistryScanner* new_registry_scanner(Header* header, FILE* file, size_t start_offset, ScanMode scan_mode);
+
+/**
+ * Reads the next registry on the scan (removed registries are also returned)
+ * @param scanner the target scanner
+ * @param registry the registry ptr on which the data will be read into
+ * @return if a registry was read (false when the end of the file was reached)
+ */
+bool scanner_next(RegistryScanner* scanner, Registry* registry);
+
+/**
+ * Views the next registry on the scan (removed registries are also returned)
+ *
+ * The view is only valid until the next call on the scanner
+ * @param scanner the target scanner
+ * @param view the view to be filled
+ * @return if a registry was read (false when the end of the file was reached)
+ */
+bool scanner_next_view(RegistryScanner* scanner, RegistryView* view);
+
+/**
+ * Decodes the next batch of registries on the scan (removed registries are also returned)
+ *
+ * Only available on SM_MMAP scanners, the batch is valid while the scanner exists
+ * @param scanner the target scanner
+ * @param batch the batch to be filled
+ * @return if any registry was decoded (false when the end of the file was reached)
+ */
+bool scanner_next_batch(RegistryScanner* scanner, RegistryBatch* batch);
+
+/**
+ * Destroys (frees) the given scanner, the file and header are kept untouched
+ * @param scanner the target scanner
+ */
+void destroy_registry_scanner(RegistryScanner* scanner);
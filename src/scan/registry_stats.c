@@ -0,0 +1,152 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "registry_stats.h"
+
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../struct/t1_registry.h"
+#include "../struct/t2_registry.h"
+#include "../struct/t3_registry.h"
+#include "registry_scanner.h"
+
+/**
+ * Computes the amount of bytes used by a live registry's fields
+ * @param view the registry view
+ * @return the used bytes (metadata included)
+ */
+static size_t registry_used_bytes(RegistryView* view) {
+    size_t used_bytes = registry_metadata_size(view->registry_type);
+
+    used_bytes += member_size(RegistryView, id);
+    used_bytes += member_size(RegistryView, ano);
+    used_bytes += member_size(RegistryView, qtt);
+    used_bytes += member_size(RegistryView, sigla);
+
+    // Null fields aren't stored
+    StrSlice fields[] = {view->cidade, view->marca, view->modelo};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(StrSlice); i++) {
+        if (fields[i].data != NULL) {
+            used_bytes += sizeof(strlen_t) + CODE_FIELD_LEN + fields[i].len;
+        }
+    }
+
+    return used_bytes;
+}
+
+/**
+ * Walks the header's removed registries list
+ * @param header the data file header
+ * @param file the data file
+ * @param max_length amount of removed registries on the file (longer lists have cycles)
+ * @return the list length (-1 if it is broken)
+ */
+static int64_t free_list_length(Header* header, FILE* file, uint32_t max_length) {
+    int64_t current = header->registry_type == RT_FIX_LEN ? ((T1HeaderMetadata*) header->header_metadata)->topo
+                                                          : ((T2HeaderMetadata*) header->header_metadata)->topo;
+
+    Registry* registry = build_registry(header);
+    int64_t length = 0;
+
+    while (current != -1) {
+        // Only the metadata matters, removed registries have no content to decode
+        bool valid = length < max_length && current >= 0 && seek_registry(header, file, (size_t) current);
+        valid = valid && read_registry_projected(registry, file, 0) != 0 && is_registry_removed(registry);
+
+        if (!valid) {
+            length = -1;
+            break;
+        }
+
+        current = registry->registry_type == RT_FIX_LEN ? ((T1RegistryMetadata*) registry->registry_metadata)->prox
+                                                        : ((T2RegistryMetadata*) registry->registry_metadata)->prox;
+        length++;
+    }
+
+    destroy_registry(registry);
+    return length;
+}
+
+/**
+ * Scans a data file's registries and measures their space usage
+ * @param stats where the stats will be stored
+ * @param header the data file header
+ * @param file the data file
+ * @param first_registry_offset offset of the first registry
+ */
+void collect_registry_stats(RegistryStats* stats, Header* header, FILE* file, size_t first_registry_offset) {
+    ex_assert(stats != NULL, EX_GENERIC_ERROR);
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    memset(stats, 0, sizeof(struct RegistryStats));
+
+    RegistryScanner* scanner = new_registry_scanner(header, file, first_registry_offset, SM_BLOCK);
+    RegistryView view;
+
+    while (scanner_next_view(scanner, &view)) {
+        // Page headers are bookkeeping (like the file header) and free page tails are filler
+        if (view.registry_type == RT_SLOTTED && view.removed) {
+            if ((view.offset - T3_HEADER_SIZE) % T3_PAGE_SIZE == 0) {
+                continue;
+            }
+            if (view.slot == T3_TAIL_SLOT) {
+                stats->filler_bytes += view.size;
+                continue;
+            }
+        }
+
+        if (view.removed) {
+            stats->removed_bytes += view.size;
+            stats->n_removed++;
+
+            // Bucket of the size's highest bit
+            uint32_t bucket = view.size == 0 ? 0 : (uint32_t) (63 - __builtin_clzll((unsigned long long) view.size));
+            stats->hole_histogram[bucket < STATS_HOLE_BUCKETS ? bucket : STATS_HOLE_BUCKETS - 1]++;
+            continue;
+        }
+
+        // Fixed length registries always take their whole slot, so their padding isn't dead space
+        size_t used_bytes = view.registry_type == RT_FIX_LEN ? view.size : registry_used_bytes(&view);
+        ex_assert(used_bytes <= view.size, EX_CORRUPTED_REGISTRY);
+
+        stats->live_bytes += used_bytes;
+        stats->filler_bytes += view.size - used_bytes;
+        stats->n_live++;
+    }
+
+    destroy_registry_scanner(scanner);
+
+    // Slotted files have no list, every hole is reached through its page
+    if (header->registry_type == RT_SLOTTED) {
+        stats->free_list_length = stats->n_removed;
+        return;
+    }
+
+    stats->free_list_length = free_list_length(header, file, stats->n_removed);
+}
+
+/**
+ * Computes the amount of bytes not used by any registry field (filler and removed registries)
+ * @param stats target stats
+ * @return the dead bytes
+ */
+size_t stats_dead_bytes(RegistryStats* stats) {
+    return stats->filler_bytes + stats->removed_bytes;
+}
+
+/**
+ * Computes the percentage of the registries area taken by dead bytes
+ * @param stats target stats
+ * @return the dead ratio (0 to 100, 0 for empty files)
+ */
+double stats_dead_ratio(RegistryStats* stats) {
+    size_t total_bytes = stats->live_bytes + stats_dead_bytes(stats);
+    if (total_bytes == 0) {
+        return 0;
+    }
+
+    return 100.0 * (double) stats_dead_bytes(stats) / (double) total_bytes;
+}
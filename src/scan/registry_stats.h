@@ -0,0 +1,60 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "../struct/registry.h"
+
+// Hole size histogram buckets (powers of two, the last one also holds every bigger hole)
+#define STATS_HOLE_BUCKETS 16
+
+/**
+ * Space usage of a data file's registries area (the header isn't accounted for)
+ *
+ * Variable length registries only use their fields' bytes, the rest of their slot is filler: the '$' left by in-place
+ * updates with shorter strings or by registries reusing bigger removed ones (tamanhoRegistro slack). Both are
+ * indistinguishable on the file, so they are reported together. Fixed length registries always use their whole slot.
+ * Slotted page headers are left out (like the file header) and free page tails are reported as filler.
+ */
+typedef struct RegistryStats {
+    size_t live_bytes;
+    size_t filler_bytes;
+    size_t removed_bytes;
+
+    uint32_t n_live;
+    uint32_t n_removed;
+
+    // Removed registries reachable from the header's list (-1 if the list is broken)
+    int64_t free_list_length;
+
+    // Removed registries by size on the file (bucket i holds sizes in [2^i, 2^(i + 1)))
+    uint32_t hole_histogram[STATS_HOLE_BUCKETS];
+} RegistryStats;
+
+/**
+ * Scans a data file's registries and measures their space usage
+ * @param stats where the stats will be stored
+ * @param header the data file header
+ * @param file the data file
+ * @param first_registry_offset offset of the first registry
+ */
+void collect_registry_stats(RegistryStats* stats, Header* header, FILE* file, size_t first_registry_offset);
+
+/**
+ * Computes the amount of bytes not used by any registry field (filler and removed registries)
+ * @param stats target stats
+ * @return the dead bytes
+ */
+size_t stats_dead_bytes(RegistryStats* stats);
+
+/**
+ * Computes the percentage of the registries area taken by dead bytes
+ * @param stats target stats
+ * @return the dead ratio (0 to 100, 0 for empty files)
+ */
+double stats_dead_ratio(RegistryStats* stats);
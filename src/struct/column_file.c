@@ -0,0 +1,548 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "column_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/utils.h"
+#include "common.h"
+
+// Columns holding int32 values (id, ano and qtt)
+#define NUMBER_COLUMNS 3
+
+// First string column (cidade, marca and modelo follow it)
+#define FIRST_STRING_COLUMN 4
+
+// Column holding the sigla
+#define SIGLA_COLUMN 3
+
+/**
+ * Computes the amount of 64-bit words of a null bitmap
+ * @param n_rows rows covered by the bitmap
+ * @return the amount of words
+ */
+static size_t null_words(uint32_t n_rows) {
+    return ((size_t) n_rows + 63) / 64;
+}
+
+/**
+ * Computes the size of a chunk's fixed part (null bitmap and per row values, string bytes excluded)
+ * @param column the column index
+ * @param n_rows rows on the segment
+ * @return the fixed part size
+ */
+static size_t chunk_fixed_size(uint8_t column, uint32_t n_rows) {
+    size_t bitmap_size = null_words(n_rows) * sizeof(uint64_t);
+    if (column == SIGLA_COLUMN) {
+        return bitmap_size + (size_t) n_rows * REGISTRY_SIGLA_SIZE;
+    }
+
+    // Numbers and string end offsets both take 4 bytes per row
+    return bitmap_size + (size_t) n_rows * sizeof(int32_t);
+}
+
+/**
+ * Retrieves the index of a column from its flag
+ * @param column the column (FM_* flag)
+ * @return the column index
+ */
+static uint8_t column_index(field_mask_t column) {
+    ex_assert(column != 0 && (column & (column - 1)) == 0 && column <= FM_MODELO, EX_GENERIC_ERROR);
+    return (uint8_t) __builtin_ctz(column);
+}
+
+/**
+ * Sets a row's bit on a null bitmap
+ * @param bitmap target bitmap
+ * @param row the row
+ */
+static void set_null(uint64_t* bitmap, uint32_t row) {
+    bitmap[row / 64] |= (uint64_t) 1 << (row % 64);
+}
+
+// File I/O //
+
+/**
+ * Writes the given columnar file header into the target file
+ * @param header header to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_column_file_header(ColumnFileHeader* header, FILE* dest) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->header_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    size_t written_bytes = 0;
+
+    written_bytes += fwrite_member_field(header, status, dest);
+    written_bytes += write_header_content(header->header_content, dest);
+    written_bytes += fwrite_member_field(header, tipoOrigem, dest);
+    written_bytes += fwrite_member_field(header, nroRegistros, dest);
+    written_bytes += fwrite_member_field(header, nroSegmentos, dest);
+    written_bytes += fwrite_member_field(header, registrosPorSegmento, dest);
+
+    return written_bytes;
+}
+
+/**
+ * Reads the given columnar file header from the target file
+ * @param header header to be read into
+ * @param src source file
+ * @return the amount of bytes read (0 if the file is too short)
+ */
+size_t read_column_file_header(ColumnFileHeader* header, FILE* src) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->header_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    size_t read_bytes = 0;
+
+    read_bytes += fread_member_field(header, status, src);
+    read_bytes += read_header_content(header->header_content, src);
+    read_bytes += fread_member_field(header, tipoOrigem, src);
+    read_bytes += fread_member_field(header, nroRegistros, src);
+    read_bytes += fread_member_field(header, nroSegmentos, src);
+    read_bytes += fread_member_field(header, registrosPorSegmento, src);
+
+    if (read_bytes != COLUMN_FILE_HEADER_SIZE) {
+        return 0;
+    }
+
+    return read_bytes;
+}
+
+// Segments //
+
+/**
+ * Reads a segment's row count and chunk sizes at the file's current position (its chunks are only loaded on request)
+ * @param segment target segment (previously loaded chunks are dropped)
+ * @param src source file
+ * @return the segment's total size on the file (0 if it is truncated)
+ */
+size_t read_column_segment(ColumnSegment* segment, FILE* src) {
+    ex_assert(segment != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    segment->loaded = 0;
+
+    size_t read_bytes = 0;
+    read_bytes += fread_member_field(segment, n_rows, src);
+    read_bytes += fread_member_field(segment, chunk_sizes, src);
+
+    if (read_bytes != sizeof(segment->n_rows) + sizeof(segment->chunk_sizes)) {
+        segment->n_rows = 0;
+        return 0;
+    }
+
+    ex_assert(segment->n_rows > 0 && segment->n_rows <= MAX_COLUMN_SEGMENT_ROWS, EX_CORRUPTED_REGISTRY);
+
+    size_t segment_size = read_bytes;
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        size_t fixed_size = chunk_fixed_size(i, segment->n_rows);
+        bool valid = i >= FIRST_STRING_COLUMN ? segment->chunk_sizes[i] >= fixed_size : segment->chunk_sizes[i] == fixed_size;
+        ex_assert(valid, EX_CORRUPTED_REGISTRY);
+
+        segment_size += segment->chunk_sizes[i];
+    }
+
+    segment->chunks_offset = (size_t) ftell(src);
+
+    return segment_size;
+}
+
+/**
+ * Checks a loaded string chunk's end offsets (non decreasing and ending at the chunk's end)
+ * @param segment target segment
+ * @param column the column index
+ */
+static void validate_string_chunk(ColumnSegment* segment, uint8_t column) {
+    size_t bitmap_size = null_words(segment->n_rows) * sizeof(uint64_t);
+    size_t data_size = segment->chunk_sizes[column] - chunk_fixed_size(column, segment->n_rows);
+    const uint32_t* ends = (const uint32_t*) (segment->chunks[column] + bitmap_size);
+
+    uint32_t previous = 0;
+    for (uint32_t row = 0; row < segment->n_rows; row++) {
+        ex_assert(ends[row] >= previous, EX_CORRUPTED_REGISTRY);
+        previous = ends[row];
+    }
+
+    ex_assert(previous == data_size, EX_CORRUPTED_REGISTRY);
+}
+
+/**
+ * Loads the requested chunks of a segment (already loaded ones are kept)
+ * @param segment target segment
+ * @param src source file
+ * @param fields requested columns (FM_* flags)
+ * @return if every requested chunk was loaded (false if the file is truncated)
+ */
+bool load_column_segment(ColumnSegment* segment, FILE* src, field_mask_t fields) {
+    ex_assert(segment != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    size_t chunk_offset = segment->chunks_offset;
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        field_mask_t column = (field_mask_t) (1 << i);
+        size_t chunk_size = segment->chunk_sizes[i];
+
+        if ((fields & column) != 0 && (segment->loaded & column) == 0) {
+            // Chunks are kept on malloc'd memory, so the values after the 64-bit bitmap words stay aligned
+            if (segment->chunk_capacities[i] < chunk_size) {
+                char* chunk = realloc(segment->chunks[i], chunk_size);
+                ex_assert(chunk != NULL, EX_MEMORY_ERROR);
+                segment->chunks[i] = chunk;
+                segment->chunk_capacities[i] = chunk_size;
+            }
+
+            if (fseek(src, (long) chunk_offset, SEEK_SET) != 0 || fread(segment->chunks[i], 1, chunk_size, src) != chunk_size) {
+                return false;
+            }
+
+            if (i >= FIRST_STRING_COLUMN) {
+                validate_string_chunk(segment, i);
+            }
+
+            segment->loaded |= column;
+        }
+
+        chunk_offset += chunk_size;
+    }
+
+    return true;
+}
+
+/**
+ * Checks if a row's field is null, from its column's null bitmap (the column must be loaded)
+ * @param segment target segment
+ * @param column the column (FM_* flag)
+ * @param row the row on the segment
+ * @return if the field is null
+ */
+bool is_column_null(ColumnSegment* segment, field_mask_t column, uint32_t row) {
+    ex_assert(segment != NULL, EX_GENERIC_ERROR);
+    ex_assert((segment->loaded & column) != 0, EX_GENERIC_ERROR);
+    ex_assert(row < segment->n_rows, EX_GENERIC_ERROR);
+
+    const uint64_t* bitmap = (const uint64_t*) segment->chunks[column_index(column)];
+    return (bitmap[row / 64] >> (row % 64)) & 1;
+}
+
+/**
+ * Builds a view over a segment row (only the loaded columns are filled, the other fields are null)
+ *
+ * The view is only valid while the segment chunks are kept
+ * @param segment source segment
+ * @param registry_type the source registry type
+ * @param row the row on the segment
+ * @param view the view to be filled
+ */
+void view_column_segment_row(ColumnSegment* segment, RegistryType registry_type, uint32_t row, RegistryView* view) {
+    ex_assert(segment != NULL, EX_GENERIC_ERROR);
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+    ex_assert(row < segment->n_rows, EX_GENERIC_ERROR);
+
+    // Rows have no offset on a row file
+    setup_registry_view(view, registry_type, SIZE_MAX);
+
+    size_t bitmap_size = null_words(segment->n_rows) * sizeof(uint64_t);
+
+    int32_t* numbers[NUMBER_COLUMNS] = {&view->id, &view->ano, &view->qtt};
+    for (uint8_t i = 0; i < NUMBER_COLUMNS; i++) {
+        if ((segment->loaded & (1 << i)) != 0) {
+            *numbers[i] = ((const int32_t*) (segment->chunks[i] + bitmap_size))[row];
+        }
+    }
+
+    if ((segment->loaded & FM_SIGLA) != 0) {
+        memcpy(view->sigla, segment->chunks[SIGLA_COLUMN] + bitmap_size + (size_t) row * REGISTRY_SIGLA_SIZE, REGISTRY_SIGLA_SIZE);
+    }
+
+    StrSlice* strings[] = {&view->cidade, &view->marca, &view->modelo};
+    for (uint8_t i = FIRST_STRING_COLUMN; i < COLUMN_COUNT; i++) {
+        field_mask_t column = (field_mask_t) (1 << i);
+        if ((segment->loaded & column) == 0 || is_column_null(segment, column, row)) {
+            continue;
+        }
+
+        const uint32_t* ends = (const uint32_t*) (segment->chunks[i] + bitmap_size);
+        const char* data = segment->chunks[i] + chunk_fixed_size(i, segment->n_rows);
+
+        uint32_t start = row == 0 ? 0 : ends[row - 1];
+        *strings[i - FIRST_STRING_COLUMN] = make_str_slice(data + start, (strlen_t) (ends[row] - start));
+    }
+}
+
+// Writer //
+
+/**
+ * Appends a registry to the segment being built, writing the segment once full
+ * @param writer target writer
+ * @param view the registry view
+ */
+void column_writer_append(ColumnWriter* writer, RegistryView* view) {
+    ex_assert(writer != NULL, EX_GENERIC_ERROR);
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+
+    uint32_t row = writer->n_rows;
+
+    // Null integers are stored as -1 on every row format
+    int32_t numbers[NUMBER_COLUMNS] = {view->id, view->ano, view->qtt};
+    for (uint8_t i = 0; i < NUMBER_COLUMNS; i++) {
+        writer->numbers[i][row] = numbers[i];
+        if (numbers[i] == -1) {
+            set_null(writer->nulls[i], row);
+        }
+    }
+
+    memcpy(writer->siglas + (size_t) row * REGISTRY_SIGLA_SIZE, view->sigla, REGISTRY_SIGLA_SIZE);
+    if (view->sigla[0] == FILLER_BYTE[0]) {
+        set_null(writer->nulls[SIGLA_COLUMN], row);
+    }
+
+    StrSlice strings[] = {view->cidade, view->marca, view->modelo};
+    for (uint8_t i = 0; i < 3; i++) {
+        uint32_t start = row == 0 ? 0 : writer->string_ends[i][row - 1];
+
+        if (strings[i].data == NULL) {
+            set_null(writer->nulls[FIRST_STRING_COLUMN + i], row);
+            writer->string_ends[i][row] = start;
+            continue;
+        }
+
+        size_t end = (size_t) start + strings[i].len;
+        ex_assert(end <= UINT32_MAX, EX_GENERIC_ERROR);
+
+        if (writer->string_capacities[i] < end) {
+            size_t capacity = max(end, 2 * writer->string_capacities[i]);
+            char* bytes = realloc(writer->strings[i], capacity);
+            ex_assert(bytes != NULL, EX_MEMORY_ERROR);
+            writer->strings[i] = bytes;
+            writer->string_capacities[i] = capacity;
+        }
+
+        memcpy(writer->strings[i] + start, strings[i].data, strings[i].len);
+        writer->string_ends[i][row] = (uint32_t) end;
+    }
+
+    writer->n_rows++;
+    if (writer->n_rows == writer->segment_rows) {
+        column_writer_flush(writer);
+    }
+}
+
+/**
+ * Writes the segment being built, if it has any row
+ * @param writer target writer
+ */
+void column_writer_flush(ColumnWriter* writer) {
+    ex_assert(writer != NULL, EX_GENERIC_ERROR);
+    ex_assert(writer->dest != NULL, EX_FILE_ERROR);
+
+    uint32_t n_rows = writer->n_rows;
+    if (n_rows == 0) {
+        return;
+    }
+
+    size_t bitmap_size = null_words(n_rows) * sizeof(uint64_t);
+
+    uint32_t chunk_sizes[COLUMN_COUNT];
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        size_t chunk_size = chunk_fixed_size(i, n_rows);
+        if (i >= FIRST_STRING_COLUMN) {
+            chunk_size += writer->string_ends[i - FIRST_STRING_COLUMN][n_rows - 1];
+        }
+
+        ex_assert(chunk_size <= UINT32_MAX, EX_GENERIC_ERROR);
+        chunk_sizes[i] = (uint32_t) chunk_size;
+    }
+
+    fwrite(&n_rows, sizeof(n_rows), 1, writer->dest);
+    fwrite(chunk_sizes, sizeof(chunk_sizes), 1, writer->dest);
+
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        fwrite(writer->nulls[i], 1, bitmap_size, writer->dest);
+
+        if (i < NUMBER_COLUMNS) {
+            fwrite(writer->numbers[i], sizeof(int32_t), n_rows, writer->dest);
+        } else if (i == SIGLA_COLUMN) {
+            fwrite(writer->siglas, REGISTRY_SIGLA_SIZE, n_rows, writer->dest);
+        } else {
+            uint8_t string = i - FIRST_STRING_COLUMN;
+            fwrite(writer->string_ends[string], sizeof(uint32_t), n_rows, writer->dest);
+            fwrite(writer->strings[string], 1, writer->string_ends[string][n_rows - 1], writer->dest);
+        }
+
+        // Next segment starts with no null rows
+        memset(writer->nulls[i], 0, bitmap_size);
+    }
+
+    writer->header->nroRegistros += (int32_t) n_rows;
+    writer->header->nroSegmentos++;
+    writer->n_rows = 0;
+}
+
+// Setup //
+
+/**
+ * Setups the given columnar file header (as an empty file of the given source type)
+ * @param header target header
+ * @param registry_type the source registry type
+ */
+void setup_column_file_header(ColumnFileHeader* header, RegistryType registry_type) {
+    header->status = STATUS_GOOD;
+
+    if (header->header_content == NULL) {
+        header->header_content = new_header_content();
+    } else {
+        setup_header_content(header->header_content);
+    }
+
+    header->tipoOrigem = registry_type;
+    header->nroRegistros = 0;
+    header->nroSegmentos = 0;
+    header->registrosPorSegmento = 0;
+}
+
+/**
+ * Setups the given segment as an empty segment
+ * @param segment target segment
+ */
+void setup_column_segment(ColumnSegment* segment) {
+    segment->n_rows = 0;
+    memset(segment->chunk_sizes, 0, sizeof(segment->chunk_sizes));
+    segment->chunks_offset = 0;
+    segment->loaded = 0;
+}
+
+// Allocators //
+
+/**
+ * Allocates and setup a new columnar file header
+ * @param registry_type the source registry type
+ * @return the allocated header
+ */
+ColumnFileHeader* new_column_file_header(RegistryType registry_type) {
+    ColumnFileHeader* header = malloc(sizeof(struct ColumnFileHeader));
+    ex_assert(header != NULL, EX_MEMORY_ERROR);
+    header->header_content = NULL;
+    setup_column_file_header(header, registry_type);
+    return header;
+}
+
+/**
+ * Allocates and setup a new empty segment
+ * @return the allocated segment
+ */
+ColumnSegment* new_column_segment() {
+    ColumnSegment* segment = malloc(sizeof(struct ColumnSegment));
+    ex_assert(segment != NULL, EX_MEMORY_ERROR);
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        segment->chunks[i] = NULL;
+        segment->chunk_capacities[i] = 0;
+    }
+    setup_column_segment(segment);
+    return segment;
+}
+
+/**
+ * Allocates a new writer, segments are written at the destination file's current position
+ * @param header the file's header (its counts are updated on each written segment)
+ * @param dest destination file
+ * @param segment_rows rows per segment
+ * @return the allocated writer
+ */
+ColumnWriter* new_column_writer(ColumnFileHeader* header, FILE* dest, uint32_t segment_rows) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+    ex_assert(segment_rows > 0 && segment_rows <= MAX_COLUMN_SEGMENT_ROWS, EX_GENERIC_ERROR);
+
+    ColumnWriter* writer = malloc(sizeof(struct ColumnWriter));
+    ex_assert(writer != NULL, EX_MEMORY_ERROR);
+
+    writer->header = header;
+    writer->dest = dest;
+    writer->segment_rows = segment_rows;
+    writer->n_rows = 0;
+
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        writer->nulls[i] = calloc(null_words(segment_rows), sizeof(uint64_t));
+        ex_assert(writer->nulls[i] != NULL, EX_MEMORY_ERROR);
+    }
+
+    for (uint8_t i = 0; i < NUMBER_COLUMNS; i++) {
+        writer->numbers[i] = malloc(segment_rows * sizeof(int32_t));
+        ex_assert(writer->numbers[i] != NULL, EX_MEMORY_ERROR);
+    }
+
+    writer->siglas = malloc((size_t) segment_rows * REGISTRY_SIGLA_SIZE);
+    ex_assert(writer->siglas != NULL, EX_MEMORY_ERROR);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        writer->string_ends[i] = malloc(segment_rows * sizeof(uint32_t));
+        ex_assert(writer->string_ends[i] != NULL, EX_MEMORY_ERROR);
+        writer->strings[i] = NULL;
+        writer->string_capacities[i] = 0;
+    }
+
+    header->registrosPorSegmento = (int32_t) segment_rows;
+
+    return writer;
+}
+
+// Destroy //
+
+/**
+ * Destroys (frees) the given columnar file header and its contents
+ * @param header target header
+ */
+void destroy_column_file_header(ColumnFileHeader* header) {
+    if (header == NULL) {
+        return;
+    }
+
+    destroy_header_content(header->header_content);
+    free(header);
+}
+
+/**
+ * Destroys (frees) the given segment and its chunks
+ * @param segment target segment
+ */
+void destroy_column_segment(ColumnSegment* segment) {
+    if (segment == NULL) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        free(segment->chunks[i]);
+    }
+    free(segment);
+}
+
+/**
+ * Destroys (frees) the given writer (pending rows must be flushed before)
+ * @param writer target writer
+ */
+void destroy_column_writer(ColumnWriter* writer) {
+    if (writer == NULL) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < COLUMN_COUNT; i++) {
+        free(writer->nulls[i]);
+    }
+    for (uint8_t i = 0; i < NUMBER_COLUMNS; i++) {
+        free(writer->numbers[i]);
+    }
+    free(writer->siglas);
+    for (uint8_t i = 0; i < 3; i++) {
+        free(writer->string_ends[i]);
+        free(writer->strings[i]);
+    }
+    free(writer);
+}
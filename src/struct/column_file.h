@@ -0,0 +1,212 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "registry.h"
+#include "registry_content.h"
+#include "registry_view.h"
+
+// Columns of a columnar file, in FM_* flag order (column i holds the field of flag 1 << i)
+#define COLUMN_COUNT 7
+
+// Default amount of rows per segment
+#define DEFAULT_COLUMN_SEGMENT_ROWS 8192
+
+// Upper bound on rows per segment (every column chunk of a segment must fit in memory)
+#define MAX_COLUMN_SEGMENT_ROWS (1 << 20)
+
+/**
+ * Columnar file header
+ *
+ * The file holds the live registries of a row file (tipoOrigem), split into segments of registrosPorSegmento rows.
+ * The header content is kept so the registries print just like they did on the row file.
+ */
+typedef struct ColumnFileHeader {
+    char status;
+    HeaderContent* header_content;
+    int32_t tipoOrigem;
+    int32_t nroRegistros;
+    int32_t nroSegmentos;
+    int32_t registrosPorSegmento;
+} ColumnFileHeader;
+
+static const size_t COLUMN_FILE_HEADER_SIZE = 186;
+
+/**
+ * Segment of a columnar file
+ *
+ * On the file a segment is its row count and the size of each column chunk, followed by the chunks. Every chunk
+ * starts with its null bitmap (64-bit words, bit i is set if row i is null) followed by the values: int32 values for
+ * id, ano and qtt (-1 on null rows), 2 bytes per row for sigla ('$' filled on null rows) and, for the strings, the
+ * uint32 end offset of each row's bytes followed by the bytes themselves (null rows take no bytes).
+ *
+ * Chunks are only loaded when a column is requested, the others are skipped on the file
+ */
+typedef struct ColumnSegment {
+    uint32_t n_rows;
+    uint32_t chunk_sizes[COLUMN_COUNT];
+
+    // File offset of the first chunk
+    size_t chunks_offset;
+
+    // Loaded chunks (FM_* flags)
+    field_mask_t loaded;
+    char* chunks[COLUMN_COUNT];
+    size_t chunk_capacities[COLUMN_COUNT];
+} ColumnSegment;
+
+/**
+ * Builds columnar segments from appended registries, writing each one once full
+ */
+typedef struct ColumnWriter {
+    ColumnFileHeader* header;
+    FILE* dest;
+    uint32_t segment_rows;
+    uint32_t n_rows;
+
+    uint64_t* nulls[COLUMN_COUNT];
+    int32_t* numbers[3];
+    char* siglas;
+
+    // String columns (cidade, marca and modelo)
+    uint32_t* string_ends[3];
+    char* strings[3];
+    size_t string_capacities[3];
+} ColumnWriter;
+
+// File I/O //
+
+/**
+ * Writes the given columnar file header into the target file
+ * @param header header to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_column_file_header(ColumnFileHeader* header, FILE* dest);
+
+/**
+ * Reads the given columnar file header from the target file
+ * @param header header to be read into
+ * @param src source file
+ * @return the amount of bytes read (0 if the file is too short)
+ */
+size_t read_column_file_header(ColumnFileHeader* header, FILE* src);
+
+// Segments //
+
+/**
+ * Reads a segment's row count and chunk sizes at the file's current position (its chunks are only loaded on request)
+ * @param segment target segment (previously loaded chunks are dropped)
+ * @param src source file
+ * @return the segment's total size on the file (0 if it is truncated)
+ */
+size_t read_column_segment(ColumnSegment* segment, FILE* src);
+
+/**
+ * Loads the requested chunks of a segment (already loaded ones are kept)
+ * @param segment target segment
+ * @param src source file
+ * @param fields requested columns (FM_* flags)
+ * @return if every requested chunk was loaded (false if the file is truncated)
+ */
+bool load_column_segment(ColumnSegment* segment, FILE* src, field_mask_t fields);
+
+/**
+ * Checks if a row's field is null, from its column's null bitmap (the column must be loaded)
+ * @param segment target segment
+ * @param column the column (FM_* flag)
+ * @param row the row on the segment
+ * @return if the field is null
+ */
+bool is_column_null(ColumnSegment* segment, field_mask_t column, uint32_t row);
+
+/**
+ * Builds a view over a segment row (only the loaded columns are filled, the other fields are null)
+ *
+ * The view is only valid while the segment chunks are kept
+ * @param segment source segment
+ * @param registry_type the source registry type
+ * @param row the row on the segment
+ * @param view the view to be filled
+ */
+void view_column_segment_row(ColumnSegment* segment, RegistryType registry_type, uint32_t row, RegistryView* view);
+
+// Writer //
+
+/**
+ * Appends a registry to the segment being built, writing the segment once full
+ * @param writer target writer
+ * @param view the registry view
+ */
+void column_writer_append(ColumnWriter* writer, RegistryView* view);
+
+/**
+ * Writes the segment being built, if it has any row
+ * @param writer target writer
+ */
+void column_writer_flush(ColumnWriter* writer);
+
+// Setup //
+
+/**
+ * Setups the given columnar file header (as an empty file of the given source type)
+ * @param header target header
+ * @param registry_type the source registry type
+ */
+void setup_column_file_header(ColumnFileHeader* header, RegistryType registry_type);
+
+/**
+ * Setups the given segment as an empty segment
+ * @param segment target segment
+ */
+void setup_column_segment(ColumnSegment* segment);
+
+// Allocators //
+
+/**
+ * Allocates and setup a new columnar file header
+ * @param registry_type the source registry type
+ * @return the allocated header
+ */
+ColumnFileHeader* new_column_file_header(RegistryType registry_type);
+
+/**
+ * Allocates and setup a new empty segment
+ * @return the allocated segment
+ */
+ColumnSegment* new_column_segment();
+
+/**
+ * Allocates a new writer, segments are written at the destination file's current position
+ * @param header the file's header (its counts are updated on each written segment)
+ * @param dest destination file
+ * @param segment_rows rows per segment
+ * @return the allocated writer
+ */
+ColumnWriter* new_column_writer(ColumnFileHeader* header, FILE* dest, uint32_t segment_rows);
+
+// Destroy //
+
+/**
+ * Destroys (frees) the given columnar file header and its contents
+ * @param header target header
+ */
+void destroy_column_file_header(ColumnFileHeader* header);
+
+/**
+ * Destroys (frees) the given segment and its chunks
+ * @param segment target segment
+ */
+void destroy_column_segment(ColumnSegment* segment);
+
+/**
+ * Destroys (frees) the given writer (pending rows must be flushed before)
+ * @param writer target writer
+ */
+void destroy_column_writer(ColumnWriter* writer);
@@ -7,6 +7,9 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include "../exception/exception.h"
+#include "../utils/utils.h"
+
 /**
  * Write n filler bytes into a file
  * @param n number of bytes to write
@@ -14,13 +17,34 @@
  * @return number of bytes written
  */
 size_t fill_bytes(size_t n, FILE* file) {
+    // Write the filler in bulk, from a pre-filled block
+    char filler[128];
+    memset(filler, FILLER_BYTE[0], sizeof(filler));
+
     size_t written_bytes = 0;
-    for (int i = 0; i < n / sizeof(char); i++) {
-        written_bytes += fwrite(FILLER_BYTE, sizeof(char), 1, file);
+    while (written_bytes < n) {
+        size_t chunk = min(n - written_bytes, sizeof(filler));
+        size_t chunk_written = fwrite(filler, sizeof(char), chunk, file);
+        written_bytes += chunk_written;
+
+        if (chunk_written < chunk) {
+            break;
+        }
     }
     return written_bytes;
 }
 
+/**
+ * Write n filler bytes into a memory buffer
+ * @param n number of bytes to write
+ * @param dest the destination buffer (must have enough room)
+ * @return number of bytes written
+ */
+size_t mfill_bytes(size_t n, char* dest) {
+    memset(dest, FILLER_BYTE[0], n);
+    return n;
+}
+
 /**
  * Write a variable length string into a file
  * @param str the string to be written
@@ -49,6 +73,35 @@ size_t fwrite_var_len_str(char* str, strlen_t len, char* code, FILE* file) {
     return written_bytes;
 }
 
+/**
+ * Write a variable length string into a memory buffer (same layout as fwrite_var_len_str)
+ * @param str the string to be written
+ * @param len the string length
+ * @param code the column code
+ * @param dest the destination buffer (must have enough room)
+ * @return number of bytes written
+ */
+size_t mwrite_var_len_str(char* str, strlen_t len, char* code, char* dest) {
+    size_t written_bytes = 0;
+
+    if (len == 0 || str == NULL) {
+        return written_bytes;
+    }
+
+    memcpy(dest + written_bytes, &len, sizeof(strlen_t));
+    written_bytes += sizeof(strlen_t);
+    if (code == NULL) {
+        memset(dest + written_bytes, FILLER_BYTE[0], CODE_FIELD_LEN);
+    } else {
+        memcpy(dest + written_bytes, code, sizeof(char) * CODE_FIELD_LEN);
+    }
+    written_bytes += sizeof(char) * CODE_FIELD_LEN;
+    memcpy(dest + written_bytes, str, sizeof(char) * len);
+    written_bytes += sizeof(char) * len;
+
+    return written_bytes;
+}
+
 /**
  * Reads a variable length string from a file
  * @param file the source file
@@ -79,4 +132,46 @@ VarLenStrField fread_var_len_str(FILE* file) {
 
     str_field.read_bytes = read_bytes;
     return str_field;
-}
\ No newline at end of file
+}
+
+/**
+ * Reads a variable length string from a memory buffer (same semantics as fread_var_len_str)
+ * @param src the source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the variable length spring data
+ */
+VarLenStrField mread_var_len_str(const char* src, size_t available) {
+    size_t read_bytes = 0;
+    VarLenStrField str_field = {0, {0}, NULL, 0};
+
+    ex_assert(available >= sizeof(strlen_t) + CODE_FIELD_LEN, EX_CORRUPTED_REGISTRY);
+
+    // Read string length
+    memcpy(&str_field.size, src, sizeof(strlen_t));
+    read_bytes += sizeof(strlen_t);
+
+    if (str_field.size <= 0) {
+        return (VarLenStrField){-1, {0}, NULL, read_bytes};
+    }
+
+    // Read field code
+    memcpy(str_field.code, src + read_bytes, sizeof(char) * CODE_FIELD_LEN);
+    read_bytes += sizeof(char) * CODE_FIELD_LEN;
+
+    if (str_field.code[0] == '$') {
+        return (VarLenStrField){-1, {0}, NULL, read_bytes};
+    }
+
+    // Strings can't extend past the readable area
+    if (str_field.size > available - read_bytes) {
+        return (VarLenStrField){-1, {0}, NULL, available};
+    }
+
+    // Copy the string itself
+    str_field.data = calloc(str_field.size + 1, sizeof(char));
+    memcpy(str_field.data, src + read_bytes, sizeof(char) * str_field.size);
+    read_bytes += sizeof(char) * str_field.size;
+
+    str_field.read_bytes = read_bytes;
+    return str_field;
+}
@@ -6,10 +6,14 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 
 // Types //
 #define strlen_t uint32_t
 
+// Type used to represent a set of registry fields (FM_* bit flags)
+#define field_mask_t uint8_t
+
 
 // Consts //
 // Length of column's short-code indicator
@@ -30,9 +34,24 @@
 // Static bytes for var_len field
 #define STATIC_VAR_LEN_SIZE 6
 
+// Bytes of the fixed fields every registry content starts with (id, ano, qtt and sigla)
+#define STATIC_CONTENT_SIZE (3 * sizeof(int32_t) + REGISTRY_SIGLA_SIZE)
+
 // Reference to filler byte
 static const char FILLER_BYTE[1] = {'$'};
 
+// Registry field flags, used to project reads into a subset of the fields
+#define FM_ID 0x01
+#define FM_ANO 0x02
+#define FM_QTT 0x04
+#define FM_SIGLA 0x08
+#define FM_CIDADE 0x10
+#define FM_MARCA 0x20
+#define FM_MODELO 0x40
+#define FM_FIX_LEN (FM_ID | FM_ANO | FM_QTT | FM_SIGLA)
+#define FM_VAR_LEN (FM_CIDADE | FM_MARCA | FM_MODELO)
+#define FM_ALL (FM_FIX_LEN | FM_VAR_LEN)
+
 
 // Structs //
 // Struct to represent the results of reading a variable length string
@@ -62,6 +81,24 @@ size_t fwrite_var_len_str(char* str, strlen_t len, char* code, FILE* file);
  */
 VarLenStrField fread_var_len_str(FILE* file);
 
+/**
+ * Reads a variable length string from a memory buffer (same semantics as fread_var_len_str)
+ * @param src the source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the variable length spring data
+ */
+VarLenStrField mread_var_len_str(const char* src, size_t available);
+
+/**
+ * Write a variable length string into a memory buffer (same layout as fwrite_var_len_str)
+ * @param str the string to be written
+ * @param len the string length
+ * @param code the column code
+ * @param dest the destination buffer (must have enough room)
+ * @return number of bytes written
+ */
+size_t mwrite_var_len_str(char* str, strlen_t len, char* code, char* dest);
+
 /**
  * Write n filler bytes into a file
  * @param n number of bytes to write
@@ -70,6 +107,14 @@ VarLenStrField fread_var_len_str(FILE* file);
  */
 size_t fill_bytes(size_t n, FILE* file);
 
+/**
+ * Write n filler bytes into a memory buffer
+ * @param n number of bytes to write
+ * @param dest the destination buffer (must have enough room)
+ * @return number of bytes written
+ */
+size_t mfill_bytes(size_t n, char* dest);
+
 
 // Macros //
 
@@ -86,6 +131,15 @@ size_t fill_bytes(size_t n, FILE* file);
  */
 #define fwrite_member_field(struct_ptr, member, file) fwrite(&((struct_ptr)->member), 1, sizeof((struct_ptr)->member), file)
 
+/**
+ * Macro for writing a structs field into a memory buffer
+ *
+ * @param struct_ptr target struct's pointer
+ * @param member struct's member to be written
+ * @param dest destination buffer to write the data into
+ */
+#define mwrite_member_field(struct_ptr, member, dest) (memcpy((dest), &((struct_ptr)->member), sizeof((struct_ptr)->member)), sizeof((struct_ptr)->member))
+
 /**
  * Macro for reading a structs field from a file
  *
@@ -95,6 +149,15 @@ size_t fill_bytes(size_t n, FILE* file);
  */
 #define fread_member_field(struct_ptr, member, file) fread(&((struct_ptr)->member), 1, sizeof((struct_ptr)->member), file)
 
+/**
+ * Macro for reading a structs field from a memory buffer
+ *
+ * @param struct_ptr target struct's pointer
+ * @param member struct's member to be read
+ * @param src source buffer to read the data from
+ */
+#define mread_member_field(struct_ptr, member, src) (memcpy(&((struct_ptr)->member), (src), sizeof((struct_ptr)->member)), sizeof((struct_ptr)->member))
+
 /**
  * Macro for writing variable length strings struct fields into a file in a cleaner way to read
  *
@@ -104,4 +167,15 @@ size_t fill_bytes(size_t n, FILE* file);
  * @param code_field struct's string column code field name
  * @param file target file to write the data to
  */
-#define fwrite_member_var_len_str(struct_ptr, str_pointer_field, len_field, code_field, file) fwrite_var_len_str((struct_ptr)->str_pointer_field, (struct_ptr)->len_field, (struct_ptr)->code_field, file)
\ No newline at end of file
+#define fwrite_member_var_len_str(struct_ptr, str_pointer_field, len_field, code_field, file) fwrite_var_len_str((struct_ptr)->str_pointer_field, (struct_ptr)->len_field, (struct_ptr)->code_field, file)
+
+/**
+ * Macro for writing variable length strings struct fields into a memory buffer in a cleaner way to read
+ *
+ * @param struct_ptr target struct's pointer
+ * @param str_pointer_field struct's string pointer field name
+ * @param len_field struct's string length field name
+ * @param code_field struct's string column code field name
+ * @param dest destination buffer to write the data to
+ */
+#define mwrite_member_var_len_str(struct_ptr, str_pointer_field, len_field, code_field, dest) mwrite_var_len_str((struct_ptr)->str_pointer_field, (struct_ptr)->len_field, (struct_ptr)->code_field, dest)
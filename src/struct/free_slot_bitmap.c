@@ -0,0 +1,450 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "free_slot_bitmap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+#include "t1_registry.h"
+
+// Slots per bitmap word
+#define SLOTS_PER_WORD 64
+
+/**
+ * Allocates a new empty free slot bitmap
+ * @return the allocated bitmap
+ */
+FreeSlotBitmap* new_free_slot_bitmap() {
+    FreeSlotBitmap* free_slot_bitmap = malloc(sizeof(struct FreeSlotBitmap));
+    ex_assert(free_slot_bitmap != NULL, EX_MEMORY_ERROR);
+
+    free_slot_bitmap->words = NULL;
+    free_slot_bitmap->n_words = 0;
+    free_slot_bitmap->n_free = 0;
+
+    free_slot_bitmap->status = STATUS_BAD;
+    free_slot_bitmap->topo = -1;
+    free_slot_bitmap->proxRRN = 0;
+    free_slot_bitmap->nroRegRem = 0;
+
+    return free_slot_bitmap;
+}
+
+/**
+ * Destroys (frees) the given free slot bitmap
+ * @param free_slot_bitmap target bitmap
+ */
+void destroy_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap) {
+    if (free_slot_bitmap == NULL) {
+        return;
+    }
+
+    free(free_slot_bitmap->words);
+    free(free_slot_bitmap);
+}
+
+/**
+ * Builds the sidecar path for a data file
+ * @param data_path the data file path
+ * @return the allocated sidecar path
+ */
+char* free_slot_bitmap_path(const char* data_path) {
+    size_t len = strlen(data_path);
+    char* path = malloc(len + sizeof(FREE_SLOT_BITMAP_FILE_SUFFIX));
+    ex_assert(path != NULL, EX_MEMORY_ERROR);
+
+    memcpy(path, data_path, len);
+    memcpy(path + len, FREE_SLOT_BITMAP_FILE_SUFFIX, sizeof(FREE_SLOT_BITMAP_FILE_SUFFIX));
+    return path;
+}
+
+// Bit search //
+
+/**
+ * Grows the bitmap until it covers the given amount of words (new words are empty)
+ * @param free_slot_bitmap target bitmap
+ * @param n_words amount of words
+ */
+static void reserve_words(FreeSlotBitmap* free_slot_bitmap, size_t n_words) {
+    if (n_words <= free_slot_bitmap->n_words) {
+        return;
+    }
+
+    n_words = max(n_words, free_slot_bitmap->n_words * 2);
+    free_slot_bitmap->words = realloc(free_slot_bitmap->words, n_words * sizeof(uint64_t));
+    ex_assert(free_slot_bitmap->words != NULL, EX_MEMORY_ERROR);
+
+    memset(free_slot_bitmap->words + free_slot_bitmap->n_words, 0, (n_words - free_slot_bitmap->n_words) * sizeof(uint64_t));
+    free_slot_bitmap->n_words = n_words;
+}
+
+/**
+ * Finds the lowest free slot from the given RRN on
+ * @param free_slot_bitmap target bitmap
+ * @param rrn first RRN considered
+ * @return the free RRN (-1 if there are none)
+ */
+static int32_t next_free_slot(FreeSlotBitmap* free_slot_bitmap, int64_t rrn) {
+    size_t word = (size_t) rrn / SLOTS_PER_WORD;
+    if (word >= free_slot_bitmap->n_words) {
+        return -1;
+    }
+
+    // Skip the bits before the RRN on its own word
+    uint64_t bits = free_slot_bitmap->words[word] & (~UINT64_C(0) << (rrn % SLOTS_PER_WORD));
+
+    while (bits == 0) {
+        if (++word == free_slot_bitmap->n_words) {
+            return -1;
+        }
+        bits = free_slot_bitmap->words[word];
+    }
+
+    return (int32_t) (word * SLOTS_PER_WORD + __builtin_ctzll(bits));
+}
+
+/**
+ * Finds the highest free slot before the given RRN
+ * @param free_slot_bitmap target bitmap
+ * @param rrn first RRN not considered
+ * @return the free RRN (-1 if there are none)
+ */
+static int32_t prev_free_slot(FreeSlotBitmap* free_slot_bitmap, int64_t rrn) {
+    rrn = min(rrn, (int64_t) (free_slot_bitmap->n_words * SLOTS_PER_WORD));
+    if (rrn <= 0) {
+        return -1;
+    }
+
+    size_t word = (size_t) (rrn - 1) / SLOTS_PER_WORD;
+
+    // Skip the RRN and the bits after it on its own word
+    uint64_t bits = free_slot_bitmap->words[word] & (~UINT64_C(0) >> (SLOTS_PER_WORD - 1 - (rrn - 1) % SLOTS_PER_WORD));
+
+    while (bits == 0) {
+        if (word-- == 0) {
+            return -1;
+        }
+        bits = free_slot_bitmap->words[word];
+    }
+
+    return (int32_t) (word * SLOTS_PER_WORD + (SLOTS_PER_WORD - 1 - __builtin_clzll(bits)));
+}
+
+/**
+ * Checks if a slot is free
+ * @param free_slot_bitmap target bitmap
+ * @param rrn target RRN
+ * @return if the slot is free
+ */
+static bool is_slot_free(FreeSlotBitmap* free_slot_bitmap, int32_t rrn) {
+    size_t word = (size_t) rrn / SLOTS_PER_WORD;
+    return word < free_slot_bitmap->n_words && (free_slot_bitmap->words[word] >> (rrn % SLOTS_PER_WORD) & 1);
+}
+
+// Operations //
+
+/**
+ * Marks a slot as free
+ * @param free_slot_bitmap target bitmap
+ * @param rrn the removed registry RRN
+ * @param prev where the previous free RRN will be stored (-1 if the slot is the lowest one, may be NULL)
+ * @param next where the next free RRN will be stored (-1 if the slot is the highest one, may be NULL)
+ */
+void free_slot_add(FreeSlotBitmap* free_slot_bitmap, int32_t rrn, int32_t* prev, int32_t* next) {
+    ex_assert(rrn >= 0, EX_CORRUPTED_REGISTRY);
+    ex_assert(!is_slot_free(free_slot_bitmap, rrn), EX_CORRUPTED_REGISTRY);
+
+    reserve_words(free_slot_bitmap, (size_t) rrn / SLOTS_PER_WORD + 1);
+
+    if (prev != NULL) {
+        *prev = prev_free_slot(free_slot_bitmap, rrn);
+    }
+    if (next != NULL) {
+        *next = next_free_slot(free_slot_bitmap, (int64_t) rrn + 1);
+    }
+
+    free_slot_bitmap->words[rrn / SLOTS_PER_WORD] |= UINT64_C(1) << (rrn % SLOTS_PER_WORD);
+    free_slot_bitmap->n_free++;
+}
+
+/**
+ * Takes the lowest free slots
+ * @param free_slot_bitmap target bitmap
+ * @param rrns where the taken RRNs will be stored (in ascending order)
+ * @param n maximum amount of slots taken
+ * @return the amount of slots taken
+ */
+size_t free_slot_take(FreeSlotBitmap* free_slot_bitmap, int32_t* rrns, size_t n) {
+    size_t taken = 0;
+    n = min(n, (size_t) free_slot_bitmap->n_free);
+
+    // Whole words are consumed lowest bit first
+    for (size_t word = 0; word < free_slot_bitmap->n_words && taken < n; word++) {
+        uint64_t bits = free_slot_bitmap->words[word];
+
+        while (bits != 0 && taken < n) {
+            rrns[taken++] = (int32_t) (word * SLOTS_PER_WORD + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+
+        free_slot_bitmap->words[word] = bits;
+    }
+
+    free_slot_bitmap->n_free -= (int32_t) taken;
+    return taken;
+}
+
+/**
+ * Retrieves the lowest free slot (the removed registries stack's top)
+ * @param free_slot_bitmap target bitmap
+ * @return the lowest free RRN (-1 if there are none)
+ */
+int32_t free_slot_first(FreeSlotBitmap* free_slot_bitmap) {
+    if (free_slot_bitmap->n_free == 0) {
+        return -1;
+    }
+
+    return next_free_slot(free_slot_bitmap, 0);
+}
+
+/**
+ * Fills the bitmap from the data file's removed registries stack
+ * @param free_slot_bitmap target (empty) bitmap
+ * @param header the data file header
+ * @param file the data file
+ * @param sorted where the stack order will be stored (if it was already sorted by RRN)
+ * @return if the stack was valid (no repeated or out of bounds RRNs, matching the header's removed count)
+ */
+bool build_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap, Header* header, FILE* file, bool* sorted) {
+    ex_assert(header->registry_type == RT_FIX_LEN, EX_CORRUPTED_REGISTRY);
+
+    T1HeaderMetadata* header_metadata = header->header_metadata;
+    Registry* registry = build_registry(header);
+    T1RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+    reserve_words(free_slot_bitmap, (size_t) max(header_metadata->proxRRN, 0) / SLOTS_PER_WORD + 1);
+
+    int32_t current = header_metadata->topo;
+    int32_t last = -1;
+    bool valid = true;
+    *sorted = true;
+
+    while (valid && current != -1) {
+        // Only the metadata matters, removed registries have no content to decode (a repeated RRN means a cycle)
+        valid = free_slot_bitmap->n_free < header_metadata->nroRegRem && current >= 0 && !is_slot_free(free_slot_bitmap, current);
+        valid = valid && seek_registry(header, file, (size_t) current);
+        valid = valid && read_registry_projected(registry, file, 0) != 0 && is_registry_removed(registry);
+
+        if (valid) {
+            free_slot_add(free_slot_bitmap, current, NULL, NULL);
+
+            *sorted = *sorted && current > last;
+            last = current;
+            current = registry_metadata->prox;
+        }
+    }
+
+    destroy_registry(registry);
+
+    return valid && free_slot_bitmap->n_free == header_metadata->nroRegRem;
+}
+
+/**
+ * Relinks the removed registries stack in RRN order (lowest on top)
+ * @param free_slot_bitmap the stack's bitmap
+ * @param header the data file header (its top is updated)
+ * @param file the data file
+ */
+static void sort_free_slot_stack(FreeSlotBitmap* free_slot_bitmap, Header* header, FILE* file) {
+    T1HeaderMetadata* header_metadata = header->header_metadata;
+    header_metadata->topo = free_slot_first(free_slot_bitmap);
+
+    // Only the next references change, written in file order
+    for (int32_t current = header_metadata->topo; current != -1;) {
+        int32_t next = next_free_slot(free_slot_bitmap, (int64_t) current + 1);
+        size_t written = t1_write_registry_prox((size_t) current, next, file);
+        ex_assert(written == sizeof(int32_t), EX_FILE_ERROR);
+        current = next;
+    }
+}
+
+// File I/O //
+
+/**
+ * Writes the free slot bitmap into the given file
+ * @param free_slot_bitmap target bitmap
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap, FILE* dest) {
+    ex_assert(free_slot_bitmap != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    size_t written_bytes = 0;
+
+    written_bytes += fwrite_member_field(free_slot_bitmap, status, dest);
+    written_bytes += fwrite_member_field(free_slot_bitmap, topo, dest);
+    written_bytes += fwrite_member_field(free_slot_bitmap, proxRRN, dest);
+    written_bytes += fwrite_member_field(free_slot_bitmap, nroRegRem, dest);
+
+    // Trailing empty words aren't stored
+    size_t n_words = free_slot_bitmap->n_words;
+    while (n_words > 0 && free_slot_bitmap->words[n_words - 1] == 0) {
+        n_words--;
+    }
+
+    uint32_t n_stored_words = (uint32_t) n_words;
+    written_bytes += fwrite(&n_stored_words, 1, sizeof(n_stored_words), dest);
+    written_bytes += fwrite(free_slot_bitmap->words, sizeof(uint64_t), n_words, dest) * sizeof(uint64_t);
+
+    return written_bytes;
+}
+
+/**
+ * Reads the free slot bitmap from the given file
+ * @param free_slot_bitmap target (empty) bitmap
+ * @param src source file
+ * @return the amount of bytes read (0 on invalid files)
+ */
+size_t read_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap, FILE* src) {
+    ex_assert(free_slot_bitmap != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    size_t read_bytes = 0;
+
+    read_bytes += fread_member_field(free_slot_bitmap, status, src);
+    read_bytes += fread_member_field(free_slot_bitmap, topo, src);
+    read_bytes += fread_member_field(free_slot_bitmap, proxRRN, src);
+    read_bytes += fread_member_field(free_slot_bitmap, nroRegRem, src);
+
+    uint32_t n_words = 0;
+    if (fread(&n_words, 1, sizeof(n_words), src) != sizeof(n_words)) {
+        return 0;
+    }
+    read_bytes += sizeof(n_words);
+
+    if (free_slot_bitmap->status != STATUS_GOOD || free_slot_bitmap->proxRRN < 0 || free_slot_bitmap->nroRegRem < 0) {
+        return 0;
+    }
+
+    // Every free slot lies before the next RRN
+    if (n_words > ((size_t) free_slot_bitmap->proxRRN + SLOTS_PER_WORD - 1) / SLOTS_PER_WORD) {
+        return 0;
+    }
+
+    reserve_words(free_slot_bitmap, (size_t) free_slot_bitmap->proxRRN / SLOTS_PER_WORD + 1);
+    if (fread(free_slot_bitmap->words, sizeof(uint64_t), n_words, src) != n_words) {
+        return 0;
+    }
+    read_bytes += n_words * sizeof(uint64_t);
+
+    int64_t n_free = 0;
+    for (size_t i = 0; i < n_words; i++) {
+        n_free += __builtin_popcountll(free_slot_bitmap->words[i]);
+    }
+
+    if (n_free != free_slot_bitmap->nroRegRem || next_free_slot(free_slot_bitmap, free_slot_bitmap->proxRRN) != -1) {
+        return 0;
+    }
+    free_slot_bitmap->n_free = (int32_t) n_free;
+
+    return read_bytes;
+}
+
+/**
+ * Loads the data file's free slot bitmap, from its sidecar or else from the removed registries stack (which is relinked
+ * in RRN order if needed). The sidecar is deleted until the bitmap is saved again, so a command interrupted midway
+ * never leaves an outdated one behind
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @return the loaded bitmap (NULL for variable length files, when disabled through SETTING_FREE_SLOT_BITMAP or when
+ * the stack is invalid)
+ */
+FreeSlotBitmap* load_free_slot_bitmap(Header* header, FILE* file, const char* data_path) {
+    // Only fixed length files have a stack of slots
+    if (header->registry_type != RT_FIX_LEN) {
+        return NULL;
+    }
+
+    char* path = free_slot_bitmap_path(data_path);
+
+    // Commands popping the stack one by one still outdate the sidecar
+    if (!get_size_setting(SETTING_FREE_SLOT_BITMAP, 0, 0, 1)) {
+        remove(path);
+        free(path);
+        return NULL;
+    }
+
+    FreeSlotBitmap* free_slot_bitmap = new_free_slot_bitmap();
+
+    FILE* free_slot_bitmap_file = fopen(path, "rb");
+
+    bool valid = false;
+    if (free_slot_bitmap_file != NULL) {
+        valid = read_free_slot_bitmap(free_slot_bitmap, free_slot_bitmap_file) != 0;
+        fclose(free_slot_bitmap_file);
+        remove(path);
+    }
+    free(path);
+
+    // The bitmap must describe the current stack
+    T1HeaderMetadata* header_metadata = header->header_metadata;
+    valid = valid && free_slot_bitmap->topo == header_metadata->topo;
+    valid = valid && free_slot_bitmap->proxRRN == header_metadata->proxRRN;
+    valid = valid && free_slot_bitmap->nroRegRem == header_metadata->nroRegRem;
+    valid = valid && free_slot_first(free_slot_bitmap) == header_metadata->topo;
+
+    // Rebuild from the stack
+    if (!valid) {
+        destroy_free_slot_bitmap(free_slot_bitmap);
+        free_slot_bitmap = new_free_slot_bitmap();
+
+        bool sorted;
+        if (!build_free_slot_bitmap(free_slot_bitmap, header, file, &sorted)) {
+            destroy_free_slot_bitmap(free_slot_bitmap);
+            return NULL;
+        }
+
+        if (!sorted) {
+            sort_free_slot_stack(free_slot_bitmap, header, file);
+        }
+    }
+
+    return free_slot_bitmap;
+}
+
+/**
+ * Writes the data file's free slot bitmap to its sidecar (no-op if the header has no bitmap)
+ * @param header the data file header (with its changes already written)
+ * @param data_path the data file path
+ */
+void save_free_slot_bitmap(Header* header, const char* data_path) {
+    FreeSlotBitmap* free_slot_bitmap = header->free_slot_bitmap;
+    if (free_slot_bitmap == NULL) {
+        return;
+    }
+
+    T1HeaderMetadata* header_metadata = header->header_metadata;
+    free_slot_bitmap->status = STATUS_GOOD;
+    free_slot_bitmap->topo = header_metadata->topo;
+    free_slot_bitmap->proxRRN = header_metadata->proxRRN;
+    free_slot_bitmap->nroRegRem = header_metadata->nroRegRem;
+
+    char* path = free_slot_bitmap_path(data_path);
+    FILE* file = fopen(path, "wb");
+    free(path);
+
+    // The sidecar is just an accelerator, failing to write it isn't an error
+    if (file == NULL) {
+        return;
+    }
+
+    write_free_slot_bitmap(free_slot_bitmap, file);
+    fclose(file);
+}
@@ -0,0 +1,126 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "registry.h"
+
+// Sidecar file holding the free slot bitmap of a data file (<data file path><suffix>)
+#define FREE_SLOT_BITMAP_FILE_SUFFIX ".fsb"
+
+/**
+ * Free slot bitmap for fixed length files: one bit per RRN, set for removed registries
+ *
+ * While the bitmap is in use the on-disk removed registries stack is kept sorted by RRN (lowest on top), so any amount
+ * of free slots can be handed out at once, in file order, by popping the stack's top, and a removal only relinks its
+ * previous free slot. The header fields seen when the bitmap was saved validate the sidecar on load.
+ */
+typedef struct FreeSlotBitmap {
+    uint64_t* words;
+    size_t n_words;
+    int32_t n_free;
+
+    // Header state matching the bitmap
+    char status;
+    int32_t topo;
+    int32_t proxRRN;
+    int32_t nroRegRem;
+} FreeSlotBitmap;
+
+// Memory management //
+
+/**
+ * Allocates a new empty free slot bitmap
+ * @return the allocated bitmap
+ */
+FreeSlotBitmap* new_free_slot_bitmap();
+
+/**
+ * Destroys (frees) the given free slot bitmap
+ * @param free_slot_bitmap target bitmap
+ */
+void destroy_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap);
+
+/**
+ * Builds the sidecar path for a data file
+ * @param data_path the data file path
+ * @return the allocated sidecar path
+ */
+char* free_slot_bitmap_path(const char* data_path);
+
+// Operations //
+
+/**
+ * Marks a slot as free
+ * @param free_slot_bitmap target bitmap
+ * @param rrn the removed registry RRN
+ * @param prev where the previous free RRN will be stored (-1 if the slot is the lowest one, may be NULL)
+ * @param next where the next free RRN will be stored (-1 if the slot is the highest one, may be NULL)
+ */
+void free_slot_add(FreeSlotBitmap* free_slot_bitmap, int32_t rrn, int32_t* prev, int32_t* next);
+
+/**
+ * Takes the lowest free slots
+ * @param free_slot_bitmap target bitmap
+ * @param rrns where the taken RRNs will be stored (in ascending order)
+ * @param n maximum amount of slots taken
+ * @return the amount of slots taken
+ */
+size_t free_slot_take(FreeSlotBitmap* free_slot_bitmap, int32_t* rrns, size_t n);
+
+/**
+ * Retrieves the lowest free slot (the removed registries stack's top)
+ * @param free_slot_bitmap target bitmap
+ * @return the lowest free RRN (-1 if there are none)
+ */
+int32_t free_slot_first(FreeSlotBitmap* free_slot_bitmap);
+
+/**
+ * Fills the bitmap from the data file's removed registries stack
+ * @param free_slot_bitmap target (empty) bitmap
+ * @param header the data file header
+ * @param file the data file
+ * @param sorted where the stack order will be stored (if it was already sorted by RRN)
+ * @return if the stack was valid (no repeated or out of bounds RRNs, matching the header's removed count)
+ */
+bool build_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap, Header* header, FILE* file, bool* sorted);
+
+/**
+ * Writes the free slot bitmap into the given file
+ * @param free_slot_bitmap target bitmap
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap, FILE* dest);
+
+/**
+ * Reads the free slot bitmap from the given file
+ * @param free_slot_bitmap target (empty) bitmap
+ * @param src source file
+ * @return the amount of bytes read (0 on invalid files)
+ */
+size_t read_free_slot_bitmap(FreeSlotBitmap* free_slot_bitmap, FILE* src);
+
+/**
+ * Loads the data file's free slot bitmap, from its sidecar or else from the removed registries stack (which is relinked
+ * in RRN order if needed). The sidecar is deleted until the bitmap is saved again, so a command interrupted midway
+ * never leaves an outdated one behind
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @return the loaded bitmap (NULL for variable length files, when disabled through SETTING_FREE_SLOT_BITMAP or when
+ * the stack is invalid)
+ */
+FreeSlotBitmap* load_free_slot_bitmap(Header* header, FILE* file, const char* data_path);
+
+/**
+ * Writes the data file's free slot bitmap to its sidecar (no-op if the header has no bitmap)
+ * @param header the data file header (with its changes already written)
+ * @param data_path the data file path
+ */
+void save_free_slot_bitmap(Header* header, const char* data_path);
@@ -0,0 +1,438 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "free_space_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/settings.h"
+#include "../utils/utils.h"
+#include "t2_registry.h"
+
+/**
+ * Allocates a new empty free space map
+ * @param policy slot reuse policy
+ * @return the allocated map
+ */
+FreeSpaceMap* new_free_space_map(FitPolicy policy) {
+    FreeSpaceMap* free_space_map = malloc(sizeof(struct FreeSpaceMap));
+    ex_assert(free_space_map != NULL, EX_MEMORY_ERROR);
+
+    free_space_map->policy = policy;
+    free_space_map->classes = NULL;
+    free_space_map->n_classes = 0;
+    free_space_map->capacity = 0;
+
+    free_space_map->status = STATUS_BAD;
+    free_space_map->topo = -1;
+    free_space_map->proxByteOffset = 0;
+    free_space_map->nroRegRem = 0;
+
+    return free_space_map;
+}
+
+/**
+ * Destroys (frees) the given free space map
+ * @param free_space_map target map
+ */
+void destroy_free_space_map(FreeSpaceMap* free_space_map) {
+    if (free_space_map == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < free_space_map->n_classes; i++) {
+        free(free_space_map->classes[i].offsets);
+    }
+
+    free(free_space_map->classes);
+    free(free_space_map);
+}
+
+/**
+ * Builds the sidecar path for a data file
+ * @param data_path the data file path
+ * @return the allocated sidecar path
+ */
+char* free_space_map_path(const char* data_path) {
+    size_t len = strlen(data_path);
+    char* path = malloc(len + sizeof(FREE_SPACE_MAP_FILE_SUFFIX));
+    ex_assert(path != NULL, EX_MEMORY_ERROR);
+
+    memcpy(path, data_path, len);
+    memcpy(path + len, FREE_SPACE_MAP_FILE_SUFFIX, sizeof(FREE_SPACE_MAP_FILE_SUFFIX));
+    return path;
+}
+
+// Size classes //
+
+/**
+ * Finds the position of a size among the classes (biggest first)
+ * @param free_space_map target map
+ * @param size target size
+ * @return the index of the first class not bigger than the size
+ */
+static size_t find_size_class(FreeSpaceMap* free_space_map, uint32_t size) {
+    size_t low = 0;
+    size_t high = free_space_map->n_classes;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (free_space_map->classes[mid].size > size) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Offset of a class' first removed registry in list order
+ * @param size_class target class
+ * @return the offset
+ */
+static int64_t class_front(SizeClass* size_class) {
+    return size_class->offsets[size_class->first];
+}
+
+/**
+ * Offset of a class' last removed registry in list order
+ * @param size_class target class
+ * @return the offset
+ */
+static int64_t class_back(SizeClass* size_class) {
+    return size_class->offsets[size_class->n_offsets - 1];
+}
+
+/**
+ * Adds a removed registry to the map
+ * @param free_space_map target map
+ * @param offset removed registry offset
+ * @param size removed registry size (tamanhoRegistro)
+ * @param prev where the previous list node offset will be stored (-1 if the registry is the list's new front)
+ * @param next where the next list node offset will be stored (-1 if the registry is the list's new end)
+ */
+void free_space_add(FreeSpaceMap* free_space_map, int64_t offset, uint32_t size, int64_t* prev, int64_t* next) {
+    size_t position = find_size_class(free_space_map, size);
+
+    // New size, the class goes between the bigger and the smaller ones
+    if (position == free_space_map->n_classes || free_space_map->classes[position].size != size) {
+        if (free_space_map->n_classes == free_space_map->capacity) {
+            free_space_map->capacity = max(free_space_map->capacity * 2, 16);
+            free_space_map->classes = realloc(free_space_map->classes, free_space_map->capacity * sizeof(struct SizeClass));
+            ex_assert(free_space_map->classes != NULL, EX_MEMORY_ERROR);
+        }
+
+        memmove(&free_space_map->classes[position + 1], &free_space_map->classes[position], (free_space_map->n_classes - position) * sizeof(struct SizeClass));
+        free_space_map->classes[position] = (SizeClass){size, NULL, 0, 0, 0};
+        free_space_map->n_classes++;
+    }
+
+    SizeClass* size_class = &free_space_map->classes[position];
+
+    // Equal sizes are kept in removal order, so the registry goes after every removed registry at least as big
+    if (size_class->n_offsets > size_class->first) {
+        *prev = class_back(size_class);
+    } else {
+        *prev = position > 0 ? class_back(&free_space_map->classes[position - 1]) : -1;
+    }
+    *next = position + 1 < free_space_map->n_classes ? class_front(&free_space_map->classes[position + 1]) : -1;
+
+    // Drop taken offsets before growing
+    if (size_class->n_offsets == size_class->capacity && size_class->first > 0) {
+        size_class->n_offsets -= size_class->first;
+        memmove(size_class->offsets, size_class->offsets + size_class->first, size_class->n_offsets * sizeof(int64_t));
+        size_class->first = 0;
+    }
+
+    if (size_class->n_offsets == size_class->capacity) {
+        size_class->capacity = max(size_class->capacity * 2, 16);
+        size_class->offsets = realloc(size_class->offsets, size_class->capacity * sizeof(int64_t));
+        ex_assert(size_class->offsets != NULL, EX_MEMORY_ERROR);
+    }
+
+    size_class->offsets[size_class->n_offsets++] = offset;
+}
+
+/**
+ * Takes a removed registry from the map for a new registry (picked according to the map's policy)
+ * @param free_space_map target map
+ * @param needed_size size required by the new registry (tamanhoRegistro)
+ * @param offset where the removed registry offset will be stored
+ * @param size where the removed registry size will be stored
+ * @param prev where the previous list node offset will be stored (-1 if the registry was the list's front)
+ * @param next where the next list node offset will be stored (-1 if the registry was the list's end)
+ * @return if a removed registry was taken
+ */
+bool free_space_take(FreeSpaceMap* free_space_map, uint32_t needed_size, int64_t* offset, uint32_t* size, int64_t* prev, int64_t* next) {
+    if (free_space_map->n_classes == 0 || free_space_map->classes[0].size < needed_size) {
+        return false;
+    }
+
+    // Worst-fit takes the list front, best-fit the front of the last class big enough
+    size_t position = 0;
+    if (free_space_map->policy == FP_BEST_FIT) {
+        position = find_size_class(free_space_map, needed_size);
+        if (position == free_space_map->n_classes || free_space_map->classes[position].size != needed_size) {
+            position--;
+        }
+    }
+
+    SizeClass* size_class = &free_space_map->classes[position];
+    *offset = class_front(size_class);
+    *size = size_class->size;
+    *prev = position > 0 ? class_back(&free_space_map->classes[position - 1]) : -1;
+
+    size_class->first++;
+    if (size_class->first < size_class->n_offsets) {
+        *next = class_front(size_class);
+        return true;
+    }
+
+    // Emptied class
+    free(size_class->offsets);
+    free_space_map->n_classes--;
+    memmove(&free_space_map->classes[position], &free_space_map->classes[position + 1], (free_space_map->n_classes - position) * sizeof(struct SizeClass));
+
+    *next = position < free_space_map->n_classes ? class_front(&free_space_map->classes[position]) : -1;
+    return true;
+}
+
+/**
+ * Fills the map from the data file's removed registries list
+ * @param free_space_map target (empty) map
+ * @param header the data file header
+ * @param file the data file
+ * @return if the list was valid (sorted by size and matching the header's removed count)
+ */
+bool build_free_space_map(FreeSpaceMap* free_space_map, Header* header, FILE* file) {
+    ex_assert(header->registry_type == RT_VAR_LEN, EX_CORRUPTED_REGISTRY);
+
+    T2HeaderMetadata* header_metadata = header->header_metadata;
+    Registry* registry = build_registry(header);
+    T2RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+    int64_t current = header_metadata->topo;
+    int32_t n_removed = 0;
+    uint32_t last_size = UINT32_MAX;
+    bool valid = true;
+
+    while (valid && current != -1) {
+        // Only the metadata matters, removed registries have no content to decode
+        valid = n_removed < header_metadata->nroRegRem && current >= 0 && seek_registry(header, file, (size_t) current);
+        valid = valid && read_registry_projected(registry, file, 0) != 0 && is_registry_removed(registry);
+        valid = valid && registry_metadata->tamanhoRegistro <= last_size;
+
+        if (valid) {
+            // Sorted sizes, so the registry always lands at the end of the list
+            int64_t prev, next;
+            free_space_add(free_space_map, current, registry_metadata->tamanhoRegistro, &prev, &next);
+
+            last_size = registry_metadata->tamanhoRegistro;
+            current = registry_metadata->prox;
+            n_removed++;
+        }
+    }
+
+    destroy_registry(registry);
+
+    return valid && n_removed == header_metadata->nroRegRem;
+}
+
+// File I/O //
+
+/**
+ * Writes the free space map into the given file
+ * @param free_space_map target map
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_free_space_map(FreeSpaceMap* free_space_map, FILE* dest) {
+    ex_assert(free_space_map != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    size_t written_bytes = 0;
+
+    written_bytes += fwrite_member_field(free_space_map, status, dest);
+    written_bytes += fwrite_member_field(free_space_map, topo, dest);
+    written_bytes += fwrite_member_field(free_space_map, proxByteOffset, dest);
+    written_bytes += fwrite_member_field(free_space_map, nroRegRem, dest);
+
+    uint32_t n_classes = (uint32_t) free_space_map->n_classes;
+    written_bytes += fwrite(&n_classes, 1, sizeof(n_classes), dest);
+
+    for (size_t i = 0; i < free_space_map->n_classes; i++) {
+        SizeClass* size_class = &free_space_map->classes[i];
+        uint32_t n_offsets = (uint32_t) (size_class->n_offsets - size_class->first);
+
+        written_bytes += fwrite_member_field(size_class, size, dest);
+        written_bytes += fwrite(&n_offsets, 1, sizeof(n_offsets), dest);
+        written_bytes += fwrite(size_class->offsets + size_class->first, sizeof(int64_t), n_offsets, dest) * sizeof(int64_t);
+    }
+
+    return written_bytes;
+}
+
+/**
+ * Reads the free space map from the given file
+ * @param free_space_map target (empty) map
+ * @param src source file
+ * @return the amount of bytes read (0 on invalid files)
+ */
+size_t read_free_space_map(FreeSpaceMap* free_space_map, FILE* src) {
+    ex_assert(free_space_map != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    size_t read_bytes = 0;
+
+    read_bytes += fread_member_field(free_space_map, status, src);
+    read_bytes += fread_member_field(free_space_map, topo, src);
+    read_bytes += fread_member_field(free_space_map, proxByteOffset, src);
+    read_bytes += fread_member_field(free_space_map, nroRegRem, src);
+
+    uint32_t n_classes = 0;
+    read_bytes += fread(&n_classes, 1, sizeof(n_classes), src);
+
+    if (read_bytes == 0 || free_space_map->status != STATUS_GOOD || free_space_map->nroRegRem < 0) {
+        return 0;
+    }
+
+    // Each class holds at least one removed registry
+    if (n_classes > (uint32_t) free_space_map->nroRegRem) {
+        return 0;
+    }
+
+    int64_t n_removed = 0;
+    for (uint32_t i = 0; i < n_classes; i++) {
+        uint32_t size = 0;
+        uint32_t n_offsets = 0;
+        read_bytes += fread(&size, 1, sizeof(size), src);
+
+        // Classes must be non-empty and sorted (biggest first)
+        if (fread(&n_offsets, 1, sizeof(n_offsets), src) != sizeof(n_offsets) || n_offsets == 0) {
+            return 0;
+        }
+        if (n_removed + n_offsets > free_space_map->nroRegRem) {
+            return 0;
+        }
+        if (free_space_map->n_classes > 0 && free_space_map->classes[free_space_map->n_classes - 1].size <= size) {
+            return 0;
+        }
+
+        if (free_space_map->n_classes == free_space_map->capacity) {
+            free_space_map->capacity = max(free_space_map->capacity * 2, 16);
+            free_space_map->classes = realloc(free_space_map->classes, free_space_map->capacity * sizeof(struct SizeClass));
+            ex_assert(free_space_map->classes != NULL, EX_MEMORY_ERROR);
+        }
+
+        SizeClass* size_class = &free_space_map->classes[free_space_map->n_classes++];
+        *size_class = (SizeClass){size, malloc(n_offsets * sizeof(int64_t)), 0, 0, n_offsets};
+        ex_assert(size_class->offsets != NULL, EX_MEMORY_ERROR);
+
+        size_class->n_offsets = fread(size_class->offsets, sizeof(int64_t), n_offsets, src);
+        if (size_class->n_offsets != n_offsets) {
+            return 0;
+        }
+
+        read_bytes += sizeof(n_offsets) + n_offsets * sizeof(int64_t);
+        n_removed += n_offsets;
+    }
+
+    if (n_removed != free_space_map->nroRegRem) {
+        return 0;
+    }
+
+    return read_bytes;
+}
+
+/**
+ * Loads the data file's free space map, from its sidecar or else from the removed registries list. The sidecar is
+ * deleted until the map is saved again, so a command interrupted midway never leaves an outdated one behind
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @return the loaded map (NULL for fixed length files, when disabled through SETTING_FREE_SPACE_MAP or when the
+ * list is invalid)
+ */
+FreeSpaceMap* load_free_space_map(Header* header, FILE* file, const char* data_path) {
+    // Only variable length files have a sorted list
+    if (header->registry_type != RT_VAR_LEN) {
+        return NULL;
+    }
+
+    char* path = free_space_map_path(data_path);
+
+    // Commands walking the list still outdate the sidecar
+    FitPolicy policy = (FitPolicy) get_size_setting(SETTING_FREE_SPACE_MAP, FP_WORST_FIT, FP_DISABLED, FP_BEST_FIT);
+    if (policy == FP_DISABLED) {
+        remove(path);
+        free(path);
+        return NULL;
+    }
+
+    FreeSpaceMap* free_space_map = new_free_space_map(policy);
+
+    FILE* free_space_map_file = fopen(path, "rb");
+
+    bool valid = false;
+    if (free_space_map_file != NULL) {
+        valid = read_free_space_map(free_space_map, free_space_map_file) != 0;
+        fclose(free_space_map_file);
+        remove(path);
+    }
+    free(path);
+
+    // The map must describe the current list
+    T2HeaderMetadata* header_metadata = header->header_metadata;
+    valid = valid && free_space_map->topo == header_metadata->topo;
+    valid = valid && free_space_map->proxByteOffset == header_metadata->proxByteOffset;
+    valid = valid && free_space_map->nroRegRem == header_metadata->nroRegRem;
+    valid = valid && (free_space_map->n_classes == 0 ? header_metadata->topo == -1 : class_front(&free_space_map->classes[0]) == header_metadata->topo);
+
+    // Rebuild from the list
+    if (!valid) {
+        destroy_free_space_map(free_space_map);
+        free_space_map = new_free_space_map(policy);
+
+        if (!build_free_space_map(free_space_map, header, file)) {
+            destroy_free_space_map(free_space_map);
+            return NULL;
+        }
+    }
+
+    return free_space_map;
+}
+
+/**
+ * Writes the data file's free space map to its sidecar (no-op if the header has no map)
+ * @param header the data file header (with its changes already written)
+ * @param data_path the data file path
+ */
+void save_free_space_map(Header* header, const char* data_path) {
+    FreeSpaceMap* free_space_map = header->free_space_map;
+    if (free_space_map == NULL) {
+        return;
+    }
+
+    T2HeaderMetadata* header_metadata = header->header_metadata;
+    free_space_map->status = STATUS_GOOD;
+    free_space_map->topo = header_metadata->topo;
+    free_space_map->proxByteOffset = header_metadata->proxByteOffset;
+    free_space_map->nroRegRem = header_metadata->nroRegRem;
+
+    char* path = free_space_map_path(data_path);
+    FILE* file = fopen(path, "wb");
+    free(path);
+
+    // The sidecar is just an accelerator, failing to write it isn't an error
+    if (file == NULL) {
+        return;
+    }
+
+    write_free_space_map(free_space_map, file);
+    fclose(file);
+}
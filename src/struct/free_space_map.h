@@ -0,0 +1,146 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "registry.h"
+
+// Sidecar file holding the free space map of a data file (<data file path><suffix>)
+#define FREE_SPACE_MAP_FILE_SUFFIX ".fsm"
+
+/**
+ * Which removed registry is reused by an insertion
+ */
+typedef enum FitPolicy {
+    FP_DISABLED = 0,
+    // Biggest removed registry, only if it fits (the same one the on-disk list front gives)
+    FP_WORST_FIT = 1,
+    // Smallest removed registry that fits
+    FP_BEST_FIT = 2
+} FitPolicy;
+
+/**
+ * Removed registries of the same size, in list order
+ */
+typedef struct SizeClass {
+    uint32_t size;
+    int64_t* offsets;
+    size_t first;
+    size_t n_offsets;
+    size_t capacity;
+} SizeClass;
+
+/**
+ * Free space map for variable length files: removed registries bucketed by size class (biggest first), mirroring the
+ * on-disk removed registries list, which is kept sorted by size (ties in removal order)
+ *
+ * The list position of any size is found with a binary search over the classes, so removals and insertions only touch
+ * the neighbouring list nodes instead of walking the list. The header fields seen when the map was saved validate
+ * the sidecar on load.
+ */
+typedef struct FreeSpaceMap {
+    FitPolicy policy;
+    SizeClass* classes;
+    size_t n_classes;
+    size_t capacity;
+
+    // Header state matching the map
+    char status;
+    int64_t topo;
+    int64_t proxByteOffset;
+    int32_t nroRegRem;
+} FreeSpaceMap;
+
+// Memory management //
+
+/**
+ * Allocates a new empty free space map
+ * @param policy slot reuse policy
+ * @return the allocated map
+ */
+FreeSpaceMap* new_free_space_map(FitPolicy policy);
+
+/**
+ * Destroys (frees) the given free space map
+ * @param free_space_map target map
+ */
+void destroy_free_space_map(FreeSpaceMap* free_space_map);
+
+/**
+ * Builds the sidecar path for a data file
+ * @param data_path the data file path
+ * @return the allocated sidecar path
+ */
+char* free_space_map_path(const char* data_path);
+
+// Operations //
+
+/**
+ * Adds a removed registry to the map
+ * @param free_space_map target map
+ * @param offset removed registry offset
+ * @param size removed registry size (tamanhoRegistro)
+ * @param prev where the previous list node offset will be stored (-1 if the registry is the list's new front)
+ * @param next where the next list node offset will be stored (-1 if the registry is the list's new end)
+ */
+void free_space_add(FreeSpaceMap* free_space_map, int64_t offset, uint32_t size, int64_t* prev, int64_t* next);
+
+/**
+ * Takes a removed registry from the map for a new registry (picked according to the map's policy)
+ * @param free_space_map target map
+ * @param needed_size size required by the new registry (tamanhoRegistro)
+ * @param offset where the removed registry offset will be stored
+ * @param size where the removed registry size will be stored
+ * @param prev where the previous list node offset will be stored (-1 if the registry was the list's front)
+ * @param next where the next list node offset will be stored (-1 if the registry was the list's end)
+ * @return if a removed registry was taken
+ */
+bool free_space_take(FreeSpaceMap* free_space_map, uint32_t needed_size, int64_t* offset, uint32_t* size, int64_t* prev, int64_t* next);
+
+/**
+ * Fills the map from the data file's removed registries list
+ * @param free_space_map target (empty) map
+ * @param header the data file header
+ * @param file the data file
+ * @return if the list was valid (sorted by size and matching the header's removed count)
+ */
+bool build_free_space_map(FreeSpaceMap* free_space_map, Header* header, FILE* file);
+
+/**
+ * Writes the free space map into the given file
+ * @param free_space_map target map
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t write_free_space_map(FreeSpaceMap* free_space_map, FILE* dest);
+
+/**
+ * Reads the free space map from the given file
+ * @param free_space_map target (empty) map
+ * @param src source file
+ * @return the amount of bytes read (0 on invalid files)
+ */
+size_t read_free_space_map(FreeSpaceMap* free_space_map, FILE* src);
+
+/**
+ * Loads the data file's free space map, from its sidecar or else from the removed registries list. The sidecar is
+ * deleted until the map is saved again, so a command interrupted midway never leaves an outdated one behind
+ * @param header the data file header
+ * @param file the data file
+ * @param data_path the data file path
+ * @return the loaded map (NULL for fixed length files, when disabled through SETTING_FREE_SPACE_MAP or when the
+ * list is invalid)
+ */
+FreeSpaceMap* load_free_space_map(Header* header, FILE* file, const char* data_path);
+
+/**
+ * Writes the data file's free space map to its sidecar (no-op if the header has no map)
+ * @param header the data file header (with its changes already written)
+ * @param data_path the data file path
+ */
+void save_free_space_map(Header* header, const char* data_path);
@@ -0,0 +1,347 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "insertion_plan.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/utils.h"
+#include "free_slot_bitmap.h"
+#include "free_space_map.h"
+#include "t1_registry.h"
+#include "t2_registry.h"
+
+/**
+ * Allocates a new insertion plan over a file (the header is updated as registries are planned)
+ * @param header target file header
+ * @param file target file
+ * @return the allocated plan
+ */
+InsertionPlan* new_insertion_plan(Header* header, FILE* file) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->registry_type != RT_UNKNOWN, EX_CORRUPTED_REGISTRY);
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    InsertionPlan* plan = malloc(sizeof(struct InsertionPlan));
+    ex_assert(plan != NULL, EX_MEMORY_ERROR);
+
+    plan->header = header;
+    plan->file = file;
+    plan->front = build_registry(header);
+
+    plan->reused = NULL;
+    plan->n_reused = 0;
+    plan->reused_capacity = 0;
+    plan->reused_data = NULL;
+    plan->reused_data_used = 0;
+    plan->reused_data_capacity = 0;
+
+    plan->free_slots = NULL;
+    plan->n_free_slots = 0;
+    plan->next_free_slot = 0;
+
+    plan->links = NULL;
+    plan->n_links = 0;
+    plan->links_capacity = 0;
+
+    plan->append_offset = get_max_offset(header);
+    plan->appended_data = NULL;
+    plan->appended_data_used = 0;
+    plan->appended_data_capacity = 0;
+
+    return plan;
+}
+
+/**
+ * Reserves room for n more bytes on a growing byte buffer
+ * @param data the buffer
+ * @param used amount of bytes in use
+ * @param capacity buffer capacity
+ * @param n amount of bytes
+ * @return where the bytes should be written
+ */
+static char* reserve_plan_bytes(char** data, size_t* used, size_t* capacity, size_t n) {
+    if (*used + n > *capacity) {
+        *capacity = max(max(*capacity * 2, *used + n), 4096);
+        *data = realloc(*data, *capacity);
+        ex_assert(*data != NULL, EX_MEMORY_ERROR);
+    }
+
+    return *data + *used;
+}
+
+/**
+ * Loads the front of the removed registries list (top of the stack or head of the queue, depending on file type)
+ * @param plan target plan
+ * @param reference the front reference (RRN or byte offset)
+ * @return the front registry (owned by the plan)
+ */
+static Registry* read_free_list_front(InsertionPlan* plan, int64_t reference) {
+    seek_registry(plan->header, plan->file, (size_t) reference);
+
+    // Only the metadata matters, removed registries have no content to decode
+    read_registry_projected(plan->front, plan->file, 0);
+    ex_assert(is_registry_removed(plan->front), EX_FILE_ERROR);
+
+    return plan->front;
+}
+
+/**
+ * Plans the relink of a removed registry
+ * @param plan target plan
+ * @param offset removed registry offset
+ * @param prox its new next reference
+ */
+static void plan_link(InsertionPlan* plan, size_t offset, int64_t prox) {
+    if (plan->n_links == plan->links_capacity) {
+        plan->links_capacity = max(plan->links_capacity * 2, 64);
+        plan->links = realloc(plan->links, plan->links_capacity * sizeof(struct PlannedLink));
+        ex_assert(plan->links != NULL, EX_MEMORY_ERROR);
+    }
+
+    plan->links[plan->n_links++] = (PlannedLink){offset, prox};
+}
+
+/**
+ * Takes up to n free slots at once from the header's free slot bitmap (no-op without one), so the next insertions
+ * fill them in file order
+ * @param plan target plan
+ * @param n amount of registries about to be planned
+ */
+void reserve_free_slots(InsertionPlan* plan, size_t n) {
+    FreeSlotBitmap* free_slot_bitmap = plan->header->free_slot_bitmap;
+    if (free_slot_bitmap == NULL || n == 0) {
+        return;
+    }
+
+    // Leftovers of a previous reservation are kept in front
+    size_t n_left = plan->n_free_slots - plan->next_free_slot;
+    if (n_left > 0) {
+        memmove(plan->free_slots, plan->free_slots + plan->next_free_slot, n_left * sizeof(int32_t));
+    }
+
+    plan->free_slots = realloc(plan->free_slots, (n_left + n) * sizeof(int32_t));
+    ex_assert(plan->free_slots != NULL, EX_MEMORY_ERROR);
+
+    plan->n_free_slots = n_left + free_slot_take(free_slot_bitmap, plan->free_slots + n_left, n);
+    plan->next_free_slot = 0;
+}
+
+/**
+ * Plans the insertion of a registry, reusing the removed registry add_registry would pick (the registry's offset is set)
+ * @param plan target plan
+ * @param registry registry to be inserted (encoded right away, so it can be reused afterwards)
+ */
+void plan_insertion(InsertionPlan* plan, Registry* registry) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(plan->header->registry_type == registry->registry_type, EX_CORRUPTED_REGISTRY);
+
+    Header* header = plan->header;
+    bool reuse = false;
+    size_t reuse_offset = 0;
+
+    // Slotted registries go straight into their page (a page is written at once anyway)
+    if (header->registry_type == RT_SLOTTED) {
+        add_registry(header, registry, plan->file);
+        return;
+    }
+
+    if (header->registry_type == RT_FIX_LEN) {
+        T1HeaderMetadata* header_metadata = header->header_metadata;
+
+        // Reset registry metadata
+        t1_setup_registry_metadata(registry->registry_metadata);
+
+        if (header->free_slot_bitmap != NULL) {
+            // Reserved slots go first, then the bitmap's lowest one (the sorted stack's top either way)
+            if (plan->next_free_slot == plan->n_free_slots) {
+                reserve_free_slots(plan, 1);
+            }
+
+            if (plan->next_free_slot < plan->n_free_slots) {
+                int32_t free_slot = plan->free_slots[plan->next_free_slot++];
+                ex_assert(free_slot == header_metadata->topo, EX_FILE_ERROR);
+
+                // Slots still reserved stay linked on the stack
+                if (plan->next_free_slot < plan->n_free_slots) {
+                    header_metadata->topo = plan->free_slots[plan->next_free_slot];
+                } else {
+                    header_metadata->topo = free_slot_first(header->free_slot_bitmap);
+                }
+                header_metadata->nroRegRem--;
+
+                reuse = true;
+                reuse_offset = T1_HEADER_SIZE + (size_t) free_slot * T1_REGISTRY_SIZE;
+            }
+        } else if (header_metadata->topo != -1) {
+            // Pop the stack's top
+            Registry* top_registry = read_free_list_front(plan, header_metadata->topo);
+
+            header_metadata->topo = ((T1RegistryMetadata*) top_registry->registry_metadata)->prox;
+            header_metadata->nroRegRem--;
+
+            reuse = true;
+            reuse_offset = top_registry->offset;
+        }
+    }
+
+    if (header->registry_type == RT_VAR_LEN) {
+        T2HeaderMetadata* header_metadata = header->header_metadata;
+        T2RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+        // Reset registry metadata
+        t2_setup_registry_metadata(registry->registry_metadata);
+
+        if (header->free_space_map != NULL) {
+            int64_t slot_offset, prev_reference, next_reference;
+            uint32_t slot_size;
+            uint32_t needed_size = (uint32_t) (total_registry_size(registry) - T2_IGNORED_SIZE);
+
+            // Same pick as add_registry, the previous node is relinked when the plan is applied
+            if (free_space_take(header->free_space_map, needed_size, &slot_offset, &slot_size, &prev_reference, &next_reference)) {
+                if (prev_reference == -1) {
+                    header_metadata->topo = next_reference;
+                } else {
+                    plan_link(plan, (size_t) prev_reference, next_reference);
+                }
+                header_metadata->nroRegRem--;
+
+                reuse = true;
+                reuse_offset = (size_t) slot_offset;
+                // Copy registry size
+                registry_metadata->tamanhoRegistro = slot_size;
+            }
+        } else if (header_metadata->topo != -1) {
+            // Only the queue's front (the biggest removed registry) is ever considered
+            Registry* front_registry = read_free_list_front(plan, header_metadata->topo);
+            T2RegistryMetadata* front_registry_metadata = front_registry->registry_metadata;
+
+            if (front_registry_metadata->tamanhoRegistro + T2_IGNORED_SIZE >= total_registry_size(registry)) {
+                header_metadata->topo = front_registry_metadata->prox;
+                header_metadata->nroRegRem--;
+
+                reuse = true;
+                reuse_offset = front_registry->offset;
+                // Copy registry size
+                registry_metadata->tamanhoRegistro = front_registry_metadata->tamanhoRegistro;
+            }
+        }
+    }
+
+    size_t size = encoded_registry_size(registry);
+
+    if (reuse) {
+        if (plan->n_reused == plan->reused_capacity) {
+            plan->reused_capacity = max(plan->reused_capacity * 2, 64);
+            plan->reused = realloc(plan->reused, plan->reused_capacity * sizeof(struct PlannedSlot));
+            ex_assert(plan->reused != NULL, EX_MEMORY_ERROR);
+        }
+
+        char* dest = reserve_plan_bytes(&plan->reused_data, &plan->reused_data_used, &plan->reused_data_capacity, size);
+        encode_registry(registry, dest, reuse_offset);
+
+        plan->reused[plan->n_reused++] = (PlannedSlot){reuse_offset, plan->reused_data_used, size};
+        plan->reused_data_used += size;
+    } else {
+        // Appended registries go right after each other, from the end of the file
+        size_t offset = plan->append_offset + plan->appended_data_used;
+
+        char* dest = reserve_plan_bytes(&plan->appended_data, &plan->appended_data_used, &plan->appended_data_capacity, size);
+        encode_registry(registry, dest, offset);
+
+        plan->appended_data_used += size;
+        header_increment_next(header, size);
+    }
+}
+
+/**
+ * Compares planned slots by file offset
+ * @param a PlannedSlot ptr
+ * @param b PlannedSlot ptr
+ * @return comparison result
+ */
+static int compare_planned_slots(const void* a, const void* b) {
+    const PlannedSlot* slot_a = a;
+    const PlannedSlot* slot_b = b;
+
+    if (slot_a->offset < slot_b->offset) return -1;
+    if (slot_a->offset > slot_b->offset) return 1;
+    return 0;
+}
+
+/**
+ * Writes every planned registry into the file
+ * @param plan target plan
+ */
+void apply_insertion_plan(InsertionPlan* plan) {
+    // Relinks go first, a relinked registry reused later on is then overwritten whole
+    for (size_t i = 0; i < plan->n_links; i++) {
+        size_t written = t2_write_registry_prox(plan->links[i].offset, plan->links[i].prox, plan->file);
+        ex_assert(written == sizeof(int64_t), EX_FILE_ERROR);
+    }
+
+    // Reused slots are written in file order
+    if (plan->n_reused > 0) {
+        qsort(plan->reused, plan->n_reused, sizeof(struct PlannedSlot), compare_planned_slots);
+    }
+
+    for (size_t i = 0; i < plan->n_reused;) {
+        PlannedSlot* slot = &plan->reused[i];
+        size_t size = slot->size;
+
+        // Neighbouring slots planned in file order (holes filled lowest first) are written at once
+        for (i++; i < plan->n_reused; i++) {
+            PlannedSlot* next_slot = &plan->reused[i];
+            if (next_slot->offset != slot->offset + size || next_slot->data_offset != slot->data_offset + size) {
+                break;
+            }
+            size += next_slot->size;
+        }
+
+        go_to_offset(slot->offset, plan->file);
+        size_t written = fwrite(plan->reused_data + slot->data_offset, 1, size, plan->file);
+        ex_assert(written == size, EX_FILE_ERROR);
+    }
+
+    // Appended registries are already contiguous
+    if (plan->appended_data_used > 0) {
+        go_to_offset(plan->append_offset, plan->file);
+        size_t written = fwrite(plan->appended_data, 1, plan->appended_data_used, plan->file);
+        ex_assert(written == plan->appended_data_used, EX_FILE_ERROR);
+    }
+
+    // The plan can keep going from the new end of the file
+    plan->n_reused = 0;
+    plan->reused_data_used = 0;
+    plan->n_links = 0;
+    plan->append_offset += plan->appended_data_used;
+    plan->appended_data_used = 0;
+}
+
+/**
+ * Destroys (frees) the plan, registries not applied yet are discarded
+ * @param plan target plan
+ */
+void destroy_insertion_plan(InsertionPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+
+    // Slots reserved but never used are still linked on the stack
+    if (plan->header->free_slot_bitmap != NULL) {
+        for (size_t i = plan->next_free_slot; i < plan->n_free_slots; i++) {
+            free_slot_add(plan->header->free_slot_bitmap, plan->free_slots[i], NULL, NULL);
+        }
+    }
+
+    destroy_registry(plan->front);
+    free(plan->free_slots);
+    free(plan->reused);
+    free(plan->reused_data);
+    free(plan->links);
+    free(plan->appended_data);
+    free(plan);
+}
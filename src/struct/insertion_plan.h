@@ -0,0 +1,97 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+#include "registry.h"
+
+/**
+ * A registry planned over a removed one, written in place
+ */
+typedef struct PlannedSlot {
+    size_t offset;
+    size_t data_offset;
+    size_t size;
+} PlannedSlot;
+
+/**
+ * A removed registry relinked to a new next reference (when a removed registry is taken from the middle of the list)
+ */
+typedef struct PlannedLink {
+    size_t offset;
+    int64_t prox;
+} PlannedLink;
+
+/**
+ * Insertion batch plan: slots are assigned exactly like successive add_registry calls would, but nothing is written
+ * until the plan is applied (reused slots in file order, appended registries in a single contiguous write)
+ */
+typedef struct InsertionPlan {
+    Header* header;
+    FILE* file;
+
+    // Scratch registry used to walk the removed registries list
+    Registry* front;
+
+    // Registries reusing removed slots (encoded back to back on reused_data)
+    PlannedSlot* reused;
+    size_t n_reused;
+    size_t reused_capacity;
+    char* reused_data;
+    size_t reused_data_used;
+    size_t reused_data_capacity;
+
+    // Free slots handed out at once by the header's free slot bitmap (ascending RRNs, used in order)
+    int32_t* free_slots;
+    size_t n_free_slots;
+    size_t next_free_slot;
+
+    // Removed registries relinked around the reused ones (written before them, in plan order)
+    PlannedLink* links;
+    size_t n_links;
+    size_t links_capacity;
+
+    // Registries appended to the end of the file, starting at append_offset
+    size_t append_offset;
+    char* appended_data;
+    size_t appended_data_used;
+    size_t appended_data_capacity;
+} InsertionPlan;
+
+/**
+ * Allocates a new insertion plan over a file (the header is updated as registries are planned)
+ * @param header target file header
+ * @param file target file
+ * @return the allocated plan
+ */
+InsertionPlan* new_insertion_plan(Header* header, FILE* file);
+
+/**
+ * Takes up to n free slots at once from the header's free slot bitmap (no-op without one), so the next insertions
+ * fill them in file order
+ * @param plan target plan
+ * @param n amount of registries about to be planned
+ */
+void reserve_free_slots(InsertionPlan* plan, size_t n);
+
+/**
+ * Plans the insertion of a registry, reusing the removed registry add_registry would pick (the registry's offset is set)
+ * @param plan target plan
+ * @param registry registry to be inserted (encoded right away, so it can be reused afterwards)
+ */
+void plan_insertion(InsertionPlan* plan, Registry* registry);
+
+/**
+ * Writes every planned registry into the file (relinked removed registries first)
+ * @param plan target plan
+ */
+void apply_insertion_plan(InsertionPlan* plan);
+
+/**
+ * Destroys (frees) the plan, registries not applied yet are discarded (unused free slots go back to the bitmap)
+ * @param plan target plan
+ */
+void destroy_insertion_plan(InsertionPlan* plan);
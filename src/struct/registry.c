@@ -10,8 +10,11 @@
 #include "../const/const.h"
 #include "../exception/exception.h"
 #include "../utils/utils.h"
+#include "free_slot_bitmap.h"
+#include "free_space_map.h"
 #include "t1_registry.h"
 #include "t2_registry.h"
+#include "t3_registry.h"
 
 /**
  * Setup an already allocated header with default NULL-equivalent data
@@ -49,6 +52,21 @@ void setup_header(Header* header) {
                 t2_setup_header_metadata(header->header_metadata);
             }
             break;
+        case RT_SLOTTED:
+            // Setup header content
+            if (header->header_content == NULL) {
+                header->header_content = new_header_content();
+            } else {
+                setup_header_content(header->header_content);
+            }
+
+            // Setup header metadata
+            if (header->header_metadata == NULL) {
+                header->header_metadata = t3_new_header_metadata();
+            } else {
+                t3_setup_header_metadata(header->header_metadata);
+            }
+            break;
         default:
             header->registry_type = RT_UNKNOWN;
             header->header_metadata = NULL;
@@ -94,6 +112,21 @@ void setup_registry(Registry* registry) {
                 t2_setup_registry_metadata(registry->registry_metadata);
             }
             break;
+        case RT_SLOTTED:
+            // Setup registry content
+            if (registry->registry_content == NULL) {
+                registry->registry_content = new_registry_content();
+            } else {
+                setup_registry_content(registry->registry_content);
+            }
+
+            // Setup registry metadata
+            if (registry->registry_metadata == NULL) {
+                registry->registry_metadata = t3_new_registry_metadata();
+            } else {
+                t3_setup_registry_metadata(registry->registry_metadata);
+            }
+            break;
         default:
             registry->registry_type = RT_UNKNOWN;
             registry->registry_content = NULL;
@@ -109,6 +142,8 @@ void setup_registry(Registry* registry) {
 Header* new_header() {
     Header* header = malloc(sizeof(struct Header));
     header->registry_type = RT_UNKNOWN;
+    header->free_space_map = NULL;
+    header->free_slot_bitmap = NULL;
     setup_header(header);
     return header;
 }
@@ -135,6 +170,8 @@ void destroy_header(Header* header) {
 
     // Destroy content
     destroy_header_content(header->header_content);
+    destroy_free_space_map(header->free_space_map);
+    destroy_free_slot_bitmap(header->free_slot_bitmap);
 
     // Destroy metadata
     switch (header->registry_type) {
@@ -144,6 +181,9 @@ void destroy_header(Header* header) {
         case RT_VAR_LEN:
             t2_destroy_header_metadata(header->header_metadata);
             break;
+        case RT_SLOTTED:
+            t3_destroy_header_metadata(header->header_metadata);
+            break;
         default:
             break;
     }
@@ -172,6 +212,9 @@ void destroy_registry(Registry* registry) {
         case RT_VAR_LEN:
             t2_destroy_registry_metadata(registry->registry_metadata);
             break;
+        case RT_SLOTTED:
+            t3_destroy_registry_metadata(registry->registry_metadata);
+            break;
         default:
             break;
     }
@@ -211,6 +254,10 @@ Header* build_default_header(RegistryType registry_type) {
             memcpy(header->header_metadata, &DEFAULT_T2_HEADER_METADATA, sizeof(struct T2HeaderMetadata));
             memcpy(header->header_content, &DEFAULT_HEADER_CONTENT, sizeof(struct HeaderContent));
             break;
+        case RT_SLOTTED:
+            memcpy(header->header_metadata, &DEFAULT_T3_HEADER_METADATA, sizeof(struct T3HeaderMetadata));
+            memcpy(header->header_content, &DEFAULT_HEADER_CONTENT, sizeof(struct HeaderContent));
+            break;
         default:
             ex_raise(EX_GENERIC_ERROR);
             break;
@@ -263,6 +310,9 @@ size_t write_header(Header* header, FILE* dest) {
         case RT_VAR_LEN:
             written_bytes += t2_write_header(header, dest);
             break;
+        case RT_SLOTTED:
+            written_bytes += t3_write_header(header, dest);
+            break;
         default:
             ex_raise(EX_CORRUPTED_REGISTRY);
             break;
@@ -292,6 +342,9 @@ size_t read_header(Header* header, FILE* src) {
         case RT_VAR_LEN:
             read_bytes += t2_read_header(header, src);
             break;
+        case RT_SLOTTED:
+            read_bytes += t3_read_header(header, src);
+            break;
         default:
             ex_raise(EX_CORRUPTED_REGISTRY);
             break;
@@ -321,6 +374,42 @@ size_t write_registry(Registry* registry, FILE* dest) {
         case RT_VAR_LEN:
             written_bytes += t2_write_registry(registry, dest);
             break;
+        case RT_SLOTTED:
+            written_bytes += t3_write_registry(registry, dest);
+            break;
+        default:
+            ex_raise(EX_CORRUPTED_REGISTRY);
+            break;
+    }
+
+    return written_bytes;
+}
+
+/**
+ * Encodes a registry into a memory buffer (same bytes as write_registry)
+ * @param registry the registry to be encoded
+ * @param dest the destination buffer (must hold at least encoded_registry_size bytes)
+ * @param offset the file offset the encoded bytes will be written at
+ * @return the amount of bytes written
+ */
+size_t encode_registry(Registry* registry, char* dest, size_t offset) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_GENERIC_ERROR);
+
+    registry->offset = offset;
+
+    size_t written_bytes = 0;
+
+    switch (registry->registry_type) {
+        case RT_FIX_LEN:
+            written_bytes += t1_encode_registry(registry, dest);
+            break;
+        case RT_VAR_LEN:
+            written_bytes += t2_encode_registry(registry, dest);
+            break;
+        case RT_SLOTTED:
+            written_bytes += t3_encode_registry(registry, dest);
+            break;
         default:
             ex_raise(EX_CORRUPTED_REGISTRY);
             break;
@@ -329,6 +418,27 @@ size_t write_registry(Registry* registry, FILE* dest) {
     return written_bytes;
 }
 
+/**
+ * Computes the amount of bytes written when encoding (or writing) a registry
+ * @param registry the target registry
+ * @return the encoded size
+ */
+size_t encoded_registry_size(Registry* registry) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+
+    switch (registry->registry_type) {
+        case RT_FIX_LEN:
+            return t1_encoded_registry_size(registry);
+        case RT_VAR_LEN:
+            return t2_encoded_registry_size(registry);
+        case RT_SLOTTED:
+            return t3_encoded_registry_size(registry);
+        default:
+            ex_raise(EX_CORRUPTED_REGISTRY);
+            return 0;
+    }
+}
+
 /**
  * Reads a registry from the given file
  * @param registry the registry ptr on which the data will be read into
@@ -336,6 +446,17 @@ size_t write_registry(Registry* registry, FILE* dest) {
  * @return the amount of bytes read
  */
 size_t read_registry(Registry* registry, FILE* src) {
+    return read_registry_projected(registry, src, FM_ALL);
+}
+
+/**
+ * Reads a registry from the given file, decoding only the projected fields (see read_registry_content_projected)
+ * @param registry the registry ptr on which the data will be read into
+ * @param src the source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t read_registry_projected(Registry* registry, FILE* src, field_mask_t fields) {
     ex_assert(registry != NULL, EX_GENERIC_ERROR);
     ex_assert(src != NULL, EX_FILE_ERROR);
 
@@ -347,10 +468,77 @@ size_t read_registry(Registry* registry, FILE* src) {
 
     switch (registry->registry_type) {
         case RT_FIX_LEN:
-            read_bytes += t1_read_registry(registry, src);
+            read_bytes += t1_read_registry_projected(registry, src, fields);
+            break;
+        case RT_VAR_LEN:
+            read_bytes += t2_read_registry_projected(registry, src, fields);
+            break;
+        case RT_SLOTTED:
+            read_bytes += t3_read_registry_projected(registry, src, fields);
+            break;
+        default:
+            ex_raise(EX_CORRUPTED_REGISTRY);
+            break;
+    }
+
+    return read_bytes;
+}
+
+/**
+ * Decodes the fields left out when the registry was read with a projection (no-op for fully read registries)
+ *
+ * The file is left positioned right after the registry
+ * @param registry the partially read registry
+ * @param src the source file
+ * @return the amount of bytes read
+ */
+size_t read_registry_remaining(Registry* registry, FILE* src) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    RegistryContent* registry_content = registry->registry_content;
+    if (is_registry_removed(registry) || (registry_content->decoded_fields & FM_ALL) == FM_ALL) {
+        return 0;
+    }
+
+    size_t metadata_size = registry_metadata_size(registry->registry_type);
+    size_t registry_size = total_registry_size(registry);
+
+    // Decode again from the content's beginning, skipping the fields already decoded
+    go_to_offset(registry->offset + metadata_size, src);
+    size_t read_bytes = read_registry_content_remaining(registry_content, src, registry_size - metadata_size);
+    go_to_offset(registry->offset + registry_size, src);
+
+    return read_bytes;
+}
+
+/**
+ * Reads a registry from a memory buffer holding the file's bytes (e.g. a mapped file)
+ * @param registry the registry ptr on which the data will be read into
+ * @param src the source buffer (positioned at the registry's beginning)
+ * @param available amount of bytes that can be safely read from the buffer
+ * @param offset the registry's offset on the file
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t read_registry_from_buffer(Registry* registry, const char* src, size_t available, size_t offset) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_GENERIC_ERROR);
+
+    setup_registry(registry);
+
+    registry->offset = offset;
+
+    size_t read_bytes = 0;
+
+    switch (registry->registry_type) {
+        case RT_FIX_LEN:
+            read_bytes += t1_read_registry_from_buffer(registry, src, available);
             break;
         case RT_VAR_LEN:
-            read_bytes += t2_read_registry(registry, src);
+            read_bytes += t2_read_registry_from_buffer(registry, src, available);
+            break;
+        case RT_SLOTTED:
+            read_bytes += t3_read_registry_from_buffer(registry, src, available);
             break;
         default:
             ex_raise(EX_CORRUPTED_REGISTRY);
@@ -360,6 +548,67 @@ size_t read_registry(Registry* registry, FILE* src) {
     return read_bytes;
 }
 
+/**
+ * Retrieves the amount of metadata bytes at the beginning of every registry of the given type
+ * @param registry_type the registry type
+ * @return the metadata size
+ */
+size_t registry_metadata_size(RegistryType registry_type) {
+    switch (registry_type) {
+        case RT_FIX_LEN:
+            return member_size(T1RegistryMetadata, removido) + member_size(T1RegistryMetadata, prox);
+        case RT_VAR_LEN:
+            return T2_IGNORED_SIZE + member_size(T2RegistryMetadata, prox);
+        case RT_SLOTTED:
+            return T3_IGNORED_SIZE + member_size(T3RegistryMetadata, slot);
+        default:
+            ex_raise(EX_CORRUPTED_REGISTRY);
+            return 0;
+    }
+}
+
+/**
+ * Peeks a registry's total size on the file from its metadata bytes, without decoding the registry
+ * @param registry_type the registry type
+ * @param src the source buffer (positioned at the registry's beginning)
+ * @param available amount of bytes that can be safely read from the buffer
+ * @param removed output for the registry's removal status
+ * @return the registry size (0 if the metadata isn't fully available)
+ */
+size_t peek_registry_size(RegistryType registry_type, const char* src, size_t available, bool* removed) {
+    if (available < registry_metadata_size(registry_type)) {
+        return 0;
+    }
+
+    if (registry_type == RT_FIX_LEN) {
+        T1RegistryMetadata registry_metadata;
+        size_t read_bytes = mread_member_field(&registry_metadata, removido, src);
+        ex_assert(read_bytes <= available, EX_CORRUPTED_REGISTRY);
+        *removed = registry_metadata.removido == REMOVED;
+        return T1_REGISTRY_SIZE;
+    }
+
+    if (registry_type == RT_VAR_LEN) {
+        T2RegistryMetadata registry_metadata;
+        size_t read_bytes = mread_member_field(&registry_metadata, removido, src);
+        read_bytes += mread_member_field(&registry_metadata, tamanhoRegistro, src + read_bytes);
+        ex_assert(read_bytes <= available, EX_CORRUPTED_REGISTRY);
+        *removed = registry_metadata.removido == REMOVED;
+        return registry_metadata.tamanhoRegistro + T2_IGNORED_SIZE;
+    }
+
+    if (registry_type == RT_SLOTTED) {
+        T3RegistryMetadata registry_metadata;
+        size_t read_bytes = mread_member_field(&registry_metadata, removido, src);
+        read_bytes += mread_member_field(&registry_metadata, tamanhoRegistro, src + read_bytes);
+        ex_assert(read_bytes <= available, EX_CORRUPTED_REGISTRY);
+        *removed = registry_metadata.removido == REMOVED;
+        return registry_metadata.tamanhoRegistro + T3_IGNORED_SIZE;
+    }
+
+    return 0;
+}
+
 /**
  * Calculates the total registry size (actual number of bytes on the file).
  *
@@ -380,6 +629,12 @@ size_t total_registry_size(Registry* registry) {
         return T2_IGNORED_SIZE + registry_size;
     }
 
+    if (registry->registry_type == RT_SLOTTED) {
+        T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+        size_t registry_size = max(t3_minimum_registry_size(registry), registry_metadata->tamanhoRegistro);
+        return T3_IGNORED_SIZE + registry_size;
+    }
+
     return 0;
 }
 
@@ -399,16 +654,28 @@ void remove_registry(Header* header, Registry* registry, FILE* file) {
         T1HeaderMetadata* header_metadata = header->header_metadata;
         T1RegistryMetadata* registry_metadata = registry->registry_metadata;
 
+        int32_t reference = (int32_t) get_registry_reference(header, registry->offset);
+
         // Update metadata for removal status
         registry_metadata->removido = REMOVED;
         registry_metadata->prox = header_metadata->topo;
 
+        // The bitmap gives the sorted stack position right away, only the previous slot is relinked
+        int32_t prev_reference = -1;
+        if (header->free_slot_bitmap != NULL) {
+            free_slot_add(header->free_slot_bitmap, reference, &prev_reference, &registry_metadata->prox);
+        }
+
         // Go to the beginning of the target registry
         go_to_registry(registry, file);
         write_registry(registry, file);
 
         // Update header removal references
-        header_metadata->topo = (int32_t) get_registry_reference(header, registry->offset);
+        if (prev_reference == -1) {
+            header_metadata->topo = reference;
+        } else {
+            t1_write_registry_prox((size_t) prev_reference, reference, file);
+        }
         header_metadata->nroRegRem++;
     }
 
@@ -419,7 +686,18 @@ void remove_registry(Header* header, Registry* registry, FILE* file) {
         // Go to the beginning of the target registry
         int64_t current_top = header_metadata->topo;
 
-        if (current_top != -1) {
+        if (header->free_space_map != NULL) {
+            // The map gives the list position right away, only the previous node is relinked
+            int64_t reference = (int64_t) get_registry_reference(header, registry->offset);
+            int64_t prev_reference;
+            free_space_add(header->free_space_map, reference, registry_metadata->tamanhoRegistro, &prev_reference, &registry_metadata->prox);
+
+            if (prev_reference == -1) {
+                header_metadata->topo = reference;
+            } else {
+                t2_write_registry_prox((size_t) prev_reference, reference, file);
+            }
+        } else if (current_top != -1) {
             // Load queue front registry
             seek_registry(header, file, current_top);
             Registry* prev_registry = NULL;
@@ -484,6 +762,67 @@ void remove_registry(Header* header, Registry* registry, FILE* file) {
         registry_metadata->removido = REMOVED;
         write_registry(registry, file);
     }
+
+    if (registry->registry_type == RT_SLOTTED) {
+        T3HeaderMetadata* header_metadata = header->header_metadata;
+        T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+        // Only the registry's page changes, its bytes become a hole
+        T3Page page;
+        ex_assert(t3_read_page(&page, t3_offset_page(registry->offset), file) != 0, EX_CORRUPTED_REGISTRY);
+
+        t3_page_remove(&page, registry_metadata->slot);
+        t3_write_page(&page, file);
+        t3_track_page(header, &page);
+
+        // Update header removed reg count
+        header_metadata->nroRegRem++;
+
+        registry_metadata->removido = REMOVED;
+        registry_metadata->slot = T3_NO_SLOT;
+    }
+}
+
+/**
+ * Add registry to the given RT_SLOTTED file, on any page but the skipped one
+ * @param header target file header
+ * @param registry target registry to add
+ * @param file target file
+ * @param skipped_page page that must not be changed (-1 for none)
+ */
+static void add_slotted_registry(Header* header, Registry* registry, FILE* file, int32_t skipped_page) {
+    T3HeaderMetadata* header_metadata = header->header_metadata;
+
+    // Reset registry metadata
+    t3_setup_registry_metadata(registry->registry_metadata);
+
+    // First page with room for the registry, or else the last page when it isn't tracked by the inventory
+    int32_t page_number = t3_find_page(header, t3_encoded_registry_size(registry), skipped_page);
+    if (page_number == -1 && header_metadata->nroPaginas > T3_TRACKED_PAGES && header_metadata->nroPaginas - 1 != skipped_page) {
+        page_number = header_metadata->nroPaginas - 1;
+    }
+
+    T3Page page;
+    bool inserted = false;
+
+    if (page_number != -1) {
+        ex_assert(t3_read_page(&page, page_number, file) != 0, EX_CORRUPTED_REGISTRY);
+
+        // Inserting may compact the page, dropping its holes
+        uint16_t n_holes = page.nroRemovidos;
+        inserted = t3_page_insert(&page, registry);
+        header_metadata->nroRegRem -= n_holes - page.nroRemovidos;
+    }
+
+    // Appending a new page
+    if (!inserted) {
+        t3_setup_page(&page, header_metadata->nroPaginas++);
+        inserted = t3_page_insert(&page, registry);
+        ex_assert(inserted, EX_CORRUPTED_REGISTRY);
+    }
+
+    t3_write_page(&page, file);
+    t3_track_page(header, &page);
 }
 
 /**
@@ -505,7 +844,20 @@ void add_registry(Header* header, Registry* registry, FILE* file) {
         int32_t stack_top = header_metadata->topo;
         uint32_t write_location = header_metadata->proxRRN;
 
-        if (stack_top != -1) {
+        if (header->free_slot_bitmap != NULL) {
+            // The stack is sorted, so its top is the lowest free slot
+            int32_t free_slot;
+            if (free_slot_take(header->free_slot_bitmap, &free_slot, 1) == 1) {
+                ex_assert(free_slot == stack_top, EX_FILE_ERROR);
+
+                header_metadata->topo = free_slot_first(header->free_slot_bitmap);
+                header_metadata->nroRegRem--;
+
+                write_location = free_slot;
+            } else {
+                header_metadata->proxRRN++;
+            }
+        } else if (stack_top != -1) {
             // Load top registry
             Registry* top_registry = build_registry(header);
             seek_registry(header, file, stack_top);
@@ -542,7 +894,25 @@ void add_registry(Header* header, Registry* registry, FILE* file) {
         int64_t queue_front = header_metadata->topo;
         size_t write_offset = header_metadata->proxByteOffset;
 
-        if (queue_front != -1) {
+        if (header->free_space_map != NULL) {
+            int64_t reuse_offset, prev_reference, next_reference;
+            uint32_t reuse_size;
+            uint32_t needed_size = (uint32_t) (total_registry_size(registry) - T2_IGNORED_SIZE);
+
+            // Unlink the picked registry (the list front, unless best-fit picks a smaller one)
+            if (free_space_take(header->free_space_map, needed_size, &reuse_offset, &reuse_size, &prev_reference, &next_reference)) {
+                if (prev_reference == -1) {
+                    header_metadata->topo = next_reference;
+                } else {
+                    t2_write_registry_prox((size_t) prev_reference, next_reference, file);
+                }
+                header_metadata->nroRegRem--;
+
+                write_offset = (size_t) reuse_offset;
+                // Copy registry size
+                registry_metadata->tamanhoRegistro = reuse_size;
+            }
+        } else if (queue_front != -1) {
             // Load top registry
             Registry* front_registry = build_registry(header);
             seek_registry(header, file, queue_front);
@@ -570,6 +940,10 @@ void add_registry(Header* header, Registry* registry, FILE* file) {
         // Update header's proxByteOffset reference, if needed
         header_metadata->proxByteOffset = (int64_t) max(header_metadata->proxByteOffset, current_offset(file));
     }
+
+    if (header->registry_type == RT_SLOTTED) {
+        add_slotted_registry(header, registry, file, -1);
+    }
 }
 
 /**
@@ -609,6 +983,28 @@ bool update_registry(Header* header, Registry* registry, FILE* file) {
         }
     }
 
+    if (header->registry_type == RT_SLOTTED) {
+        T3HeaderMetadata* header_metadata = header->header_metadata;
+
+        T3Page page;
+        ex_assert(t3_read_page(&page, t3_offset_page(registry->offset), file) != 0, EX_CORRUPTED_REGISTRY);
+
+        // Growing inside its page keeps the registry's reference
+        uint16_t n_holes = page.nroRemovidos;
+        if (t3_page_update(&page, registry)) {
+            t3_write_page(&page, file);
+            t3_track_page(header, &page);
+            header_metadata->nroRegRem += page.nroRemovidos - n_holes;
+            return false;
+        }
+
+        // Moved to another page, its own page isn't compacted (scans might be going through it)
+        int32_t page_number = page.number;
+        remove_registry(header, registry, file);
+        add_slotted_registry(header, registry, file, page_number);
+        return true;
+    }
+
     return false;
 }
 
@@ -659,6 +1055,10 @@ bool is_registry_removed(Registry* registry) {
         return ((T2RegistryMetadata*) registry->registry_metadata)->removido == REMOVED;
     }
 
+    if (registry->registry_type == RT_SLOTTED) {
+        return ((T3RegistryMetadata*) registry->registry_metadata)->removido == REMOVED;
+    }
+
     return false;
 }
 
@@ -679,6 +1079,11 @@ void set_header_status(Header* header, char status) {
         T2HeaderMetadata* header_metadata = header->header_metadata;
         header_metadata->status = status;
     }
+
+    if (header->registry_type == RT_SLOTTED) {
+        T3HeaderMetadata* header_metadata = header->header_metadata;
+        header_metadata->status = status;
+    }
 }
 
 /**
@@ -699,6 +1104,11 @@ char get_header_status(Header* header) {
         return header_metadata->status;
     }
 
+    if (header->registry_type == RT_SLOTTED) {
+        T3HeaderMetadata* header_metadata = header->header_metadata;
+        return header_metadata->status;
+    }
+
     return -1;
 }
 
@@ -722,6 +1132,58 @@ void header_increment_next(Header* header, size_t appended_bytes) {
         T2HeaderMetadata* header_metadata = header->header_metadata;
         header_metadata->proxByteOffset += (int64_t) appended_bytes;
     }
+
+    // Slotted files only grow by whole pages
+    if (header->registry_type == RT_SLOTTED) {
+        T3HeaderMetadata* header_metadata = header->header_metadata;
+        header_metadata->nroPaginas += (int32_t) (appended_bytes / T3_PAGE_SIZE);
+    }
+}
+
+/**
+ * Empties the header's registry bookkeeping (no registries, no removed registries), keeping its status and content
+ * @param header the target header
+ */
+void reset_header_registries(Header* header) {
+    ex_assert(header->registry_type != RT_UNKNOWN, EX_CORRUPTED_REGISTRY);
+
+    char status = get_header_status(header);
+
+    if (header->registry_type == RT_FIX_LEN) {
+        memcpy(header->header_metadata, &DEFAULT_T1_HEADER_METADATA, sizeof(struct T1HeaderMetadata));
+    }
+
+    if (header->registry_type == RT_VAR_LEN) {
+        memcpy(header->header_metadata, &DEFAULT_T2_HEADER_METADATA, sizeof(struct T2HeaderMetadata));
+    }
+
+    if (header->registry_type == RT_SLOTTED) {
+        memcpy(header->header_metadata, &DEFAULT_T3_HEADER_METADATA, sizeof(struct T3HeaderMetadata));
+    }
+
+    set_header_status(header, status);
+}
+
+/**
+ * Resets a registry's metadata as if it was never written (not removed, no free space and no next removed registry)
+ * @param registry the target registry
+ */
+void reset_registry_metadata(Registry* registry) {
+    ex_assert(registry->registry_type != RT_UNKNOWN, EX_CORRUPTED_REGISTRY);
+
+    if (registry->registry_type == RT_FIX_LEN) {
+        t1_setup_registry_metadata(registry->registry_metadata);
+    }
+
+    if (registry->registry_type == RT_VAR_LEN) {
+        T2RegistryMetadata* registry_metadata = registry->registry_metadata;
+        t2_setup_registry_metadata(registry_metadata);
+        registry_metadata->tamanhoRegistro = (uint32_t) t2_compact_registry_size(registry);
+    }
+
+    if (registry->registry_type == RT_SLOTTED) {
+        t3_setup_registry_metadata(registry->registry_metadata);
+    }
 }
 
 /**
@@ -742,6 +1204,11 @@ size_t get_max_offset(Header* header) {
         return header_metadata->proxByteOffset;
     }
 
+    if (header->registry_type == RT_SLOTTED) {
+        T3HeaderMetadata* header_metadata = header->header_metadata;
+        return t3_page_offset(header_metadata->nroPaginas);
+    }
+
     return -1;
 }
 
@@ -780,6 +1247,10 @@ bool seek_registry(Header* header, FILE* file, size_t target) {
         return true;
     }
 
+    if (header->registry_type == RT_SLOTTED) {
+        return t3_seek_registry(header, file, target);
+    }
+
     return false;
 }
 
@@ -798,5 +1269,27 @@ size_t get_registry_reference(Header* header, size_t total_bytes_before_read) {
         return rrn;
     }
 
+    // The slot isn't known from the offset
+    ex_assert(header->registry_type != RT_SLOTTED, EX_GENERIC_ERROR);
+
     return total_bytes_before_read;
 }
+
+/**
+ * Retrieves the reference of a registry read from (or written into) the file (RRN, byte offset or page and slot,
+ * depending on registry type)
+ * @param header the registry header
+ * @param registry the target registry
+ * @return the registry's reference
+ */
+size_t registry_reference(Header* header, Registry* registry) {
+    ex_assert(header->registry_type == registry->registry_type, EX_CORRUPTED_REGISTRY);
+    ex_assert(registry->offset != SIZE_MAX, EX_CORRUPTED_REGISTRY);
+
+    if (registry->registry_type == RT_SLOTTED) {
+        T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+        return (size_t) t3_make_reference(t3_offset_page(registry->offset), registry_metadata->slot);
+    }
+
+    return get_registry_reference(header, registry->offset);
+}
@@ -15,9 +15,16 @@
 typedef enum RegistryType {
     RT_UNKNOWN = 0,
     RT_FIX_LEN = 1,
-    RT_VAR_LEN = 2
+    RT_VAR_LEN = 2,
+    RT_SLOTTED = 3
 } RegistryType;
 
+// Removed registries map (see free_space_map.h)
+struct FreeSpaceMap;
+
+// Free slots bitmap (see free_slot_bitmap.h)
+struct FreeSlotBitmap;
+
 /**
  * Generic header struct
  */
@@ -25,6 +32,11 @@ typedef struct Header {
     void* header_metadata;
     HeaderContent* header_content;
     RegistryType registry_type;
+
+    // Optional, owned by the header (add_registry and remove_registry skip the list walks when present)
+    struct FreeSpaceMap* free_space_map;
+    // Optional, owned by the header (add_registry and remove_registry keep the stack sorted by RRN when present)
+    struct FreeSlotBitmap* free_slot_bitmap;
 } Header;
 
 /**
@@ -130,6 +142,22 @@ size_t read_header(Header* header, FILE* src);
  */
 size_t write_registry(Registry* registry, FILE* dest);
 
+/**
+ * Encodes a registry into a memory buffer (same bytes as write_registry)
+ * @param registry the registry to be encoded
+ * @param dest the destination buffer (must hold at least encoded_registry_size bytes)
+ * @param offset the file offset the encoded bytes will be written at
+ * @return the amount of bytes written
+ */
+size_t encode_registry(Registry* registry, char* dest, size_t offset);
+
+/**
+ * Computes the amount of bytes written when encoding (or writing) a registry
+ * @param registry the target registry
+ * @return the encoded size
+ */
+size_t encoded_registry_size(Registry* registry);
+
 /**
  * Reads a registry from the given file
  * @param registry the registry ptr on which the data will be read into
@@ -138,6 +166,52 @@ size_t write_registry(Registry* registry, FILE* dest);
  */
 size_t read_registry(Registry* registry, FILE* src);
 
+/**
+ * Reads a registry from the given file, decoding only the projected fields (see read_registry_content_projected)
+ * @param registry the registry ptr on which the data will be read into
+ * @param src the source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t read_registry_projected(Registry* registry, FILE* src, field_mask_t fields);
+
+/**
+ * Decodes the fields left out when the registry was read with a projection (no-op for fully read registries)
+ *
+ * The file is left positioned right after the registry
+ * @param registry the partially read registry
+ * @param src the source file
+ * @return the amount of bytes read
+ */
+size_t read_registry_remaining(Registry* registry, FILE* src);
+
+/**
+ * Reads a registry from a memory buffer holding the file's bytes (e.g. a mapped file)
+ * @param registry the registry ptr on which the data will be read into
+ * @param src the source buffer (positioned at the registry's beginning)
+ * @param available amount of bytes that can be safely read from the buffer
+ * @param offset the registry's offset on the file
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t read_registry_from_buffer(Registry* registry, const char* src, size_t available, size_t offset);
+
+/**
+ * Retrieves the amount of metadata bytes at the beginning of every registry of the given type
+ * @param registry_type the registry type
+ * @return the metadata size
+ */
+size_t registry_metadata_size(RegistryType registry_type);
+
+/**
+ * Peeks a registry's total size on the file from its metadata bytes, without decoding the registry
+ * @param registry_type the registry type
+ * @param src the source buffer (positioned at the registry's beginning)
+ * @param available amount of bytes that can be safely read from the buffer
+ * @param removed output for the registry's removal status
+ * @return the registry size (0 if the metadata isn't fully available)
+ */
+size_t peek_registry_size(RegistryType registry_type, const char* src, size_t available, bool* removed);
+
 // Operations //
 
 /**
@@ -229,6 +303,18 @@ char get_header_status(Header* header);
  */
 void header_increment_next(Header* header, size_t appended_bytes);
 
+/**
+ * Empties the header's registry bookkeeping (no registries, no removed registries), keeping its status and content
+ * @param header the target header
+ */
+void reset_header_registries(Header* header);
+
+/**
+ * Resets a registry's metadata as if it was never written (not removed, no free space and no next removed registry)
+ * @param registry the target registry
+ */
+void reset_registry_metadata(Registry* registry);
+
 /**
  * Computes the file's end reference based off the next open position reference
  * @param header the target header
@@ -247,8 +333,19 @@ bool seek_registry(Header* header, FILE* file, size_t target);
 
 /**
  * Retrieves the registries relative position (RRN or byte offset, depending on registry type)
+ *
+ * Slotted registries can't be located by their offset alone, see registry_reference
  * @param header the registry header
  * @param total_bytes_before_read the total amount of bytes read before the target element
  * @return the registry's relative position
  */
 size_t get_registry_reference(Header* header, size_t total_bytes_before_read);
+
+/**
+ * Retrieves the reference of a registry read from (or written into) the file (RRN, byte offset or page and slot,
+ * depending on registry type)
+ * @param header the registry header
+ * @param registry the target registry
+ * @return the registry's reference
+ */
+size_t registry_reference(Header* header, Registry* registry);
@@ -4,11 +4,40 @@
 
 #include "registry_content.h"
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../exception/exception.h"
 
+/**
+ * Moves a read variable length field into the appropriate registry column (based on its column code)
+ * @param registry_content target registry contents
+ * @param var_len_field the read field (its data ownership is transferred to the registry content)
+ * @return if the column code was valid
+ */
+static bool assign_var_len_field(RegistryContent* registry_content, VarLenStrField* var_len_field) {
+    if (strncmp(var_len_field->code, "0", CODE_FIELD_LEN) == 0) {
+        registry_content->tamCidade = var_len_field->size;
+        memcpy(registry_content->codC5, var_len_field->code, CODE_FIELD_LEN * sizeof(char));
+        registry_content->cidade = var_len_field->data;
+    } else if (strncmp(var_len_field->code, "1", CODE_FIELD_LEN) == 0) {
+        registry_content->tamMarca = var_len_field->size;
+        memcpy(registry_content->codC6, var_len_field->code, CODE_FIELD_LEN * sizeof(char));
+        registry_content->marca = var_len_field->data;
+    } else if (strncmp(var_len_field->code, "2", CODE_FIELD_LEN) == 0) {
+        registry_content->tamModelo = var_len_field->size;
+        memcpy(registry_content->codC7, var_len_field->code, CODE_FIELD_LEN * sizeof(char));
+        registry_content->modelo = var_len_field->data;
+    } else {
+        free(var_len_field->data);
+        ex_raise(EX_FILE_ERROR);
+        return false;
+    }
+
+    return true;
+}
+
 /**
  * Writes the header contents into the given file
  * @param header_content target header contents
@@ -88,6 +117,31 @@ size_t write_registry_content(RegistryContent* registry_content, FILE* dest) {
     return written_bytes;
 }
 
+/**
+ * Encodes the registry contents into a memory buffer (same layout as write_registry_content)
+ * @param registry_content target registry contents
+ * @param dest destination buffer (must have enough room)
+ * @return amount of bytes written
+ */
+size_t encode_registry_content(RegistryContent* registry_content, char* dest) {
+    ex_assert(registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_GENERIC_ERROR);
+
+    size_t written_bytes = 0;
+
+    written_bytes += mwrite_member_field(registry_content, id, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_content, ano, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_content, qtt, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_content, sigla, dest + written_bytes);
+
+    // Write variable length fields to the buffer
+    written_bytes += mwrite_member_var_len_str(registry_content, cidade, tamCidade, codC5, dest + written_bytes);
+    written_bytes += mwrite_member_var_len_str(registry_content, marca, tamMarca, codC6, dest + written_bytes);
+    written_bytes += mwrite_member_var_len_str(registry_content, modelo, tamModelo, codC7, dest + written_bytes);
+
+    return written_bytes;
+}
+
 /**
  * Reads the registry contents from the given file
  * @param registry_content target registry contents on which the data will be read into
@@ -96,14 +150,36 @@ size_t write_registry_content(RegistryContent* registry_content, FILE* dest) {
  * @return amount of bytes read
  */
 size_t read_registry_content(RegistryContent* registry_content, FILE* src, size_t max_read_bytes) {
-    ex_assert(registry_content != NULL, EX_GENERIC_ERROR);
-    ex_assert(src != NULL, EX_FILE_ERROR);
+    return read_registry_content_projected(registry_content, src, max_read_bytes, FM_ALL);
+}
 
-    free(registry_content->cidade);
-    free(registry_content->marca);
-    free(registry_content->modelo);
-    setup_registry_content(registry_content);
+/**
+ * Maps a column code into its field flag
+ * @param code the column code
+ * @return the field flag (0 for unknown codes)
+ */
+static field_mask_t var_len_field_flag(char code) {
+    switch (code) {
+        case '0':
+            return FM_CIDADE;
+        case '1':
+            return FM_MARCA;
+        case '2':
+            return FM_MODELO;
+        default:
+            return 0;
+    }
+}
 
+/**
+ * Decodes the given fields from the file into the registry contents (other fields are kept untouched)
+ * @param registry_content target registry contents
+ * @param src source file (positioned at the content's beginning)
+ * @param max_read_bytes maximum amount of bytes to be read
+ * @param fields fields to be decoded (FM_* flags)
+ * @return amount of bytes read (or skipped)
+ */
+static size_t decode_registry_content(RegistryContent* registry_content, FILE* src, size_t max_read_bytes, field_mask_t fields) {
     size_t read_bytes = 0;
 
     read_bytes += fread_member_field(registry_content, id, src);
@@ -113,7 +189,106 @@ size_t read_registry_content(RegistryContent* registry_content, FILE* src, size_
 
     // Read variable length fields
     for (uint8_t i = 0; i < 3 && read_bytes + STATIC_VAR_LEN_SIZE < max_read_bytes; i++) {
-        VarLenStrField var_len_field = fread_var_len_str(src);
+        VarLenStrField var_len_field = {0, {0}, NULL, 0};
+
+        // Read string length
+        read_bytes += fread(&var_len_field.size, 1, sizeof(strlen_t), src);
+
+        // Null field, no more fields remaining, break
+        if (var_len_field.size == 0) {
+            break;
+        }
+
+        // Read field code
+        read_bytes += fread(var_len_field.code, 1, sizeof(char) * CODE_FIELD_LEN, src);
+
+        if (var_len_field.code[0] == FILLER_BYTE[0]) {
+            break;
+        }
+
+        field_mask_t field = var_len_field_flag(var_len_field.code[0]);
+
+        // Skip fields out of the projection by their length
+        if (field != 0 && (fields & field) == 0) {
+            fseek(src, (long) var_len_field.size, SEEK_CUR);
+            read_bytes += var_len_field.size;
+            continue;
+        }
+
+        // Read the string itself
+        var_len_field.data = calloc(var_len_field.size + 1, sizeof(char));
+        ex_assert(var_len_field.data != NULL, EX_MEMORY_ERROR);
+        read_bytes += fread(var_len_field.data, 1, sizeof(char) * var_len_field.size, src);
+
+        // Fill appropriate column based on the column code
+        if (!assign_var_len_field(registry_content, &var_len_field)) {
+            return 0;
+        }
+    }
+
+    registry_content->decoded_fields |= FM_FIX_LEN | fields;
+
+    return read_bytes;
+}
+
+/**
+ * Reads the registry contents from the given file, decoding only the projected fields
+ *
+ * The fixed length fields are always decoded (they share a single read), string fields out of the projection are
+ * skipped by their length and left NULL
+ * @param registry_content target registry contents on which the data will be read into
+ * @param src source file
+ * @param max_read_bytes maximum amount of bytes to be read
+ * @param fields projected fields (FM_* flags)
+ * @return amount of bytes read (or skipped)
+ */
+size_t read_registry_content_projected(RegistryContent* registry_content, FILE* src, size_t max_read_bytes, field_mask_t fields) {
+    ex_assert(registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    setup_registry_content(registry_content);
+    registry_content->decoded_fields = 0;
+
+    return decode_registry_content(registry_content, src, max_read_bytes, fields);
+}
+
+/**
+ * Decodes the fields left out by a projected read (the file must be positioned at the content's beginning)
+ * @param registry_content target registry contents
+ * @param src source file
+ * @param max_read_bytes maximum amount of bytes to be read
+ * @return amount of bytes read (or skipped)
+ */
+size_t read_registry_content_remaining(RegistryContent* registry_content, FILE* src, size_t max_read_bytes) {
+    ex_assert(registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    return decode_registry_content(registry_content, src, max_read_bytes, FM_ALL & ~registry_content->decoded_fields);
+}
+
+/**
+ * Reads the registry contents from a memory buffer (e.g. a mapped file)
+ * @param registry_content target registry contents on which the data will be read into
+ * @param src source buffer
+ * @param max_read_bytes maximum amount of bytes to be read (must be fully available on the buffer)
+ * @return amount of bytes read
+ */
+size_t read_registry_content_from_buffer(RegistryContent* registry_content, const char* src, size_t max_read_bytes) {
+    ex_assert(registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_GENERIC_ERROR);
+
+    setup_registry_content(registry_content);
+
+    size_t read_bytes = 0;
+
+    read_bytes += mread_member_field(registry_content, id, src + read_bytes);
+    read_bytes += mread_member_field(registry_content, ano, src + read_bytes);
+    read_bytes += mread_member_field(registry_content, qtt, src + read_bytes);
+    read_bytes += mread_member_field(registry_content, sigla, src + read_bytes);
+
+    // Read variable length fields
+    for (uint8_t i = 0; i < 3 && read_bytes + STATIC_VAR_LEN_SIZE < max_read_bytes; i++) {
+        VarLenStrField var_len_field = mread_var_len_str(src + read_bytes, max_read_bytes - read_bytes);
         read_bytes += var_len_field.read_bytes;
 
         // Null field, no more fields remaining, break
@@ -122,20 +297,7 @@ size_t read_registry_content(RegistryContent* registry_content, FILE* src, size_
         }
 
         // Fill appropriate column based on the column code
-        if (strncmp(var_len_field.code, "0", CODE_FIELD_LEN) == 0) {
-            registry_content->tamCidade = var_len_field.size;
-            memcpy(registry_content->codC5, var_len_field.code, CODE_FIELD_LEN * sizeof(char));
-            registry_content->cidade = var_len_field.data;
-        } else if (strncmp(var_len_field.code, "1", CODE_FIELD_LEN) == 0) {
-            registry_content->tamMarca = var_len_field.size;
-            memcpy(registry_content->codC6, var_len_field.code, CODE_FIELD_LEN * sizeof(char));
-            registry_content->marca = var_len_field.data;
-        } else if (strncmp(var_len_field.code, "2", CODE_FIELD_LEN) == 0) {
-            registry_content->tamModelo = var_len_field.size;
-            memcpy(registry_content->codC7, var_len_field.code, CODE_FIELD_LEN * sizeof(char));
-            registry_content->modelo = var_len_field.data;
-        } else {
-            ex_raise(EX_FILE_ERROR);
+        if (!assign_var_len_field(registry_content, &var_len_field)) {
             return 0;
         }
     }
@@ -170,6 +332,8 @@ void setup_registry_content(RegistryContent* registry_content) {
     free(registry_content->modelo);
     registry_content->tamModelo = 0;
     registry_content->modelo = NULL;
+
+    registry_content->decoded_fields = FM_ALL;
 }
 
 /**
@@ -194,6 +358,11 @@ RegistryContent* new_registry_content() {
     registry_content->marca = NULL;
     registry_content->modelo = NULL;
     setup_registry_content(registry_content);
+
+    // Numeric fields aren't reset by the setup (CSV lines missing columns keep the previous line values)
+    registry_content->id = 0;
+    registry_content->ano = 0;
+    registry_content->qtt = 0;
     return registry_content;
 }
 
@@ -38,6 +38,9 @@ typedef struct RegistryContent {
     strlen_t tamModelo;
     char codC7[CODE_FIELD_LEN];
     char* modelo;
+
+    // Fields already decoded (projected reads leave the other string fields NULL)
+    field_mask_t decoded_fields;
 } RegistryContent;
 
 /**
@@ -83,6 +86,14 @@ size_t read_header_content(HeaderContent* header_content, FILE* src);
  */
 size_t write_registry_content(RegistryContent* registry_content, FILE* dest);
 
+/**
+ * Encodes the registry contents into a memory buffer (same layout as write_registry_content)
+ * @param registry_content target registry contents
+ * @param dest destination buffer (must have enough room)
+ * @return amount of bytes written
+ */
+size_t encode_registry_content(RegistryContent* registry_content, char* dest);
+
 /**
  * Reads the registry contents from the given file
  * @param registry_content target registry contents on which the data will be read into
@@ -92,6 +103,37 @@ size_t write_registry_content(RegistryContent* registry_content, FILE* dest);
  */
 size_t read_registry_content(RegistryContent* registry_content, FILE* src, size_t max_read_bytes);
 
+/**
+ * Reads the registry contents from the given file, decoding only the projected fields
+ *
+ * The fixed length fields are always decoded (they share a single read), string fields out of the projection are
+ * skipped by their length and left NULL
+ * @param registry_content target registry contents on which the data will be read into
+ * @param src source file
+ * @param max_read_bytes maximum amount of bytes to be read
+ * @param fields projected fields (FM_* flags)
+ * @return amount of bytes read (or skipped)
+ */
+size_t read_registry_content_projected(RegistryContent* registry_content, FILE* src, size_t max_read_bytes, field_mask_t fields);
+
+/**
+ * Decodes the fields left out by a projected read (the file must be positioned at the content's beginning)
+ * @param registry_content target registry contents
+ * @param src source file
+ * @param max_read_bytes maximum amount of bytes to be read
+ * @return amount of bytes read (or skipped)
+ */
+size_t read_registry_content_remaining(RegistryContent* registry_content, FILE* src, size_t max_read_bytes);
+
+/**
+ * Reads the registry contents from a memory buffer (e.g. a mapped file)
+ * @param registry_content target registry contents on which the data will be read into
+ * @param src source buffer
+ * @param max_read_bytes maximum amount of bytes to be read (must be fully available on the buffer)
+ * @return amount of bytes read
+ */
+size_t read_registry_content_from_buffer(RegistryContent* registry_content, const char* src, size_t max_read_bytes);
+
 // Setups //
 
 /**
@@ -0,0 +1,205 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "registry_view.h"
+
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "t1_registry.h"
+#include "t2_registry.h"
+#include "t3_registry.h"
+
+/**
+ * Setups a view with NULL-equivalent data
+ * @param view target view
+ * @param registry_type the registry type
+ * @param offset the registry's offset on the file
+ */
+void setup_registry_view(RegistryView* view, RegistryType registry_type, size_t offset) {
+    view->registry_type = registry_type;
+    view->offset = offset;
+    view->size = 0;
+    view->removed = false;
+    view->slot = T3_NO_SLOT;
+    view->id = -1;
+    view->ano = -1;
+    view->qtt = -1;
+    for (uint8_t i = 0; i < REGISTRY_SIGLA_SIZE; i++) {
+        view->sigla[i] = FILLER_BYTE[0];
+    }
+    view->cidade = make_str_slice(NULL, 0);
+    view->marca = make_str_slice(NULL, 0);
+    view->modelo = make_str_slice(NULL, 0);
+}
+
+/**
+ * Builds a view over a registry stored on a memory buffer (e.g. a mapped file or a read page)
+ * @param view target view
+ * @param registry_type the registry type
+ * @param src the source buffer (positioned at the registry's beginning)
+ * @param available amount of bytes that can be safely read from the buffer
+ * @param offset the registry's offset on the file
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t view_registry(RegistryView* view, RegistryType registry_type, const char* src, size_t available, size_t offset) {
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_GENERIC_ERROR);
+
+    setup_registry_view(view, registry_type, offset);
+
+    switch (registry_type) {
+        case RT_FIX_LEN:
+            view->size = t1_view_registry(view, src, available);
+            break;
+        case RT_VAR_LEN:
+            view->size = t2_view_registry(view, src, available);
+            break;
+        case RT_SLOTTED:
+            view->size = t3_view_registry(view, src, available);
+            break;
+        default:
+            ex_raise(EX_CORRUPTED_REGISTRY);
+            break;
+    }
+
+    return view->size;
+}
+
+/**
+ * Builds a view over the registry contents stored on a memory buffer
+ * @param view target view
+ * @param src the source buffer (positioned at the content's beginning)
+ * @param max_read_bytes maximum amount of bytes to be read (must be fully available on the buffer)
+ * @return amount of bytes read
+ */
+size_t view_registry_content(RegistryView* view, const char* src, size_t max_read_bytes) {
+    size_t read_bytes = 0;
+
+    read_bytes += mread_member_field(view, id, src + read_bytes);
+    read_bytes += mread_member_field(view, ano, src + read_bytes);
+    read_bytes += mread_member_field(view, qtt, src + read_bytes);
+    read_bytes += mread_member_field(view, sigla, src + read_bytes);
+
+    // Read variable length fields (same layout rules as read_registry_content)
+    for (uint8_t i = 0; i < 3 && read_bytes + STATIC_VAR_LEN_SIZE < max_read_bytes; i++) {
+        strlen_t size;
+        memcpy(&size, src + read_bytes, sizeof(strlen_t));
+        read_bytes += sizeof(strlen_t);
+
+        // Null field, no more fields remaining, break
+        if (size == 0) {
+            break;
+        }
+
+        char code = src[read_bytes];
+        read_bytes += CODE_FIELD_LEN;
+
+        if (code == FILLER_BYTE[0]) {
+            break;
+        }
+
+        // Strings can't extend past the readable area
+        ex_assert(size <= max_read_bytes - read_bytes, EX_CORRUPTED_REGISTRY);
+        if (size > max_read_bytes - read_bytes) {
+            return max_read_bytes;
+        }
+
+        StrSlice slice = {src + read_bytes, size};
+        read_bytes += size;
+
+        // Fill appropriate column based on the column code
+        if (code == '0') {
+            view->cidade = slice;
+        } else if (code == '1') {
+            view->marca = slice;
+        } else if (code == '2') {
+            view->modelo = slice;
+        } else {
+            ex_raise(EX_FILE_ERROR);
+            return 0;
+        }
+    }
+
+    return read_bytes;
+}
+
+/**
+ * Builds a view over an already materialized registry (the view borrows the registry strings)
+ * @param view target view
+ * @param registry source registry
+ */
+void view_from_registry(RegistryView* view, Registry* registry) {
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+
+    RegistryContent* registry_content = registry->registry_content;
+
+    setup_registry_view(view, registry->registry_type, registry->offset);
+    view->size = total_registry_size(registry);
+    view->removed = is_registry_removed(registry);
+    if (registry->registry_type == RT_SLOTTED) {
+        view->slot = ((T3RegistryMetadata*) registry->registry_metadata)->slot;
+    }
+
+    view->id = registry_content->id;
+    view->ano = registry_content->ano;
+    view->qtt = registry_content->qtt;
+    memcpy(view->sigla, registry_content->sigla, sizeof(view->sigla));
+    view->cidade = make_str_slice(registry_content->cidade, registry_content->tamCidade);
+    view->marca = make_str_slice(registry_content->marca, registry_content->tamMarca);
+    view->modelo = make_str_slice(registry_content->modelo, registry_content->tamModelo);
+}
+
+/**
+ * Retrieves the reference of a viewed registry (see registry_reference)
+ * @param header the registry header
+ * @param view target view
+ * @return the registry's reference
+ */
+size_t view_reference(Header* header, RegistryView* view) {
+    ex_assert(view != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->registry_type == view->registry_type, EX_CORRUPTED_REGISTRY);
+
+    if (view->registry_type == RT_SLOTTED) {
+        return (size_t) t3_make_reference(t3_offset_page(view->offset), view->slot);
+    }
+
+    return get_registry_reference(header, view->offset);
+}
+
+/**
+ * Builds a slice over a NULL-terminated (or NULL) string
+ * @param str source string
+ * @param len string length
+ * @return the slice
+ */
+StrSlice make_str_slice(const char* str, strlen_t len) {
+    if (str == NULL) {
+        return (StrSlice){NULL, 0};
+    }
+    return (StrSlice){str, len};
+}
+
+/**
+ * Checks if a slice holds the same text as a NULL-terminated string (strcmp semantics)
+ * @param slice target slice (must be non-null)
+ * @param str target string
+ * @return if both are equal
+ */
+bool str_slice_equals(StrSlice slice, const char* str) {
+    size_t len = str_slice_length(slice);
+    return strncmp(str, slice.data, len) == 0 && str[len] == '\0';
+}
+
+/**
+ * Retrieves a slice's effective length (up to the first NULL byte, same as the materialized string)
+ * @param slice target slice (must be non-null)
+ * @return the effective length
+ */
+size_t str_slice_length(StrSlice slice) {
+    // Materialized strings end at their first NULL byte, so slices must do the same
+    const char* end = memchr(slice.data, '\0', slice.len);
+    return end == NULL ? slice.len : (size_t) (end - slice.data);
+}
@@ -0,0 +1,111 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "common.h"
+#include "registry.h"
+
+/**
+ * Read-only string slice (not NULL-terminated). A NULL data pointer represents a null field
+ */
+typedef struct StrSlice {
+    const char* data;
+    strlen_t len;
+} StrSlice;
+
+/**
+ * Read-only view of a registry, its string fields point straight into the source buffer
+ *
+ * A view is only valid while the buffer it was built from is kept untouched
+ */
+typedef struct RegistryView {
+    RegistryType registry_type;
+    size_t offset;
+    size_t size;
+    bool removed;
+    // Slot on its page (slotted registries only)
+    uint16_t slot;
+    int32_t id;
+    int32_t ano;
+    int32_t qtt;
+    char sigla[REGISTRY_SIGLA_SIZE];
+    StrSlice cidade;
+    StrSlice marca;
+    StrSlice modelo;
+} RegistryView;
+
+// Views //
+
+/**
+ * Setups a view with NULL-equivalent data
+ * @param view target view
+ * @param registry_type the registry type
+ * @param offset the registry's offset on the file
+ */
+void setup_registry_view(RegistryView* view, RegistryType registry_type, size_t offset);
+
+/**
+ * Builds a view over a registry stored on a memory buffer (e.g. a mapped file or a read page)
+ * @param view target view
+ * @param registry_type the registry type
+ * @param src the source buffer (positioned at the registry's beginning)
+ * @param available amount of bytes that can be safely read from the buffer
+ * @param offset the registry's offset on the file
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t view_registry(RegistryView* view, RegistryType registry_type, const char* src, size_t available, size_t offset);
+
+/**
+ * Builds a view over the registry contents stored on a memory buffer
+ * @param view target view
+ * @param src the source buffer (positioned at the content's beginning)
+ * @param max_read_bytes maximum amount of bytes to be read (must be fully available on the buffer)
+ * @return amount of bytes read
+ */
+size_t view_registry_content(RegistryView* view, const char* src, size_t max_read_bytes);
+
+/**
+ * Builds a view over an already materialized registry (the view borrows the registry strings)
+ * @param view target view
+ * @param registry source registry
+ */
+void view_from_registry(RegistryView* view, Registry* registry);
+
+/**
+ * Retrieves the reference of a viewed registry (see registry_reference)
+ * @param header the registry header
+ * @param view target view
+ * @return the registry's reference
+ */
+size_t view_reference(Header* header, RegistryView* view);
+
+// Slices //
+
+/**
+ * Builds a slice over a NULL-terminated (or NULL) string
+ * @param str source string
+ * @param len string length
+ * @return the slice
+ */
+StrSlice make_str_slice(const char* str, strlen_t len);
+
+/**
+ * Checks if a slice holds the same text as a NULL-terminated string (strcmp semantics)
+ * @param slice target slice (must be non-null)
+ * @param str target string
+ * @return if both are equal
+ */
+bool str_slice_equals(StrSlice slice, const char* str);
+
+/**
+ * Retrieves a slice's effective length (up to the first NULL byte, same as the materialized string)
+ * @param slice target slice (must be non-null)
+ * @return the effective length
+ */
+size_t str_slice_length(StrSlice slice);
@@ -112,6 +112,79 @@ size_t t1_write_registry(Registry* registry, FILE* dest) {
     return written_bytes;
 }
 
+/**
+ * Relinks a removed registry (of type RT_FIX_LEN) on the target file, only its next reference is written
+ * @param rrn removed registry RRN
+ * @param prox new next removed registry RRN
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t1_write_registry_prox(size_t rrn, int32_t prox, FILE* dest) {
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    // The reference comes right after the removal flag
+    fseek(dest, (long) (T1_HEADER_SIZE + rrn * T1_REGISTRY_SIZE + member_size(T1RegistryMetadata, removido)), SEEK_SET);
+    return fwrite(&prox, 1, sizeof(prox), dest);
+}
+
+/**
+ * Encodes the given registry (of type RT_FIX_LEN) into a memory buffer (same bytes as t1_write_registry)
+ * @param registry registry to be encoded
+ * @param dest destination buffer (must hold at least t1_encoded_registry_size bytes)
+ * @return the amount of bytes written
+ */
+size_t t1_encode_registry(Registry* registry, char* dest) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_FIX_LEN, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_GENERIC_ERROR);
+
+    T1RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Amount of bytes written
+    size_t written_bytes = 0;
+
+    // Write registry metadata
+    written_bytes += mwrite_member_field(registry_metadata, removido, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_metadata, prox, dest + written_bytes);
+
+    // Don't update other data if registry is removed
+    if (registry_metadata->removido == REMOVED) {
+        return written_bytes;
+    }
+
+    // Write registry content
+    written_bytes += encode_registry_content(registry_content, dest + written_bytes);
+
+    // Fill remaining bytes
+    written_bytes += mfill_bytes(T1_REGISTRY_SIZE - written_bytes, dest + written_bytes);
+
+    return written_bytes;
+}
+
+/**
+ * Computes the amount of bytes written when encoding the given registry (of type RT_FIX_LEN)
+ * @param registry target registry
+ * @return the encoded size
+ */
+size_t t1_encoded_registry_size(Registry* registry) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_FIX_LEN, EX_GENERIC_ERROR);
+
+    T1RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+    // Removed registries only have their metadata written
+    if (registry_metadata->removido == REMOVED) {
+        return sizeof(registry_metadata->removido) + sizeof(registry_metadata->prox);
+    }
+
+    return T1_REGISTRY_SIZE;
+}
+
 /**
  * Reads the given registry (of type RT_FIX_LEN) from the target file
  * @param registry registry to be read into
@@ -119,6 +192,17 @@ size_t t1_write_registry(Registry* registry, FILE* dest) {
  * @return the amount of bytes read
  */
 size_t t1_read_registry(Registry* registry, FILE* src) {
+    return t1_read_registry_projected(registry, src, FM_ALL);
+}
+
+/**
+ * Reads the given registry (of type RT_FIX_LEN) from the target file, decoding only the projected fields
+ * @param registry registry to be read into
+ * @param src source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t t1_read_registry_projected(Registry* registry, FILE* src, field_mask_t fields) {
     ex_assert(registry != NULL, EX_GENERIC_ERROR);
     ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
     ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
@@ -141,7 +225,7 @@ size_t t1_read_registry(Registry* registry, FILE* src) {
     }
 
     // Read registry content
-    read_bytes += read_registry_content(registry_content, src, T1_REGISTRY_SIZE - read_bytes);
+    read_bytes += read_registry_content_projected(registry_content, src, T1_REGISTRY_SIZE - read_bytes, fields);
 
     // Skip remaining bytes
     size_t remaining_bytes = T1_REGISTRY_SIZE - read_bytes;
@@ -150,6 +234,90 @@ size_t t1_read_registry(Registry* registry, FILE* src) {
     return read_bytes + remaining_bytes;
 }
 
+/**
+ * Reads the given registry (of type RT_FIX_LEN) from a memory buffer
+ * @param registry registry to be read into
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t1_read_registry_from_buffer(Registry* registry, const char* src, size_t available) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_FIX_LEN, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_GENERIC_ERROR);
+
+    T1RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Truncated registry metadata
+    if (available < registry_metadata_size(RT_FIX_LEN)) {
+        return 0;
+    }
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += mread_member_field(registry_metadata, removido, src + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, prox, src + read_bytes);
+
+    // Removed registries only need their metadata
+    if (registry_metadata->removido == REMOVED) {
+        return T1_REGISTRY_SIZE;
+    }
+
+    // Truncated registry
+    if (available < T1_REGISTRY_SIZE) {
+        return 0;
+    }
+
+    // Read registry content (remaining bytes are just skipped)
+    read_registry_content_from_buffer(registry_content, src + read_bytes, T1_REGISTRY_SIZE - read_bytes);
+
+    return T1_REGISTRY_SIZE;
+}
+
+/**
+ * Builds a view over the given registry (of type RT_FIX_LEN) stored on a memory buffer
+ * @param view view to be filled
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t1_view_registry(RegistryView* view, const char* src, size_t available) {
+    // Truncated registry metadata
+    if (available < registry_metadata_size(RT_FIX_LEN)) {
+        return 0;
+    }
+
+    T1RegistryMetadata registry_metadata;
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += mread_member_field(&registry_metadata, removido, src + read_bytes);
+    read_bytes += mread_member_field(&registry_metadata, prox, src + read_bytes);
+
+    // Removed registries only need their metadata
+    view->removed = registry_metadata.removido == REMOVED;
+    if (view->removed) {
+        return T1_REGISTRY_SIZE;
+    }
+
+    // Truncated registry
+    if (available < T1_REGISTRY_SIZE) {
+        return 0;
+    }
+
+    // View registry content (remaining bytes are just skipped)
+    view_registry_content(view, src + read_bytes, T1_REGISTRY_SIZE - read_bytes);
+
+    return T1_REGISTRY_SIZE;
+}
+
 /**
  * Setups the given RT_FIX_LEN header metadata
  * @param header_metadata target header metadata
@@ -7,6 +7,7 @@
 #include "common.h"
 #include "registry.h"
 #include "registry_content.h"
+#include "registry_view.h"
 
 #define T1_HEADER_SIZE 182
 #define T1_REGISTRY_SIZE 97
@@ -55,6 +56,30 @@ size_t t1_read_header(Header* header, FILE* src);
  */
 size_t t1_write_registry(Registry* registry, FILE* dest);
 
+/**
+ * Relinks a removed registry (of type RT_FIX_LEN) on the target file, only its next reference is written
+ * @param rrn removed registry RRN
+ * @param prox new next removed registry RRN
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t1_write_registry_prox(size_t rrn, int32_t prox, FILE* dest);
+
+/**
+ * Encodes the given registry (of type RT_FIX_LEN) into a memory buffer (same bytes as t1_write_registry)
+ * @param registry registry to be encoded
+ * @param dest destination buffer (must hold at least t1_encoded_registry_size bytes)
+ * @return the amount of bytes written
+ */
+size_t t1_encode_registry(Registry* registry, char* dest);
+
+/**
+ * Computes the amount of bytes written when encoding the given registry (of type RT_FIX_LEN)
+ * @param registry target registry
+ * @return the encoded size
+ */
+size_t t1_encoded_registry_size(Registry* registry);
+
 /**
  * Reads the given registry (of type RT_FIX_LEN) from the target file
  * @param registry registry to be read into
@@ -63,6 +88,33 @@ size_t t1_write_registry(Registry* registry, FILE* dest);
  */
 size_t t1_read_registry(Registry* registry, FILE* src);
 
+/**
+ * Reads the given registry (of type RT_FIX_LEN) from the target file, decoding only the projected fields
+ * @param registry registry to be read into
+ * @param src source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t t1_read_registry_projected(Registry* registry, FILE* src, field_mask_t fields);
+
+/**
+ * Reads the given registry (of type RT_FIX_LEN) from a memory buffer
+ * @param registry registry to be read into
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t1_read_registry_from_buffer(Registry* registry, const char* src, size_t available);
+
+/**
+ * Builds a view over the given registry (of type RT_FIX_LEN) stored on a memory buffer
+ * @param view view to be filled
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t1_view_registry(RegistryView* view, const char* src, size_t available);
+
 // Setup //
 
 /**
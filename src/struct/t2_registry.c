@@ -116,6 +116,37 @@ size_t t2_minimum_registry_size(Registry* registry) {
     return size;
 }
 
+/**
+ * Computes the smallest registry size the given registry can be read back from
+ * @param registry the target registry
+ * @return the minimum registry size plus a filler byte when the last variable length field holds a single character
+ */
+size_t t2_compact_registry_size(Registry* registry) {
+    RegistryContent* registry_content = registry->registry_content;
+
+    size_t size = t2_minimum_registry_size(registry);
+
+    // Readers stop before a single character field that ends the registry exactly, so one filler byte is kept after it
+    strlen_t last_field_len = 0;
+    if (registry_content->tamCidade != 0 && registry_content->cidade != NULL) {
+        last_field_len = registry_content->tamCidade;
+    }
+
+    if (registry_content->tamMarca != 0 && registry_content->marca != NULL) {
+        last_field_len = registry_content->tamMarca;
+    }
+
+    if (registry_content->tamModelo != 0 && registry_content->modelo != NULL) {
+        last_field_len = registry_content->tamModelo;
+    }
+
+    if (last_field_len == 1) {
+        size += sizeof(char);
+    }
+
+    return size;
+}
+
 /**
  * Writes the given registry (of type RT_VAR_LEN) into the target file
  * @param registry registry to be written
@@ -162,6 +193,88 @@ size_t t2_write_registry(Registry* registry, FILE* dest) {
     return written_bytes;
 }
 
+/**
+ * Relinks a removed registry (of type RT_VAR_LEN) on the target file, only its next reference is written
+ * @param offset removed registry offset
+ * @param prox new next removed registry reference
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t2_write_registry_prox(size_t offset, int64_t prox, FILE* dest) {
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    // The reference comes right after the ignored part (removido and tamanhoRegistro)
+    fseek(dest, (long) (offset + T2_IGNORED_SIZE), SEEK_SET);
+    return fwrite(&prox, 1, sizeof(prox), dest);
+}
+
+/**
+ * Encodes the given registry (of type RT_VAR_LEN) into a memory buffer (same bytes as t2_write_registry)
+ * @param registry registry to be encoded
+ * @param dest destination buffer (must hold at least t2_encoded_registry_size bytes)
+ * @return the amount of bytes written
+ */
+size_t t2_encode_registry(Registry* registry, char* dest) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_VAR_LEN, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_GENERIC_ERROR);
+
+    T2RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Update registry size
+    if (registry_metadata->removido == NOT_REMOVED) {
+        registry_metadata->tamanhoRegistro = max(registry_metadata->tamanhoRegistro, t2_minimum_registry_size(registry));
+    }
+
+    size_t expected_size = registry_metadata->tamanhoRegistro + T2_IGNORED_SIZE;
+
+    // Amount of bytes written
+    size_t written_bytes = 0;
+
+    // Write registry metadata
+    written_bytes += mwrite_member_field(registry_metadata, removido, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_metadata, tamanhoRegistro, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_metadata, prox, dest + written_bytes);
+
+    if (registry_metadata->removido == REMOVED) {
+        return written_bytes;
+    }
+
+    // Write registry content
+    written_bytes += encode_registry_content(registry_content, dest + written_bytes);
+
+    // Fill remaining bytes for reused registries
+    if (written_bytes < expected_size) {
+        written_bytes += mfill_bytes(expected_size - written_bytes, dest + written_bytes);
+    }
+
+    return written_bytes;
+}
+
+/**
+ * Computes the amount of bytes written when encoding the given registry (of type RT_VAR_LEN)
+ * @param registry target registry
+ * @return the encoded size
+ */
+size_t t2_encoded_registry_size(Registry* registry) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_VAR_LEN, EX_GENERIC_ERROR);
+
+    T2RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+    // Removed registries only have their metadata written
+    if (registry_metadata->removido == REMOVED) {
+        return sizeof(registry_metadata->removido) + sizeof(registry_metadata->tamanhoRegistro) + sizeof(registry_metadata->prox);
+    }
+
+    return max(registry_metadata->tamanhoRegistro, t2_minimum_registry_size(registry)) + T2_IGNORED_SIZE;
+}
+
 /**
  * Reads the given registry (of type RT_VAR_LEN) from the target file
  * @param registry registry to be read into
@@ -169,6 +282,17 @@ size_t t2_write_registry(Registry* registry, FILE* dest) {
  * @return the amount of bytes read
  */
 size_t t2_read_registry(Registry* registry, FILE* src) {
+    return t2_read_registry_projected(registry, src, FM_ALL);
+}
+
+/**
+ * Reads the given registry (of type RT_VAR_LEN) from the target file, decoding only the projected fields
+ * @param registry registry to be read into
+ * @param src source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t t2_read_registry_projected(Registry* registry, FILE* src, field_mask_t fields) {
     ex_assert(registry != NULL, EX_GENERIC_ERROR);
     ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
     ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
@@ -194,7 +318,7 @@ size_t t2_read_registry(Registry* registry, FILE* src) {
     }
 
     // Read registry content
-    read_bytes += read_registry_content(registry_content, src, (registry_metadata->tamanhoRegistro + T2_IGNORED_SIZE) - read_bytes);
+    read_bytes += read_registry_content_projected(registry_content, src, (registry_metadata->tamanhoRegistro + T2_IGNORED_SIZE) - read_bytes, fields);
 
     // Skip remaining bytes
     if (read_bytes < expected_size) {
@@ -207,6 +331,102 @@ size_t t2_read_registry(Registry* registry, FILE* src) {
     return expected_size;
 }
 
+/**
+ * Reads the given registry (of type RT_VAR_LEN) from a memory buffer
+ * @param registry registry to be read into
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t2_read_registry_from_buffer(Registry* registry, const char* src, size_t available) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_VAR_LEN, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_GENERIC_ERROR);
+
+    T2RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Truncated registry metadata
+    if (available < registry_metadata_size(RT_VAR_LEN)) {
+        return 0;
+    }
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += mread_member_field(registry_metadata, removido, src + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, tamanhoRegistro, src + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, prox, src + read_bytes);
+
+    size_t expected_size = registry_metadata->tamanhoRegistro + T2_IGNORED_SIZE;
+
+    // Removed registries only need their metadata
+    if (registry_metadata->removido == REMOVED) {
+        return expected_size;
+    }
+
+    // Truncated registry (its fixed fields must fit it, the same way its strings are bounded)
+    if (expected_size > available || expected_size < read_bytes + STATIC_CONTENT_SIZE) {
+        return 0;
+    }
+
+    // Read registry content (remaining bytes are just skipped)
+    read_bytes += read_registry_content_from_buffer(registry_content, src + read_bytes, expected_size - read_bytes);
+
+    // Check for over-reads
+    ex_assert(read_bytes <= expected_size, EX_CORRUPTED_REGISTRY);
+
+    return expected_size;
+}
+
+/**
+ * Builds a view over the given registry (of type RT_VAR_LEN) stored on a memory buffer
+ * @param view view to be filled
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t2_view_registry(RegistryView* view, const char* src, size_t available) {
+    // Truncated registry metadata
+    if (available < registry_metadata_size(RT_VAR_LEN)) {
+        return 0;
+    }
+
+    T2RegistryMetadata registry_metadata;
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += mread_member_field(&registry_metadata, removido, src + read_bytes);
+    read_bytes += mread_member_field(&registry_metadata, tamanhoRegistro, src + read_bytes);
+    read_bytes += mread_member_field(&registry_metadata, prox, src + read_bytes);
+
+    size_t expected_size = registry_metadata.tamanhoRegistro + T2_IGNORED_SIZE;
+
+    // Removed registries only need their metadata
+    view->removed = registry_metadata.removido == REMOVED;
+    if (view->removed) {
+        return expected_size;
+    }
+
+    // Truncated registry (its fixed fields must fit it, the same way its strings are bounded)
+    if (expected_size > available || expected_size < read_bytes + STATIC_CONTENT_SIZE) {
+        return 0;
+    }
+
+    // View registry content (remaining bytes are just skipped)
+    read_bytes += view_registry_content(view, src + read_bytes, expected_size - read_bytes);
+
+    // Check for over-reads
+    ex_assert(read_bytes <= expected_size, EX_CORRUPTED_REGISTRY);
+
+    return expected_size;
+}
+
 /**
  * Setups the given RT_VAR_LEN header metadata
  * @param header_metadata target header metadata
@@ -0,0 +1,830 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "t3_registry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "../utils/utils.h"
+
+// Position of the slot directory on the page header
+static const size_t T3_PAGE_SLOTS_POSITION = T3_PAGE_HEADER_SIZE - member_size(T3Page, slots);
+
+/**
+ * Writes the given header (of type RT_SLOTTED) into the target file
+ * @param header header to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t3_write_header(Header* header, FILE* dest) {
+    // Basic validation
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->header_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->header_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    T3HeaderMetadata* metadata = header->header_metadata;
+    HeaderContent* header_content = header->header_content;
+
+    // Amount of bytes written
+    size_t written_bytes = 0;
+
+    // Write metadata before content
+    written_bytes += fwrite_member_field(metadata, status, dest);
+
+    // Write header content
+    written_bytes += write_header_content(header_content, dest);
+
+    // Write metadata after content (the free space inventory fills the rest of the page)
+    written_bytes += fwrite_member_field(metadata, nroPaginas, dest);
+    written_bytes += fwrite_member_field(metadata, nroRegRem, dest);
+    written_bytes += fwrite_member_field(metadata, espacoLivre, dest);
+
+    return written_bytes;
+}
+
+/**
+ * Reads the given header (of type RT_SLOTTED) from the target file
+ * @param header header to be read into
+ * @param src source file
+ * @return the amount of bytes read
+ */
+size_t t3_read_header(Header* header, FILE* src) {
+    ex_assert(header != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->header_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->header_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(header->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    T3HeaderMetadata* metadata = header->header_metadata;
+    HeaderContent* content = header->header_content;
+
+    // Assumes that header is already set-up on parent call
+    size_t read_bytes = 0;
+
+    // Read metadata before content
+    read_bytes += fread_member_field(metadata, status, src);
+
+    read_bytes += read_header_content(content, src);
+
+    // Read metadata after content
+    read_bytes += fread_member_field(metadata, nroPaginas, src);
+    read_bytes += fread_member_field(metadata, nroRegRem, src);
+    read_bytes += fread_member_field(metadata, espacoLivre, src);
+
+    return read_bytes;
+}
+
+/**
+ * Computes the required registry size for a given registry
+ * @param registry the target registry
+ * @return the minimum required size for the registry (except for the ignored parts)
+ */
+size_t t3_minimum_registry_size(Registry* registry) {
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    size_t size = 0;
+
+    // Static fields (without removed and registry size)
+    size += sizeof(registry_metadata->slot);
+
+    size += sizeof(registry_content->id);
+    size += sizeof(registry_content->ano);
+    size += sizeof(registry_content->qtt);
+    size += sizeof(registry_content->sigla);
+
+    // Var len str fields
+    if (registry_content->tamCidade != 0 && registry_content->cidade != NULL) {
+        size += sizeof(registry_content->tamCidade);
+        size += sizeof(registry_content->codC5);
+        size += sizeof(char) * registry_content->tamCidade;
+    }
+
+    if (registry_content->tamMarca != 0 && registry_content->marca != NULL) {
+        size += sizeof(registry_content->tamMarca);
+        size += sizeof(registry_content->codC6);
+        size += sizeof(char) * registry_content->tamMarca;
+    }
+
+    if (registry_content->tamModelo != 0 && registry_content->modelo != NULL) {
+        size += sizeof(registry_content->tamModelo);
+        size += sizeof(registry_content->codC7);
+        size += sizeof(char) * registry_content->tamModelo;
+    }
+
+    return size;
+}
+
+/**
+ * Writes the given registry (of type RT_SLOTTED) into the target file, over its current bytes (pages are only changed
+ * through the t3_page_* functions)
+ * @param registry registry to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t3_write_registry(Registry* registry, FILE* dest) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    char buffer[T3_PAGE_SIZE];
+    ex_assert(t3_encoded_registry_size(registry) <= T3_PAGE_SIZE, EX_CORRUPTED_REGISTRY);
+
+    size_t encoded_bytes = t3_encode_registry(registry, buffer);
+    return fwrite(buffer, 1, encoded_bytes, dest);
+}
+
+/**
+ * Encodes the given registry (of type RT_SLOTTED) into a memory buffer (same bytes as t3_write_registry)
+ * @param registry registry to be encoded
+ * @param dest destination buffer (must hold at least t3_encoded_registry_size bytes)
+ * @return the amount of bytes written
+ */
+size_t t3_encode_registry(Registry* registry, char* dest) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+    ex_assert(dest != NULL, EX_GENERIC_ERROR);
+
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Update registry size
+    if (registry_metadata->removido == NOT_REMOVED) {
+        registry_metadata->tamanhoRegistro = (uint16_t) max(registry_metadata->tamanhoRegistro, t3_minimum_registry_size(registry));
+    }
+
+    size_t expected_size = registry_metadata->tamanhoRegistro + T3_IGNORED_SIZE;
+
+    // Amount of bytes written
+    size_t written_bytes = 0;
+
+    // Write registry metadata
+    written_bytes += mwrite_member_field(registry_metadata, removido, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_metadata, tamanhoRegistro, dest + written_bytes);
+    written_bytes += mwrite_member_field(registry_metadata, slot, dest + written_bytes);
+
+    if (registry_metadata->removido == REMOVED) {
+        return written_bytes;
+    }
+
+    // Write registry content
+    written_bytes += encode_registry_content(registry_content, dest + written_bytes);
+
+    // Fill remaining bytes for registries that shrank
+    if (written_bytes < expected_size) {
+        written_bytes += mfill_bytes(expected_size - written_bytes, dest + written_bytes);
+    }
+
+    return written_bytes;
+}
+
+/**
+ * Computes the amount of bytes written when encoding the given registry (of type RT_SLOTTED)
+ * @param registry target registry
+ * @return the encoded size
+ */
+size_t t3_encoded_registry_size(Registry* registry) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+
+    // Removed registries only have their metadata written
+    if (registry_metadata->removido == REMOVED) {
+        return registry_metadata_size(RT_SLOTTED);
+    }
+
+    return max(registry_metadata->tamanhoRegistro, t3_minimum_registry_size(registry)) + T3_IGNORED_SIZE;
+}
+
+/**
+ * Reads the given registry (of type RT_SLOTTED) from the target file
+ * @param registry registry to be read into
+ * @param src source file
+ * @return the amount of bytes read
+ */
+size_t t3_read_registry(Registry* registry, FILE* src) {
+    return t3_read_registry_projected(registry, src, FM_ALL);
+}
+
+/**
+ * Reads the given registry (of type RT_SLOTTED) from the target file, decoding only the projected fields
+ * @param registry registry to be read into
+ * @param src source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t t3_read_registry_projected(Registry* registry, FILE* src, field_mask_t fields) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += fread_member_field(registry_metadata, removido, src);
+    read_bytes += fread_member_field(registry_metadata, tamanhoRegistro, src);
+    read_bytes += fread_member_field(registry_metadata, slot, src);
+
+    size_t expected_size = registry_metadata->tamanhoRegistro + T3_IGNORED_SIZE;
+
+    if (registry_metadata->removido == REMOVED) {
+        fseek(src, (long) (expected_size - read_bytes), SEEK_CUR);
+        return expected_size;
+    }
+
+    // Read registry content
+    read_bytes += read_registry_content_projected(registry_content, src, expected_size - read_bytes, fields);
+
+    // Skip remaining bytes
+    if (read_bytes < expected_size) {
+        fseek(src, (long) (expected_size - read_bytes), SEEK_CUR);
+    }
+
+    // Check for over-reads
+    ex_assert(read_bytes <= expected_size, EX_CORRUPTED_REGISTRY);
+
+    return expected_size;
+}
+
+/**
+ * Reads the given registry (of type RT_SLOTTED) from a memory buffer
+ * @param registry registry to be read into
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t3_read_registry_from_buffer(Registry* registry, const char* src, size_t available) {
+    ex_assert(registry != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_content != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_metadata != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_GENERIC_ERROR);
+
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+    RegistryContent* registry_content = registry->registry_content;
+
+    // Truncated registry metadata
+    if (available < registry_metadata_size(RT_SLOTTED)) {
+        return 0;
+    }
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += mread_member_field(registry_metadata, removido, src + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, tamanhoRegistro, src + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, slot, src + read_bytes);
+
+    size_t expected_size = registry_metadata->tamanhoRegistro + T3_IGNORED_SIZE;
+
+    // Removed registries (page headers and free tails included) only need their metadata
+    if (registry_metadata->removido == REMOVED) {
+        return expected_size;
+    }
+
+    // Truncated registry (its fixed fields must fit it, the same way its strings are bounded)
+    if (expected_size > available || expected_size < read_bytes + STATIC_CONTENT_SIZE) {
+        return 0;
+    }
+
+    // Read registry content (remaining bytes are just skipped)
+    read_bytes += read_registry_content_from_buffer(registry_content, src + read_bytes, expected_size - read_bytes);
+
+    // Check for over-reads
+    ex_assert(read_bytes <= expected_size, EX_CORRUPTED_REGISTRY);
+
+    return expected_size;
+}
+
+/**
+ * Builds a view over the given registry (of type RT_SLOTTED) stored on a memory buffer
+ * @param view view to be filled
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t3_view_registry(RegistryView* view, const char* src, size_t available) {
+    // Truncated registry metadata
+    if (available < registry_metadata_size(RT_SLOTTED)) {
+        return 0;
+    }
+
+    T3RegistryMetadata registry_metadata;
+
+    // Amount of bytes read
+    size_t read_bytes = 0;
+
+    // Read registry metadata
+    read_bytes += mread_member_field(&registry_metadata, removido, src + read_bytes);
+    read_bytes += mread_member_field(&registry_metadata, tamanhoRegistro, src + read_bytes);
+    read_bytes += mread_member_field(&registry_metadata, slot, src + read_bytes);
+
+    size_t expected_size = registry_metadata.tamanhoRegistro + T3_IGNORED_SIZE;
+    view->slot = registry_metadata.slot;
+
+    // Removed registries (page headers and free tails included) only need their metadata
+    view->removed = registry_metadata.removido == REMOVED;
+    if (view->removed) {
+        return expected_size;
+    }
+
+    // Truncated registry (its fixed fields must fit it, the same way its strings are bounded)
+    if (expected_size > available || expected_size < read_bytes + STATIC_CONTENT_SIZE) {
+        return 0;
+    }
+
+    // View registry content (remaining bytes are just skipped)
+    read_bytes += view_registry_content(view, src + read_bytes, expected_size - read_bytes);
+
+    // Check for over-reads
+    ex_assert(read_bytes <= expected_size, EX_CORRUPTED_REGISTRY);
+
+    return expected_size;
+}
+
+/**
+ * Seeks the registry at the given reference, through its page's slot directory
+ * @param header the file's header
+ * @param file the target file
+ * @param reference the registry reference
+ * @return if the reference points to a registry (else the file position goes to the end)
+ */
+bool t3_seek_registry(Header* header, FILE* file, size_t reference) {
+    ex_assert(header->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+
+    T3HeaderMetadata* header_metadata = header->header_metadata;
+    size_t page = reference >> T3_SLOT_BITS;
+    size_t slot = reference & (T3_PAGE_SLOTS - 1);
+
+    // Look the registry up on the page's slot directory (0 for free slots)
+    uint16_t position = 0;
+    if (page < (size_t) header_metadata->nroPaginas) {
+        go_to_offset(t3_page_offset((int32_t) page) + T3_PAGE_SLOTS_POSITION + slot * sizeof(uint16_t), file);
+        if (fread(&position, 1, sizeof(position), file) != sizeof(position)) {
+            position = 0;
+        }
+    }
+
+    if (position < T3_PAGE_HEADER_SIZE || position >= T3_PAGE_SIZE) {
+        go_to_offset(t3_page_offset(header_metadata->nroPaginas), file);
+        return false;
+    }
+
+    go_to_offset(t3_page_offset((int32_t) page) + position, file);
+    return true;
+}
+
+/**
+ * Builds a registry reference
+ * @param page page number
+ * @param slot slot on the page
+ * @return the reference
+ */
+int64_t t3_make_reference(int32_t page, uint16_t slot) {
+    ex_assert(slot < T3_PAGE_SLOTS, EX_CORRUPTED_REGISTRY);
+    return ((int64_t) page << T3_SLOT_BITS) | slot;
+}
+
+/**
+ * Computes the file offset of a page
+ * @param page page number
+ * @return the page offset
+ */
+size_t t3_page_offset(int32_t page) {
+    return T3_HEADER_SIZE + (size_t) page * T3_PAGE_SIZE;
+}
+
+/**
+ * Computes the number of the page holding a file offset
+ * @param offset the file offset (past the header)
+ * @return the page number
+ */
+int32_t t3_offset_page(size_t offset) {
+    ex_assert(offset >= T3_HEADER_SIZE, EX_CORRUPTED_REGISTRY);
+    return (int32_t) ((offset - T3_HEADER_SIZE) / T3_PAGE_SIZE);
+}
+
+/**
+ * Reads the metadata of the registry at a page position
+ * @param page source page
+ * @param position the registry position on the page
+ * @param registry_metadata where the metadata will be stored
+ * @return the registry size
+ */
+static size_t peek_page_registry(T3Page* page, size_t position, T3RegistryMetadata* registry_metadata) {
+    ex_assert(position + registry_metadata_size(RT_SLOTTED) <= T3_PAGE_SIZE, EX_CORRUPTED_REGISTRY);
+
+    size_t read_bytes = 0;
+    read_bytes += mread_member_field(registry_metadata, removido, page->data + position + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, tamanhoRegistro, page->data + position + read_bytes);
+    read_bytes += mread_member_field(registry_metadata, slot, page->data + position + read_bytes);
+
+    size_t size = registry_metadata->tamanhoRegistro + T3_IGNORED_SIZE;
+    ex_assert(size >= read_bytes && position + size <= T3_PAGE_SIZE, EX_CORRUPTED_REGISTRY);
+
+    return size;
+}
+
+/**
+ * Finds a free slot on the page (the lowest one)
+ * @param page target page
+ * @return the free slot (-1 if the slot directory is full)
+ */
+static int32_t free_page_slot(T3Page* page) {
+    for (uint16_t i = 0; i < page->nroSlots; i++) {
+        if (page->slots[i] == 0) {
+            return i;
+        }
+    }
+
+    return page->nroSlots < T3_PAGE_SLOTS ? page->nroSlots : -1;
+}
+
+/**
+ * Moves every registry to the beginning of the page, merging the holes into the free tail (slots are kept)
+ * @param page target page
+ */
+static void compact_page(T3Page* page) {
+    size_t position = T3_PAGE_HEADER_SIZE;
+    size_t compacted_position = T3_PAGE_HEADER_SIZE;
+
+    while (position < page->fimRegistros) {
+        T3RegistryMetadata registry_metadata;
+        size_t size = peek_page_registry(page, position, &registry_metadata);
+
+        if (registry_metadata.removido != REMOVED) {
+            ex_assert(registry_metadata.slot < T3_PAGE_SLOTS && page->slots[registry_metadata.slot] == position, EX_CORRUPTED_REGISTRY);
+
+            memmove(page->data + compacted_position, page->data + position, size);
+            page->slots[registry_metadata.slot] = (uint16_t) compacted_position;
+            compacted_position += size;
+        }
+
+        position += size;
+    }
+
+    page->fimRegistros = (uint16_t) compacted_position;
+    page->nroRemovidos = 0;
+
+    ex_assert(page->bytesLivres == T3_PAGE_SIZE - page->fimRegistros, EX_CORRUPTED_REGISTRY);
+}
+
+/**
+ * Writes a registry at the page's free tail, compacting the page first if the tail is too short
+ * @param page target page
+ * @param registry registry to be written
+ * @param slot the registry slot
+ * @return if the registry fit on the page
+ */
+static bool place_page_registry(T3Page* page, Registry* registry, uint16_t slot) {
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+    registry_metadata->removido = NOT_REMOVED;
+
+    size_t size = t3_encoded_registry_size(registry);
+    if (size > page->bytesLivres) {
+        return false;
+    }
+
+    if (size > (size_t) (T3_PAGE_SIZE - page->fimRegistros)) {
+        compact_page(page);
+    }
+
+    // A tail too short to be skipped as a removed registry is given to the registry
+    size_t tail_size = T3_PAGE_SIZE - page->fimRegistros - size;
+    if (tail_size > 0 && tail_size < registry_metadata_size(RT_SLOTTED)) {
+        size += tail_size;
+    }
+
+    registry_metadata->tamanhoRegistro = (uint16_t) (size - T3_IGNORED_SIZE);
+    registry_metadata->slot = slot;
+    t3_encode_registry(registry, page->data + page->fimRegistros);
+    registry->offset = t3_page_offset(page->number) + page->fimRegistros;
+
+    page->slots[slot] = page->fimRegistros;
+    page->nroSlots = max(page->nroSlots, slot + 1);
+    page->fimRegistros += size;
+    page->bytesLivres -= size;
+
+    return true;
+}
+
+/**
+ * Setups the given page as an empty page
+ * @param page target page
+ * @param number page number
+ */
+void t3_setup_page(T3Page* page, int32_t number) {
+    page->number = number;
+    page->nroSlots = 0;
+    page->nroRemovidos = 0;
+    page->fimRegistros = T3_PAGE_HEADER_SIZE;
+    page->bytesLivres = T3_PAGE_SIZE - T3_PAGE_HEADER_SIZE;
+    memset(page->slots, 0, sizeof(page->slots));
+}
+
+/**
+ * Reads a page from the target file
+ * @param page page to be read into
+ * @param number page number
+ * @param src source file
+ * @return the amount of bytes read (0 on corrupted pages)
+ */
+size_t t3_read_page(T3Page* page, int32_t number, FILE* src) {
+    ex_assert(page != NULL, EX_GENERIC_ERROR);
+    ex_assert(src != NULL, EX_FILE_ERROR);
+
+    go_to_offset(t3_page_offset(number), src);
+    if (fread(page->data, 1, T3_PAGE_SIZE, src) != T3_PAGE_SIZE) {
+        return 0;
+    }
+
+    page->number = number;
+
+    // Page fields come right after the page header's registry metadata
+    size_t read_bytes = registry_metadata_size(RT_SLOTTED);
+    read_bytes += mread_member_field(page, nroSlots, page->data + read_bytes);
+    read_bytes += mread_member_field(page, nroRemovidos, page->data + read_bytes);
+    read_bytes += mread_member_field(page, fimRegistros, page->data + read_bytes);
+    read_bytes += mread_member_field(page, bytesLivres, page->data + read_bytes);
+    read_bytes += mread_member_field(page, slots, page->data + read_bytes);
+
+    bool valid = page->data[0] == REMOVED && page->nroSlots <= T3_PAGE_SLOTS;
+    valid = valid && page->fimRegistros >= T3_PAGE_HEADER_SIZE && page->fimRegistros <= T3_PAGE_SIZE;
+    valid = valid && page->bytesLivres >= T3_PAGE_SIZE - page->fimRegistros && page->bytesLivres <= T3_PAGE_SIZE - T3_PAGE_HEADER_SIZE;
+
+    return valid ? T3_PAGE_SIZE : 0;
+}
+
+/**
+ * Encodes the page fields and its free tail into the page bytes
+ * @param page target page
+ * @return the page bytes
+ */
+const char* t3_encode_page(T3Page* page) {
+    ex_assert(page != NULL, EX_GENERIC_ERROR);
+
+    // The page header is a removed registry spanning the page fields
+    T3RegistryMetadata page_metadata = {REMOVED, (uint16_t) (T3_PAGE_HEADER_SIZE - T3_IGNORED_SIZE), T3_NO_SLOT};
+
+    size_t written_bytes = 0;
+    written_bytes += mwrite_member_field(&page_metadata, removido, page->data + written_bytes);
+    written_bytes += mwrite_member_field(&page_metadata, tamanhoRegistro, page->data + written_bytes);
+    written_bytes += mwrite_member_field(&page_metadata, slot, page->data + written_bytes);
+    written_bytes += mwrite_member_field(page, nroSlots, page->data + written_bytes);
+    written_bytes += mwrite_member_field(page, nroRemovidos, page->data + written_bytes);
+    written_bytes += mwrite_member_field(page, fimRegistros, page->data + written_bytes);
+    written_bytes += mwrite_member_field(page, bytesLivres, page->data + written_bytes);
+    written_bytes += mwrite_member_field(page, slots, page->data + written_bytes);
+
+    // So is the free tail
+    size_t tail_size = T3_PAGE_SIZE - page->fimRegistros;
+    if (tail_size > 0) {
+        ex_assert(tail_size >= registry_metadata_size(RT_SLOTTED), EX_CORRUPTED_REGISTRY);
+
+        T3RegistryMetadata tail_metadata = {REMOVED, (uint16_t) (tail_size - T3_IGNORED_SIZE), T3_TAIL_SLOT};
+        char* tail = page->data + page->fimRegistros;
+
+        written_bytes = 0;
+        written_bytes += mwrite_member_field(&tail_metadata, removido, tail + written_bytes);
+        written_bytes += mwrite_member_field(&tail_metadata, tamanhoRegistro, tail + written_bytes);
+        written_bytes += mwrite_member_field(&tail_metadata, slot, tail + written_bytes);
+        mfill_bytes(tail_size - written_bytes, tail + written_bytes);
+    }
+
+    return page->data;
+}
+
+/**
+ * Writes a page into the target file
+ * @param page page to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t3_write_page(T3Page* page, FILE* dest) {
+    ex_assert(dest != NULL, EX_FILE_ERROR);
+
+    const char* data = t3_encode_page(page);
+
+    go_to_offset(t3_page_offset(page->number), dest);
+    return fwrite(data, 1, T3_PAGE_SIZE, dest);
+}
+
+/**
+ * Inserts a registry on the page, compacting it if needed (the registry's offset and slot are set)
+ * @param page target page
+ * @param registry registry to be inserted
+ * @return if the registry fit on the page
+ */
+bool t3_page_insert(T3Page* page, Registry* registry) {
+    ex_assert(page != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry != NULL && registry->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+
+    int32_t slot = free_page_slot(page);
+    if (slot == -1) {
+        return false;
+    }
+
+    return place_page_registry(page, registry, (uint16_t) slot);
+}
+
+/**
+ * Removes a registry from the page, its bytes are left as a hole and its slot is freed
+ * @param page target page
+ * @param slot the registry slot
+ */
+void t3_page_remove(T3Page* page, uint16_t slot) {
+    ex_assert(page != NULL, EX_GENERIC_ERROR);
+    ex_assert(slot < page->nroSlots && page->slots[slot] != 0, EX_CORRUPTED_REGISTRY);
+
+    size_t position = page->slots[slot];
+
+    T3RegistryMetadata registry_metadata;
+    size_t size = peek_page_registry(page, position, &registry_metadata);
+    ex_assert(registry_metadata.removido != REMOVED && registry_metadata.slot == slot, EX_CORRUPTED_REGISTRY);
+
+    // Only the metadata changes
+    registry_metadata.removido = REMOVED;
+    registry_metadata.slot = T3_NO_SLOT;
+    memcpy(page->data + position, &registry_metadata.removido, sizeof(registry_metadata.removido));
+    memcpy(page->data + position + T3_IGNORED_SIZE, &registry_metadata.slot, sizeof(registry_metadata.slot));
+
+    // The hole only joins the free tail when the page is compacted, so scans going through the page aren't disturbed
+    page->slots[slot] = 0;
+    page->bytesLivres += size;
+    page->nroRemovidos++;
+
+    // Trailing free slots leave the directory
+    while (page->nroSlots > 0 && page->slots[page->nroSlots - 1] == 0) {
+        page->nroSlots--;
+    }
+}
+
+/**
+ * Rewrites a registry on the page, moving it to the free tail if it grew (its slot is kept, the page isn't compacted)
+ * @param page target page
+ * @param registry registry to be rewritten (read from the page)
+ * @return if the registry fit on the page
+ */
+bool t3_page_update(T3Page* page, Registry* registry) {
+    ex_assert(page != NULL, EX_GENERIC_ERROR);
+    ex_assert(registry != NULL && registry->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+
+    T3RegistryMetadata* registry_metadata = registry->registry_metadata;
+    uint16_t slot = registry_metadata->slot;
+    ex_assert(slot < page->nroSlots, EX_CORRUPTED_REGISTRY);
+
+    size_t position = page->slots[slot];
+    ex_assert(position != 0 && t3_page_offset(page->number) + position == registry->offset, EX_CORRUPTED_REGISTRY);
+
+    size_t current_size = registry_metadata->tamanhoRegistro + T3_IGNORED_SIZE;
+    size_t new_size = t3_minimum_registry_size(registry) + T3_IGNORED_SIZE;
+
+    // Fits on its current bytes (shrinking leaves filler bytes behind, just like RT_VAR_LEN)
+    if (new_size <= current_size) {
+        t3_encode_registry(registry, page->data + position);
+        return true;
+    }
+
+    // Only the free tail is used, compacting would move registries under scans going through the page
+    if (new_size > (size_t) (T3_PAGE_SIZE - page->fimRegistros)) {
+        return false;
+    }
+
+    // Moved to the free tail, its slot now points to the new position
+    t3_page_remove(page, slot);
+    registry_metadata->tamanhoRegistro = 0;
+
+    bool placed = place_page_registry(page, registry, slot);
+    ex_assert(placed, EX_CORRUPTED_REGISTRY);
+
+    return true;
+}
+
+/**
+ * Computes the free bytes available for new registries on the page (0 if it has no free slots)
+ * @param page target page
+ * @return the free bytes
+ */
+size_t t3_page_free_space(T3Page* page) {
+    return free_page_slot(page) == -1 ? 0 : page->bytesLivres;
+}
+
+/**
+ * Updates the header's free space inventory entry of a page
+ * @param header the file's header
+ * @param page the changed page
+ */
+void t3_track_page(Header* header, T3Page* page) {
+    ex_assert(header->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+
+    if (page->number >= T3_TRACKED_PAGES) {
+        return;
+    }
+
+    T3HeaderMetadata* header_metadata = header->header_metadata;
+    header_metadata->espacoLivre[page->number] = (uint8_t) min(t3_page_free_space(page) / T3_FREE_SPACE_UNIT, UINT8_MAX);
+}
+
+/**
+ * Finds the first page with enough free space for a registry, from the header's free space inventory
+ * @param header the file's header
+ * @param size the registry size
+ * @param skipped_page page that must not be returned (-1 for none)
+ * @return the page number (-1 if there are none)
+ */
+int32_t t3_find_page(Header* header, size_t size, int32_t skipped_page) {
+    ex_assert(header->registry_type == RT_SLOTTED, EX_GENERIC_ERROR);
+
+    T3HeaderMetadata* header_metadata = header->header_metadata;
+    int32_t n_tracked = min(header_metadata->nroPaginas, T3_TRACKED_PAGES);
+
+    // Entries are rounded down, so any page found has room for the registry
+    for (int32_t i = 0; i < n_tracked; i++) {
+        if (i != skipped_page && (size_t) header_metadata->espacoLivre[i] * T3_FREE_SPACE_UNIT >= size) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Setups the given RT_SLOTTED header metadata
+ * @param header_metadata target header metadata
+ */
+void t3_setup_header_metadata(T3HeaderMetadata* header_metadata) {
+    header_metadata->status = STATUS_BAD;
+    header_metadata->nroPaginas = 0;
+    header_metadata->nroRegRem = 0;
+    memset(header_metadata->espacoLivre, 0, sizeof(header_metadata->espacoLivre));
+}
+
+/**
+ * Setups the given RT_SLOTTED registry metadata
+ * @param registry_metadata
+ */
+void t3_setup_registry_metadata(T3RegistryMetadata* registry_metadata) {
+    registry_metadata->removido = NOT_REMOVED;
+    registry_metadata->tamanhoRegistro = 0;
+    registry_metadata->slot = T3_NO_SLOT;
+}
+
+/**
+ * Allocates and setup a new RT_SLOTTED header metadata
+ * @return the allocated header metadata
+ */
+T3HeaderMetadata* t3_new_header_metadata() {
+    T3HeaderMetadata* header_metadata = malloc(sizeof(struct T3HeaderMetadata));
+    t3_setup_header_metadata(header_metadata);
+    return header_metadata;
+}
+
+/**
+ * Allocates and setup a new RT_SLOTTED registry metadata
+ * @return the allocated registry metadata
+ */
+T3RegistryMetadata* t3_new_registry_metadata() {
+    T3RegistryMetadata* registry_metadata = malloc(sizeof(struct T3RegistryMetadata));
+    t3_setup_registry_metadata(registry_metadata);
+    return registry_metadata;
+}
+
+/**
+ * Destroys (frees) the given header metadata and its contents
+ * @param header_metadata the target header metadata
+ */
+void t3_destroy_header_metadata(T3HeaderMetadata* header_metadata) {
+    if (header_metadata == NULL) {
+        return;
+    }
+
+    free(header_metadata);
+}
+
+/**
+ * Destroys (frees) the given registry metadata and its contents
+ * @param registry_metadata the target registry metadata
+ */
+void t3_destroy_registry_metadata(T3RegistryMetadata* registry_metadata) {
+    if (registry_metadata == NULL) {
+        return;
+    }
+
+    free(registry_metadata);
+}
@@ -0,0 +1,319 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include "common.h"
+#include "registry.h"
+#include "registry_content.h"
+#include "registry_view.h"
+
+// Page size, the header takes the whole first page so every page is aligned on the file
+#define T3_PAGE_SIZE 4096
+
+// Slot directory entries per page
+#define T3_PAGE_SLOTS 128
+
+// Bits of a reference taken by the slot (references are (page << T3_SLOT_BITS) | slot)
+#define T3_SLOT_BITS 7
+
+// Slot of page headers and removed registries
+#define T3_NO_SLOT UINT16_MAX
+
+// Slot of free page tails (so they can be told apart from removed registries)
+#define T3_TAIL_SLOT (UINT16_MAX - 1)
+
+// Granularity of the header's free space inventory (in bytes)
+#define T3_FREE_SPACE_UNIT 16
+
+// Pages tracked by the header's free space inventory (one byte each, filling the rest of the header page)
+#define T3_TRACKED_PAGES (T3_PAGE_SIZE - 178)
+
+/**
+ * RT_SLOTTED header metadata struct
+ *
+ * espacoLivre holds the free bytes (in T3_FREE_SPACE_UNIT units, rounded down) available for new registries on each
+ * page, 0 for pages without free slots. Pages past T3_TRACKED_PAGES are only appended to
+ */
+typedef struct T3HeaderMetadata {
+    char status;
+    int32_t nroPaginas;
+    int32_t nroRegRem;
+    uint8_t espacoLivre[T3_TRACKED_PAGES];
+} T3HeaderMetadata;
+
+static const size_t T3_HEADER_SIZE = T3_PAGE_SIZE;
+
+/**
+ * RT_SLOTTED registry metadata struct
+ */
+typedef struct T3RegistryMetadata {
+    char removido;
+    uint16_t tamanhoRegistro;
+    uint16_t slot;
+} T3RegistryMetadata;
+
+// Ignore T3 registry size on field tamanhoRegistro
+static const size_t T3_IGNORED_SIZE = member_size(T3RegistryMetadata, removido) + member_size(T3RegistryMetadata, tamanhoRegistro);
+
+/**
+ * In-memory copy of a page
+ *
+ * A page starts with its header, stored as a removed registry (so sequential scans just skip it) holding the page
+ * fields and the slot directory, followed by the registries and the free tail (also a removed registry, if any).
+ * Removed registries stay as holes until an insertion runs out of tail space and compacts the page, which only moves
+ * registries inside the page, so their (page, slot) reference never changes
+ */
+typedef struct T3Page {
+    int32_t number;
+    uint16_t nroSlots;
+    uint16_t nroRemovidos;
+    uint16_t fimRegistros;
+    uint16_t bytesLivres;
+    uint16_t slots[T3_PAGE_SLOTS];
+    char data[T3_PAGE_SIZE];
+} T3Page;
+
+// Page header size (registry metadata, page fields and slot directory)
+static const size_t T3_PAGE_HEADER_SIZE = member_size(T3RegistryMetadata, removido) + member_size(T3RegistryMetadata, tamanhoRegistro) + member_size(T3RegistryMetadata, slot) + member_size(T3Page, nroSlots) + member_size(T3Page, nroRemovidos) + member_size(T3Page, fimRegistros) + member_size(T3Page, bytesLivres) + member_size(T3Page, slots);
+
+// File I/O //
+
+/**
+ * Writes the given header (of type RT_SLOTTED) into the target file
+ * @param header header to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t3_write_header(Header* header, FILE* dest);
+
+/**
+ * Reads the given header (of type RT_SLOTTED) from the target file
+ * @param header header to be read into
+ * @param src source file
+ * @return the amount of bytes read
+ */
+size_t t3_read_header(Header* header, FILE* src);
+
+/**
+ * Computes the required registry size for a given registry
+ * @param registry the target registry
+ * @return the minimum required size for the registry (except for the ignored parts)
+ */
+size_t t3_minimum_registry_size(Registry* registry);
+
+/**
+ * Writes the given registry (of type RT_SLOTTED) into the target file, over its current bytes (pages are only changed
+ * through the t3_page_* functions)
+ * @param registry registry to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t3_write_registry(Registry* registry, FILE* dest);
+
+/**
+ * Encodes the given registry (of type RT_SLOTTED) into a memory buffer (same bytes as t3_write_registry)
+ * @param registry registry to be encoded
+ * @param dest destination buffer (must hold at least t3_encoded_registry_size bytes)
+ * @return the amount of bytes written
+ */
+size_t t3_encode_registry(Registry* registry, char* dest);
+
+/**
+ * Computes the amount of bytes written when encoding the given registry (of type RT_SLOTTED)
+ * @param registry target registry
+ * @return the encoded size
+ */
+size_t t3_encoded_registry_size(Registry* registry);
+
+/**
+ * Reads the given registry (of type RT_SLOTTED) from the target file
+ * @param registry registry to be read into
+ * @param src source file
+ * @return the amount of bytes read
+ */
+size_t t3_read_registry(Registry* registry, FILE* src);
+
+/**
+ * Reads the given registry (of type RT_SLOTTED) from the target file, decoding only the projected fields
+ * @param registry registry to be read into
+ * @param src source file
+ * @param fields projected fields (FM_* flags)
+ * @return the amount of bytes read
+ */
+size_t t3_read_registry_projected(Registry* registry, FILE* src, field_mask_t fields);
+
+/**
+ * Reads the given registry (of type RT_SLOTTED) from a memory buffer
+ * @param registry registry to be read into
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the amount of bytes read (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t3_read_registry_from_buffer(Registry* registry, const char* src, size_t available);
+
+/**
+ * Builds a view over the given registry (of type RT_SLOTTED) stored on a memory buffer
+ * @param view view to be filled
+ * @param src source buffer
+ * @param available amount of bytes that can be safely read from the buffer
+ * @return the registry's size on the file (0 if the buffer doesn't hold the whole registry)
+ */
+size_t t3_view_registry(RegistryView* view, const char* src, size_t available);
+
+/**
+ * Seeks the registry at the given reference, through its page's slot directory
+ * @param header the file's header
+ * @param file the target file
+ * @param reference the registry reference
+ * @return if the reference points to a registry (else the file position goes to the end)
+ */
+bool t3_seek_registry(Header* header, FILE* file, size_t reference);
+
+// References //
+
+/**
+ * Builds a registry reference
+ * @param page page number
+ * @param slot slot on the page
+ * @return the reference
+ */
+int64_t t3_make_reference(int32_t page, uint16_t slot);
+
+/**
+ * Computes the file offset of a page
+ * @param page page number
+ * @return the page offset
+ */
+size_t t3_page_offset(int32_t page);
+
+/**
+ * Computes the number of the page holding a file offset
+ * @param offset the file offset (past the header)
+ * @return the page number
+ */
+int32_t t3_offset_page(size_t offset);
+
+// Pages //
+
+/**
+ * Setups the given page as an empty page
+ * @param page target page
+ * @param number page number
+ */
+void t3_setup_page(T3Page* page, int32_t number);
+
+/**
+ * Reads a page from the target file
+ * @param page page to be read into
+ * @param number page number
+ * @param src source file
+ * @return the amount of bytes read (0 on corrupted pages)
+ */
+size_t t3_read_page(T3Page* page, int32_t number, FILE* src);
+
+/**
+ * Encodes the page fields and its free tail into the page bytes
+ * @param page target page
+ * @return the page bytes
+ */
+const char* t3_encode_page(T3Page* page);
+
+/**
+ * Writes a page into the target file
+ * @param page page to be written
+ * @param dest destination file
+ * @return the amount of bytes written
+ */
+size_t t3_write_page(T3Page* page, FILE* dest);
+
+/**
+ * Inserts a registry on the page, compacting it if needed (the registry's offset and slot are set)
+ * @param page target page
+ * @param registry registry to be inserted
+ * @return if the registry fit on the page
+ */
+bool t3_page_insert(T3Page* page, Registry* registry);
+
+/**
+ * Removes a registry from the page, its bytes are left as a hole and its slot is freed
+ * @param page target page
+ * @param slot the registry slot
+ */
+void t3_page_remove(T3Page* page, uint16_t slot);
+
+/**
+ * Rewrites a registry on the page, moving it to the free tail if it grew (its slot is kept, the page isn't compacted)
+ * @param page target page
+ * @param registry registry to be rewritten (read from the page)
+ * @return if the registry fit on the page
+ */
+bool t3_page_update(T3Page* page, Registry* registry);
+
+/**
+ * Computes the free bytes available for new registries on the page (0 if it has no free slots)
+ * @param page target page
+ * @return the free bytes
+ */
+size_t t3_page_free_space(T3Page* page);
+
+// Free space inventory //
+
+/**
+ * Updates the header's free space inventory entry of a page
+ * @param header the file's header
+ * @param page the changed page
+ */
+void t3_track_page(Header* header, T3Page* page);
+
+/**
+ * Finds the first page with enough free space for a registry, from the header's free space inventory
+ * @param header the file's header
+ * @param size the registry size
+ * @param skipped_page page that must not be returned (-1 for none)
+ * @return the page number (-1 if there are none)
+ */
+int32_t t3_find_page(Header* header, size_t size, int32_t skipped_page);
+
+// Setup //
+
+/**
+ * Setups the given RT_SLOTTED header metadata
+ * @param header_metadata target header metadata
+ */
+void t3_setup_header_metadata(T3HeaderMetadata* header_metadata);
+
+/**
+ * Setups the given RT_SLOTTED registry metadata
+ * @param registry_metadata
+ */
+void t3_setup_registry_metadata(T3RegistryMetadata* registry_metadata);
+
+// Allocators //
+
+/**
+ * Allocates and setup a new RT_SLOTTED header metadata
+ * @return the allocated header metadata
+ */
+T3HeaderMetadata* t3_new_header_metadata();
+
+/**
+ * Allocates and setup a new RT_SLOTTED registry metadata
+ * @return the allocated registry metadata
+ */
+T3RegistryMetadata* t3_new_registry_metadata();
+
+// Destroy //
+
+/**
+ * Destroys (frees) the given header metadata and its contents
+ * @param header_metadata the target header metadata
+ */
+void t3_destroy_header_metadata(T3HeaderMetadata* header_metadata);
+
+/**
+ * Destroys (frees) the given registry metadata and its contents
+ * @param registry_metadata the target registry metadata
+ */
+void t3_destroy_registry_metadata(T3RegistryMetadata* registry_metadata);
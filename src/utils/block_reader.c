@@ -0,0 +1,117 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "block_reader.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "utils.h"
+
+/**
+ * Allocates a new block reader
+ * @param file source file
+ * @param start_offset offset of the reader's cursor
+ * @param block_size the block size (clamped into [MIN_READ_BLOCK_SIZE, MAX_READ_BLOCK_SIZE])
+ * @return the allocated reader
+ */
+BlockReader* new_block_reader(FILE* file, size_t start_offset, size_t block_size) {
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    BlockReader* reader = malloc(sizeof(struct BlockReader));
+    ex_assert(reader != NULL, EX_MEMORY_ERROR);
+
+    reader->file = file;
+    reader->block_size = max(MIN_READ_BLOCK_SIZE, min(MAX_READ_BLOCK_SIZE, block_size));
+    reader->block = malloc(reader->block_size);
+    ex_assert(reader->block != NULL, EX_MEMORY_ERROR);
+    reader->block_offset = start_offset;
+    reader->block_len = 0;
+    reader->file_offset = SIZE_MAX;// Unknown, force a seek on the first load
+    reader->position = start_offset;
+
+    return reader;
+}
+
+/**
+ * Retrieves the bytes at the cursor, loading blocks as needed. Requests bigger than the block grow it.
+ * @param reader target reader
+ * @param n amount of contiguous bytes wanted
+ * @param available output for the amount of contiguous bytes available (may be less than n at the end of file)
+ * @return pointer to the bytes at the cursor
+ */
+const char* block_reader_peek(BlockReader* reader, size_t n, size_t* available) {
+    ex_assert(reader != NULL, EX_GENERIC_ERROR);
+
+    size_t block_end = reader->block_offset + reader->block_len;
+
+    // Fast path: already loaded
+    if (reader->position >= reader->block_offset && reader->position + n <= block_end) {
+        *available = block_end - reader->position;
+        return reader->block + (reader->position - reader->block_offset);
+    }
+
+    // Grow the block for oversized requests
+    if (n > reader->block_size) {
+        reader->block_size = n;
+        reader->block = realloc(reader->block, reader->block_size);
+        ex_assert(reader->block != NULL, EX_MEMORY_ERROR);
+    }
+
+    // Keep the loaded tail when the cursor is still inside the block (registry crossing the block boundary)
+    size_t kept = 0;
+    if (reader->position >= reader->block_offset && reader->position < block_end) {
+        kept = block_end - reader->position;
+        memmove(reader->block, reader->block + (reader->position - reader->block_offset), kept);
+    }
+
+    reader->block_offset = reader->position;
+    reader->block_len = kept;
+
+    // Load the remaining of the block (only seek when the file isn't already there)
+    size_t load_offset = reader->block_offset + kept;
+    if (reader->file_offset != load_offset) {
+        fseek(reader->file, (long) load_offset, SEEK_SET);
+    }
+    reader->block_len += fread(reader->block + kept, 1, reader->block_size - kept, reader->file);
+    reader->file_offset = reader->block_offset + reader->block_len;
+
+    *available = reader->block_len;
+    return reader->block;
+}
+
+/**
+ * Advances the cursor (skips past the loaded block are resolved lazily with a single fseek)
+ * @param reader target reader
+ * @param n amount of bytes to skip
+ */
+void block_reader_skip(BlockReader* reader, size_t n) {
+    ex_assert(reader != NULL, EX_GENERIC_ERROR);
+    reader->position += n;
+}
+
+/**
+ * Retrieves the cursor's offset on the file
+ * @param reader target reader
+ * @return the cursor offset
+ */
+size_t block_reader_offset(BlockReader* reader) {
+    ex_assert(reader != NULL, EX_GENERIC_ERROR);
+    return reader->position;
+}
+
+/**
+ * Destroys (frees) the given reader (the file is kept open)
+ * @param reader target reader
+ */
+void destroy_block_reader(BlockReader* reader) {
+    if (reader == NULL) {
+        return;
+    }
+
+    free(reader->block);
+    free(reader);
+}
@@ -0,0 +1,63 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+// Block size bounds
+#define MIN_READ_BLOCK_SIZE (64 * 1024)
+#define MAX_READ_BLOCK_SIZE (4 * 1024 * 1024)
+#define DEFAULT_READ_BLOCK_SIZE (1024 * 1024)
+
+/**
+ * Sequential reader that loads a file in large blocks, exposing the bytes at its cursor as a contiguous buffer
+ */
+typedef struct BlockReader {
+    FILE* file;
+    char* block;
+    size_t block_size;
+    size_t block_offset;// File offset of the first byte on the block
+    size_t block_len;   // Amount of valid bytes on the block
+    size_t file_offset; // Current position of the underlying file
+    size_t position;    // Cursor offset on the file
+} BlockReader;
+
+/**
+ * Allocates a new block reader
+ * @param file source file
+ * @param start_offset offset of the reader's cursor
+ * @param block_size the block size (clamped into [MIN_READ_BLOCK_SIZE, MAX_READ_BLOCK_SIZE])
+ * @return the allocated reader
+ */
+BlockReader* new_block_reader(FILE* file, size_t start_offset, size_t block_size);
+
+/**
+ * Retrieves the bytes at the cursor, loading blocks as needed. Requests bigger than the block grow it.
+ * @param reader target reader
+ * @param n amount of contiguous bytes wanted
+ * @param available output for the amount of contiguous bytes available (may be less than n at the end of file)
+ * @return pointer to the bytes at the cursor
+ */
+const char* block_reader_peek(BlockReader* reader, size_t n, size_t* available);
+
+/**
+ * Advances the cursor (skips past the loaded block are resolved lazily with a single fseek)
+ * @param reader target reader
+ * @param n amount of bytes to skip
+ */
+void block_reader_skip(BlockReader* reader, size_t n);
+
+/**
+ * Retrieves the cursor's offset on the file
+ * @param reader target reader
+ * @return the cursor offset
+ */
+size_t block_reader_offset(BlockReader* reader);
+
+/**
+ * Destroys (frees) the given reader (the file is kept open)
+ * @param reader target reader
+ */
+void destroy_block_reader(BlockReader* reader);
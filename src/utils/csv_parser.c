@@ -4,10 +4,21 @@
 
 #include "csv_parser.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "../exception/exception.h"
+#include "settings.h"
+#include "utils.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CSV_X86_SIMD 1
+#endif
+
+// Characters classified at once by the streaming tokenizer (one bit each)
+#define CSV_SCAN_BLOCK 64
 
 /**
  * Allocate and preset a new CSVHeader
@@ -138,7 +149,7 @@ CSVContent* read_csv(FILE* csv_file, bool has_header) {
     CSVContent* content = new_csvcontent();
 
     // Static buffer, since teoretically, a registry couldn't even surpass 100 bytes
-    char buffer[512];
+    char buffer[CSV_MAX_FIELD_LEN];
 
     uint16_t buffer_idx = 0;
 
@@ -216,7 +227,7 @@ CSVContent* read_csv(FILE* csv_file, bool has_header) {
         }
 
         // Prevent buffer overflow
-        ex_assert(buffer_idx < 512, EX_GENERIC_ERROR);
+        ex_assert(buffer_idx < CSV_MAX_FIELD_LEN, EX_GENERIC_ERROR);
 
         // Write char to buffer
         buffer[buffer_idx] = (char) cur_char;
@@ -258,86 +269,368 @@ CSVContent* read_csv(FILE* csv_file, bool has_header) {
 }
 
 /**
- * Stream a csv line by line
- * @param csv_file targe CSV file
- * @param it the iterating function called with each line
- * @param passthrough passthrough params to the iterating function
+ * Read the next newline-aligned chunk, the partial last line is carried over to the next chunk
+ * @param csv_file source file
+ * @param chunk destination chunk
+ * @param carry partial line carried between chunks
+ * @return if there might be more data after this chunk
  */
-void stream_csv(FILE* csv_file, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough) {
-    // Static buffer, since teoretically, a registry couldn't even surpass 100 bytes
-    char buffer[512];
+bool read_csv_chunk(FILE* csv_file, CSVChunk* chunk, CSVChunk* carry) {
+    // Start with the carried partial line
+    if (chunk->capacity < carry->size + CSV_CHUNK_SIZE) {
+        chunk->capacity = carry->size + CSV_CHUNK_SIZE;
+        chunk->data = realloc(chunk->data, chunk->capacity);
+        ex_assert(chunk->data != NULL, EX_MEMORY_ERROR);
+    }
+    if (carry->size > 0) {
+        memcpy(chunk->data, carry->data, carry->size);
+    }
+    chunk->size = carry->size;
+    carry->size = 0;
 
-    uint16_t buffer_idx = 0;
+    while (true) {
+        size_t searched = chunk->size;
+        chunk->size += fread(chunk->data + chunk->size, 1, chunk->capacity - chunk->size, csv_file);
 
-    CSVLine* cur_line = new_csvline();
-    int idx = 0;
-    CSVField* cur_field = NULL;
+        // Whatever is left is the last chunk
+        if (chunk->size < chunk->capacity && feof(csv_file)) {
+            return false;
+        }
 
-    // Loop the entire file until EOF
-    while (1) {
-        int32_t cur_char = getc(csv_file);
+        // Cut after the last line break
+        for (size_t i = chunk->size; i > searched; i--) {
+            if (chunk->data[i - 1] == '\n') {
+                size_t remainder = chunk->size - i;
+                if (carry->capacity < remainder) {
+                    carry->capacity = max(remainder, CSV_CHUNK_SIZE);
+                    carry->data = realloc(carry->data, carry->capacity);
+                    ex_assert(carry->data != NULL, EX_MEMORY_ERROR);
+                }
+                memcpy(carry->data, chunk->data + i, remainder);
+                carry->size = remainder;
+                chunk->size = i;
+                return true;
+            }
+        }
 
-        if (cur_char == '\r') {
-            cur_char = getc(csv_file);
+        // No line break on the whole chunk, keep reading into a bigger one
+        if (chunk->size == chunk->capacity) {
+            chunk->capacity *= 2;
+            chunk->data = realloc(chunk->data, chunk->capacity);
+            ex_assert(chunk->data != NULL, EX_MEMORY_ERROR);
         }
+    }
+}
 
-        // Handle separators
-        if (cur_char == ',' || cur_char == '\n' || cur_char == EOF) {
+/**
+ * Classifies a block of CSV_SCAN_BLOCK characters
+ * @param block the characters
+ * @return bitmask with the positions holding a ',', '\n' or '\r'
+ */
+typedef uint64_t (*CSVSeparatorMask)(const char* block);
 
-            // Handle field creation and insertion
-            if (buffer_idx != 0 || cur_char == ',') {
-                // Create the new field
-                CSVField* new_field = new_csvfield();
+/**
+ * Scalar classification of the first n characters of a block (fallback, also used on the text tail)
+ * @param block the characters
+ * @param n amount of characters (up to CSV_SCAN_BLOCK)
+ * @return bitmask with the positions holding a ',', '\n' or '\r'
+ */
+static uint64_t csv_separator_mask_partial(const char* block, size_t n) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (block[i] == ',' || block[i] == '\n' || block[i] == '\r') {
+            mask |= (uint64_t) 1 << i;
+        }
+    }
+    return mask;
+}
 
-                // Copy buffer into new field
-                if (buffer_idx != 0) {
-                    new_field->content = calloc(buffer_idx + 1, sizeof(char));
-                    memcpy(new_field->content, buffer, buffer_idx);
-                    new_field->content[buffer_idx] = '\0';
-                    new_field->content_len = buffer_idx;
-                    buffer_idx = 0;
-                }
+/**
+ * Scalar block classification
+ * @param block the characters
+ * @return bitmask with the positions holding a ',', '\n' or '\r'
+ */
+static uint64_t csv_separator_mask_scalar(const char* block) {
+    return csv_separator_mask_partial(block, CSV_SCAN_BLOCK);
+}
 
-                // Insert new field in the line's field list
-                if (cur_field == NULL) {
-                    cur_field = new_field;
-                    cur_line->head_field = cur_field;
-                    cur_line->n_fields++;
-                } else {
-                    cur_field->next = new_field;
-                    cur_field = new_field;
-                    cur_line->n_fields++;
-                }
+#ifdef CSV_X86_SIMD
+/**
+ * SSE2 block classification, 16 characters at a time
+ * @param block the characters
+ * @return bitmask with the positions holding a ',', '\n' or '\r'
+ */
+__attribute__((target("sse2"))) static uint64_t csv_separator_mask_sse2(const char* block) {
+    __m128i comma = _mm_set1_epi8(',');
+    __m128i line_feed = _mm_set1_epi8('\n');
+    __m128i carriage_return = _mm_set1_epi8('\r');
+
+    uint64_t mask = 0;
+    for (size_t i = 0; i < CSV_SCAN_BLOCK; i += 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i*) (block + i));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, comma), _mm_cmpeq_epi8(chars, line_feed)),
+                                    _mm_cmpeq_epi8(chars, carriage_return));
+        mask |= (uint64_t) (uint32_t) _mm_movemask_epi8(hits) << i;
+    }
+    return mask;
+}
+
+/**
+ * AVX2 block classification, 32 characters at a time
+ * @param block the characters
+ * @return bitmask with the positions holding a ',', '\n' or '\r'
+ */
+__attribute__((target("avx2"))) static uint64_t csv_separator_mask_avx2(const char* block) {
+    __m256i comma = _mm256_set1_epi8(',');
+    __m256i line_feed = _mm256_set1_epi8('\n');
+    __m256i carriage_return = _mm256_set1_epi8('\r');
+
+    uint64_t mask = 0;
+    for (size_t i = 0; i < CSV_SCAN_BLOCK; i += 32) {
+        __m256i chars = _mm256_loadu_si256((const __m256i*) (block + i));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chars, comma), _mm256_cmpeq_epi8(chars, line_feed)),
+                                       _mm256_cmpeq_epi8(chars, carriage_return));
+        mask |= (uint64_t) (uint32_t) _mm256_movemask_epi8(hits) << i;
+    }
+    return mask;
+}
+#endif
+
+// Block classification implementation, resolved once since parsing threads tokenize concurrently
+static CSVSeparatorMask csv_separator_mask = NULL;
+static pthread_once_t csv_separator_mask_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Picks the best block classification implementation for the running CPU (bounded by SETTING_SIMD_LEVEL)
+ */
+static void resolve_csv_separator_mask() {
+    size_t simd_level = get_size_setting(SETTING_SIMD_LEVEL, 2, 0, 2);
+    csv_separator_mask = csv_separator_mask_scalar;
+
+#ifdef CSV_X86_SIMD
+    __builtin_cpu_init();
+    if (simd_level >= 2 && __builtin_cpu_supports("avx2")) {
+        csv_separator_mask = csv_separator_mask_avx2;
+    } else if (simd_level >= 1 && __builtin_cpu_supports("sse2")) {
+        csv_separator_mask = csv_separator_mask_sse2;
+    }
+#else
+    (void) simd_level;
+#endif
+}
+
+/**
+ * Field storage reused between lines, fields which can't point straight into the text are copied here
+ */
+typedef struct CSVFieldSlot {
+    CSVField field;
+    bool copied;
+    char copy[CSV_MAX_FIELD_LEN + 1];
+} CSVFieldSlot;
+
+/**
+ * Streaming tokenizer state, the line handed to the iterating function is built over the slots
+ */
+typedef struct CSVTokenizer {
+    CSVLine line;
+    CSVFieldSlot* slots;
+    uint32_t n_slots;
+} CSVTokenizer;
+
+/**
+ * Preset a tokenizer
+ * @param tokenizer target tokenizer
+ */
+static void setup_csv_tokenizer(CSVTokenizer* tokenizer) {
+    pthread_once(&csv_separator_mask_once, resolve_csv_separator_mask);
+
+    tokenizer->line.n_fields = 0;
+    tokenizer->line.head_field = NULL;
+    tokenizer->line.next = NULL;
+    tokenizer->slots = NULL;
+    tokenizer->n_slots = 0;
+}
+
+/**
+ * Add the text in [start, end) as a field of the current line (same rules as read_csv)
+ * @param tokenizer target tokenizer
+ * @param data csv text
+ * @param start field start
+ * @param end field end (position of its separator)
+ * @param has_cr if the field holds a '\r' (dropped, the character after it is always taken as content)
+ * @param comma if the field was ended by a ',' (empty fields are only kept when followed by a comma)
+ */
+static void csv_tokenizer_push_field(CSVTokenizer* tokenizer, const char* data, size_t start, size_t end, bool has_cr, bool comma) {
+    if (start == end && !comma) {
+        return;
+    }
+
+    // Grow the slots (pointers are only linked once the line is complete)
+    if (tokenizer->line.n_fields == tokenizer->n_slots) {
+        tokenizer->n_slots = max(2 * tokenizer->n_slots, 16);
+        tokenizer->slots = realloc(tokenizer->slots, tokenizer->n_slots * sizeof(struct CSVFieldSlot));
+        ex_assert(tokenizer->slots != NULL, EX_MEMORY_ERROR);
+    }
+    CSVFieldSlot* slot = &tokenizer->slots[tokenizer->line.n_fields];
+
+    // Point straight into the text, the comma right after the field stops any strtol
+    if (comma && !has_cr) {
+        ex_assert(end - start <= CSV_MAX_FIELD_LEN, EX_GENERIC_ERROR);
+        slot->copied = false;
+        slot->field.content = start != end ? (char*) data + start : NULL;
+        slot->field.content_len = end - start;
+        tokenizer->line.n_fields++;
+        return;
+    }
+
+    // Copy (and null terminate) the field, dropping carriage returns
+    size_t len = 0;
+    for (size_t i = start; i < end; i++) {
+        char cur_char = data[i];
+        if (has_cr && cur_char == '\r') {
+            if (++i == end) {
+                break;
             }
+            cur_char = data[i];
+        }
 
-            // Handle line break/EOF
-            if (cur_char == '\n' || cur_char == EOF) {
-                if (cur_line->n_fields != 0) {
-                    it(idx, cur_line, passthrough);
-                    idx++;
-                    if (cur_char != EOF) {
-                        // Create next line
-                        destroy_csvline(cur_line);
-                        cur_line = new_csvline();
-                        cur_field = NULL;
-                    }
+        ex_assert(len < CSV_MAX_FIELD_LEN, EX_GENERIC_ERROR);
+        slot->copy[len++] = cur_char;
+    }
+
+    if (len == 0 && !comma) {
+        return;
+    }
+
+    slot->copy[len] = '\0';
+    slot->copied = len != 0;
+    slot->field.content = NULL;
+    slot->field.content_len = len;
+    tokenizer->line.n_fields++;
+}
+
+/**
+ * Hand the current line over to the iterating function (empty lines are skipped)
+ * @param tokenizer target tokenizer
+ * @param idx the line index
+ * @param it the iterating function
+ * @param passthrough passthrough params to the iterating function
+ * @return the index of the next line
+ */
+static int csv_tokenizer_emit_line(CSVTokenizer* tokenizer, int idx, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough) {
+    CSVLine* line = &tokenizer->line;
+    if (line->n_fields == 0) {
+        return idx;
+    }
+
+    for (uint32_t i = 0; i < line->n_fields; i++) {
+        CSVFieldSlot* slot = &tokenizer->slots[i];
+        if (slot->copied) {
+            slot->field.content = slot->copy;
+        }
+        slot->field.next = i + 1 < line->n_fields ? &tokenizer->slots[i + 1].field : NULL;
+    }
+    line->head_field = &tokenizer->slots[0].field;
+
+    it(idx, line, passthrough);
+
+    line->n_fields = 0;
+    line->head_field = NULL;
+    return idx + 1;
+}
+
+/**
+ * Tokenize a csv text line by line, jumping straight between separators
+ * @param tokenizer tokenizer state
+ * @param data csv text
+ * @param size text size
+ * @param idx the index given to the first line
+ * @param it the iterating function called with each line
+ * @param passthrough passthrough params to the iterating function
+ * @return the index of the line after the last one
+ */
+static int tokenize_csv(CSVTokenizer* tokenizer, const char* data, size_t size, int idx, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough) {
+    size_t field_start = 0;
+    bool has_cr = false;
+
+    // Position of a '\r' right after a dropped one, it's content rather than a separator
+    size_t literal = SIZE_MAX;
+
+    for (size_t block = 0; block < size; block += CSV_SCAN_BLOCK) {
+        uint64_t mask = size - block >= CSV_SCAN_BLOCK ? csv_separator_mask(data + block)
+                                                       : csv_separator_mask_partial(data + block, size - block);
+
+        while (mask != 0) {
+            size_t i = block + (size_t) __builtin_ctzll(mask);
+            mask &= mask - 1;
+
+            if (i == literal) {
+                continue;
+            }
+
+            if (data[i] == '\r') {
+                has_cr = true;
+                if (i + 1 < size && data[i + 1] == '\r') {
+                    literal = i + 1;
                 }
+                continue;
             }
 
-            if (cur_char == EOF) {
-                break;
+            csv_tokenizer_push_field(tokenizer, data, field_start, i, has_cr, data[i] == ',');
+            if (data[i] == '\n') {
+                idx = csv_tokenizer_emit_line(tokenizer, idx, it, passthrough);
             }
 
-            continue;
+            field_start = i + 1;
+            has_cr = false;
         }
+    }
 
-        // Prevent buffer overflow
-        ex_assert(buffer_idx < 512, EX_GENERIC_ERROR);
+    // The text end works as a line break
+    csv_tokenizer_push_field(tokenizer, data, field_start, size, has_cr, false);
+    return csv_tokenizer_emit_line(tokenizer, idx, it, passthrough);
+}
 
-        // Write char to buffer
-        buffer[buffer_idx] = (char) cur_char;
-        buffer_idx++;
+/**
+ * Stream a csv line by line (lines and fields are reused between calls, their contents are only valid during the call)
+ * @param csv_file targe CSV file
+ * @param it the iterating function called with each line
+ * @param passthrough passthrough params to the iterating function
+ */
+void stream_csv(FILE* csv_file, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough) {
+    CSVTokenizer tokenizer;
+    setup_csv_tokenizer(&tokenizer);
+
+    CSVChunk chunk = {0, NULL, 0, 0, NULL};
+    CSVChunk carry = {0, NULL, 0, 0, NULL};
+    int idx = 0;
+
+    // Lines never cross a line break, so chunks can be tokenized independently
+    bool more_data = true;
+    while (more_data) {
+        more_data = read_csv_chunk(csv_file, &chunk, &carry);
+        idx = tokenize_csv(&tokenizer, chunk.data, chunk.size, idx, it, passthrough);
     }
 
-    destroy_csvline(cur_line);
-}
\ No newline at end of file
+    free(chunk.data);
+    free(carry.data);
+    free(tokenizer.slots);
+}
+
+/**
+ * Stream an in-memory csv (e.g. a chunk of a bigger file) line by line, without modifying it
+ * Fields may point straight into the text, so their contents are only valid during the call
+ * @param data csv text
+ * @param size text size
+ * @param first_idx the index given to the first line
+ * @param it the iterating function called with each line
+ * @param passthrough passthrough params to the iterating function
+ */
+void stream_csv_buffer(const char* data, size_t size, int first_idx, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough) {
+    CSVTokenizer tokenizer;
+    setup_csv_tokenizer(&tokenizer);
+
+    tokenize_csv(&tokenizer, data, size, first_idx, it, passthrough);
+
+    free(tokenizer.slots);
+}
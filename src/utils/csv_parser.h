@@ -8,6 +8,12 @@
 #include <stdint.h>
 #include <stdio.h>
 
+// Size of the newline-aligned text chunks read from streamed CSV files
+#define CSV_CHUNK_SIZE (1024 * 1024)
+
+// Longest field accepted by the parsers
+#define CSV_MAX_FIELD_LEN 512
+
 /**
  * CSV header struct
  */
@@ -35,6 +41,17 @@ typedef struct CSVLine {
     struct CSVLine* next;
 } CSVLine;
 
+/**
+ * Newline-aligned piece of a CSV file (and the result of its parsing, when streamed through a pipeline)
+ */
+typedef struct CSVChunk {
+    uint64_t index;
+    char* data;
+    size_t size;
+    size_t capacity;
+    void* result;
+} CSVChunk;
+
 /**
  * CSV content (full file) struct
  */
@@ -105,9 +122,29 @@ void destroy_csvfield(CSVField* field);
 CSVContent* read_csv(FILE* csv_file, bool has_header);
 
 /**
- * Stream a csv line by line
+ * Read the next newline-aligned chunk, the partial last line is carried over to the next chunk
+ * @param csv_file source file
+ * @param chunk destination chunk
+ * @param carry partial line carried between chunks
+ * @return if there might be more data after this chunk
+ */
+bool read_csv_chunk(FILE* csv_file, CSVChunk* chunk, CSVChunk* carry);
+
+/**
+ * Stream a csv line by line (lines and fields are reused between calls, their contents are only valid during the call)
  * @param csv_file targe CSV file
  * @param it the iterating function called with each line
  * @param passthrough passthrough params to the iterating function
  */
 void stream_csv(FILE* csv_file, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough);
+
+/**
+ * Stream an in-memory csv (e.g. a chunk of a bigger file) line by line, without modifying it
+ * Fields may point straight into the text, so their contents are only valid during the call
+ * @param data csv text
+ * @param size text size
+ * @param first_idx the index given to the first line
+ * @param it the iterating function called with each line
+ * @param passthrough passthrough params to the iterating function
+ */
+void stream_csv_buffer(const char* data, size_t size, int first_idx, void (*it)(int idx, CSVLine* cur_line, void* passthrough), void* passthrough);
@@ -0,0 +1,204 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "csv_pipeline.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "../exception/exception.h"
+#include "settings.h"
+#include "utils.h"
+
+/**
+ * Chunk slot states (empty slots belong to the reader, ready ones to the parsers and done ones to the consumer)
+ */
+typedef enum ChunkState {
+    CS_EMPTY,
+    CS_READY,
+    CS_DONE
+} ChunkState;
+
+/**
+ * Data shared by the reader, the parsing threads and the consumer
+ */
+typedef struct CSVPipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t ready_cond;
+    pthread_cond_t done_cond;
+
+    // Ring of chunk slots, chunk n lives on slot n % n_slots
+    CSVChunk* slots;
+    ChunkState* states;
+    size_t n_slots;
+
+    uint64_t n_read;
+    uint64_t n_taken;
+    bool finished;
+
+    CSVChunkParser parse;
+    void* passthrough;
+} CSVPipeline;
+
+/**
+ * Parsing thread body: take ready chunks in order and parse them
+ * @param pipeline_ptr the CSVPipeline
+ * @return NULL
+ */
+static void* parse_csv_chunks(void* pipeline_ptr) {
+    CSVPipeline* pipeline = pipeline_ptr;
+
+    pthread_mutex_lock(&pipeline->lock);
+    while (true) {
+        while (pipeline->n_taken == pipeline->n_read && !pipeline->finished) {
+            pthread_cond_wait(&pipeline->ready_cond, &pipeline->lock);
+        }
+
+        // Nothing left to parse
+        if (pipeline->n_taken == pipeline->n_read) {
+            break;
+        }
+
+        size_t slot = pipeline->n_taken++ % pipeline->n_slots;
+
+        pthread_mutex_unlock(&pipeline->lock);
+        pipeline->parse(&pipeline->slots[slot], pipeline->passthrough);
+        pthread_mutex_lock(&pipeline->lock);
+
+        pipeline->states[slot] = CS_DONE;
+        pthread_cond_broadcast(&pipeline->done_cond);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+
+    return NULL;
+}
+
+/**
+ * Retrieves the amount of threads to be used on csv parsing
+ * @return the thread count
+ */
+static size_t csv_pipeline_thread_count() {
+    long online_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t default_threads = online_cpus > 0 ? (size_t) online_cpus : 1;
+    return get_size_setting(SETTING_PARSE_THREADS, min(default_threads, MAX_CSV_PIPELINE_THREADS), 1, MAX_CSV_PIPELINE_THREADS);
+}
+
+/**
+ * Stream a csv in newline-aligned chunks, parsing them on a thread pool and consuming them in file order
+ * @param csv_file target CSV file
+ * @param parse chunk parsing function
+ * @param consume chunk consuming function
+ * @param release chunk result release function
+ * @param passthrough shared data given to both parse and consume
+ * @return if the stream was executed (false when parsing threads are disabled, so the caller must stream sequentially)
+ */
+bool parallel_stream_csv(FILE* csv_file, CSVChunkParser parse, CSVChunkConsumer consume, CSVChunkRelease release, void* passthrough) {
+    ex_assert(csv_file != NULL, EX_FILE_ERROR);
+
+    size_t n_threads = csv_pipeline_thread_count();
+    if (n_threads < 2) {
+        return false;
+    }
+
+    CSVPipeline pipeline;
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.ready_cond, NULL);
+    pthread_cond_init(&pipeline.done_cond, NULL);
+
+    // Two chunks per thread, so the reader and the consumer can work while the parsers are busy
+    pipeline.n_slots = 2 * n_threads;
+    pipeline.slots = calloc(pipeline.n_slots, sizeof(struct CSVChunk));
+    pipeline.states = calloc(pipeline.n_slots, sizeof(ChunkState));
+    ex_assert(pipeline.slots != NULL && pipeline.states != NULL, EX_MEMORY_ERROR);
+
+    pipeline.n_read = 0;
+    pipeline.n_taken = 0;
+    pipeline.finished = false;
+    pipeline.parse = parse;
+    pipeline.passthrough = passthrough;
+
+    // Spawn parsing threads
+    pthread_t threads[MAX_CSV_PIPELINE_THREADS];
+    size_t n_spawned = 0;
+    for (size_t i = 0; i < n_threads; i++) {
+        if (pthread_create(&threads[n_spawned], NULL, parse_csv_chunks, &pipeline) == 0) {
+            n_spawned++;
+        }
+    }
+
+    // Couldn't spawn any thread, nothing was read yet so the caller can still stream sequentially
+    if (n_spawned == 0) {
+        free(pipeline.slots);
+        free(pipeline.states);
+        pthread_cond_destroy(&pipeline.ready_cond);
+        pthread_cond_destroy(&pipeline.done_cond);
+        pthread_mutex_destroy(&pipeline.lock);
+        return false;
+    }
+
+    CSVChunk carry = {0, NULL, 0, 0, NULL};
+    uint64_t n_consumed = 0;
+    bool more_data = true;
+
+    while (true) {
+        // Hand new chunks over while there are free slots
+        while (more_data && pipeline.n_read - n_consumed < pipeline.n_slots) {
+            size_t slot = pipeline.n_read % pipeline.n_slots;
+            more_data = read_csv_chunk(csv_file, &pipeline.slots[slot], &carry);
+            pipeline.slots[slot].index = pipeline.n_read;
+
+            if (pipeline.slots[slot].size > 0) {
+                pthread_mutex_lock(&pipeline.lock);
+                pipeline.states[slot] = CS_READY;
+                pipeline.n_read++;
+                pthread_cond_signal(&pipeline.ready_cond);
+                pthread_mutex_unlock(&pipeline.lock);
+            }
+        }
+
+        // Every chunk was consumed
+        if (n_consumed == pipeline.n_read) {
+            break;
+        }
+
+        // Consume the oldest chunk
+        size_t slot = n_consumed % pipeline.n_slots;
+        pthread_mutex_lock(&pipeline.lock);
+        while (pipeline.states[slot] != CS_DONE) {
+            pthread_cond_wait(&pipeline.done_cond, &pipeline.lock);
+        }
+        pthread_mutex_unlock(&pipeline.lock);
+
+        consume(&pipeline.slots[slot], passthrough);
+        pipeline.states[slot] = CS_EMPTY;
+        n_consumed++;
+    }
+
+    // Stop parsing threads
+    pthread_mutex_lock(&pipeline.lock);
+    pipeline.finished = true;
+    pthread_cond_broadcast(&pipeline.ready_cond);
+    pthread_mutex_unlock(&pipeline.lock);
+
+    for (size_t i = 0; i < n_spawned; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Cleanup
+    for (size_t i = 0; i < pipeline.n_slots; i++) {
+        free(pipeline.slots[i].data);
+        if (pipeline.slots[i].result != NULL) {
+            release(pipeline.slots[i].result);
+        }
+    }
+    free(carry.data);
+    free(pipeline.slots);
+    free(pipeline.states);
+    pthread_cond_destroy(&pipeline.ready_cond);
+    pthread_cond_destroy(&pipeline.done_cond);
+    pthread_mutex_destroy(&pipeline.lock);
+
+    return true;
+}
@@ -0,0 +1,40 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "csv_parser.h"
+
+// Upper bound on parsing threads
+#define MAX_CSV_PIPELINE_THREADS 64
+
+/**
+ * Parses a chunk into its result (called from the parsing threads, must be thread-safe)
+ */
+typedef void (*CSVChunkParser)(CSVChunk* chunk, void* passthrough);
+
+/**
+ * Consumes a parsed chunk, always called from the calling thread and in file order
+ */
+typedef void (*CSVChunkConsumer)(CSVChunk* chunk, void* passthrough);
+
+/**
+ * Frees a chunk result (results are reused between chunks until the stream ends)
+ */
+typedef void (*CSVChunkRelease)(void* result);
+
+/**
+ * Stream a csv in newline-aligned chunks, parsing them on a thread pool and consuming them in file order
+ * @param csv_file target CSV file
+ * @param parse chunk parsing function
+ * @param consume chunk consuming function
+ * @param release chunk result release function
+ * @param passthrough shared data given to both parse and consume
+ * @return if the stream was executed (false when parsing threads are disabled, so the caller must stream sequentially)
+ */
+bool parallel_stream_csv(FILE* csv_file, CSVChunkParser parse, CSVChunkConsumer consume, CSVChunkRelease release, void* passthrough);
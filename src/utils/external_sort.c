@@ -0,0 +1,280 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "external_sort.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "utils.h"
+
+/**
+ * Allocates a new external sorter
+ * @param record_size size of each record
+ * @param compare record comparator
+ * @param memory_budget maximum amount of bytes used to hold records in memory
+ * @return the allocated sorter
+ */
+ExternalSorter* new_external_sorter(size_t record_size, RecordComparator compare, size_t memory_budget) {
+    ex_assert(record_size > 0, EX_GENERIC_ERROR);
+    ex_assert(compare != NULL, EX_GENERIC_ERROR);
+
+    ExternalSorter* sorter = malloc(sizeof(struct ExternalSorter));
+    ex_assert(sorter != NULL, EX_MEMORY_ERROR);
+
+    sorter->record_size = record_size;
+    sorter->compare = compare;
+    sorter->memory_budget = memory_budget;
+
+    // The in-memory run grows on demand, up to the budget
+    sorter->records = NULL;
+    sorter->allocated = 0;
+    sorter->capacity = max(memory_budget / record_size, 1);
+    sorter->used = 0;
+
+    sorter->runs = NULL;
+    sorter->n_runs = 0;
+    sorter->heap = NULL;
+    sorter->heap_size = 0;
+
+    sorter->n_records = 0;
+    sorter->next_record = 0;
+    sorter->finished = false;
+
+    return sorter;
+}
+
+/**
+ * Retrieves the record at the given position of the in-memory run
+ * @param sorter target sorter
+ * @param position record position
+ * @return the record
+ */
+static inline char* sorter_record(ExternalSorter* sorter, size_t position) {
+    return sorter->records + position * sorter->record_size;
+}
+
+/**
+ * Retrieves the current record of a spilled run
+ * @param sorter target sorter
+ * @param run_idx run index
+ * @return the record
+ */
+static inline const char* run_head(ExternalSorter* sorter, uint32_t run_idx) {
+    SortRun* run = &sorter->runs[run_idx];
+    return run->buffer + run->position * sorter->record_size;
+}
+
+/**
+ * Sorts the in-memory run and writes it into a new temporary file
+ * @param sorter target sorter
+ */
+static void spill_run(ExternalSorter* sorter) {
+    qsort(sorter->records, sorter->used, sorter->record_size, sorter->compare);
+
+    FILE* file = tmpfile();
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    size_t written = fwrite(sorter->records, sorter->record_size, sorter->used, file);
+    ex_assert(written == sorter->used, EX_FILE_ERROR);
+
+    sorter->runs = realloc(sorter->runs, (sorter->n_runs + 1) * sizeof(struct SortRun));
+    ex_assert(sorter->runs != NULL, EX_MEMORY_ERROR);
+    sorter->runs[sorter->n_runs++] = (SortRun){file, NULL, 0, 0, sorter->used};
+
+    sorter->used = 0;
+}
+
+/**
+ * Loads the next records of a run into its buffer
+ * @param sorter target sorter
+ * @param run target run
+ * @param buffer_records buffer capacity (records)
+ * @return if any record was loaded
+ */
+static bool refill_run(ExternalSorter* sorter, SortRun* run, size_t buffer_records) {
+    if (run->remaining == 0) {
+        return false;
+    }
+
+    size_t n = (size_t) min(run->remaining, (uint64_t) buffer_records);
+    size_t read = fread(run->buffer, sorter->record_size, n, run->file);
+    ex_assert(read == n, EX_FILE_ERROR);
+
+    run->buffered = n;
+    run->position = 0;
+    run->remaining -= n;
+    return true;
+}
+
+/**
+ * Restores the heap property from the given heap position downwards
+ * @param sorter target sorter
+ * @param position heap position
+ */
+static void sift_down(ExternalSorter* sorter, uint32_t position) {
+    uint32_t* heap = sorter->heap;
+
+    while (true) {
+        uint32_t smallest = position;
+        uint32_t left = 2 * position + 1;
+        uint32_t right = left + 1;
+
+        if (left < sorter->heap_size && sorter->compare(run_head(sorter, heap[left]), run_head(sorter, heap[smallest])) < 0) {
+            smallest = left;
+        }
+        if (right < sorter->heap_size && sorter->compare(run_head(sorter, heap[right]), run_head(sorter, heap[smallest])) < 0) {
+            smallest = right;
+        }
+
+        if (smallest == position) {
+            return;
+        }
+
+        uint32_t tmp = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = tmp;
+        position = smallest;
+    }
+}
+
+/**
+ * Adds a record to the sorter (must be called before external_sorter_finish)
+ * @param sorter target sorter
+ * @param record record to be copied into the sorter
+ */
+void external_sorter_add(ExternalSorter* sorter, const void* record) {
+    ex_assert(!sorter->finished, EX_GENERIC_ERROR);
+
+    // Budget exhausted, spill the current run
+    if (sorter->used == sorter->capacity) {
+        spill_run(sorter);
+    }
+
+    // Grow the in-memory run (exponentially)
+    if (sorter->used == sorter->allocated) {
+        sorter->allocated = min(max(sorter->allocated * 2, 1024), sorter->capacity);
+        sorter->records = realloc(sorter->records, sorter->allocated * sorter->record_size);
+        ex_assert(sorter->records != NULL, EX_MEMORY_ERROR);
+    }
+
+    memcpy(sorter_record(sorter, sorter->used), record, sorter->record_size);
+    sorter->used++;
+    sorter->n_records++;
+}
+
+/**
+ * Sorts the pending records and prepares the merge, no records can be added afterwards
+ * @param sorter target sorter
+ */
+void external_sorter_finish(ExternalSorter* sorter) {
+    ex_assert(!sorter->finished, EX_GENERIC_ERROR);
+    sorter->finished = true;
+
+    // Everything fits in memory, no merge needed
+    if (sorter->n_runs == 0) {
+        qsort(sorter->records, sorter->used, sorter->record_size, sorter->compare);
+        return;
+    }
+
+    // Spill the last run and hand its memory over to the merge buffers
+    if (sorter->used > 0) {
+        spill_run(sorter);
+    }
+    free(sorter->records);
+    sorter->records = NULL;
+    sorter->allocated = 0;
+
+    size_t buffer_records = max(sorter->capacity / sorter->n_runs, MIN_RUN_BUFFER_RECORDS);
+
+    sorter->heap = malloc(sorter->n_runs * sizeof(uint32_t));
+    ex_assert(sorter->heap != NULL, EX_MEMORY_ERROR);
+
+    for (uint32_t i = 0; i < sorter->n_runs; i++) {
+        SortRun* run = &sorter->runs[i];
+        run->buffer = malloc(buffer_records * sorter->record_size);
+        ex_assert(run->buffer != NULL, EX_MEMORY_ERROR);
+
+        rewind(run->file);
+        if (refill_run(sorter, run, buffer_records)) {
+            sorter->heap[sorter->heap_size++] = i;
+        }
+    }
+
+    // Heapify
+    for (int64_t i = (int64_t) sorter->heap_size / 2 - 1; i >= 0; i--) {
+        sift_down(sorter, (uint32_t) i);
+    }
+}
+
+/**
+ * Retrieves the next record in order (must be called after external_sorter_finish)
+ * @param sorter target sorter
+ * @param record where the record will be copied to
+ * @return if there was a record left
+ */
+bool external_sorter_next(ExternalSorter* sorter, void* record) {
+    ex_assert(sorter->finished, EX_GENERIC_ERROR);
+
+    // In-memory sort
+    if (sorter->n_runs == 0) {
+        if (sorter->next_record >= sorter->used) {
+            return false;
+        }
+
+        memcpy(record, sorter_record(sorter, sorter->next_record++), sorter->record_size);
+        return true;
+    }
+
+    // K-way merge, the smallest head is always on the top of the heap
+    if (sorter->heap_size == 0) {
+        return false;
+    }
+
+    uint32_t run_idx = sorter->heap[0];
+    SortRun* run = &sorter->runs[run_idx];
+    memcpy(record, run_head(sorter, run_idx), sorter->record_size);
+
+    // Advance the run, dropping it from the heap once exhausted
+    run->position++;
+    if (run->position == run->buffered) {
+        size_t buffer_records = max(sorter->capacity / sorter->n_runs, MIN_RUN_BUFFER_RECORDS);
+        if (!refill_run(sorter, run, buffer_records)) {
+            sorter->heap[0] = sorter->heap[--sorter->heap_size];
+        }
+    }
+
+    sift_down(sorter, 0);
+    return true;
+}
+
+/**
+ * Amount of records added to the sorter
+ * @param sorter target sorter
+ * @return the amount of records
+ */
+uint64_t external_sorter_size(ExternalSorter* sorter) {
+    return sorter->n_records;
+}
+
+/**
+ * Destroys (frees) the sorter and closes its temporary files
+ * @param sorter target sorter
+ */
+void destroy_external_sorter(ExternalSorter* sorter) {
+    if (sorter == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < sorter->n_runs; i++) {
+        fclose(sorter->runs[i].file);
+        free(sorter->runs[i].buffer);
+    }
+
+    free(sorter->runs);
+    free(sorter->heap);
+    free(sorter->records);
+    free(sorter);
+}
@@ -0,0 +1,99 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Default memory budget of external sorts (bytes)
+#define DEFAULT_SORT_MEMORY (64 * 1024 * 1024)
+
+// Minimum amount of records buffered per run while merging
+#define MIN_RUN_BUFFER_RECORDS 16
+
+/**
+ * Fixed size record comparator (same contract as qsort's)
+ */
+typedef int (*RecordComparator)(const void* a, const void* b);
+
+/**
+ * Sorted run spilled into a temporary file
+ */
+typedef struct SortRun {
+    FILE* file;
+    char* buffer;
+    size_t buffered;
+    size_t position;
+    uint64_t remaining;
+} SortRun;
+
+/**
+ * Sorts fixed size records under a memory budget, spilling sorted runs to temporary files and merging them back
+ */
+typedef struct ExternalSorter {
+    size_t record_size;
+    RecordComparator compare;
+    size_t memory_budget;
+
+    // Records of the current (not yet spilled) run
+    char* records;
+    size_t allocated;
+    size_t capacity;
+    size_t used;
+
+    // Spilled runs and the merge heap (run indexes ordered by their current record)
+    SortRun* runs;
+    uint32_t n_runs;
+    uint32_t* heap;
+    uint32_t heap_size;
+
+    uint64_t n_records;
+    size_t next_record;
+    bool finished;
+} ExternalSorter;
+
+/**
+ * Allocates a new external sorter
+ * @param record_size size of each record
+ * @param compare record comparator
+ * @param memory_budget maximum amount of bytes used to hold records in memory
+ * @return the allocated sorter
+ */
+ExternalSorter* new_external_sorter(size_t record_size, RecordComparator compare, size_t memory_budget);
+
+/**
+ * Adds a record to the sorter (must be called before external_sorter_finish)
+ * @param sorter target sorter
+ * @param record record to be copied into the sorter
+ */
+void external_sorter_add(ExternalSorter* sorter, const void* record);
+
+/**
+ * Sorts the pending records and prepares the merge, no records can be added afterwards
+ * @param sorter target sorter
+ */
+void external_sorter_finish(ExternalSorter* sorter);
+
+/**
+ * Retrieves the next record in order (must be called after external_sorter_finish)
+ * @param sorter target sorter
+ * @param record where the record will be copied to
+ * @return if there was a record left
+ */
+bool external_sorter_next(ExternalSorter* sorter, void* record);
+
+/**
+ * Amount of records added to the sorter
+ * @param sorter target sorter
+ * @return the amount of records
+ */
+uint64_t external_sorter_size(ExternalSorter* sorter);
+
+/**
+ * Destroys (frees) the sorter and closes its temporary files
+ * @param sorter target sorter
+ */
+void destroy_external_sorter(ExternalSorter* sorter);
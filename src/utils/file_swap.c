@@ -0,0 +1,296 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "file_swap.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../exception/exception.h"
+
+// Marks the start and the end of a complete intent record
+static const char SWAP_MAGIC[8] = {'A', 'R', 'Q', 'S', 'W', 'A', 'P', '1'};
+static const char SWAP_COMMIT_MAGIC[8] = {'A', 'R', 'Q', 'C', 'O', 'M', 'I', 'T'};
+
+// Upper bound on the paths stored in an intent record
+#define SWAP_MAX_PATH_LEN 4096
+
+/**
+ * Builds the path of a file's sidecar
+ * @param path the file path
+ * @param suffix sidecar suffix
+ * @return the allocated sidecar path
+ */
+char* swap_sidecar_path(const char* path, const char* suffix) {
+    size_t len = strlen(path);
+    size_t suffix_len = strlen(suffix);
+    char* sidecar_path = malloc(len + suffix_len + 1);
+    ex_assert(sidecar_path != NULL, EX_MEMORY_ERROR);
+
+    memcpy(sidecar_path, path, len);
+    memcpy(sidecar_path + len, suffix, suffix_len + 1);
+
+    return sidecar_path;
+}
+
+/**
+ * Flushes a file's directory entry changes (renames) to the disk
+ * @param path the file path
+ */
+static void sync_parent_directory(const char* path) {
+    char* directory = strdup(path);
+    ex_assert(directory != NULL, EX_MEMORY_ERROR);
+
+    char* slash = strrchr(directory, '/');
+    if (slash == NULL) {
+        strcpy(directory, ".");
+    } else {
+        slash[slash == directory ? 1 : 0] = '\0';
+    }
+
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd != -1) {
+        fsync(fd);
+        close(fd);
+    }
+
+    free(directory);
+}
+
+/**
+ * Starts a swap over a data file
+ * @param data_path the data file path
+ * @return the allocated swap
+ */
+FileSwap* new_file_swap(const char* data_path) {
+    ex_assert(data_path != NULL, EX_GENERIC_ERROR);
+
+    FileSwap* swap = malloc(sizeof(struct FileSwap));
+    ex_assert(swap != NULL, EX_MEMORY_ERROR);
+
+    swap->path = swap_sidecar_path(data_path, SWAP_FILE_SUFFIX);
+    swap->n_files = 0;
+    swap->committed = false;
+
+    return swap;
+}
+
+/**
+ * Creates the replacement of a file (empty, opened as "wb+")
+ * @param swap target swap
+ * @param path the replaced file path
+ * @return the replacement stream (NULL if it couldn't be created)
+ */
+FILE* swap_fopen(FileSwap* swap, const char* path) {
+    ex_assert(swap != NULL && !swap->committed, EX_GENERIC_ERROR);
+    ex_assert(swap->n_files < SWAP_MAX_FILES, EX_GENERIC_ERROR);
+
+    char* new_path = swap_sidecar_path(path, SWAP_NEW_FILE_SUFFIX);
+    FILE* file = fopen(new_path, "wb+");
+    if (file == NULL) {
+        free(new_path);
+        return NULL;
+    }
+
+    swap->paths[swap->n_files] = strdup(path);
+    ex_assert(swap->paths[swap->n_files] != NULL, EX_MEMORY_ERROR);
+    swap->new_paths[swap->n_files] = new_path;
+    swap->n_files++;
+
+    return file;
+}
+
+/**
+ * Flushes a closed file to the disk
+ * @param path the file path
+ * @return if the file is durable
+ */
+static bool sync_file(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+/**
+ * Makes the replacements durable (they must be closed)
+ * @param swap target swap
+ * @return if every replacement is on the disk
+ */
+bool sync_file_swap(FileSwap* swap) {
+    ex_assert(swap != NULL, EX_GENERIC_ERROR);
+
+    bool durable = true;
+    for (uint32_t i = 0; i < swap->n_files && durable; i++) {
+        durable = sync_file(swap->new_paths[i]);
+    }
+    return durable;
+}
+
+/**
+ * Makes the replacements durable, then renames them over the replaced files (the replacements must be closed)
+ * @param swap target swap
+ * @return if the files were swapped
+ */
+bool commit_file_swap(FileSwap* swap) {
+    ex_assert(swap != NULL && !swap->committed, EX_GENERIC_ERROR);
+
+    // Replacements must be fully on the disk before any of them is renamed
+    if (!sync_file_swap(swap)) {
+        return false;
+    }
+
+    // Intent record: the renamed files, then the commit mark
+    FILE* record = fopen(swap->path, "wb");
+    if (record == NULL) {
+        return false;
+    }
+
+    bool recorded = fwrite(SWAP_MAGIC, 1, sizeof(SWAP_MAGIC), record) == sizeof(SWAP_MAGIC);
+    recorded = recorded && fwrite(&swap->n_files, sizeof(swap->n_files), 1, record) == 1;
+    for (uint32_t i = 0; i < swap->n_files && recorded; i++) {
+        uint32_t path_len = (uint32_t) strlen(swap->paths[i]);
+        recorded = fwrite(&path_len, sizeof(path_len), 1, record) == 1;
+        recorded = recorded && fwrite(swap->paths[i], 1, path_len, record) == path_len;
+    }
+    recorded = recorded && fwrite(SWAP_COMMIT_MAGIC, 1, sizeof(SWAP_COMMIT_MAGIC), record) == sizeof(SWAP_COMMIT_MAGIC);
+    recorded = recorded && fflush(record) == 0 && fsync(fileno(record)) == 0;
+    fclose(record);
+
+    if (!recorded) {
+        unlink(swap->path);
+        return false;
+    }
+    sync_parent_directory(swap->path);
+
+    // From here on a crash is finished by the recovery
+    bool renamed = true;
+    for (uint32_t i = 0; i < swap->n_files; i++) {
+        renamed = rename(swap->new_paths[i], swap->paths[i]) == 0 && renamed;
+        sync_parent_directory(swap->paths[i]);
+    }
+
+    // Keep the record for the next recovery if any rename failed
+    if (renamed) {
+        unlink(swap->path);
+    }
+
+    swap->committed = true;
+    return renamed;
+}
+
+/**
+ * Destroys (frees) the swap, uncommitted replacements are deleted
+ * @param swap target swap
+ */
+void destroy_file_swap(FileSwap* swap) {
+    if (swap == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < swap->n_files; i++) {
+        if (!swap->committed) {
+            unlink(swap->new_paths[i]);
+        }
+        free(swap->paths[i]);
+        free(swap->new_paths[i]);
+    }
+
+    free(swap->path);
+    free(swap);
+}
+
+/**
+ * Renames a committed replacement over its file (nothing is done if it was already renamed)
+ * @param path the replaced file path
+ * @return if the replacement is in place
+ */
+bool rename_replacement(const char* path) {
+    char* new_path = swap_sidecar_path(path, SWAP_NEW_FILE_SUFFIX);
+
+    bool renamed = access(new_path, F_OK) != 0;
+    if (!renamed && rename(new_path, path) == 0) {
+        sync_parent_directory(path);
+        renamed = true;
+    }
+
+    free(new_path);
+    return renamed;
+}
+
+/**
+ * Deletes the replacement left by a swap which never committed (nothing is done if there is none)
+ * @param path the replaced file path
+ */
+void discard_replacement(const char* path) {
+    char* new_path = swap_sidecar_path(path, SWAP_NEW_FILE_SUFFIX);
+    unlink(new_path);
+    free(new_path);
+}
+
+/**
+ * Finishes a data file's interrupted swap (only swaps which reached their renames are finished)
+ * @param data_path the data file path
+ * @return if a swap was finished
+ */
+bool recover_file_swap(const char* data_path) {
+    char* path = swap_sidecar_path(data_path, SWAP_FILE_SUFFIX);
+    FILE* record = fopen(path, "rb");
+    if (record == NULL) {
+        free(path);
+        return false;
+    }
+
+    char magic[sizeof(SWAP_MAGIC)];
+    uint32_t n_files = 0;
+    bool valid = fread(magic, 1, sizeof(magic), record) == sizeof(magic) && memcmp(magic, SWAP_MAGIC, sizeof(SWAP_MAGIC)) == 0;
+    valid = valid && fread(&n_files, sizeof(n_files), 1, record) == 1 && n_files <= SWAP_MAX_FILES;
+
+    // Validate the whole record before renaming anything (only whole paths are kept)
+    char* paths[SWAP_MAX_FILES];
+    uint32_t n_read = 0;
+    while (n_read < n_files && valid) {
+        uint32_t path_len = 0;
+        valid = fread(&path_len, sizeof(path_len), 1, record) == 1 && path_len <= SWAP_MAX_PATH_LEN;
+        if (!valid) {
+            break;
+        }
+
+        paths[n_read] = calloc(path_len + 1, sizeof(char));
+        ex_assert(paths[n_read] != NULL, EX_MEMORY_ERROR);
+        valid = fread(paths[n_read], 1, path_len, record) == path_len;
+        if (!valid) {
+            free(paths[n_read]);
+            break;
+        }
+        n_read++;
+    }
+
+    char commit_magic[sizeof(SWAP_COMMIT_MAGIC)];
+    valid = valid && fread(commit_magic, 1, sizeof(commit_magic), record) == sizeof(commit_magic);
+    valid = valid && memcmp(commit_magic, SWAP_COMMIT_MAGIC, sizeof(SWAP_COMMIT_MAGIC)) == 0;
+    fclose(record);
+
+    // Replacements already renamed are gone, the others are renamed now
+    // A torn record means no file was renamed yet, so the swap is dropped along with its replacements
+    for (uint32_t i = 0; i < n_read; i++) {
+        if (valid) {
+            rename_replacement(paths[i]);
+        } else {
+            discard_replacement(paths[i]);
+        }
+        free(paths[i]);
+    }
+
+    unlink(path);
+    free(path);
+
+    return valid;
+}
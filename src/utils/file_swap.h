@@ -0,0 +1,92 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Replacement of a file while it is being built (<file path><suffix>)
+#define SWAP_NEW_FILE_SUFFIX ".new"
+
+// Intent record of a data file's swap (<data file path><suffix>), it only exists while the files are being renamed
+#define SWAP_FILE_SUFFIX ".swap"
+
+// Files replaced by the same swap (the data file and its index)
+#define SWAP_MAX_FILES 4
+
+/**
+ * Replacement of a group of files by new versions, all of them or none (a crash mid-swap is finished on recovery)
+ */
+typedef struct FileSwap {
+    char* path;
+    char* paths[SWAP_MAX_FILES];
+    char* new_paths[SWAP_MAX_FILES];
+    uint32_t n_files;
+    bool committed;
+} FileSwap;
+
+/**
+ * Builds the path of a file's sidecar
+ * @param path the file path
+ * @param suffix sidecar suffix
+ * @return the allocated sidecar path
+ */
+char* swap_sidecar_path(const char* path, const char* suffix);
+
+/**
+ * Starts a swap over a data file
+ * @param data_path the data file path
+ * @return the allocated swap
+ */
+FileSwap* new_file_swap(const char* data_path);
+
+/**
+ * Creates the replacement of a file (empty, opened as "wb+")
+ * @param swap target swap
+ * @param path the replaced file path
+ * @return the replacement stream (NULL if it couldn't be created)
+ */
+FILE* swap_fopen(FileSwap* swap, const char* path);
+
+/**
+ * Makes the replacements durable (they must be closed)
+ * @param swap target swap
+ * @return if every replacement is on the disk
+ */
+bool sync_file_swap(FileSwap* swap);
+
+/**
+ * Makes the replacements durable, then renames them over the replaced files (the replacements must be closed)
+ * @param swap target swap
+ * @return if the files were swapped
+ */
+bool commit_file_swap(FileSwap* swap);
+
+/**
+ * Destroys (frees) the swap, uncommitted replacements are deleted
+ * @param swap target swap
+ */
+void destroy_file_swap(FileSwap* swap);
+
+/**
+ * Renames a committed replacement over its file (nothing is done if it was already renamed)
+ * @param path the replaced file path
+ * @return if the replacement is in place
+ */
+bool rename_replacement(const char* path);
+
+/**
+ * Deletes the replacement left by a swap which never committed (nothing is done if there is none)
+ * @param path the replaced file path
+ */
+void discard_replacement(const char* path);
+
+/**
+ * Finishes a data file's interrupted swap (only swaps which reached their renames are finished)
+ * @param data_path the data file path
+ * @return if a swap was finished
+ */
+bool recover_file_swap(const char* data_path);
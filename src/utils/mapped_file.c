@@ -0,0 +1,58 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "mapped_file.h"
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../exception/exception.h"
+
+/**
+ * Map the entire content of an already opened file into memory (read-only)
+ * @param file target file
+ * @return the mapping (NULL if the file couldn't be mapped, e.g. empty files or pipes)
+ */
+MappedFile* map_file(FILE* file) {
+    ex_assert(file != NULL, EX_FILE_ERROR);
+
+    // Make sure buffered writes reach the file before mapping it
+    fflush(file);
+
+    int fd = fileno(file);
+    struct stat file_stat;
+    if (fd == -1 || fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode) || file_stat.st_size <= 0) {
+        return NULL;
+    }
+
+    size_t size = (size_t) file_stat.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Scans walk the mapping front to back, so let the kernel read ahead aggressively
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    MappedFile* mapped_file = malloc(sizeof(struct MappedFile));
+    ex_assert(mapped_file != NULL, EX_MEMORY_ERROR);
+    mapped_file->data = data;
+    mapped_file->size = size;
+
+    return mapped_file;
+}
+
+/**
+ * Unmap and free a file mapping
+ * @param mapped_file target mapping
+ */
+void unmap_file(MappedFile* mapped_file) {
+    if (mapped_file == NULL) {
+        return;
+    }
+
+    munmap((void*) mapped_file->data, mapped_file->size);
+    free(mapped_file);
+}
@@ -0,0 +1,28 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+/**
+ * Read-only memory mapping of a file
+ */
+typedef struct MappedFile {
+    const char* data;
+    size_t size;
+} MappedFile;
+
+/**
+ * Map the entire content of an already opened file into memory (read-only)
+ * @param file target file
+ * @return the mapping (NULL if the file couldn't be mapped, e.g. empty files or pipes)
+ */
+MappedFile* map_file(FILE* file);
+
+/**
+ * Unmap and free a file mapping
+ * @param mapped_file target mapping
+ */
+void unmap_file(MappedFile* mapped_file);
@@ -0,0 +1,102 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "output_buffer.h"
+
+#include <stdlib.h>
+
+#include "../exception/exception.h"
+
+/**
+ * Allocates a new output buffer, appending from the file's current position
+ * @param file destination file
+ * @param capacity buffer capacity
+ * @return the allocated buffer
+ */
+OutputBuffer* new_output_buffer(FILE* file, size_t capacity) {
+    ex_assert(file != NULL, EX_FILE_ERROR);
+    ex_assert(capacity > 0, EX_GENERIC_ERROR);
+
+    OutputBuffer* buffer = malloc(sizeof(struct OutputBuffer));
+    ex_assert(buffer != NULL, EX_MEMORY_ERROR);
+
+    buffer->file = file;
+    buffer->data = malloc(capacity);
+    ex_assert(buffer->data != NULL, EX_MEMORY_ERROR);
+    buffer->capacity = capacity;
+    buffer->used = 0;
+    buffer->file_offset = (size_t) ftell(file);
+
+    return buffer;
+}
+
+/**
+ * Reserves room for n bytes (flushing or growing the buffer when needed), must be followed by output_buffer_commit
+ * @param buffer target buffer
+ * @param n amount of bytes
+ * @return where the bytes should be written
+ */
+char* output_buffer_reserve(OutputBuffer* buffer, size_t n) {
+    if (buffer->used + n > buffer->capacity) {
+        flush_output_buffer(buffer);
+
+        // Oversized reservation
+        if (n > buffer->capacity) {
+            buffer->data = realloc(buffer->data, n);
+            ex_assert(buffer->data != NULL, EX_MEMORY_ERROR);
+            buffer->capacity = n;
+        }
+    }
+
+    return buffer->data + buffer->used;
+}
+
+/**
+ * Commits bytes written on the reserved area
+ * @param buffer target buffer
+ * @param n amount of bytes written (at most the reserved amount)
+ */
+void output_buffer_commit(OutputBuffer* buffer, size_t n) {
+    ex_assert(buffer->used + n <= buffer->capacity, EX_GENERIC_ERROR);
+    buffer->used += n;
+}
+
+/**
+ * Retrieves the file offset the next committed byte will be written at
+ * @param buffer target buffer
+ * @return the offset
+ */
+size_t output_buffer_offset(OutputBuffer* buffer) {
+    return buffer->file_offset + buffer->used;
+}
+
+/**
+ * Writes every buffered byte into the file
+ * @param buffer target buffer
+ */
+void flush_output_buffer(OutputBuffer* buffer) {
+    if (buffer->used == 0) {
+        return;
+    }
+
+    size_t written_bytes = fwrite(buffer->data, sizeof(char), buffer->used, buffer->file);
+    ex_assert(written_bytes == buffer->used, EX_FILE_ERROR);
+
+    buffer->file_offset += buffer->used;
+    buffer->used = 0;
+}
+
+/**
+ * Flushes and destroys (frees) the buffer, the file is kept open
+ * @param buffer target buffer
+ */
+void destroy_output_buffer(OutputBuffer* buffer) {
+    if (buffer == NULL) {
+        return;
+    }
+
+    flush_output_buffer(buffer);
+    free(buffer->data);
+    free(buffer);
+}
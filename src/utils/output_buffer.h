@@ -0,0 +1,63 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdio.h>
+
+// Default capacity of output buffers
+#define DEFAULT_OUTPUT_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * Append-only write buffer over a file, data is encoded in place and written in big chunks
+ */
+typedef struct OutputBuffer {
+    FILE* file;
+    char* data;
+    size_t capacity;
+    size_t used;
+    size_t file_offset;
+} OutputBuffer;
+
+/**
+ * Allocates a new output buffer, appending from the file's current position
+ * @param file destination file
+ * @param capacity buffer capacity
+ * @return the allocated buffer
+ */
+OutputBuffer* new_output_buffer(FILE* file, size_t capacity);
+
+/**
+ * Reserves room for n bytes (flushing or growing the buffer when needed), must be followed by output_buffer_commit
+ * @param buffer target buffer
+ * @param n amount of bytes
+ * @return where the bytes should be written
+ */
+char* output_buffer_reserve(OutputBuffer* buffer, size_t n);
+
+/**
+ * Commits bytes written on the reserved area
+ * @param buffer target buffer
+ * @param n amount of bytes written (at most the reserved amount)
+ */
+void output_buffer_commit(OutputBuffer* buffer, size_t n);
+
+/**
+ * Retrieves the file offset the next committed byte will be written at
+ * @param buffer target buffer
+ * @return the offset
+ */
+size_t output_buffer_offset(OutputBuffer* buffer);
+
+/**
+ * Writes every buffered byte into the file
+ * @param buffer target buffer
+ */
+void flush_output_buffer(OutputBuffer* buffer);
+
+/**
+ * Flushes and destroys (frees) the buffer, the file is kept open
+ * @param buffer target buffer
+ */
+void destroy_output_buffer(OutputBuffer* buffer);
@@ -0,0 +1,142 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "result_writer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../exception/exception.h"
+#include "settings.h"
+
+/**
+ * Allocates a new result writer
+ * @param stream destination stream
+ * @param format the result format
+ * @return the allocated writer
+ */
+ResultWriter* new_result_writer(FILE* stream, OutputFormat format) {
+    ex_assert(stream != NULL, EX_FILE_ERROR);
+
+    ResultWriter* writer = malloc(sizeof(struct ResultWriter));
+    ex_assert(writer != NULL, EX_MEMORY_ERROR);
+
+    writer->stream = stream;
+    writer->format = format;
+    writer->buffer = malloc(RESULT_WRITER_BUFFER_SIZE);
+    ex_assert(writer->buffer != NULL, EX_MEMORY_ERROR);
+    writer->used = 0;
+    writer->n_rows = 0;
+
+    return writer;
+}
+
+/**
+ * Retrieves the result format selected on the environment (SETTING_OUTPUT_FORMAT), defaults to OF_TEXT
+ * @return the selected format
+ */
+OutputFormat get_output_format_setting() {
+    const char* format = get_string_setting(SETTING_OUTPUT_FORMAT, "text");
+
+    if (strcmp(format, "tsv") == 0) {
+        return OF_TSV;
+    }
+
+    if (strcmp(format, "binary") == 0) {
+        return OF_BINARY;
+    }
+
+    return OF_TEXT;
+}
+
+/**
+ * Appends raw bytes to the writer
+ * @param writer target writer
+ * @param data source bytes
+ * @param n amount of bytes
+ */
+void writer_write(ResultWriter* writer, const void* data, size_t n) {
+    if (writer->used + n > RESULT_WRITER_BUFFER_SIZE) {
+        flush_result_writer(writer);
+
+        // Too big to be buffered, write it straight away
+        if (n > RESULT_WRITER_BUFFER_SIZE) {
+            fwrite(data, sizeof(char), n, writer->stream);
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->used, data, n);
+    writer->used += n;
+}
+
+/**
+ * Appends a single char to the writer
+ * @param writer target writer
+ * @param c target char
+ */
+void writer_putc(ResultWriter* writer, char c) {
+    if (writer->used == RESULT_WRITER_BUFFER_SIZE) {
+        flush_result_writer(writer);
+    }
+
+    writer->buffer[writer->used++] = c;
+}
+
+/**
+ * Appends a NULL-terminated string to the writer
+ * @param writer target writer
+ * @param str target string
+ */
+void writer_puts(ResultWriter* writer, const char* str) {
+    writer_write(writer, str, strlen(str));
+}
+
+/**
+ * Appends the decimal representation of an int32 to the writer (same output as printf's "%d")
+ * @param writer target writer
+ * @param value target value
+ */
+void writer_put_int32(ResultWriter* writer, int32_t value) {
+    char digits[12];
+    size_t pos = sizeof(digits);
+
+    // Work on the magnitude as unsigned, so INT32_MIN doesn't overflow
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t) value : (uint32_t) value;
+    do {
+        digits[--pos] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+
+    writer_write(writer, digits + pos, sizeof(digits) - pos);
+}
+
+/**
+ * Writes every buffered byte to the stream
+ * @param writer target writer
+ */
+void flush_result_writer(ResultWriter* writer) {
+    if (writer->used > 0) {
+        fwrite(writer->buffer, sizeof(char), writer->used, writer->stream);
+        writer->used = 0;
+    }
+}
+
+/**
+ * Flushes and destroys (frees) the writer, the stream is kept open
+ * @param writer target writer
+ */
+void destroy_result_writer(ResultWriter* writer) {
+    if (writer == NULL) {
+        return;
+    }
+
+    flush_result_writer(writer);
+    free(writer->buffer);
+    free(writer);
+}
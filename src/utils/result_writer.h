@@ -0,0 +1,90 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Size of the reusable output buffer
+#define RESULT_WRITER_BUFFER_SIZE (64 * 1024)
+
+/**
+ * Available result formats
+ *
+ * OF_TEXT is the human-readable layout (one "description: value" line per field)
+ * OF_TSV is one tab-separated line per registry, after a column names line
+ * OF_BINARY is one length-prefixed row per registry (see print_registry_view)
+ */
+typedef enum OutputFormat {
+    OF_TEXT = 0,
+    OF_TSV = 1,
+    OF_BINARY = 2
+} OutputFormat;
+
+/**
+ * Buffered result sink, the buffer is only written to the stream when full, flushed or destroyed
+ */
+typedef struct ResultWriter {
+    FILE* stream;
+    OutputFormat format;
+    char* buffer;
+    size_t used;
+    size_t n_rows;
+} ResultWriter;
+
+/**
+ * Allocates a new result writer
+ * @param stream destination stream
+ * @param format the result format
+ * @return the allocated writer
+ */
+ResultWriter* new_result_writer(FILE* stream, OutputFormat format);
+
+/**
+ * Retrieves the result format selected on the environment (SETTING_OUTPUT_FORMAT), defaults to OF_TEXT
+ * @return the selected format
+ */
+OutputFormat get_output_format_setting();
+
+/**
+ * Appends raw bytes to the writer
+ * @param writer target writer
+ * @param data source bytes
+ * @param n amount of bytes
+ */
+void writer_write(ResultWriter* writer, const void* data, size_t n);
+
+/**
+ * Appends a single char to the writer
+ * @param writer target writer
+ * @param c target char
+ */
+void writer_putc(ResultWriter* writer, char c);
+
+/**
+ * Appends a NULL-terminated string to the writer
+ * @param writer target writer
+ * @param str target string
+ */
+void writer_puts(ResultWriter* writer, const char* str);
+
+/**
+ * Appends the decimal representation of an int32 to the writer (same output as printf's "%d")
+ * @param writer target writer
+ * @param value target value
+ */
+void writer_put_int32(ResultWriter* writer, int32_t value);
+
+/**
+ * Writes every buffered byte to the stream
+ * @param writer target writer
+ */
+void flush_result_writer(ResultWriter* writer);
+
+/**
+ * Flushes and destroys (frees) the writer, the stream is kept open
+ * @param writer target writer
+ */
+void destroy_result_writer(ResultWriter* writer);
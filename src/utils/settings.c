@@ -0,0 +1,53 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#include "settings.h"
+
+#include <stdlib.h>
+
+#include "utils.h"
+
+/**
+ * Retrieves a size setting from the environment (accepts K and M suffixes), clamped into [min_value, max_value]
+ * @param name setting name
+ * @param default_value value used when the setting is absent or invalid
+ * @param min_value minimum accepted value
+ * @param max_value maximum accepted value
+ * @return the setting value
+ */
+size_t get_size_setting(const char* name, size_t default_value, size_t min_value, size_t max_value) {
+    const char* raw_value = getenv(name);
+    if (raw_value == NULL || raw_value[0] == '\0') {
+        return default_value;
+    }
+
+    char* end = NULL;
+    unsigned long long value = strtoull(raw_value, &end, 10);
+    if (end == raw_value) {
+        return default_value;
+    }
+
+    // Unit suffixes
+    if (*end == 'k' || *end == 'K') {
+        value <<= 10;
+    } else if (*end == 'm' || *end == 'M') {
+        value <<= 20;
+    }
+
+    return max(min_value, min(max_value, (size_t) value));
+}
+
+/**
+ * Retrieves a string setting from the environment
+ * @param name setting name
+ * @param default_value value used when the setting is absent or empty
+ * @return the setting value
+ */
+const char* get_string_setting(const char* name, const char* default_value) {
+    const char* value = getenv(name);
+    if (value == NULL || value[0] == '\0') {
+        return default_value;
+    }
+    return value;
+}
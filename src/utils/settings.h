@@ -0,0 +1,76 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Runtime tuning knobs are read from environment variables (the defaults keep the commands' output unchanged)
+
+// Block size (bytes, accepts K/M suffixes) used by the block reader on sequential scans
+#define SETTING_BLOCK_SIZE "ARQUIVOS_BLOCK_SIZE"
+
+// Amount of worker threads used by parallel scans (defaults to the online CPU count, 1 disables them)
+#define SETTING_SCAN_THREADS "ARQUIVOS_SCAN_THREADS"
+
+// Amount of worker threads used to parse CSV files (defaults to the online CPU count, 1 disables them)
+#define SETTING_PARSE_THREADS "ARQUIVOS_PARSE_THREADS"
+
+// Amount of registries between checkpoints on newly built variable length checkpoint sidecars
+#define SETTING_CHECKPOINT_INTERVAL "ARQUIVOS_CHECKPOINT_INTERVAL"
+
+// Highest instruction set used by vectorized filters (0 scalar, 1 SSE2, 2 AVX2, capped by the CPU support)
+#define SETTING_SIMD_LEVEL "ARQUIVOS_SIMD_LEVEL"
+
+// Percentage of each B-Tree node filled when building B-Tree indexes bottom-up (0 keeps one-by-one insertions)
+#define SETTING_BTREE_FILL_FACTOR "ARQUIVOS_BTREE_FILL_FACTOR"
+
+// Memory budget (bytes, accepts K/M suffixes) of external sorts, sorted runs are spilled to temporary files past it
+#define SETTING_SORT_MEMORY "ARQUIVOS_SORT_MEMORY"
+
+// Largest delta segment of linear index files, as a percentage of their sorted segment (0, default, always rewrites them)
+#define SETTING_INDEX_DELTA "ARQUIVOS_INDEX_DELTA"
+
+// Removed registry reuse on variable length files, through a free space map sidecar (0 walks the on-disk list instead,
+// 1, default, worst-fit: same slots as the on-disk list, 2 best-fit)
+#define SETTING_FREE_SPACE_MAP "ARQUIVOS_FREE_SPACE_MAP"
+
+// Removed registry reuse on fixed length files, through a free slot bitmap sidecar (0, default, pops the on-disk stack
+// one slot at a time, 1 keeps the stack sorted by RRN and fills the lowest slots first, written in file order)
+#define SETTING_FREE_SLOT_BITMAP "ARQUIVOS_FREE_SLOT_BITMAP"
+
+// Dead space percentage (filler and removed registries) past which insert/update/remove batches compact the data file
+// and rebuild its index afterwards (0, default, never compacts automatically)
+#define SETTING_AUTO_COMPACT "ARQUIVOS_AUTO_COMPACT"
+
+// Journal insert/update/remove batches through a write-ahead log sidecar (1, default) or write the files in place (0)
+#define SETTING_WAL "ARQUIVOS_WAL"
+
+// Memory budget (bytes, accepts K/M suffixes) of a journaled batch's dirty pages, they're spilled to its log past it
+#define SETTING_WAL_MEMORY "ARQUIVOS_WAL_MEMORY"
+
+// Amount of registries per segment on newly converted columnar files
+#define SETTING_COLUMN_SEGMENT_ROWS "ARQUIVOS_COLUMN_SEGMENT_ROWS"
+
+// Format of printed registries ("text", "tsv" or "binary"), defaults to the human-readable text
+#define SETTING_OUTPUT_FORMAT "ARQUIVOS_OUTPUT_FORMAT"
+
+/**
+ * Retrieves a size setting from the environment (accepts K and M suffixes), clamped into [min_value, max_value]
+ * @param name setting name
+ * @param default_value value used when the setting is absent or invalid
+ * @param min_value minimum accepted value
+ * @param max_value maximum accepted value
+ * @return the setting value
+ */
+size_t get_size_setting(const char* name, size_t default_value, size_t min_value, size_t max_value);
+
+/**
+ * Retrieves a string setting from the environment
+ * @param name setting name
+ * @param default_value value used when the setting is absent or empty
+ * @return the setting value
+ */
+const char* get_string_setting(const char* name, const char* default_value);
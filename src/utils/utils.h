@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <stdio.h>
+
 /**
  * Maximum of two elements macro
  * @param a first element
@@ -0,0 +1,1017 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+// Journaled streams are built with fopencookie
+#define _GNU_SOURCE
+
+#include "wal.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../exception/exception.h"
+#include "settings.h"
+#include "utils.h"
+
+// Marks the start of a log (a batch is in flight) and the end of a committed one
+static const char WAL_MAGIC[8] = {'A', 'R', 'Q', 'W', 'A', 'L', '0', '3'};
+static const char WAL_COMMIT_MAGIC[8] = {'A', 'R', 'Q', 'C', 'O', 'M', 'I', 'T'};
+
+// Upper bound on the paths stored in a log
+#define WAL_MAX_PATH_LEN 4096
+
+// FNV-1a offset basis
+#define WAL_CHECKSUM_SEED 14695981039346656037ULL
+
+// Log record tags, any other tag is a page image of the journaled file with that index
+#define WAL_REPLACE_TAG (UINT32_MAX - 1) // A journaled file got a replacement (followed by its path)
+#define WAL_COMMIT_TAG UINT32_MAX        // Files of the committed batch (followed by the commit mark)
+
+/**
+ * A file listed by a committed log, along with what tells if the log still belongs to it
+ */
+typedef struct LoggedFile {
+    char path[WAL_MAX_PATH_LEN + 1];
+    bool replaced;
+    // Size before the batch and hash of the first bytes it leaves in place
+    int64_t base_size;
+    uint64_t base_hash;
+    // Size after the batch and hash of its first page
+    int64_t size;
+    uint64_t hash;
+} LoggedFile;
+
+/**
+ * What a log holds, read back by the recovery
+ */
+typedef struct LogContents {
+    LoggedFile files[WAL_MAX_FILES];
+    uint32_t n_files;
+    // Replacements created by the batch (deleted if it isn't replayed)
+    char replaced[WAL_MAX_FILES][WAL_MAX_PATH_LEN + 1];
+    uint32_t n_replaced;
+    // Offset of the commit record
+    long commit_offset;
+} LogContents;
+
+// Log of the batch currently in flight (journaled streams are looked up through it)
+static WriteAheadLog* active_wal = NULL;
+
+/**
+ * Builds the log path for a data file
+ * @param data_path the data file path
+ * @return the allocated log path
+ */
+char* wal_file_path(const char* data_path) {
+    size_t len = strlen(data_path);
+    char* path = malloc(len + sizeof(WAL_FILE_SUFFIX));
+    ex_assert(path != NULL, EX_MEMORY_ERROR);
+
+    memcpy(path, data_path, len);
+    memcpy(path + len, WAL_FILE_SUFFIX, sizeof(WAL_FILE_SUFFIX));
+    return path;
+}
+
+///////////////////
+// Disk helpers  //
+///////////////////
+
+/**
+ * Reads up to size bytes at the given offset, zero filling whatever couldn't be read
+ * @param fd source file descriptor
+ * @param data destination buffer
+ * @param size amount of bytes
+ * @param offset file offset
+ */
+static void read_at(int fd, char* data, size_t size, int64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, data + done, size - done, (off_t) (offset + (int64_t) done));
+        if (n <= 0) {
+            break;
+        }
+        done += (size_t) n;
+    }
+    memset(data + done, 0, size - done);
+}
+
+/**
+ * Writes size bytes at the given offset
+ * @param fd destination file descriptor
+ * @param data source buffer
+ * @param size amount of bytes
+ * @param offset file offset
+ * @return if everything was written
+ */
+static bool write_at(int fd, const char* data, size_t size, int64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pwrite(fd, data + done, size - done, (off_t) (offset + (int64_t) done));
+        if (n <= 0) {
+            return false;
+        }
+        done += (size_t) n;
+    }
+    return true;
+}
+
+/**
+ * FNV-1a hash step, used to detect torn logs
+ * @param checksum running checksum
+ * @param data hashed bytes
+ * @param size amount of bytes
+ */
+static void update_checksum(uint64_t* checksum, const void* data, size_t size) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        *checksum = (*checksum ^ bytes[i]) * 1099511628211ULL;
+    }
+}
+
+/**
+ * Hashes the first bytes of a file, the log keeps them to recognize the files it was written for
+ * @param fd source file descriptor
+ * @param size amount of bytes (at most a page)
+ * @return the hash
+ */
+static uint64_t prefix_hash(int fd, size_t size) {
+    char* data = malloc(WAL_PAGE_SIZE);
+    ex_assert(data != NULL, EX_MEMORY_ERROR);
+    read_at(fd, data, size, 0);
+
+    uint64_t hash = WAL_CHECKSUM_SEED;
+    update_checksum(&hash, data, size);
+    free(data);
+    return hash;
+}
+
+/**
+ * Checks a file's size and first bytes
+ * @param path the file path
+ * @param min_size minimum accepted size
+ * @param max_size maximum accepted size
+ * @param prefix amount of hashed bytes (at most a page)
+ * @param hash expected hash of the first bytes
+ * @return if the file exists and matches
+ */
+static bool file_starts_with(const char* path, int64_t min_size, int64_t max_size, size_t prefix, uint64_t hash) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat file_stat;
+    bool matches = fstat(fd, &file_stat) == 0 && file_stat.st_size >= min_size && file_stat.st_size <= max_size;
+    matches = matches && prefix_hash(fd, prefix) == hash;
+
+    close(fd);
+    return matches;
+}
+
+//////////////////////
+// Journaled files  //
+//////////////////////
+
+/**
+ * Writes into the log, keeping its running checksum (a failed write breaks the log)
+ * @param wal target log
+ * @param data written bytes
+ * @param size amount of bytes
+ */
+static void write_log(WriteAheadLog* wal, const void* data, size_t size) {
+    update_checksum(&wal->checksum, data, size);
+    if (!wal->broken && fwrite(data, 1, size, wal->log) != size) {
+        wal->broken = true;
+    }
+}
+
+/**
+ * Moves every dirty page kept in memory into the log, reads of them go to the log from then on
+ * @param wal target log
+ */
+static void spill_pages(WriteAheadLog* wal) {
+    for (uint32_t i = 0; i < wal->n_files && !wal->broken; i++) {
+        WalFile* file = &wal->files[i];
+        for (size_t page = 0; page < file->n_pages && !wal->broken; page++) {
+            WalPage* dirty = &file->pages[page];
+            if (dirty->data == NULL) {
+                continue;
+            }
+
+            uint64_t page_number = page;
+            write_log(wal, &i, sizeof(i));
+            write_log(wal, &page_number, sizeof(page_number));
+            int64_t offset = (int64_t) ftell(wal->log);
+            write_log(wal, dirty->data, WAL_PAGE_SIZE);
+
+            if (!wal->broken) {
+                dirty->log_offset = offset;
+                free(dirty->data);
+                dirty->data = NULL;
+                wal->n_dirty--;
+            }
+        }
+    }
+
+    // Spilled images are read back straight from the log file
+    if (!wal->broken && fflush(wal->log) != 0) {
+        wal->broken = true;
+    }
+}
+
+/**
+ * Reads the current image of a page (kept in memory, spilled to the log or still on the disk)
+ * @param file target file
+ * @param page page number
+ * @param data page sized destination buffer
+ */
+static void read_page(WalFile* file, size_t page, char* data) {
+    if (page < file->n_pages && file->pages[page].data != NULL) {
+        memcpy(data, file->pages[page].data, WAL_PAGE_SIZE);
+    } else if (page < file->n_pages && file->pages[page].log_offset != -1) {
+        read_at(fileno(file->wal->log), data, WAL_PAGE_SIZE, file->pages[page].log_offset);
+    } else {
+        int64_t start = (int64_t) page * WAL_PAGE_SIZE;
+        size_t readable = start < file->disk_size ? (size_t) min(file->disk_size - start, WAL_PAGE_SIZE) : 0;
+        read_at(file->fd, data, readable, start);
+        memset(data + readable, 0, WAL_PAGE_SIZE - readable);
+    }
+}
+
+/**
+ * Retrieves a page of a journaled file for writing, loading it on its first change (or once it's spilled)
+ * @param file target file
+ * @param page page number
+ * @return the page data
+ */
+static char* wal_page(WalFile* file, size_t page) {
+    if (page >= file->n_pages) {
+        size_t n_pages = max(max(page + 1, 2 * file->n_pages), 16);
+        file->pages = realloc(file->pages, n_pages * sizeof(WalPage));
+        ex_assert(file->pages != NULL, EX_MEMORY_ERROR);
+        for (size_t i = file->n_pages; i < n_pages; i++) {
+            file->pages[i] = (WalPage){NULL, -1};
+        }
+        file->n_pages = n_pages;
+    }
+
+    if (file->pages[page].data == NULL) {
+        WriteAheadLog* wal = file->wal;
+        if (wal->n_dirty >= wal->max_dirty && !wal->broken) {
+            spill_pages(wal);
+        }
+
+        char* data = malloc(WAL_PAGE_SIZE);
+        ex_assert(data != NULL, EX_MEMORY_ERROR);
+        read_page(file, page, data);
+
+        file->pages[page].data = data;
+        wal->n_dirty++;
+    }
+
+    return file->pages[page].data;
+}
+
+/**
+ * Journaled stream read (dirty pages come from memory or from the log, clean ones straight from the disk)
+ */
+static ssize_t wal_stream_read(void* cookie, char* buffer, size_t size) {
+    WalFile* file = cookie;
+    if (file->position >= file->size) {
+        return 0;
+    }
+    size = (size_t) min((int64_t) size, file->size - file->position);
+
+    size_t done = 0;
+    while (done < size) {
+        int64_t offset = file->position + (int64_t) done;
+        size_t page = (size_t) (offset / WAL_PAGE_SIZE);
+        size_t in_page = (size_t) (offset % WAL_PAGE_SIZE);
+        size_t n = min(WAL_PAGE_SIZE - in_page, size - done);
+
+        if (page < file->n_pages && file->pages[page].data != NULL) {
+            memcpy(buffer + done, file->pages[page].data + in_page, n);
+        } else if (page < file->n_pages && file->pages[page].log_offset != -1) {
+            read_at(fileno(file->wal->log), buffer + done, n, file->pages[page].log_offset + (int64_t) in_page);
+        } else {
+            size_t readable = offset < file->disk_size ? (size_t) min(file->disk_size - offset, (int64_t) n) : 0;
+            read_at(file->fd, buffer + done, readable, offset);
+            memset(buffer + done + readable, 0, n - readable);
+        }
+
+        done += n;
+    }
+
+    file->position += (int64_t) done;
+    return (ssize_t) done;
+}
+
+/**
+ * Journaled stream write (only dirty pages are changed)
+ */
+static ssize_t wal_stream_write(void* cookie, const char* buffer, size_t size) {
+    WalFile* file = cookie;
+
+    size_t done = 0;
+    while (done < size) {
+        int64_t offset = file->position + (int64_t) done;
+        size_t in_page = (size_t) (offset % WAL_PAGE_SIZE);
+        size_t n = min(WAL_PAGE_SIZE - in_page, size - done);
+
+        memcpy(wal_page(file, (size_t) (offset / WAL_PAGE_SIZE)) + in_page, buffer + done, n);
+        done += n;
+    }
+
+    file->position += (int64_t) done;
+    file->size = max(file->size, file->position);
+    return (ssize_t) done;
+}
+
+/**
+ * Journaled stream seek
+ */
+static int wal_stream_seek(void* cookie, off64_t* offset, int whence) {
+    WalFile* file = cookie;
+
+    int64_t position;
+    switch (whence) {
+        case SEEK_SET:
+            position = *offset;
+            break;
+        case SEEK_CUR:
+            position = file->position + *offset;
+            break;
+        case SEEK_END:
+            position = file->size + *offset;
+            break;
+        default:
+            return -1;
+    }
+
+    if (position < 0) {
+        return -1;
+    }
+
+    file->position = position;
+    *offset = position;
+    return 0;
+}
+
+/**
+ * Journaled stream close (the pages stay with the log until it's committed or destroyed)
+ */
+static int wal_stream_close(void* cookie) {
+    WalFile* file = cookie;
+    file->stream = NULL;
+    return 0;
+}
+
+/**
+ * Checks if a dirty page holds anything different from the disk
+ * @param file target file
+ * @param page page number
+ * @param scratch page sized buffer
+ * @return if the page has to be written
+ */
+static bool wal_page_changed(WalFile* file, size_t page, char* scratch) {
+    // Spilled pages are logged again, their older image would be replayed otherwise
+    if (file->pages[page].log_offset != -1) {
+        return true;
+    }
+
+    int64_t start = (int64_t) page * WAL_PAGE_SIZE;
+    size_t used = (size_t) min(file->size - start, WAL_PAGE_SIZE);
+
+    // Appended bytes are always written
+    if (start + (int64_t) used > file->disk_size) {
+        return true;
+    }
+
+    read_at(file->fd, scratch, used, start);
+    return memcmp(scratch, file->pages[page].data, used) != 0;
+}
+
+/**
+ * Moves the full rewrite of a journaled file into a replacement, renamed over the file on commit (journaling the
+ * rewrite would keep a copy of the whole file in the log)
+ * @param wal target log
+ * @param file the rewritten file (its stream is closed)
+ * @return the replacement stream (NULL if it couldn't be created)
+ */
+static FILE* replace_journaled_file(WriteAheadLog* wal, WalFile* file) {
+    // Only its replacements are used, the log takes the place of the swap's intent record
+    if (wal->swap == NULL) {
+        wal->swap = new_file_swap(file->path);
+    }
+
+    fflush(file->stream);
+    fclose(file->stream);
+
+    FILE* replacement = swap_fopen(wal->swap, file->path);
+    if (replacement == NULL) {
+        wal->broken = true;
+        return NULL;
+    }
+
+    // Logged right away, so the replacement is deleted along with an unfinished batch
+    uint32_t tag = WAL_REPLACE_TAG;
+    uint32_t path_len = (uint32_t) strlen(file->path);
+    write_log(wal, &tag, sizeof(tag));
+    write_log(wal, &path_len, sizeof(path_len));
+    write_log(wal, file->path, path_len);
+    if (!wal->broken && fflush(wal->log) != 0) {
+        wal->broken = true;
+    }
+
+    // Older changes are superseded by the replacement (spilled ones are skipped on replay)
+    for (size_t page = 0; page < file->n_pages; page++) {
+        if (file->pages[page].data != NULL) {
+            free(file->pages[page].data);
+            wal->n_dirty--;
+        }
+    }
+    free(file->pages);
+    file->pages = NULL;
+    file->n_pages = 0;
+    file->replaced = true;
+
+    return replacement;
+}
+
+/////////////
+// Batches //
+/////////////
+
+/**
+ * Starts a batch over a data file, finishing any interrupted one first (the log marks the batch as in flight)
+ * @param data_path the data file path
+ * @return the log (NULL if it couldn't be created)
+ */
+WriteAheadLog* begin_wal(const char* data_path) {
+    ex_assert(active_wal == NULL, EX_GENERIC_ERROR);
+
+    recover_wal(data_path);
+
+    // Also read back, for the pages spilled into it
+    char* path = wal_file_path(data_path);
+    FILE* log = fopen(path, "wb+");
+    if (log == NULL) {
+        free(path);
+        return NULL;
+    }
+
+    uint32_t page_size = WAL_PAGE_SIZE;
+    fwrite(WAL_MAGIC, 1, sizeof(WAL_MAGIC), log);
+    fwrite(&page_size, 1, sizeof(page_size), log);
+    fflush(log);
+
+    WriteAheadLog* wal = calloc(1, sizeof(struct WriteAheadLog));
+    ex_assert(wal != NULL, EX_MEMORY_ERROR);
+    wal->path = path;
+    wal->log = log;
+    wal->n_files = 0;
+    wal->swap = NULL;
+    wal->n_dirty = 0;
+    wal->max_dirty = get_size_setting(SETTING_WAL_MEMORY, DEFAULT_WAL_MEMORY, WAL_PAGE_SIZE, SIZE_MAX) / WAL_PAGE_SIZE;
+    wal->checksum = WAL_CHECKSUM_SEED;
+    wal->broken = false;
+    wal->committed = false;
+
+    active_wal = wal;
+    return wal;
+}
+
+/**
+ * Opens a file through the log (same as "rb+", but changes only reach the file on commit)
+ * @param wal target log
+ * @param path the file path
+ * @return the journaled stream (NULL if the file couldn't be opened)
+ */
+FILE* wal_fopen(WriteAheadLog* wal, const char* path) {
+    ex_assert(wal != NULL && !wal->committed, EX_GENERIC_ERROR);
+    ex_assert(wal->n_files < WAL_MAX_FILES, EX_GENERIC_ERROR);
+
+    if (strlen(path) > WAL_MAX_PATH_LEN) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDWR);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return NULL;
+    }
+
+    WalFile* file = &wal->files[wal->n_files];
+    file->wal = wal;
+    file->path = strdup(path);
+    ex_assert(file->path != NULL, EX_MEMORY_ERROR);
+    file->fd = fd;
+    file->disk_size = file->size = (int64_t) file_stat.st_size;
+    file->position = 0;
+    file->pages = NULL;
+    file->n_pages = 0;
+    file->replaced = false;
+
+    cookie_io_functions_t functions = {wal_stream_read, wal_stream_write, wal_stream_seek, wal_stream_close};
+    file->stream = fopencookie(file, "r+", functions);
+    if (file->stream == NULL) {
+        free(file->path);
+        close(fd);
+        return NULL;
+    }
+
+    wal->n_files++;
+    return file->stream;
+}
+
+/**
+ * Writes a file entry of the commit record
+ * @param wal target log
+ * @param file the logged file
+ */
+static void write_logged_file(WriteAheadLog* wal, const LoggedFile* file) {
+    uint32_t path_len = (uint32_t) strlen(file->path);
+    uint8_t replaced = file->replaced;
+
+    write_log(wal, &path_len, sizeof(path_len));
+    write_log(wal, file->path, path_len);
+    write_log(wal, &replaced, sizeof(replaced));
+    write_log(wal, &file->base_size, sizeof(file->base_size));
+    write_log(wal, &file->base_hash, sizeof(file->base_hash));
+    write_log(wal, &file->size, sizeof(file->size));
+    write_log(wal, &file->hash, sizeof(file->hash));
+}
+
+/**
+ * Fills the commit record entry of a journaled file: its size and first bytes before and after the batch (only the
+ * bytes the batch leaves in place are hashed from before it)
+ * @param file the journaled file
+ * @param logged destination entry
+ * @param scratch page sized buffer
+ * @return if the entry could be filled
+ */
+static bool fill_logged_file(WalFile* file, LoggedFile* logged, char* scratch) {
+    strcpy(logged->path, file->path);
+    logged->replaced = file->replaced;
+    logged->base_size = file->disk_size;
+
+    if (!file->replaced) {
+        logged->base_hash = prefix_hash(file->fd, (size_t) min(min(file->disk_size, file->size), WAL_PAGE_SIZE));
+        logged->size = file->size;
+
+        read_page(file, 0, scratch);
+        logged->hash = WAL_CHECKSUM_SEED;
+        update_checksum(&logged->hash, scratch, (size_t) min(file->size, WAL_PAGE_SIZE));
+        return true;
+    }
+
+    // The replacement is what the file becomes
+    logged->base_hash = prefix_hash(file->fd, (size_t) min(file->disk_size, WAL_PAGE_SIZE));
+
+    char* new_path = swap_sidecar_path(file->path, SWAP_NEW_FILE_SUFFIX);
+    int fd = open(new_path, O_RDONLY);
+    free(new_path);
+
+    struct stat file_stat;
+    bool filled = fd != -1 && fstat(fd, &file_stat) == 0;
+    if (filled) {
+        logged->size = (int64_t) file_stat.st_size;
+        logged->hash = prefix_hash(fd, (size_t) min(logged->size, WAL_PAGE_SIZE));
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+    return filled;
+}
+
+/**
+ * Reads from the log, keeping the running checksum
+ * @param log the log file
+ * @param data destination buffer
+ * @param size amount of bytes
+ * @param checksum running checksum (NULL if the log was already validated)
+ * @return if everything was read
+ */
+static bool read_log(FILE* log, void* data, size_t size, uint64_t* checksum) {
+    if (fread(data, 1, size, log) != size) {
+        return false;
+    }
+    if (checksum != NULL) {
+        update_checksum(checksum, data, size);
+    }
+    return true;
+}
+
+/**
+ * Applies a validated log to its files: pages in log order (later images win), then the sizes, then the first pages
+ * (until then the files still start as they did before the batch), replacements are renamed over their files
+ * @param log the log file
+ * @param body offset of the first record
+ * @param end offset of the commit record
+ * @param files the logged files
+ * @param n_files amount of logged files
+ * @return if every change reached the files (it stops at the first failure, before the sizes and first pages)
+ */
+static bool replay_log(FILE* log, long body, long end, const LoggedFile* files, uint32_t n_files) {
+    int fds[WAL_MAX_FILES];
+    char* first_pages[WAL_MAX_FILES];
+    bool applied = true;
+
+    for (uint32_t i = 0; i < n_files; i++) {
+        fds[i] = files[i].replaced ? -1 : open(files[i].path, O_WRONLY);
+        first_pages[i] = NULL;
+        applied = applied && (files[i].replaced || fds[i] != -1);
+    }
+
+    char* data = malloc(WAL_PAGE_SIZE);
+    ex_assert(data != NULL, EX_MEMORY_ERROR);
+
+    fseek(log, body, SEEK_SET);
+    while (applied && ftell(log) < end) {
+        uint32_t tag;
+        uint32_t path_len;
+        uint64_t page;
+        if (!read_log(log, &tag, sizeof(tag), NULL)) {
+            applied = false;
+            break;
+        }
+
+        if (tag == WAL_REPLACE_TAG) {
+            if (!read_log(log, &path_len, sizeof(path_len), NULL) || fseek(log, path_len, SEEK_CUR) != 0) {
+                applied = false;
+                break;
+            }
+            continue;
+        }
+
+        if (!read_log(log, &page, sizeof(page), NULL) || !read_log(log, data, WAL_PAGE_SIZE, NULL)) {
+            applied = false;
+            break;
+        }
+
+        // Pages of replaced files are superseded by their replacements
+        if (tag >= n_files || fds[tag] == -1) {
+            continue;
+        }
+
+        int64_t start = (int64_t) page * WAL_PAGE_SIZE;
+        if (page == 0) {
+            if (first_pages[tag] == NULL) {
+                first_pages[tag] = malloc(WAL_PAGE_SIZE);
+                ex_assert(first_pages[tag] != NULL, EX_MEMORY_ERROR);
+            }
+            memcpy(first_pages[tag], data, WAL_PAGE_SIZE);
+        } else if (start < files[tag].size) {
+            applied = write_at(fds[tag], data, (size_t) min(files[tag].size - start, WAL_PAGE_SIZE), start);
+        }
+    }
+    free(data);
+
+    // Past a failure the files keep their sizes and first pages from before the batch, so the log can be replayed again
+    for (uint32_t i = 0; i < n_files; i++) {
+        if (fds[i] != -1) {
+            if (applied) {
+                applied = ftruncate(fds[i], (off_t) files[i].size) == 0;
+            }
+            if (applied && first_pages[i] != NULL) {
+                applied = write_at(fds[i], first_pages[i], (size_t) min(files[i].size, WAL_PAGE_SIZE), 0);
+            }
+            applied = fsync(fds[i]) == 0 && applied;
+            close(fds[i]);
+        } else if (files[i].replaced && applied) {
+            applied = rename_replacement(files[i].path);
+        }
+        free(first_pages[i]);
+    }
+
+    return applied;
+}
+
+/**
+ * Logs the changes of every journaled file, then applies them and drops the log (streams still open are flushed,
+ * replacements must be closed)
+ * @param wal target log
+ * @return if the changes were applied
+ */
+bool commit_wal(WriteAheadLog* wal) {
+    ex_assert(wal != NULL && !wal->committed, EX_GENERIC_ERROR);
+
+    char* scratch = malloc(WAL_PAGE_SIZE);
+    ex_assert(scratch != NULL, EX_MEMORY_ERROR);
+
+    // Keep only the pages which really change something (holes left by seeks past the end are written as zeros)
+    for (uint32_t i = 0; i < wal->n_files; i++) {
+        WalFile* file = &wal->files[i];
+        if (file->stream != NULL) {
+            fflush(file->stream);
+        }
+        if (file->replaced) {
+            continue;
+        }
+
+        for (int64_t start = file->disk_size - file->disk_size % WAL_PAGE_SIZE; start < file->size; start += WAL_PAGE_SIZE) {
+            size_t page = (size_t) (start / WAL_PAGE_SIZE);
+            if (page >= file->n_pages || (file->pages[page].data == NULL && file->pages[page].log_offset == -1)) {
+                wal_page(file, page);
+            }
+        }
+
+        for (size_t page = 0; page < file->n_pages; page++) {
+            if (file->pages[page].data != NULL && !wal_page_changed(file, page, scratch)) {
+                free(file->pages[page].data);
+                file->pages[page].data = NULL;
+                wal->n_dirty--;
+            }
+        }
+    }
+
+    // Replacements must be fully on the disk before the log points at them
+    bool logged = !wal->broken && (wal->swap == NULL || sync_file_swap(wal->swap));
+
+    // Log: the remaining pages, then the files (path, size and first bytes before and after the batch), then the
+    // commit mark
+    LoggedFile* files = calloc(WAL_MAX_FILES, sizeof(LoggedFile));
+    ex_assert(files != NULL, EX_MEMORY_ERROR);
+    for (uint32_t i = 0; i < wal->n_files && logged; i++) {
+        logged = fill_logged_file(&wal->files[i], &files[i], scratch);
+    }
+    free(scratch);
+
+    spill_pages(wal);
+
+    long end = ftell(wal->log);
+    uint32_t tag = WAL_COMMIT_TAG;
+    write_log(wal, &tag, sizeof(tag));
+    write_log(wal, &wal->n_files, sizeof(wal->n_files));
+    for (uint32_t i = 0; i < wal->n_files && logged; i++) {
+        write_logged_file(wal, &files[i]);
+    }
+
+    logged = logged && !wal->broken;
+    logged = logged && fwrite(&wal->checksum, 1, sizeof(wal->checksum), wal->log) == sizeof(wal->checksum);
+    logged = logged && fwrite(WAL_COMMIT_MAGIC, 1, sizeof(WAL_COMMIT_MAGIC), wal->log) == sizeof(WAL_COMMIT_MAGIC);
+    logged = logged && fflush(wal->log) == 0 && fsync(fileno(wal->log)) == 0;
+
+    // Nothing reached the files, the batch is dropped along with the log
+    if (!logged) {
+        free(files);
+        return false;
+    }
+
+    // Replacements now belong to the log, a crash from here on renames them on recovery
+    if (wal->swap != NULL) {
+        wal->swap->committed = true;
+    }
+
+    // Checkpoint: the log is safe, so apply it and drop it (a crash from here on replays it)
+    bool applied = replay_log(wal->log, (long) (sizeof(WAL_MAGIC) + sizeof(uint32_t)), end, files, wal->n_files);
+    free(files);
+
+    // Keep the log for the next recovery if the files couldn't be fully written
+    fclose(wal->log);
+    wal->log = NULL;
+    if (applied) {
+        unlink(wal->path);
+    }
+
+    wal->committed = true;
+    return applied;
+}
+
+/**
+ * Destroys (frees) the log, uncommitted changes are discarded along with the log file
+ * @param wal target log
+ */
+void destroy_wal(WriteAheadLog* wal) {
+    if (wal == NULL) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < wal->n_files; i++) {
+        WalFile* file = &wal->files[i];
+        if (file->stream != NULL) {
+            fclose(file->stream);
+        }
+        for (size_t page = 0; page < file->n_pages; page++) {
+            free(file->pages[page].data);
+        }
+        free(file->pages);
+        free(file->path);
+        close(file->fd);
+    }
+
+    if (wal->log != NULL) {
+        fclose(wal->log);
+        unlink(wal->path);
+    }
+    destroy_file_swap(wal->swap);
+
+    if (active_wal == wal) {
+        active_wal = NULL;
+    }
+
+    free(wal->path);
+    free(wal);
+}
+
+//////////////
+// Recovery //
+//////////////
+
+/**
+ * Reads a file entry of the commit record
+ * @param log the log file
+ * @param file destination entry
+ * @param checksum running checksum
+ * @return if the entry was read
+ */
+static bool read_logged_file(FILE* log, LoggedFile* file, uint64_t* checksum) {
+    uint32_t path_len = 0;
+    uint8_t replaced = 0;
+
+    bool valid = read_log(log, &path_len, sizeof(path_len), checksum) && path_len <= WAL_MAX_PATH_LEN;
+    valid = valid && read_log(log, file->path, path_len, checksum);
+    valid = valid && read_log(log, &replaced, sizeof(replaced), checksum);
+    valid = valid && read_log(log, &file->base_size, sizeof(file->base_size), checksum);
+    valid = valid && read_log(log, &file->base_hash, sizeof(file->base_hash), checksum);
+    valid = valid && read_log(log, &file->size, sizeof(file->size), checksum);
+    valid = valid && read_log(log, &file->hash, sizeof(file->hash), checksum);
+
+    file->path[valid ? path_len : 0] = '\0';
+    file->replaced = replaced != 0;
+    return valid;
+}
+
+/**
+ * Reads the body of a log (right after its start mark), collecting its files and the replacements it created
+ * @param log the log file
+ * @param contents destination of what the log holds
+ * @return if the log is complete (committed and untorn)
+ */
+static bool scan_log(FILE* log, LogContents* contents) {
+    uint64_t checksum = WAL_CHECKSUM_SEED;
+    contents->n_files = 0;
+    contents->n_replaced = 0;
+
+    char* data = malloc(WAL_PAGE_SIZE);
+    ex_assert(data != NULL, EX_MEMORY_ERROR);
+
+    // Records up to the commit record (a torn log ends before it)
+    uint32_t n_tags = 0;
+    bool valid = true;
+    while (valid) {
+        uint32_t tag;
+        long offset = ftell(log);
+        valid = read_log(log, &tag, sizeof(tag), &checksum);
+
+        if (valid && tag == WAL_COMMIT_TAG) {
+            contents->commit_offset = offset;
+            break;
+        }
+
+        if (valid && tag == WAL_REPLACE_TAG) {
+            uint32_t path_len = 0;
+            char* path = contents->replaced[contents->n_replaced];
+            valid = contents->n_replaced < WAL_MAX_FILES;
+            valid = valid && read_log(log, &path_len, sizeof(path_len), &checksum) && path_len <= WAL_MAX_PATH_LEN;
+            valid = valid && read_log(log, path, path_len, &checksum);
+            if (valid) {
+                path[path_len] = '\0';
+                contents->n_replaced++;
+            }
+        } else if (valid) {
+            uint64_t page;
+            valid = tag < WAL_MAX_FILES && read_log(log, &page, sizeof(page), &checksum);
+            valid = valid && read_log(log, data, WAL_PAGE_SIZE, &checksum);
+            n_tags = max(n_tags, tag + 1);
+        }
+    }
+    free(data);
+
+    // Files of the committed batch, every page must belong to one of them
+    uint32_t n_files = 0;
+    valid = valid && read_log(log, &n_files, sizeof(n_files), &checksum) && n_files <= WAL_MAX_FILES && n_tags <= n_files;
+    for (uint32_t i = 0; i < n_files && valid; i++) {
+        valid = read_logged_file(log, &contents->files[i], &checksum);
+        if (valid) {
+            contents->n_files++;
+        }
+    }
+
+    // Commit mark
+    uint64_t stored_checksum;
+    char commit_magic[sizeof(WAL_COMMIT_MAGIC)];
+    valid = valid && fread(&stored_checksum, 1, sizeof(stored_checksum), log) == sizeof(stored_checksum);
+    valid = valid && stored_checksum == checksum;
+    valid = valid && fread(commit_magic, 1, sizeof(commit_magic), log) == sizeof(commit_magic);
+    valid = valid && memcmp(commit_magic, WAL_COMMIT_MAGIC, sizeof(WAL_COMMIT_MAGIC)) == 0;
+
+    return valid;
+}
+
+/**
+ * Checks if a logged file is still the one its log was written for: either the batch was fully applied to it, or it
+ * still starts as it did before the batch (the first page is applied last) with a size between its sizes before and
+ * after the batch (replaced files must match their replacement, renamed or not)
+ * @param file the logged file
+ * @return if the log can be replayed over the file
+ */
+static bool logged_file_matches(const LoggedFile* file) {
+    if (file->replaced) {
+        char* new_path = swap_sidecar_path(file->path, SWAP_NEW_FILE_SUFFIX);
+        const char* current_path = access(new_path, F_OK) == 0 ? new_path : file->path;
+        bool matches = file_starts_with(current_path, file->size, file->size, (size_t) min(file->size, WAL_PAGE_SIZE), file->hash);
+        free(new_path);
+        return matches;
+    }
+
+    int64_t low_size = min(file->base_size, file->size);
+    int64_t high_size = max(file->base_size, file->size);
+    return file_starts_with(file->path, file->size, file->size, (size_t) min(file->size, WAL_PAGE_SIZE), file->hash) ||
+           file_starts_with(file->path, low_size, high_size, (size_t) min(low_size, WAL_PAGE_SIZE), file->base_hash);
+}
+
+/**
+ * Finishes a data file's interrupted batch, replaying it if it was committed or discarding it otherwise (committed
+ * batches whose files were replaced since are discarded too)
+ * @param data_path the data file path
+ * @return the recovery outcome
+ */
+WalRecovery recover_wal(const char* data_path) {
+    char* path = wal_file_path(data_path);
+    FILE* log = fopen(path, "rb");
+    if (log == NULL) {
+        free(path);
+        return WR_CLEAN;
+    }
+
+    char magic[sizeof(WAL_MAGIC)];
+    uint32_t page_size = 0;
+    bool committed = fread(magic, 1, sizeof(magic), log) == sizeof(magic) && memcmp(magic, WAL_MAGIC, sizeof(WAL_MAGIC)) == 0;
+    committed = committed && fread(&page_size, 1, sizeof(page_size), log) == sizeof(page_size) && page_size == WAL_PAGE_SIZE;
+
+    // Validate the whole log and its files before touching any of them, then replay it
+    LogContents* contents = calloc(1, sizeof(LogContents));
+    ex_assert(contents != NULL, EX_MEMORY_ERROR);
+    long body = ftell(log);
+    committed = committed && scan_log(log, contents);
+
+    bool current = committed;
+    for (uint32_t i = 0; i < contents->n_files && current; i++) {
+        current = logged_file_matches(&contents->files[i]);
+    }
+
+    bool applied = true;
+    if (current) {
+        applied = replay_log(log, body, contents->commit_offset, contents->files, contents->n_files);
+    } else {
+        for (uint32_t i = 0; i < contents->n_replaced; i++) {
+            discard_replacement(contents->replaced[i]);
+        }
+    }
+
+    // Keep the log for the next recovery if the files couldn't be fully written
+    fclose(log);
+    if (applied) {
+        unlink(path);
+    }
+    free(contents);
+    free(path);
+
+    if (!committed) {
+        return WR_ROLLED_BACK;
+    }
+    if (!applied) {
+        return WR_FAILED;
+    }
+    return current ? WR_REPLAYED : WR_STALE;
+}
+
+/**
+ * Empties a file for a full rewrite (journaled streams are rewritten into a replacement, others are reopened)
+ * @param file target file
+ * @param mode mode used when reopening
+ * @return the stream to be used from now on
+ */
+FILE* reopen_truncated(FILE* file, const char* mode) {
+    if (active_wal != NULL) {
+        for (uint32_t i = 0; i < active_wal->n_files; i++) {
+            WalFile* journaled = &active_wal->files[i];
+            if (journaled->stream == file) {
+                return replace_journaled_file(active_wal, journaled);
+            }
+        }
+    }
+
+    return freopen(NULL, mode, file);
+}
@@ -0,0 +1,141 @@
+/*
+*  Daniel Henrique Lelis de Almeida - 12543822
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "file_swap.h"
+
+// Sidecar log of a data file (<data file path><suffix>), it only exists while a batch is in flight
+#define WAL_FILE_SUFFIX ".wal"
+
+// Granularity of the logged changes
+#define WAL_PAGE_SIZE 4096
+
+// Files journaled by the same log (the data file and its index)
+#define WAL_MAX_FILES 4
+
+// Default memory budget of a batch's dirty pages, past it they're spilled to the log
+#define DEFAULT_WAL_MEMORY (64 * 1024 * 1024)
+
+/**
+ * Outcome of the recovery of a data file's log
+ */
+typedef enum WalRecovery {
+    WR_CLEAN,       // No log, nothing was in flight
+    WR_REPLAYED,    // A committed batch was (re)applied to the files
+    WR_ROLLED_BACK, // An unfinished batch was discarded, the files were never touched by it
+    WR_STALE,       // A committed batch was discarded, its files were replaced since and it no longer applies to them
+    WR_FAILED       // A committed batch couldn't be fully reapplied, its log is kept for the next recovery
+} WalRecovery;
+
+/**
+ * A changed page of a journaled file
+ */
+typedef struct WalPage {
+    // Page image while it's kept in memory (NULL otherwise)
+    char* data;
+    // Offset of its latest image spilled to the log (-1 if it never was)
+    int64_t log_offset;
+} WalPage;
+
+/**
+ * A file journaled by a log: writes are kept as dirty pages until the log is committed, reads see them
+ */
+typedef struct WalFile {
+    struct WriteAheadLog* wal;
+    char* path;
+    int fd;
+    FILE* stream;
+
+    // Size of the file on the disk
+    int64_t disk_size;
+    // Size seen through the stream
+    int64_t size;
+    int64_t position;
+
+    // Changed pages, indexed by page number
+    WalPage* pages;
+    size_t n_pages;
+
+    // Rewritten from scratch into a replacement, renamed over the file on commit instead of journaled
+    bool replaced;
+} WalFile;
+
+/**
+ * Write-ahead log of a batch of changes (redo only, the files are only written after the log is safely on disk)
+ */
+typedef struct WriteAheadLog {
+    char* path;
+    FILE* log;
+    WalFile files[WAL_MAX_FILES];
+    uint32_t n_files;
+
+    // Replacements of the files rewritten from scratch
+    FileSwap* swap;
+
+    // Dirty pages kept in memory, spilled to the log past the budget
+    size_t n_dirty;
+    size_t max_dirty;
+
+    // Running checksum of the log, broken logs (failed writes) can't be committed
+    uint64_t checksum;
+    bool broken;
+    bool committed;
+} WriteAheadLog;
+
+/**
+ * Builds the log path for a data file
+ * @param data_path the data file path
+ * @return the allocated log path
+ */
+char* wal_file_path(const char* data_path);
+
+/**
+ * Starts a batch over a data file, finishing any interrupted one first (the log marks the batch as in flight)
+ * @param data_path the data file path
+ * @return the log (NULL if it couldn't be created)
+ */
+WriteAheadLog* begin_wal(const char* data_path);
+
+/**
+ * Opens a file through the log (same as "rb+", but changes only reach the file on commit)
+ * @param wal target log
+ * @param path the file path
+ * @return the journaled stream (NULL if the file couldn't be opened)
+ */
+FILE* wal_fopen(WriteAheadLog* wal, const char* path);
+
+/**
+ * Logs the changes of every journaled file, then applies them and drops the log (streams still open are flushed,
+ * replacements must be closed)
+ * @param wal target log
+ * @return if the changes were applied
+ */
+bool commit_wal(WriteAheadLog* wal);
+
+/**
+ * Destroys (frees) the log, uncommitted changes are discarded along with the log file
+ * @param wal target log
+ */
+void destroy_wal(WriteAheadLog* wal);
+
+/**
+ * Finishes a data file's interrupted batch, replaying it if it was committed or discarding it otherwise (committed
+ * batches whose files were replaced since are discarded too)
+ * @param data_path the data file path
+ * @return the recovery outcome
+ */
+WalRecovery recover_wal(const char* data_path);
+
+/**
+ * Empties a file for a full rewrite (journaled streams are rewritten into a replacement, others are reopened)
+ * @param file target file
+ * @param mode mode used when reopening
+ * @return the stream to be used from now on
+ */
+FILE* reopen_truncated(FILE* file, const char* mode);
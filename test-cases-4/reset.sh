@@ -0,0 +1,10 @@
+#!/bin/bash
+
+cp ./initial/* .
+
+# 40 copies of arquivoEntrada1.csv with their ids shifted by 1000 each, for cases which need large files
+head -n 1 ./initial/arquivoEntrada1.csv > arquivoEntrada2.csv
+for copy in {0..39}
+do
+  tail -n +2 ./initial/arquivoEntrada1.csv | awk -F, -v OFS=, -v shift=$((copy * 1000)) '{ $1 += shift; print }' >> arquivoEntrada2.csv
+done
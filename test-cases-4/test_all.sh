@@ -0,0 +1,72 @@
+#!/bin/bash
+
+cur_dir=$(pwd)
+src_dir=$cur_dir/../src
+test_script=./make_test.sh
+build_flags="env=test"
+ignored_tests=()
+
+# Cases which must print exactly what another case prints (see README.md)
+declare -A same_output=(
+  [4]=3 [6]=5 [9]=8 [11]=10 [13]=12 [16]=15 [18]=2 [20]=19 [21]=19 [25]=24 [28]=27 [30]=29 [31]=29 [33]=32 [34]=32
+  [37]=36 [45]=39 [49]=48 [50]=48 [52]=51 [53]=51 [55]=54 [56]=35 [57]=35 [59]=58 [60]=58 [61]=16 [62]=32 [63]=48
+  [66]=65 [68]=51 [70]=69 [73]=48 [74]=58 [75]=51 [77]=76 [79]=78 [81]=80 [83]=82 [84]=8 [86]=85 [87]=71 [88]=2
+  [89]=2 [90]=1 [92]=91 [93]=19 [94]=2 [95]=2 [96]=1 [97]=85 [98]=41 [104]=103 [106]=105 [108]=107 [110]=109
+  [113]=112 [115]=114 [116]=103 [119]=117 [120]=117 [121]=103 [124]=123 [126]=15 [127]=15 [128]=107 [130]=129
+  [132]=131 [133]=131 [135]=134 [136]=134 [139]=137 [142]=140 [144]=143 [145]=143 [147]=146 [148]=146 [150]=149
+  [152]=151 [154]=153 [157]=155 [165]=164 [166]=164 [173]=143 [174]=107 [175]=170 [177]=10 [178]=10 [182]=15 [190]=15
+  [191]=186 [194]=193 [196]=15 [198]=12 [199]=12 [201]=15 [202]=107 [204]=203 [206]=12 [207]=203
+)
+
+build=1
+
+while getopts ":mxd" option; do
+    case $option in
+      m)
+        test_script=./mem_test.sh;;
+      x)
+        build=0;;
+      d)
+        build_flags="env=debug";;
+      /?)
+        ;;
+    esac
+done
+
+for i in "${!same_output[@]}"
+do
+  if ! diff -q "out/$i.out" "out/${same_output[$i]}.out" > /dev/null; then
+    echo "Expected output of test $i differs from test ${same_output[$i]}"
+    exit 1
+  fi
+done
+
+if [ $build == 1 ]; then
+  cd "$src_dir" || exit
+  make clean all $build_flags
+  cd "$cur_dir" || exit
+fi
+
+./reset.sh
+
+for i in {1..207}
+do
+  if [[ " ${ignored_tests[*]} " == *" $i "* ]]; then
+    echo "Skipping test $i (disabled)"
+    continue
+  fi
+
+  echo "Testing $i"
+  $test_script "$i"
+  ec=$?
+  if [ $ec != 0 ]; then
+    echo "Failed test $i"
+    exit $ec
+  fi
+done
+
+if [ $build == 1 ]; then
+  cd "$src_dir" || exit
+  make clean
+  cd "$cur_dir" || exit
+fi
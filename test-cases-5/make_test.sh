@@ -0,0 +1,18 @@
+#!/bin/bash
+
+test_number=$1
+
+# Settings of the test (one ARQUIVOS_* assignment per line)
+test_env=()
+if [ -f "in/$test_number.env" ]; then
+  mapfile -t test_env < "in/$test_number.env"
+fi
+
+#env "${test_env[@]}" ../cmake-build-debug/ARQUIVOS < "in/$test_number.in" > tmp.txt
+env "${test_env[@]}" ../src/main < "in/$test_number.in" > tmp.txt
+diff tmp.txt "out/$test_number.out"
+ec=$?
+if [ $ec == 0 ]; then
+  rm tmp.txt
+fi
+exit $ec
@@ -0,0 +1,24 @@
+#!/bin/bash
+
+test_number=$1
+
+# Settings of the test (one ARQUIVOS_* assignment per line)
+test_env=()
+if [ -f "in/$test_number.env" ]; then
+  mapfile -t test_env < "in/$test_number.env"
+fi
+
+valgrind_args="--leak-check=full --show-leak-kinds=all --error-exitcode=1 --exit-on-first-error=no -q"
+# shellcheck disable=SC2086
+env "${test_env[@]}" valgrind $valgrind_args ../src/main < "in/$test_number.in" > tmp.txt
+ec=$?
+if [ $ec != 0 ]; then
+  exit $ec
+fi
+
+diff tmp.txt "out/$test_number.out"
+ec=$?
+if [ $ec == 0 ]; then
+  rm tmp.txt
+fi
+exit $ec
@@ -0,0 +1,72 @@
+#!/bin/bash
+
+cur_dir=$(pwd)
+src_dir=$cur_dir/../src
+test_script=./make_test.sh
+build_flags="env=test"
+ignored_tests=()
+
+# Cases which must print exactly what another case prints (see README.md)
+declare -A same_output=(
+  [2]=1 [5]=4 [6]=4 [8]=7 [9]=3 [10]=4 [12]=11 [14]=1 [15]=3 [16]=4
+)
+
+build=1
+
+while getopts ":mxd" option; do
+    case $option in
+      m)
+        test_script=./mem_test.sh;;
+      x)
+        build=0;;
+      d)
+        build_flags="env=debug";;
+      /?)
+        ;;
+    esac
+done
+
+for i in "${!same_output[@]}"
+do
+  if ! diff -q "out/$i.out" "out/${same_output[$i]}.out" > /dev/null; then
+    echo "Expected output of test $i differs from test ${same_output[$i]}"
+    exit 1
+  fi
+done
+
+if [ $build == 1 ]; then
+  cd "$src_dir" || exit
+  make clean all $build_flags
+  cd "$cur_dir" || exit
+fi
+
+./reset.sh
+
+for i in {1..16}
+do
+  if [[ " ${ignored_tests[*]} " == *" $i "* ]]; then
+    echo "Skipping test $i (disabled)"
+    continue
+  fi
+
+  echo "Testing $i"
+  $test_script "$i"
+  ec=$?
+  if [ $ec != 0 ]; then
+    echo "Failed test $i"
+    exit $ec
+  fi
+done
+
+# Every log and replacement in initial/ must have been applied or dropped by now
+leftovers=$(ls ./*.wal ./*.new 2> /dev/null)
+if [ -n "$leftovers" ]; then
+  echo "Recovery left files behind:" $leftovers
+  exit 1
+fi
+
+if [ $build == 1 ]; then
+  cd "$src_dir" || exit
+  make clean
+  cd "$cur_dir" || exit
+fi